@@ -0,0 +1,40 @@
+#include "BootTimeline.h"
+
+BootTimeline bootTimeline;
+
+void BootTimeline::phase(const char *name)
+{
+    if (current >= 0)
+        end(current);
+    current = begin(name);
+}
+
+void BootTimeline::setupDone()
+{
+    if (current >= 0)
+        end(current);
+    current = -1;
+    inSetup = false;
+    LOG_INFO("setup() done after %u ms\n", millis());
+}
+
+int BootTimeline::begin(const char *name)
+{
+    if (count == BOOT_TIMELINE_MAX_PHASES)
+        return -1;
+    Phase &p = phases[count];
+    p.name = name;
+    p.startMs = millis();
+    p.deferred = !inSetup;
+    return count++;
+}
+
+void BootTimeline::end(int index)
+{
+    if (index < 0 || index >= count || phases[index].done)
+        return;
+    Phase &p = phases[index];
+    p.durationMs = millis() - p.startMs;
+    p.done = true;
+    LOG_DEBUG("Boot phase %s took %u ms\n", p.name, p.durationMs);
+}
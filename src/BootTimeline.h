@@ -0,0 +1,46 @@
+#pragma once
+
+#include "configuration.h"
+
+#ifndef BOOT_TIMELINE_MAX_PHASES
+#define BOOT_TIMELINE_MAX_PHASES 24
+#endif
+
+/**
+ * Records how long each phase of booting takes: the steps of setup(), and the work that runs after it (DeferredInit, the
+ * GPS probe). API clients get the timeline as log records once they have their config, see PhoneAPI.
+ */
+class BootTimeline
+{
+  public:
+    struct Phase {
+        const char *name;
+        uint32_t startMs;    // millis() when it began
+        uint32_t durationMs; // 0 until it is done
+        bool done;
+        bool deferred; // Ran after setup()
+    };
+
+    /// End the current setup() phase, if any, and begin the next one
+    void phase(const char *name);
+
+    /// End the last setup() phase, the phases after this are deferred ones
+    void setupDone();
+
+    /// Begin a phase outside of setup(), several of them may run at once. @return the index to end() it with
+    int begin(const char *name);
+
+    void end(int index);
+
+    uint8_t size() const { return count; }
+
+    const Phase &get(uint8_t i) const { return phases[i]; }
+
+  private:
+    Phase phases[BOOT_TIMELINE_MAX_PHASES] = {};
+    uint8_t count = 0;
+    int current = -1; // The setup() phase that is running
+    bool inSetup = true;
+};
+
+extern BootTimeline bootTimeline;
@@ -0,0 +1,103 @@
+#include "BufferedLogFile.h"
+#include <stdarg.h>
+
+#ifdef FSCom
+
+BufferedLogFile::BufferedLogFile(const char *path, const char *header, size_t maxBytes)
+    : concurrency::OSThread("BufferedLogFile"), path(path), header(header), maxBytes(maxBytes)
+{
+    disable(); // Only runs while there is something to write
+}
+
+BufferedLogFile::~BufferedLogFile()
+{
+    flush();
+    file.close();
+}
+
+bool BufferedLogFile::open()
+{
+    if (file)
+        return true;
+
+    // Make sure the directory is there
+    char dir[64];
+    const char *slash = strrchr(path, '/');
+    if (slash && slash != path && (size_t)(slash - path) < sizeof(dir)) {
+        memcpy(dir, path, slash - path);
+        dir[slash - path] = '\0';
+        FSCom.mkdir(dir);
+    }
+
+    bool created = !FSCom.exists(path);
+    file = FSCom.open(path, created ? FILE_O_WRITE : FILE_O_APPEND);
+    if (!file) {
+        LOG_ERROR("Can't open %s for appending\n", path);
+        return false;
+    }
+    fileBytes = file.size();
+    if (created && header)
+        fileBytes += file.println(header);
+    return true;
+}
+
+bool BufferedLogFile::printf(const char *format, ...)
+{
+    for (int attempt = 0; attempt < 2; attempt++) {
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buffer + used, sizeof(buffer) - used, format, args);
+        va_end(args);
+
+        if (len >= 0 && used + len < sizeof(buffer)) {
+            if (!used) {
+                // First unwritten text, make sure it gets written out in time
+                enabled = true;
+                setIntervalFromNow(LOGFILE_FLUSH_MS);
+            }
+            used += len;
+            return true;
+        }
+        // Didn't fit, make room and try again
+        flush();
+    }
+    LOG_WARN("Row too long for %s, dropped\n", path);
+    return false;
+}
+
+void BufferedLogFile::flush()
+{
+    if (!used)
+        return;
+
+#ifdef ARCH_ESP32
+    if (FSCom.totalBytes() - FSCom.usedBytes() < 51200) {
+        LOG_WARN("Filesystem doesn't have enough free space, dropping %u bytes for %s\n", (unsigned)used, path);
+        used = 0;
+        return;
+    }
+#endif
+
+    if (open()) {
+        if (maxBytes && fileBytes + used > maxBytes) {
+            if (!full)
+                LOG_WARN("%s reached its limit of %u bytes, dropping further rows\n", path, (unsigned)maxBytes);
+            full = true;
+        } else {
+            size_t written = file.write((uint8_t const *)buffer, used);
+            if (written != used)
+                LOG_ERROR("Write to %s failed\n", path);
+            fileBytes += written;
+            file.flush();
+        }
+    }
+    used = 0;
+}
+
+int32_t BufferedLogFile::runOnce()
+{
+    flush();
+    return disable();
+}
+
+#endif
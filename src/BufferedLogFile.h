@@ -0,0 +1,57 @@
+#pragma once
+
+#include "FSCommon.h"
+#include "concurrency/OSThread.h"
+#include "configuration.h"
+
+#ifdef FSCom
+
+#ifndef LOGFILE_BUFFER_SIZE
+#define LOGFILE_BUFFER_SIZE 1024
+#endif
+
+// Longest a row waits in RAM before it is written out
+#ifndef LOGFILE_FLUSH_MS
+#define LOGFILE_FLUSH_MS (30 * 1000)
+#endif
+
+/**
+ * Appends text to a log file (such as a CSV) without going to the flash for every row.
+ *
+ * The file is opened once and kept open. Text is collected in RAM and written out in one go when the buffer is full or
+ * LOGFILE_FLUSH_MS after the first unwritten row, whichever comes first. A header line is written when the file is
+ * created.
+ *
+ * Once the file has grown to maxBytes, further rows are dropped, so a log left running can't fill the filesystem. On ESP32
+ * rows are also dropped once less than 50KB of the filesystem is free, the other platforms have no way to ask for that.
+ */
+class BufferedLogFile : private concurrency::OSThread
+{
+  public:
+    /// @param maxBytes Largest the file may grow to, 0 for no limit
+    BufferedLogFile(const char *path, const char *header = nullptr, size_t maxBytes = 0);
+    virtual ~BufferedLogFile();
+
+    /// Add printf style formatted text, returns false if it was dropped
+    bool printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+    /// Write out everything buffered so far
+    void flush();
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    bool open();
+
+    const char *path;
+    const char *header;
+    size_t maxBytes;
+    File file;
+    size_t fileBytes = 0; // Size of the file, once it is open
+    bool full = false;
+    size_t used = 0;
+    char buffer[LOGFILE_BUFFER_SIZE];
+};
+
+#endif
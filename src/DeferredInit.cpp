@@ -0,0 +1,28 @@
+#include "DeferredInit.h"
+#include "BootTimeline.h"
+
+DeferredInit *deferredInit;
+
+DeferredInit::DeferredInit() : concurrency::OSThread("DeferredInit") {}
+
+void DeferredInit::add(const char *name, Step step)
+{
+    if (numSteps == DEFERRED_INIT_MAX_STEPS) {
+        LOG_WARN("No room to defer %s, running it now\n", name);
+        step();
+        return;
+    }
+    names[numSteps] = name;
+    steps[numSteps++] = step;
+}
+
+int32_t DeferredInit::runOnce()
+{
+    if (nextStep == numSteps)
+        return disable();
+
+    int phase = bootTimeline.begin(names[nextStep]);
+    steps[nextStep++]();
+    bootTimeline.end(phase);
+    return 0;
+}
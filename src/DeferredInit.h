@@ -0,0 +1,35 @@
+#pragma once
+
+#include "concurrency/OSThread.h"
+#include "configuration.h"
+
+#define DEFERRED_INIT_MAX_STEPS 4
+
+/**
+ * Boot work that doesn't gate radio bring-up, such as probing the I2C sensors and initializing the screen. setup() adds
+ * the steps, and they run from the main loop once it is done: one step per run, so received packets get handled in
+ * between. Each step is a deferred phase in bootTimeline.
+ *
+ * Create it before setupModules(). Threads run in the order they were created, so the first step runs before the first
+ * runOnce() of any module that depends on it (the telemetry modules and the sensors).
+ */
+class DeferredInit : private concurrency::OSThread
+{
+  public:
+    typedef void (*Step)();
+
+    DeferredInit();
+
+    void add(const char *name, Step step);
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    const char *names[DEFERRED_INIT_MAX_STEPS];
+    Step steps[DEFERRED_INIT_MAX_STEPS];
+    uint8_t numSteps = 0;
+    uint8_t nextStep = 0;
+};
+
+extern DeferredInit *deferredInit;
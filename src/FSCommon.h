@@ -12,6 +12,7 @@
 #define FSBegin() true
 #define FILE_O_WRITE "w"
 #define FILE_O_READ "r"
+#define FILE_O_APPEND "a"
 #endif
 
 #if defined(ARCH_STM32WL)
@@ -31,6 +32,7 @@ const OSFS::result notfound = OSFS::result::FILE_NOT_FOUND;
 #define FSBegin() FSCom.begin() // set autoformat
 #define FILE_O_WRITE "w"
 #define FILE_O_READ "r"
+#define FILE_O_APPEND "a"
 #endif
 
 #if defined(ARCH_ESP32)
@@ -40,6 +42,7 @@ const OSFS::result notfound = OSFS::result::FILE_NOT_FOUND;
 #define FSBegin() FSCom.begin(true) // format on failure
 #define FILE_O_WRITE "w"
 #define FILE_O_READ "r"
+#define FILE_O_APPEND "a"
 #endif
 
 #if defined(ARCH_NRF52)
@@ -47,6 +50,7 @@ const OSFS::result notfound = OSFS::result::FILE_NOT_FOUND;
 #include "InternalFileSystem.h"
 #define FSCom InternalFS
 #define FSBegin() FSCom.begin() // InternalFS formats on failure
+#define FILE_O_APPEND FILE_O_WRITE // Adafruit LittleFS opens for writing at the end of the file
 using namespace Adafruit_LittleFS_Namespace;
 #endif
 
@@ -24,27 +24,40 @@ SafeFile::SafeFile(const char *_filename, bool fullAtomic)
 
 size_t SafeFile::write(uint8_t ch)
 {
-    if (!f)
-        return 0;
-
-    hash ^= ch;
-    return f.write(ch);
+    return write(&ch, 1);
 }
 
-size_t SafeFile::write(const uint8_t *buffer, size_t size)
+size_t SafeFile::write(const uint8_t *data, size_t size)
 {
     if (!f)
         return 0;
 
-    for (size_t i = 0; i < size; i++) {
-        hash ^= buffer[i];
+    crc = crc32Update(data, size, crc);
+    length += size;
+
+    if (buffered + size > sizeof(buffer))
+        flushBuffer();
+
+    if (size >= sizeof(buffer)) {
+        // Too big to be worth buffering
+        if (f.write((uint8_t const *)data, size) != size) // This nasty cast is _IMPORTANT_ otherwise the correct adafruit
+            writeFailed = true;                           // method does not get used (they made a mistake in their typing)
+    } else {
+        memcpy(buffer + buffered, data, size);
+        buffered += size;
     }
-    return f.write((uint8_t const *)buffer, size); // This nasty cast is _IMPORTANT_ otherwise the correct adafruit method does
-                                                   // not get used (they made a mistake in their typing)
+    return size;
+}
+
+void SafeFile::flushBuffer()
+{
+    if (buffered && f.write((uint8_t const *)buffer, buffered) != buffered)
+        writeFailed = true;
+    buffered = 0;
 }
 
 /**
- * Atomically close the file (deleting any old versions) and readback the contents to confirm the hash matches
+ * Atomically close the file (deleting any old versions) and readback the contents to confirm the CRC matches
  *
  * @return false for failure
  */
@@ -53,7 +66,12 @@ bool SafeFile::close()
     if (!f)
         return false;
 
+    flushBuffer();
     f.close();
+    if (writeFailed) {
+        LOG_ERROR("Can't write tmp file\n");
+        return false;
+    }
     if (!testReadback())
         return false;
 
@@ -73,7 +91,7 @@ bool SafeFile::close()
     return true;
 }
 
-/// Read our (closed) tempfile back in and compare the hash
+/// Read our (closed) tempfile back in and compare the CRC
 bool SafeFile::testReadback()
 {
     bool lfs_failed = lfs_assert_failed;
@@ -87,15 +105,18 @@ bool SafeFile::testReadback()
         return false;
     }
 
-    int c = 0;
-    uint8_t test_hash = 0;
-    while ((c = f2.read()) >= 0) {
-        test_hash ^= (uint8_t)c;
+    // The write buffer is free by now, read back through it
+    uint32_t test_crc = CRC32_INITIAL;
+    uint32_t test_length = 0;
+    int n;
+    while ((n = f2.read(buffer, sizeof(buffer))) > 0) {
+        test_crc = crc32Update(buffer, n, test_crc);
+        test_length += n;
     }
     f2.close();
 
-    if (test_hash != hash) {
-        LOG_ERROR("Readback failed hash mismatch\n");
+    if (test_length != length || test_crc != crc) {
+        LOG_ERROR("Readback failed CRC mismatch\n");
         return false;
     }
 
@@ -2,9 +2,15 @@
 
 #include "FSCommon.h"
 #include "configuration.h"
+#include <ErriezCRC32.h>
 
 #ifdef FSCom
 
+// Writes are collected and readback is done in blocks of this size, the filesystems are a lot faster that way
+#ifndef SAFEFILE_BUFFER_SIZE
+#define SAFEFILE_BUFFER_SIZE 256
+#endif
+
 /**
  * This class provides 'safe'/paranoid file writing.
  *
@@ -12,12 +18,13 @@
  * be very careful about how we write files.  This class provides a restricted (Stream only) writing API for writing to files.
  *
  * Notably:
- * - we keep a simple xor hash of all characters that were written.
+ * - we keep a CRC32 and the length of everything that was written.
+ * - writes are buffered and go to the filesystem a block at a time.
  * - We do not allow seeking (because we want to maintain our hash)
  * - we provide an close() method which is similar to close but returns false if we were unable to successfully write the
  * file.  Also this method
  * - atomically replaces any old version of the file on the disk with our new file (after first rereading the file from the disk
- * to confirm the hash matches)
+ * to confirm the CRC matches)
  * - Some files are super huge so we can't do the full atomic rename/copy (because of filesystem size limits).  If !fullAtomic
  * then we still do the readback to verify file is valid so higher level code can handle failures.
  */
@@ -30,20 +37,27 @@ class SafeFile : public Print
     virtual size_t write(const uint8_t *buffer, size_t size);
 
     /**
-     * Atomically close the file (deleting any old versions) and readback the contents to confirm the hash matches
+     * Atomically close the file (deleting any old versions) and readback the contents to confirm the CRC matches
      *
      * @return false for failure
      */
     bool close();
 
   private:
-    /// Read our (closed) tempfile back in and compare the hash
+    /// Read our (closed) tempfile back in and compare the CRC
     bool testReadback();
 
+    /// Write out whatever is buffered
+    void flushBuffer();
+
     String filename;
     File f;
     bool fullAtomic;
-    uint8_t hash = 0;
+    bool writeFailed = false;
+    uint32_t crc = CRC32_INITIAL; // Not finalized, testReadback() compares it to another unfinalized one
+    uint32_t length = 0;
+    size_t buffered = 0;
+    uint8_t buffer[SAFEFILE_BUFFER_SIZE];
 };
 
 #endif
\ No newline at end of file
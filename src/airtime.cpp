@@ -9,7 +9,7 @@ AirTime *airTime = NULL;
 uint32_t air_period_tx[PERIODS_TO_LOG];
 uint32_t air_period_rx[PERIODS_TO_LOG];
 
-void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms)
+void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms, meshtastic_MeshPacket_Priority priority)
 {
 
     if (reportType == TX_LOG) {
@@ -17,7 +17,8 @@ void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms)
         this->airtimes.periodTX[0] = this->airtimes.periodTX[0] + airtime_ms;
         air_period_tx[0] = air_period_tx[0] + airtime_ms;
 
-        this->utilizationTX[this->getPeriodUtilHour()] = this->utilizationTX[this->getPeriodUtilHour()] + airtime_ms;
+        this->utilizationTX.add(this->getSecondsSinceBoot(), airtime_ms);
+        this->priorityAirtimeTX[prioritySlot(priority)] += airtime_ms;
     } else if (reportType == RX_LOG) {
         LOG_DEBUG("AirTime - Packet received : %ums\n", airtime_ms);
         this->airtimes.periodRX[0] = this->airtimes.periodRX[0] + airtime_ms;
@@ -28,22 +29,85 @@ void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms)
     }
 
     // Log all airtime type for channel utilization
-    this->channelUtilization[this->getPeriodUtilMinute()] = channelUtilization[this->getPeriodUtilMinute()] + airtime_ms;
+    this->channelUtilization.add(this->getSecondsSinceBoot(), airtime_ms);
 }
 
-uint8_t AirTime::currentPeriodIndex()
+void AirTime::logPortnumAirtime(reportTypes reportType, meshtastic_PortNum portnum, uint32_t airtime_ms)
 {
-    return ((getSecondsSinceBoot() / SECONDS_PER_PERIOD) % PERIODS_TO_LOG);
+    if (reportType == TX_LOG)
+        this->portnumAirtime[portnumSlot(portnum)].tx += airtime_ms;
+    else if (reportType == RX_LOG)
+        this->portnumAirtime[portnumSlot(portnum)].rx += airtime_ms;
+}
+
+void AirTime::expectTransmit(const meshtastic_MeshPacket *p, meshtastic_PortNum portnum)
+{
+    // The oldest entry is most likely one that never made it on the air
+    this->pendingTX[this->nextPendingTX] = {p->from, p->id, portnumSlot(portnum), true};
+    this->nextPendingTX = (this->nextPendingTX + 1) % AIRTIME_PENDING_TX;
+}
+
+void AirTime::logTransmit(const meshtastic_MeshPacket *p, uint32_t airtime_ms)
+{
+    logAirtime(TX_LOG, airtime_ms, p->priority);
+
+    uint8_t slot = portnumSlot(meshtastic_PortNum_UNKNOWN_APP);
+    for (pendingTransmit &pending : this->pendingTX) {
+        if (pending.used && pending.from == p->from && pending.id == p->id) {
+            slot = pending.portnumSlot;
+            pending.used = false;
+            break;
+        }
+    }
+    this->portnumAirtime[slot].tx += airtime_ms;
+}
+
+uint32_t AirTime::getPortnumAirtime(reportTypes reportType, meshtastic_PortNum portnum)
+{
+    if (reportType == TX_LOG)
+        return this->portnumAirtime[portnumSlot(portnum)].tx;
+    else if (reportType == RX_LOG)
+        return this->portnumAirtime[portnumSlot(portnum)].rx;
+    return 0;
+}
+
+uint32_t AirTime::getPriorityAirtime(meshtastic_MeshPacket_Priority priority)
+{
+    return this->priorityAirtimeTX[prioritySlot(priority)];
+}
+
+uint8_t AirTime::portnumSlot(meshtastic_PortNum portnum)
+{
+    return (portnum < AIRTIME_PORTNUM_SLOTS - 1) ? portnum : AIRTIME_PORTNUM_SLOTS - 1;
 }
 
-uint8_t AirTime::getPeriodUtilMinute()
+uint8_t AirTime::prioritySlot(meshtastic_MeshPacket_Priority priority)
 {
-    return (getSecondsSinceBoot() / 10) % CHANNEL_UTILIZATION_PERIODS;
+    switch (priority) {
+    case meshtastic_MeshPacket_Priority_MIN:
+        return 1;
+    case meshtastic_MeshPacket_Priority_BACKGROUND:
+        return 2;
+    case meshtastic_MeshPacket_Priority_DEFAULT:
+        return 3;
+    case meshtastic_MeshPacket_Priority_RELIABLE:
+        return 4;
+    case meshtastic_MeshPacket_Priority_RESPONSE:
+        return 5;
+    case meshtastic_MeshPacket_Priority_HIGH:
+        return 6;
+    case meshtastic_MeshPacket_Priority_ACK:
+        return 7;
+    case meshtastic_MeshPacket_Priority_MAX:
+        return 8;
+    default:
+        return 0;
+    }
 }
 
-uint8_t AirTime::getPeriodUtilHour()
+uint8_t AirTime::currentPeriodIndex()
 {
-    return (getSecondsSinceBoot() / 60) % MINUTES_IN_HOUR;
+    return ((getSecondsSinceBoot() / SECONDS_PER_PERIOD) % PERIODS_TO_LOG);
 }
 
 void AirTime::airtimeRotatePeriod()
@@ -102,23 +166,16 @@ uint32_t AirTime::getSecondsSinceBoot()
 
 float AirTime::channelUtilizationPercent()
 {
-    uint32_t sum = 0;
-    for (uint32_t i = 0; i < CHANNEL_UTILIZATION_PERIODS; i++) {
-        sum += this->channelUtilization[i];
-        // LOG_DEBUG("ChanUtilArray %u %u\n", i, this->channelUtilization[i]);
-    }
+    uint32_t sum = this->channelUtilization.total(this->getSecondsSinceBoot());
 
-    return (float(sum) / float(CHANNEL_UTILIZATION_PERIODS * 10 * 1000)) * 100;
+    return (float(sum) / float(this->channelUtilization.windowMs())) * 100;
 }
 
 float AirTime::utilizationTXPercent()
 {
-    uint32_t sum = 0;
-    for (uint32_t i = 0; i < MINUTES_IN_HOUR; i++) {
-        sum += this->utilizationTX[i];
-    }
+    uint32_t sum = this->utilizationTX.total(this->getSecondsSinceBoot());
 
-    return (float(sum) / float(MS_IN_HOUR)) * 100;
+    return (float(sum) / float(this->utilizationTX.windowMs())) * 100;
 }
 
 bool AirTime::isTxAllowedChannelUtil(bool polite)
@@ -150,10 +207,13 @@ bool AirTime::isTxAllowedAirUtil()
 uint8_t AirTime::getSilentMinutes(float txPercent, float dutyCycle)
 {
     float newTxPercent = txPercent;
-    for (int8_t i = MINUTES_IN_HOUR - 1; i >= 0; --i) {
-        newTxPercent -= ((float)this->utilizationTX[i] / (MS_IN_MINUTE * MINUTES_IN_HOUR / 100));
-        if (newTxPercent < dutyCycle)
-            return MINUTES_IN_HOUR - 1 - i;
+    // Walk the TX window from the oldest bucket forward, dropping each one as it would expire
+    for (int32_t age = this->utilizationTX.numBuckets() - 1; age >= 0; --age) {
+        newTxPercent -= ((float)this->utilizationTX.bucket(age) / (this->utilizationTX.windowMs() / 100));
+        if (newTxPercent < dutyCycle) {
+            uint32_t silentSecs = (this->utilizationTX.numBuckets() - age) * this->utilizationTX.bucketSecs();
+            return (silentSecs + SECONDS_IN_MINUTE - 1) / SECONDS_IN_MINUTE;
+        }
     }
 
     return MINUTES_IN_HOUR;
@@ -165,20 +225,11 @@ int32_t AirTime::runOnce()
 {
     secSinceBoot++;
 
-    uint8_t utilPeriod = this->getPeriodUtilMinute();
-    uint8_t utilPeriodTX = this->getPeriodUtilHour();
-
     if (firstTime) {
 
-        // Init utilizationTX window to all 0
-        for (uint32_t i = 0; i < MINUTES_IN_HOUR; i++) {
-            this->utilizationTX[i] = 0;
-        }
-
-        // Init channelUtilization window to all 0
-        for (uint32_t i = 0; i < CHANNEL_UTILIZATION_PERIODS; i++) {
-            this->channelUtilization[i] = 0;
-        }
+        // Init utilization windows to all 0
+        this->utilizationTX.clear();
+        this->channelUtilization.clear();
 
         // Init airtime windows to all 0
         for (int i = 0; i < PERIODS_TO_LOG; i++) {
@@ -191,31 +242,13 @@ int32_t AirTime::runOnce()
         }
 
         firstTime = false;
-        lastUtilPeriod = utilPeriod;
     } else {
         this->airtimeRotatePeriod();
+    }
 
-        // Reset the channelUtilization window when we roll over
-        if (lastUtilPeriod != utilPeriod) {
-            lastUtilPeriod = utilPeriod;
-
-            this->channelUtilization[utilPeriod] = 0;
-        }
-
-        if (lastUtilPeriodTX != utilPeriodTX) {
-            lastUtilPeriodTX = utilPeriodTX;
+    // Expire buckets that slid out of the windows, so the running sums stay current even when nothing is logged
+    this->channelUtilization.advance(secSinceBoot);
+    this->utilizationTX.advance(secSinceBoot);
 
-            this->utilizationTX[utilPeriodTX] = 0;
-        }
-    }
-    /*
-        LOG_DEBUG("utilPeriodTX %d TX Airtime %3.2f%\n", utilPeriodTX, airTime->utilizationTXPercent());
-        for (uint32_t i = 0; i < MINUTES_IN_HOUR; i++) {
-            LOG_DEBUG(
-                "%d,", this->utilizationTX[i]
-                );
-        }
-        LOG_DEBUG("\n");
-    */
     return (1000 * 1);
-}
\ No newline at end of file
+}
@@ -25,7 +25,6 @@
   RX_ALL_LOG - RX_LOG = Other lora radios on our frequency channel.
 */
 
-#define CHANNEL_UTILIZATION_PERIODS 6
 #define SECONDS_PER_PERIOD 3600
 #define PERIODS_TO_LOG 8
 #define MINUTES_IN_HOUR 60
@@ -33,8 +32,91 @@
 #define MS_IN_MINUTE (SECONDS_IN_MINUTE * 1000)
 #define MS_IN_HOUR (MINUTES_IN_HOUR * SECONDS_IN_MINUTE * 1000)
 
+// Width of one bucket in the one minute channel utilization window. Must divide SECONDS_IN_MINUTE.
+#ifndef AIRTIME_CHUTIL_RESOLUTION_SECS
+#define AIRTIME_CHUTIL_RESOLUTION_SECS 10
+#endif
+
+// Width of one bucket in the one hour TX (duty cycle) window. Must divide SECONDS_IN_MINUTE * MINUTES_IN_HOUR.
+#ifndef AIRTIME_TX_RESOLUTION_SECS
+#define AIRTIME_TX_RESOLUTION_SECS 10
+#endif
+
+#define CHANNEL_UTILIZATION_PERIODS (SECONDS_IN_MINUTE / AIRTIME_CHUTIL_RESOLUTION_SECS)
+#define UTILIZATION_TX_PERIODS (MINUTES_IN_HOUR * SECONDS_IN_MINUTE / AIRTIME_TX_RESOLUTION_SECS)
+
+// Portnums above the last core app are folded into the final "other" slot
+#define AIRTIME_PORTNUM_SLOTS (meshtastic_PortNum_POWERSTRESS_APP + 2)
+#define AIRTIME_PRIORITY_SLOTS 9
+
+// Packets handed to a radio whose portnum we remember until they go on the air, like the TX queue of a radio
+#define AIRTIME_PENDING_TX 16
+
 enum reportTypes { TX_LOG, RX_LOG, RX_ALL_LOG };
 
+/**
+ * A sliding window of airtime made of BUCKETS buckets of BUCKET_SECS seconds each.
+ *
+ * A running sum is kept alongside the buckets, so adding airtime and asking for the total of the window are O(1). Buckets
+ * that fall out of the window are subtracted from the sum as time advances.
+ */
+template <uint16_t BUCKETS, uint16_t BUCKET_SECS> class AirtimeWindow
+{
+  public:
+    void add(uint32_t nowSecs, uint32_t airtime_ms)
+    {
+        advance(nowSecs);
+        buckets[head] += airtime_ms;
+        sum += airtime_ms;
+    }
+
+    /// Total airtime in the window (including the bucket currently being filled)
+    uint32_t total(uint32_t nowSecs)
+    {
+        advance(nowSecs);
+        return sum;
+    }
+
+    /// Airtime logged in a bucket, where age 0 is the bucket currently being filled
+    uint32_t bucket(uint16_t age) const { return age < BUCKETS ? buckets[(head + BUCKETS - age) % BUCKETS] : 0; }
+
+    void clear()
+    {
+        memset(buckets, 0, sizeof(buckets));
+        sum = 0;
+    }
+
+    /// Expire every bucket that has slid out of the window since the last call
+    void advance(uint32_t nowSecs)
+    {
+        uint32_t slot = nowSecs / BUCKET_SECS;
+        if (slot == headSlot)
+            return;
+
+        uint32_t steps = slot - headSlot;
+        if (steps >= BUCKETS) {
+            clear();
+        } else {
+            while (steps--) {
+                head = (head + 1) % BUCKETS;
+                sum -= buckets[head];
+                buckets[head] = 0;
+            }
+        }
+        headSlot = slot;
+    }
+
+    static constexpr uint16_t numBuckets() { return BUCKETS; }
+    static constexpr uint16_t bucketSecs() { return BUCKET_SECS; }
+    static constexpr uint32_t windowMs() { return (uint32_t)BUCKETS * BUCKET_SECS * 1000; }
+
+  private:
+    uint32_t buckets[BUCKETS] = {0};
+    uint32_t sum = 0;
+    uint16_t head = 0;
+    uint32_t headSlot = 0;
+};
+
 void logAirtime(reportTypes reportType, uint32_t airtime_ms);
 
 uint32_t *airtimeReport(reportTypes reportType);
@@ -45,13 +127,36 @@ class AirTime : private concurrency::OSThread
   public:
     AirTime();
 
-    void logAirtime(reportTypes reportType, uint32_t airtime_ms);
+    /**
+     * Account for a packet on the air. The priority is only known (and only recorded) for packets we transmit, since it
+     * is not carried in the over the air header.
+     */
+    void logAirtime(reportTypes reportType, uint32_t airtime_ms,
+                    meshtastic_MeshPacket_Priority priority = meshtastic_MeshPacket_Priority_UNSET);
+
+    /**
+     * Attribute airtime to an application port. Called by the router, which is the only place that knows the portnum of a
+     * packet. Forwarded packets we could not decode are counted against UNKNOWN_APP.
+     */
+    void logPortnumAirtime(reportTypes reportType, meshtastic_PortNum portnum, uint32_t airtime_ms);
+
+    /**
+     * Remember the portnum of a packet the router queued for sending, by the time it is transmitted it is encrypted. Packets
+     * that are cancelled or dropped before that are never counted, their entry is reused eventually.
+     */
+    void expectTransmit(const meshtastic_MeshPacket *p, meshtastic_PortNum portnum);
+
+    /// Account for a packet the radio is transmitting, to its priority and the portnum given to expectTransmit()
+    void logTransmit(const meshtastic_MeshPacket *p, uint32_t airtime_ms);
+
     float channelUtilizationPercent();
     float utilizationTXPercent();
 
-    float UtilizationPercentTX();
-    uint32_t channelUtilization[CHANNEL_UTILIZATION_PERIODS] = {0};
-    uint32_t utilizationTX[MINUTES_IN_HOUR] = {0};
+    /// Cumulative airtime (ms since boot) for a portnum. reportType must be TX_LOG or RX_LOG.
+    uint32_t getPortnumAirtime(reportTypes reportType, meshtastic_PortNum portnum);
+
+    /// Cumulative TX airtime (ms since boot) for a packet priority
+    uint32_t getPriorityAirtime(meshtastic_MeshPacket_Priority priority);
 
     void airtimeRotatePeriod();
     uint8_t getPeriodsToLog();
@@ -64,8 +169,6 @@ class AirTime : private concurrency::OSThread
 
   private:
     bool firstTime = true;
-    uint8_t lastUtilPeriod = 0;
-    uint8_t lastUtilPeriodTX = 0;
     uint32_t secSinceBoot = 0;
     uint8_t max_channel_util_percent = 40;
     uint8_t polite_channel_util_percent = 25;
@@ -78,8 +181,28 @@ class AirTime : private concurrency::OSThread
         uint8_t lastPeriodIndex;
     } airtimes;
 
-    uint8_t getPeriodUtilMinute();
-    uint8_t getPeriodUtilHour();
+    AirtimeWindow<CHANNEL_UTILIZATION_PERIODS, AIRTIME_CHUTIL_RESOLUTION_SECS> channelUtilization;
+    AirtimeWindow<UTILIZATION_TX_PERIODS, AIRTIME_TX_RESOLUTION_SECS> utilizationTX;
+
+    struct airtimeBreakdown {
+        uint32_t tx;
+        uint32_t rx;
+    };
+    airtimeBreakdown portnumAirtime[AIRTIME_PORTNUM_SLOTS] = {};
+    uint32_t priorityAirtimeTX[AIRTIME_PRIORITY_SLOTS] = {0};
+
+    struct pendingTransmit {
+        uint32_t from;
+        uint32_t id;
+        uint8_t portnumSlot;
+        bool used;
+    };
+    pendingTransmit pendingTX[AIRTIME_PENDING_TX] = {};
+    uint8_t nextPendingTX = 0;
+
+    static uint8_t portnumSlot(meshtastic_PortNum portnum);
+    static uint8_t prioritySlot(meshtastic_MeshPacket_Priority priority);
+
     uint8_t currentPeriodIndex();
 
   protected:
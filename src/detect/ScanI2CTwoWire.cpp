@@ -2,9 +2,12 @@
 
 #if !MESHTASTIC_EXCLUDE_I2C
 
+#include "SafeFile.h"
 #include "concurrency/LockGuard.h"
+#include <algorithm>
 #if defined(ARCH_PORTDUINO)
 #include "linux/LinuxHardwareI2C.h"
+#include "platform/portduino/PortduinoGlue.h"
 #endif
 #if !defined(ARCH_PORTDUINO) && !defined(ARCH_STM32WL)
 #include "main.h" // atecc
@@ -145,257 +148,477 @@ uint16_t ScanI2CTwoWire::getRegisterValue(const ScanI2CTwoWire::RegisterLocation
         type = T;                                                                                                                \
         break;
 
+// What setup() needs to know about before the radio comes up, see scanBootDevices()
+static uint8_t bootAddresses[] = {
+    SSD1306_ADDRESS, ST7567_ADDRESS, XPOWERS_AXP192_AXP2101_ADDRESS, CARDKB_ADDR, TDECK_KB_ADDR, BBQ10_KB_ADDR,
+#ifdef RV3028_RTC
+    RV3028_RTC,
+#endif
+#ifdef PCF8563_RTC
+    PCF8563_RTC,
+#endif
+#ifdef HAS_NCP5623
+    NCP5623_ADDR,
+#endif
+    // Accelerometers, some share their address with a sensor that then gets probed early as well
+    MPU6050_ADDR, LIS3DH_ADR, BMA423_ADDR, LSM6DS3_ADDR, QMI8658_ADDR, BMX160_ADDR,
+    // setupModules() only creates the air quality module if there is one
+    PMSA0031_ADDR};
+
+// Every address probeAddress() knows a device at, the cache check pings these to notice new devices and scans try them first
+static uint8_t knownAddresses[] = {
+    SSD1306_ADDRESS, ST7567_ADDRESS, CARDKB_ADDR, TDECK_KB_ADDR, BBQ10_KB_ADDR,
+#if !defined(ARCH_PORTDUINO) && !defined(ARCH_STM32WL)
+    ATECC608B_ADDR,
+#endif
+#ifdef RV3028_RTC
+    RV3028_RTC,
+#endif
+#ifdef PCF8563_RTC
+    PCF8563_RTC,
+#endif
+#ifdef HAS_NCP5623
+    NCP5623_ADDR,
+#else
+    AHT10_ADDR,
+#endif
+#ifdef HAS_PMU
+    XPOWERS_AXP192_AXP2101_ADDRESS,
+#endif
+    BME_ADDR, BME_ADDR_ALTERNATE, INA_ADDR, INA_ADDR_ALTERNATE, INA_ADDR_WAVESHARE_UPS, INA3221_ADDR, MCP9808_ADDR,
+    SHT31_4x_ADDR, SHTC3_ADDR, RCWL9620_ADDR, LPS22HB_ADDR_ALT, LPS22HB_ADDR, QMC6310_ADDR, QMI8658_ADDR, QMC5883L_ADDR,
+    PMSA0031_ADDR, MPU6050_ADDR, BMX160_ADDR, BMA423_ADDR, LSM6DS3_ADDR, TCA9555_ADDR, VEML7700_ADDR, TSL25911_ADDR,
+    OPT3001_ADDR, MLX90632_ADDR, NAU7802_ADDR};
+
+/// Probing these also sets the device up, so they get probed again even when they come from the cache
+static bool probeSetsUp(uint8_t address)
+{
+#if !defined(ARCH_PORTDUINO) && !defined(ARCH_STM32WL)
+    if (address == ATECC608B_ADDR)
+        return true;
+#endif
+#ifdef RV3028_RTC
+    if (address == RV3028_RTC)
+        return true;
+#endif
+    return false;
+}
+
+/// Which board, bus wiring and firmware a scan cache was made with, it's no good on any other. The firmware version is in
+/// there because the cache stores DeviceType values, which another version may number differently.
+static uint32_t scanCacheKey()
+{
+    uint32_t key = HW_VENDOR;
+    for (const char *c = optstr(APP_VERSION); *c; c++)
+        key = key * 31 + *c;
+#if defined(I2C_SDA) && defined(I2C_SCL)
+    key = key * 31 + I2C_SDA;
+    key = key * 31 + I2C_SCL;
+#endif
+#if defined(I2C_SDA1) && defined(I2C_SCL1)
+    key = key * 31 + I2C_SDA1;
+    key = key * 31 + I2C_SCL1;
+#endif
+#ifdef ARCH_PORTDUINO
+    for (char c : settingsStrings[i2cdev])
+        key = key * 31 + c;
+#endif
+    return key;
+}
+
 void ScanI2CTwoWire::scanPort(I2CPort port, uint8_t *address, uint8_t asize)
 {
-    concurrency::LockGuard guard((concurrency::Lock *)&lock);
+    scanAddresses(port, address, asize, false);
+}
 
-    LOG_DEBUG("Scanning for I2C devices on port %d\n", port);
+void ScanI2CTwoWire::scanBootDevices(I2CPort port)
+{
+    if (useScanCache(port))
+        return;
+    scanAddresses(port, bootAddresses, sizeof(bootAddresses), false);
+}
 
-    uint8_t err;
+void ScanI2CTwoWire::scanOtherDevices(I2CPort port)
+{
+    if (cachedPorts & (1 << port))
+        return;
+    scanAddresses(port, bootAddresses, sizeof(bootAddresses), true);
+}
 
-    DeviceAddress addr(port, 0x00);
+bool ScanI2CTwoWire::ping(TwoWire *i2cBus, uint8_t address) const
+{
+    i2cBus->beginTransmission(address);
+#ifdef ARCH_PORTDUINO
+    return i2cBus->read() != -1;
+#else
+    uint8_t err = i2cBus->endTransmission();
+    if (err == 4)
+        LOG_ERROR("Unknown error at address 0x%x\n", address);
+    return err == 0;
+#endif
+}
 
-    uint16_t registerValue = 0x00;
-    ScanI2C::DeviceType type;
-    TwoWire *i2cBus;
-#ifdef RV3028_RTC
-    Melopero_RV3028 rtc;
+void ScanI2CTwoWire::addDevice(DeviceAddress addr, DeviceType type)
+{
+    auto seen = std::find_if(responding.begin(), responding.end(), [&addr](const CachedDevice &d) {
+        return d.port == addr.port && d.address == addr.address;
+    });
+    if (seen == responding.end())
+        responding.push_back({(uint8_t)addr.port, addr.address, (uint8_t)type});
+    else
+        seen->type = type;
+    // Check if a type was found for the enumerated device - save, if so
+    if (type != NONE) {
+        deviceAddresses[type] = addr;
+        foundDevices[addr] = type;
+    }
+}
+
+bool ScanI2CTwoWire::useScanCache(I2CPort port)
+{
+#ifdef FSCom
+    concurrency::LockGuard guard((concurrency::Lock *)&lock);
+
+    if (!cacheLoaded) {
+        cacheLoaded = true;
+        auto f = FSCom.open(I2C_SCAN_CACHE_FILE, FILE_O_READ);
+        if (f) {
+            if (f.read((uint8_t *)&cache, sizeof(cache)) != sizeof(cache) || cache.version != I2C_SCAN_CACHE_VERSION ||
+                cache.key != scanCacheKey() || cache.count > I2C_SCAN_CACHE_MAX_DEVICES) {
+                LOG_INFO("I2C scan cache is for another board or firmware, ignoring it\n");
+                cache.count = 0;
+                cache.version = 0;
+            }
+            f.close();
+        }
+    }
+    if (cache.version != I2C_SCAN_CACHE_VERSION)
+        return false;
+
+    uint32_t start = millis();
+    TwoWire *i2cBus = fetchI2CBus(DeviceAddress(port, 0x00));
+    bool pinged[128] = {};
+    uint8_t numCached = 0;
+
+    for (uint8_t i = 0; i < cache.count; i++) {
+        const CachedDevice &d = cache.devices[i];
+        if (d.port != port)
+            continue;
+        numCached++;
+        pinged[d.address & 0x7f] = true;
+        if (!ping(i2cBus, d.address)) {
+            LOG_INFO("I2C device at 0x%x on port %d is gone, rescanning\n", d.address, port);
+            return false;
+        }
+    }
+    for (uint8_t address : knownAddresses) {
+        if (pinged[address])
+            continue;
+        pinged[address] = true;
+        if (ping(i2cBus, address)) {
+            LOG_INFO("New I2C device at 0x%x on port %d, rescanning\n", address, port);
+            return false;
+        }
+    }
+
+    for (uint8_t i = 0; i < cache.count; i++) {
+        const CachedDevice &d = cache.devices[i];
+        if (d.port != port)
+            continue;
+        DeviceAddress addr(port, d.address);
+        if (probeSetsUp(d.address))
+            addDevice(addr, probeAddress(addr, i2cBus));
+        else
+            addDevice(addr, (DeviceType)d.type);
+    }
+    cachedPorts |= 1 << port;
+    LOG_INFO("Using %u cached I2C devices on port %d, checked in %u ms\n", numCached, port, millis() - start);
+    return true;
+#else
+    return false;
 #endif
+}
 
-#ifdef I2C_SDA1
-    if (port == I2CPort::WIRE1) {
-        i2cBus = &Wire1;
-    } else {
+void ScanI2CTwoWire::clearScanCache()
+{
+#ifdef FSCom
+    if (FSCom.exists(I2C_SCAN_CACHE_FILE) && !FSCom.remove(I2C_SCAN_CACHE_FILE))
+        LOG_ERROR("Can't remove %s\n", I2C_SCAN_CACHE_FILE);
 #endif
-        i2cBus = &Wire;
-#ifdef I2C_SDA1
+}
+
+void ScanI2CTwoWire::saveScanCache()
+{
+#ifdef FSCom
+    if (!scannedPorts)
+        return; // Nothing new, it all came from the cache
+    if (responding.size() > I2C_SCAN_CACHE_MAX_DEVICES) {
+        LOG_WARN("Too many I2C devices to cache, the next boot scans again\n");
+        return;
     }
+
+    memset(&cache, 0, sizeof(cache));
+    cache.version = I2C_SCAN_CACHE_VERSION;
+    cache.key = scanCacheKey();
+    cache.count = responding.size();
+    memcpy(cache.devices, responding.data(), responding.size() * sizeof(CachedDevice));
+
+    FSCom.mkdir("/prefs");
+    auto f = SafeFile(I2C_SCAN_CACHE_FILE);
+    f.write((const uint8_t *)&cache, sizeof(cache));
+    if (!f.close())
+        LOG_ERROR("Can't write %s\n", I2C_SCAN_CACHE_FILE);
+    else
+        LOG_INFO("Saved %u I2C devices to %s\n", cache.count, I2C_SCAN_CACHE_FILE);
+    scannedPorts = 0;
 #endif
+}
+
+void ScanI2CTwoWire::scanAddresses(I2CPort port, uint8_t *address, uint8_t asize, bool skipListed)
+{
+    concurrency::LockGuard guard((concurrency::Lock *)&lock);
 
-    for (addr.address = 1; addr.address < 127; addr.address++) {
+    LOG_DEBUG("Scanning for I2C devices on port %d\n", port);
+
+    uint32_t start = millis();
+    DeviceAddress addr(port, 0x00);
+    TwoWire *i2cBus = fetchI2CBus(addr);
+    bool tried[128] = {};
+
+    auto scanAddress = [&](uint8_t a) {
+        if (a == 0 || a >= 127 || tried[a])
+            return;
+        tried[a] = true;
         if (asize != 0) {
-            if (!in_array(address, asize, addr.address))
-                continue;
-            LOG_DEBUG("Scanning address 0x%x\n", addr.address);
+            if (in_array(address, asize, a) == skipListed)
+                return;
+            if (!skipListed)
+                LOG_DEBUG("Scanning address 0x%x\n", a);
         }
-        i2cBus->beginTransmission(addr.address);
-#ifdef ARCH_PORTDUINO
-        if (i2cBus->read() != -1)
-            err = 0;
-        else
-            err = 2;
-#else
-        err = i2cBus->endTransmission();
-#endif
-        type = NONE;
-        if (err == 0) {
-            LOG_DEBUG("I2C device found at address 0x%x\n", addr.address);
+        addr.address = a;
+        if (ping(i2cBus, a)) {
+            LOG_DEBUG("I2C device found at address 0x%x\n", a);
+            addDevice(addr, probeAddress(addr, i2cBus));
+        }
+    };
+
+    // The addresses we know devices at first, so those are found before we wait on the empty ones
+    for (uint8_t a : knownAddresses)
+        scanAddress(a);
+    for (uint8_t a = 1; a < 127; a++)
+        scanAddress(a);
+
+    // Only a full scan, or the boot and other device scans together, are worth caching
+    if (asize == 0 || address == bootAddresses)
+        scannedPorts |= 1 << port;
+    LOG_DEBUG("Scanned port %d in %u ms\n", port, millis() - start);
+}
 
-            switch (addr.address) {
-            case SSD1306_ADDRESS:
-                type = probeOLED(addr);
-                break;
+ScanI2C::DeviceType ScanI2CTwoWire::probeAddress(DeviceAddress addr, TwoWire *i2cBus)
+{
+    uint16_t registerValue = 0x00;
+    ScanI2C::DeviceType type = NONE;
+
+    switch (addr.address) {
+    case SSD1306_ADDRESS:
+        type = probeOLED(addr);
+        break;
 
 #if !defined(ARCH_PORTDUINO) && !defined(ARCH_STM32WL)
-            case ATECC608B_ADDR:
+    case ATECC608B_ADDR:
 #ifdef RP2040_SLOW_CLOCK
-                if (atecc.begin(addr.address, Wire, Serial2) == true)
+        if (atecc.begin(addr.address, Wire, Serial2) == true)
 #else
-                if (atecc.begin(addr.address) == true)
+        if (atecc.begin(addr.address) == true)
 #endif
 
-                {
-                    LOG_INFO("ATECC608B initialized\n");
-                } else {
-                    LOG_WARN("ATECC608B initialization failed\n");
-                }
-                printATECCInfo();
-                break;
+        {
+            LOG_INFO("ATECC608B initialized\n");
+        } else {
+            LOG_WARN("ATECC608B initialization failed\n");
+        }
+        printATECCInfo();
+        break;
 #endif
 
 #ifdef RV3028_RTC
-            case RV3028_RTC:
-                // foundDevices[addr] = RTC_RV3028;
-                type = RTC_RV3028;
-                LOG_INFO("RV3028 RTC found\n");
-                rtc.initI2C(*i2cBus);
-                rtc.writeToRegister(0x35, 0x07); // no Clkout
-                rtc.writeToRegister(0x37, 0xB4);
-                break;
+    case RV3028_RTC: {
+        // foundDevices[addr] = RTC_RV3028;
+        type = RTC_RV3028;
+        LOG_INFO("RV3028 RTC found\n");
+        Melopero_RV3028 rtc;
+        rtc.initI2C(*i2cBus);
+        rtc.writeToRegister(0x35, 0x07); // no Clkout
+        rtc.writeToRegister(0x37, 0xB4);
+        break;
+    }
 #endif
 
 #ifdef PCF8563_RTC
-                SCAN_SIMPLE_CASE(PCF8563_RTC, RTC_PCF8563, "PCF8563 RTC found\n")
+        SCAN_SIMPLE_CASE(PCF8563_RTC, RTC_PCF8563, "PCF8563 RTC found\n")
 #endif
 
-            case CARDKB_ADDR:
-                // Do we have the RAK14006 instead?
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x04), 1);
-                if (registerValue == 0x02) {
-                    // KEYPAD_VERSION
-                    LOG_INFO("RAK14004 found\n");
-                    type = RAK14004;
-                } else {
-                    LOG_INFO("m5 cardKB found\n");
-                    type = CARDKB;
-                }
-                break;
+    case CARDKB_ADDR:
+        // Do we have the RAK14006 instead?
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x04), 1);
+        if (registerValue == 0x02) {
+            // KEYPAD_VERSION
+            LOG_INFO("RAK14004 found\n");
+            type = RAK14004;
+        } else {
+            LOG_INFO("m5 cardKB found\n");
+            type = CARDKB;
+        }
+        break;
 
-                SCAN_SIMPLE_CASE(TDECK_KB_ADDR, TDECKKB, "T-Deck keyboard found\n");
-                SCAN_SIMPLE_CASE(BBQ10_KB_ADDR, BBQ10KB, "BB Q10 keyboard found\n");
-                SCAN_SIMPLE_CASE(ST7567_ADDRESS, SCREEN_ST7567, "st7567 display found\n");
+        SCAN_SIMPLE_CASE(TDECK_KB_ADDR, TDECKKB, "T-Deck keyboard found\n");
+        SCAN_SIMPLE_CASE(BBQ10_KB_ADDR, BBQ10KB, "BB Q10 keyboard found\n");
+        SCAN_SIMPLE_CASE(ST7567_ADDRESS, SCREEN_ST7567, "st7567 display found\n");
 #ifdef HAS_NCP5623
-                SCAN_SIMPLE_CASE(NCP5623_ADDR, NCP5623, "NCP5623 RGB LED found\n");
+        SCAN_SIMPLE_CASE(NCP5623_ADDR, NCP5623, "NCP5623 RGB LED found\n");
 #endif
 #ifdef HAS_PMU
-                SCAN_SIMPLE_CASE(XPOWERS_AXP192_AXP2101_ADDRESS, PMU_AXP192_AXP2101, "axp192/axp2101 PMU found\n")
+        SCAN_SIMPLE_CASE(XPOWERS_AXP192_AXP2101_ADDRESS, PMU_AXP192_AXP2101, "axp192/axp2101 PMU found\n")
 #endif
-            case BME_ADDR:
-            case BME_ADDR_ALTERNATE:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xD0), 1); // GET_ID
-                switch (registerValue) {
-                case 0x61:
-                    LOG_INFO("BME-680 sensor found at address 0x%x\n", (uint8_t)addr.address);
-                    type = BME_680;
-                    break;
-                case 0x60:
-                    LOG_INFO("BME-280 sensor found at address 0x%x\n", (uint8_t)addr.address);
-                    type = BME_280;
-                    break;
-                case 0x55:
-                    LOG_INFO("BMP-085 or BMP-180 sensor found at address 0x%x\n", (uint8_t)addr.address);
-                    type = BMP_085;
-                    break;
-                default:
-                    registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x00), 1); // GET_ID
-                    switch (registerValue) {
-                    case 0x50: // BMP-388 should be 0x50
-                        LOG_INFO("BMP-388 sensor found at address 0x%x\n", (uint8_t)addr.address);
-                        type = BMP_3XX;
-                        break;
-                    case 0x58: // BMP-280 should be 0x58
-                    default:
-                        LOG_INFO("BMP-280 sensor found at address 0x%x\n", (uint8_t)addr.address);
-                        type = BMP_280;
-                        break;
-                    }
-                    break;
-                }
+    case BME_ADDR:
+    case BME_ADDR_ALTERNATE:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xD0), 1); // GET_ID
+        switch (registerValue) {
+        case 0x61:
+            LOG_INFO("BME-680 sensor found at address 0x%x\n", (uint8_t)addr.address);
+            type = BME_680;
+            break;
+        case 0x60:
+            LOG_INFO("BME-280 sensor found at address 0x%x\n", (uint8_t)addr.address);
+            type = BME_280;
+            break;
+        case 0x55:
+            LOG_INFO("BMP-085 or BMP-180 sensor found at address 0x%x\n", (uint8_t)addr.address);
+            type = BMP_085;
+            break;
+        default:
+            registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x00), 1); // GET_ID
+            switch (registerValue) {
+            case 0x50: // BMP-388 should be 0x50
+                LOG_INFO("BMP-388 sensor found at address 0x%x\n", (uint8_t)addr.address);
+                type = BMP_3XX;
                 break;
-#ifndef HAS_NCP5623
-            case AHT10_ADDR:
-                LOG_INFO("AHT10 sensor found at address 0x%x\n", (uint8_t)addr.address);
-                type = AHT10;
+            case 0x58: // BMP-280 should be 0x58
+            default:
+                LOG_INFO("BMP-280 sensor found at address 0x%x\n", (uint8_t)addr.address);
+                type = BMP_280;
                 break;
+            }
+            break;
+        }
+        break;
+#ifndef HAS_NCP5623
+    case AHT10_ADDR:
+        LOG_INFO("AHT10 sensor found at address 0x%x\n", (uint8_t)addr.address);
+        type = AHT10;
+        break;
 #endif
-            case INA_ADDR:
-            case INA_ADDR_ALTERNATE:
-            case INA_ADDR_WAVESHARE_UPS:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xFE), 2);
-                LOG_DEBUG("Register MFG_UID: 0x%x\n", registerValue);
-                if (registerValue == 0x5449) {
-                    LOG_INFO("INA260 sensor found at address 0x%x\n", (uint8_t)addr.address);
-                    type = INA260;
-                } else { // Assume INA219 if INA260 ID is not found
-                    LOG_INFO("INA219 sensor found at address 0x%x\n", (uint8_t)addr.address);
-                    type = INA219;
-                }
-                break;
-            case INA3221_ADDR:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xFE), 2);
-                LOG_DEBUG("Register MFG_UID: 0x%x\n", registerValue);
-                if (registerValue == 0x5449) {
-                    LOG_INFO("INA3221 sensor found at address 0x%x\n", (uint8_t)addr.address);
-                    type = INA3221;
-                } else {
-                    LOG_INFO("DFRobot Lark weather station found at address 0x%x\n", (uint8_t)addr.address);
-                    type = DFROBOT_LARK;
-                }
-                break;
-            case MCP9808_ADDR:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x07), 2);
-                if (registerValue == 0x0400) {
-                    type = MCP9808;
-                    LOG_INFO("MCP9808 sensor found\n");
-                } else {
-                    type = LIS3DH;
-                    LOG_INFO("LIS3DH accelerometer found\n");
-                }
+    case INA_ADDR:
+    case INA_ADDR_ALTERNATE:
+    case INA_ADDR_WAVESHARE_UPS:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xFE), 2);
+        LOG_DEBUG("Register MFG_UID: 0x%x\n", registerValue);
+        if (registerValue == 0x5449) {
+            LOG_INFO("INA260 sensor found at address 0x%x\n", (uint8_t)addr.address);
+            type = INA260;
+        } else { // Assume INA219 if INA260 ID is not found
+            LOG_INFO("INA219 sensor found at address 0x%x\n", (uint8_t)addr.address);
+            type = INA219;
+        }
+        break;
+    case INA3221_ADDR:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xFE), 2);
+        LOG_DEBUG("Register MFG_UID: 0x%x\n", registerValue);
+        if (registerValue == 0x5449) {
+            LOG_INFO("INA3221 sensor found at address 0x%x\n", (uint8_t)addr.address);
+            type = INA3221;
+        } else {
+            LOG_INFO("DFRobot Lark weather station found at address 0x%x\n", (uint8_t)addr.address);
+            type = DFROBOT_LARK;
+        }
+        break;
+    case MCP9808_ADDR:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x07), 2);
+        if (registerValue == 0x0400) {
+            type = MCP9808;
+            LOG_INFO("MCP9808 sensor found\n");
+        } else {
+            type = LIS3DH;
+            LOG_INFO("LIS3DH accelerometer found\n");
+        }
 
-                break;
+        break;
 
-            case SHT31_4x_ADDR:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x89), 2);
-                if (registerValue == 0x11a2 || registerValue == 0x11da || registerValue == 0xe9c) {
-                    type = SHT4X;
-                    LOG_INFO("SHT4X sensor found\n");
-                } else if (getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x7E), 2) == 0x5449) {
-                    type = OPT3001;
-                    LOG_INFO("OPT3001 light sensor found\n");
-                } else {
-                    type = SHT31;
-                    LOG_INFO("SHT31 sensor found\n");
-                }
+    case SHT31_4x_ADDR:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x89), 2);
+        if (registerValue == 0x11a2 || registerValue == 0x11da || registerValue == 0xe9c) {
+            type = SHT4X;
+            LOG_INFO("SHT4X sensor found\n");
+        } else if (getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x7E), 2) == 0x5449) {
+            type = OPT3001;
+            LOG_INFO("OPT3001 light sensor found\n");
+        } else {
+            type = SHT31;
+            LOG_INFO("SHT31 sensor found\n");
+        }
 
-                break;
+        break;
 
-                SCAN_SIMPLE_CASE(SHTC3_ADDR, SHTC3, "SHTC3 sensor found\n")
-                SCAN_SIMPLE_CASE(RCWL9620_ADDR, RCWL9620, "RCWL9620 sensor found\n")
-
-            case LPS22HB_ADDR_ALT:
-                SCAN_SIMPLE_CASE(LPS22HB_ADDR, LPS22HB, "LPS22HB sensor found\n")
-
-                SCAN_SIMPLE_CASE(QMC6310_ADDR, QMC6310, "QMC6310 Highrate 3-Axis magnetic sensor found\n")
-
-            case QMI8658_ADDR:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0A), 1); // get ID
-                if (registerValue == 0xC0) {
-                    type = BQ24295;
-                    LOG_INFO("BQ24295 PMU found\n");
-                    break;
-                }
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0F), 1); // get ID
-                if (registerValue == 0x6A) {
-                    type = LSM6DS3;
-                    LOG_INFO("LSM6DS3 accelerometer found at address 0x%x\n", (uint8_t)addr.address);
-                } else {
-                    type = QMI8658;
-                    LOG_INFO("QMI8658 Highrate 6-Axis inertial measurement sensor found\n");
-                }
-                break;
+        SCAN_SIMPLE_CASE(SHTC3_ADDR, SHTC3, "SHTC3 sensor found\n")
+        SCAN_SIMPLE_CASE(RCWL9620_ADDR, RCWL9620, "RCWL9620 sensor found\n")
 
-                SCAN_SIMPLE_CASE(QMC5883L_ADDR, QMC5883L, "QMC5883L Highrate 3-Axis magnetic sensor found\n")
+    case LPS22HB_ADDR_ALT:
+        SCAN_SIMPLE_CASE(LPS22HB_ADDR, LPS22HB, "LPS22HB sensor found\n")
 
-                SCAN_SIMPLE_CASE(PMSA0031_ADDR, PMSA0031, "PMSA0031 air quality sensor found\n")
-                SCAN_SIMPLE_CASE(MPU6050_ADDR, MPU6050, "MPU6050 accelerometer found\n");
-                SCAN_SIMPLE_CASE(BMX160_ADDR, BMX160, "BMX160 accelerometer found\n");
-                SCAN_SIMPLE_CASE(BMA423_ADDR, BMA423, "BMA423 accelerometer found\n");
-                SCAN_SIMPLE_CASE(LSM6DS3_ADDR, LSM6DS3, "LSM6DS3 accelerometer found at address 0x%x\n", (uint8_t)addr.address);
-                SCAN_SIMPLE_CASE(TCA9555_ADDR, TCA9555, "TCA9555 I2C expander found\n");
-                SCAN_SIMPLE_CASE(VEML7700_ADDR, VEML7700, "VEML7700 light sensor found\n");
-                SCAN_SIMPLE_CASE(TSL25911_ADDR, TSL2591, "TSL2591 light sensor found\n");
-                SCAN_SIMPLE_CASE(OPT3001_ADDR, OPT3001, "OPT3001 light sensor found\n");
-                SCAN_SIMPLE_CASE(MLX90632_ADDR, MLX90632, "MLX90632 IR temp sensor found\n");
-                SCAN_SIMPLE_CASE(NAU7802_ADDR, NAU7802, "NAU7802 based scale found\n");
+        SCAN_SIMPLE_CASE(QMC6310_ADDR, QMC6310, "QMC6310 Highrate 3-Axis magnetic sensor found\n")
 
-            default:
-                LOG_INFO("Device found at address 0x%x was not able to be enumerated\n", addr.address);
-            }
-        } else if (err == 4) {
-            LOG_ERROR("Unknown error at address 0x%x\n", addr.address);
+    case QMI8658_ADDR:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0A), 1); // get ID
+        if (registerValue == 0xC0) {
+            type = BQ24295;
+            LOG_INFO("BQ24295 PMU found\n");
+            break;
         }
-
-        // Check if a type was found for the enumerated device - save, if so
-        if (type != NONE) {
-            deviceAddresses[type] = addr;
-            foundDevices[addr] = type;
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0F), 1); // get ID
+        if (registerValue == 0x6A) {
+            type = LSM6DS3;
+            LOG_INFO("LSM6DS3 accelerometer found at address 0x%x\n", (uint8_t)addr.address);
+        } else {
+            type = QMI8658;
+            LOG_INFO("QMI8658 Highrate 6-Axis inertial measurement sensor found\n");
         }
+        break;
+
+        SCAN_SIMPLE_CASE(QMC5883L_ADDR, QMC5883L, "QMC5883L Highrate 3-Axis magnetic sensor found\n")
+
+        SCAN_SIMPLE_CASE(PMSA0031_ADDR, PMSA0031, "PMSA0031 air quality sensor found\n")
+        SCAN_SIMPLE_CASE(MPU6050_ADDR, MPU6050, "MPU6050 accelerometer found\n");
+        SCAN_SIMPLE_CASE(BMX160_ADDR, BMX160, "BMX160 accelerometer found\n");
+        SCAN_SIMPLE_CASE(BMA423_ADDR, BMA423, "BMA423 accelerometer found\n");
+        SCAN_SIMPLE_CASE(LSM6DS3_ADDR, LSM6DS3, "LSM6DS3 accelerometer found at address 0x%x\n", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(TCA9555_ADDR, TCA9555, "TCA9555 I2C expander found\n");
+        SCAN_SIMPLE_CASE(VEML7700_ADDR, VEML7700, "VEML7700 light sensor found\n");
+        SCAN_SIMPLE_CASE(TSL25911_ADDR, TSL2591, "TSL2591 light sensor found\n");
+        SCAN_SIMPLE_CASE(OPT3001_ADDR, OPT3001, "OPT3001 light sensor found\n");
+        SCAN_SIMPLE_CASE(MLX90632_ADDR, MLX90632, "MLX90632 IR temp sensor found\n");
+        SCAN_SIMPLE_CASE(NAU7802_ADDR, NAU7802, "NAU7802 based scale found\n");
+
+    default:
+        LOG_INFO("Device found at address 0x%x was not able to be enumerated\n", addr.address);
     }
+
+    return type;
 }
 
 void ScanI2CTwoWire::scanPort(I2CPort port)
 {
-    scanPort(port, nullptr, 0);
+    if (!useScanCache(port))
+        scanAddresses(port, nullptr, 0, false);
 }
 
 TwoWire *ScanI2CTwoWire::fetchI2CBus(ScanI2C::DeviceAddress address) const
@@ -7,6 +7,7 @@
 #include <memory>
 #include <stddef.h>
 #include <stdint.h>
+#include <vector>
 
 #include <Wire.h>
 
@@ -14,13 +15,33 @@
 
 #include "../concurrency/Lock.h"
 
+// What the last full scan found, so the next boot only has to check that it is still there. Gone after a factory reset
+// (with the rest of /prefs) or a change of the telemetry module config, then the next boot scans everything again.
+#define I2C_SCAN_CACHE_FILE "/prefs/i2cscan.bin"
+#define I2C_SCAN_CACHE_VERSION 1
+#define I2C_SCAN_CACHE_MAX_DEVICES 32
+
 class ScanI2CTwoWire : public ScanI2C
 {
   public:
+    /// Uses the scan cache if it still matches, see useScanCache()
     void scanPort(ScanI2C::I2CPort) override;
 
     void scanPort(ScanI2C::I2CPort, uint8_t *, uint8_t) override;
 
+    /// Only the devices setup() needs before the radio comes up: screens, PMU, RTCs, keyboards, RGB LED, accelerometers and
+    /// the air quality sensor. Uses the scan cache if it still matches, then everything is found right away.
+    void scanBootDevices(ScanI2C::I2CPort);
+
+    /// Everything scanBootDevices() leaves out, the sensors. Nothing to do if the port came from the scan cache.
+    void scanOtherDevices(ScanI2C::I2CPort);
+
+    /// Remember what was found for the next boot, if any port had to be scanned. Call once all ports are done.
+    void saveScanCache();
+
+    /// Make the next boot scan everything, e.g. because sensors were added or swapped
+    static void clearScanCache();
+
     ScanI2C::FoundDevice find(ScanI2C::DeviceType) const override;
 
     TwoWire *fetchI2CBus(ScanI2C::DeviceAddress) const;
@@ -46,6 +67,19 @@ class ScanI2CTwoWire : public ScanI2C
 
     typedef uint8_t ResponseWidth;
 
+    typedef struct CachedDevice {
+        uint8_t port;
+        uint8_t address;
+        uint8_t type; // NONE for the ones we couldn't enumerate, so they don't look new on the next boot
+    } CachedDevice;
+
+    typedef struct ScanCache {
+        uint8_t version;
+        uint32_t key; // See scanCacheKey()
+        uint8_t count;
+        CachedDevice devices[I2C_SCAN_CACHE_MAX_DEVICES];
+    } ScanCache;
+
     std::map<ScanI2C::DeviceAddress, ScanI2C::DeviceType> foundDevices;
 
     // note: prone to overwriting if multiple devices of a type are added at different addresses (rare?)
@@ -53,8 +87,30 @@ class ScanI2CTwoWire : public ScanI2C
 
     concurrency::Lock lock;
 
+    /// Every address that answered, for the scan cache
+    std::vector<CachedDevice> responding;
+
+    ScanCache cache = {};
+    bool cacheLoaded = false;
+    uint8_t cachedPorts = 0;  // Bit per I2CPort that came from the cache
+    uint8_t scannedPorts = 0; // Bit per I2CPort that had to be scanned
+
     void printATECCInfo() const;
 
+    /// Scan the listed addresses, or all the others if skipListed
+    void scanAddresses(ScanI2C::I2CPort, uint8_t *address, uint8_t asize, bool skipListed);
+
+    /// If the cached devices of this port all still answer, and nothing answers at the other addresses we know devices at,
+    /// take the cached devices without probing their registers again
+    bool useScanCache(ScanI2C::I2CPort);
+
+    bool ping(TwoWire *, uint8_t address) const;
+
+    /// Work out what answered at this address
+    DeviceType probeAddress(DeviceAddress, TwoWire *);
+
+    void addDevice(DeviceAddress, DeviceType);
+
     uint16_t getRegisterValue(const RegisterLocation &, ResponseWidth) const;
 
     DeviceType probeOLED(ScanI2C::DeviceAddress) const;
@@ -0,0 +1,147 @@
+#include "GNSSStreamParser.h"
+
+void GNSSStreamParser::reset()
+{
+    state = IDLE;
+    lineLen = 0;
+    lineBuf[0] = '\0';
+    lineDone = false;
+    frameLen = 0;
+    frameRead = 0;
+}
+
+GNSSStreamParser::Event GNSSStreamParser::feed(uint8_t c)
+{
+    switch (state) {
+    case IDLE:
+        if (c == 0xB5) {
+            state = UBX_SYNC2;
+            return NONE;
+        }
+        if (c == 0xBA) {
+            state = CAS_SYNC2;
+            return NONE;
+        }
+        return feedText(c);
+
+    // UBX: B5 62 class id len(2, LE) payload ck_a ck_b
+    case UBX_SYNC2:
+        state = (c == 0x62) ? UBX_CLASS : IDLE;
+        return NONE;
+    case UBX_CLASS:
+        ckA = ckB = 0;
+        ubxChecksum(c);
+        frameClass = c;
+        state = UBX_ID;
+        return NONE;
+    case UBX_ID:
+        ubxChecksum(c);
+        frameId = c;
+        state = UBX_LEN1;
+        return NONE;
+    case UBX_LEN1:
+        ubxChecksum(c);
+        frameLen = c;
+        state = UBX_LEN2;
+        return NONE;
+    case UBX_LEN2:
+        ubxChecksum(c);
+        frameLen |= (uint16_t)c << 8;
+        frameRead = 0;
+        // No frame we care about is this large, the length is corrupt. Resync instead of swallowing the stream.
+        if (frameLen > GNSS_PARSER_MAX_PAYLOAD)
+            state = IDLE;
+        else
+            state = frameLen ? UBX_PAYLOAD : UBX_CK_A;
+        return NONE;
+    case UBX_PAYLOAD:
+        ubxChecksum(c);
+        storePayload(c);
+        if (frameRead == frameLen)
+            state = UBX_CK_A;
+        return NONE;
+    case UBX_CK_A:
+        state = (c == ckA) ? UBX_CK_B : IDLE;
+        return NONE;
+    case UBX_CK_B:
+        state = IDLE;
+        return (c == ckB) ? UBX_FRAME : NONE;
+
+    // CASIC: BA CE len(2, LE) class id payload checksum(4)
+    case CAS_SYNC2:
+        state = (c == 0xCE) ? CAS_LEN1 : IDLE;
+        return NONE;
+    case CAS_LEN1:
+        frameLen = c;
+        state = CAS_LEN2;
+        return NONE;
+    case CAS_LEN2:
+        frameLen |= (uint16_t)c << 8;
+        state = (frameLen > GNSS_PARSER_MAX_PAYLOAD) ? IDLE : CAS_CLASS;
+        return NONE;
+    case CAS_CLASS:
+        frameClass = c;
+        state = CAS_ID;
+        return NONE;
+    case CAS_ID:
+        frameId = c;
+        frameRead = 0;
+        state = frameLen ? CAS_PAYLOAD : CAS_CK;
+        return NONE;
+    case CAS_PAYLOAD:
+        storePayload(c);
+        if (frameRead == frameLen) {
+            frameRead = 0;
+            state = CAS_CK;
+        }
+        return NONE;
+    case CAS_CK:
+        // The checksum is not verified, the class/id/payload match is what callers rely on
+        if (++frameRead < 4)
+            return NONE;
+        state = IDLE;
+        return CAS_FRAME;
+    }
+
+    state = IDLE;
+    return NONE;
+}
+
+GNSSStreamParser::Event GNSSStreamParser::feedText(uint8_t c)
+{
+    if (lineDone) {
+        lineLen = 0;
+        lineDone = false;
+    }
+
+    if (c == '\r' || c == '\n') {
+        if (lineLen == 0)
+            return NONE;
+        lineBuf[lineLen] = '\0';
+        lineDone = true;
+        return TEXT_LINE;
+    }
+
+    // A sentence start always begins a new line, even if the previous one was never terminated
+    if (c == '$')
+        lineLen = 0;
+
+    lineBuf[lineLen++] = c;
+    if (lineLen == GNSS_PARSER_MAX_LINE) {
+        lineBuf[lineLen] = '\0';
+        lineDone = true;
+        return TEXT_LINE;
+    }
+    return NONE;
+}
+
+void GNSSStreamParser::ubxChecksum(uint8_t c)
+{
+    ckA += c;
+    ckB += ckA;
+}
+
+void GNSSStreamParser::storePayload(uint8_t c)
+{
+    payloadBuf[frameRead++] = c;
+}
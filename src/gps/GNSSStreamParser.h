@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Largest UBX/CAS payload we accept (UBX-MON-VER with 10 extensions is 340 bytes). A larger length is taken as corrupt.
+#ifndef GNSS_PARSER_MAX_PAYLOAD
+#define GNSS_PARSER_MAX_PAYLOAD 400
+#endif
+
+// Longest text line we keep. Longer lines are reported truncated.
+#ifndef GNSS_PARSER_MAX_LINE
+#define GNSS_PARSER_MAX_LINE 128
+#endif
+
+/**
+ * Resumable parser for the byte stream coming from a GNSS module.
+ *
+ * Bytes are fed one at a time, in whatever chunks the UART happens to deliver them, and the parser reports when a complete
+ * text line (NMEA sentence or plain text), UBX frame or CASIC frame has been seen. Nothing blocks and no state lives on the
+ * caller's stack, so a response can be picked up across as many calls as it takes to arrive.
+ */
+class GNSSStreamParser
+{
+  public:
+    enum Event : uint8_t {
+        NONE,      // Need more bytes
+        TEXT_LINE, // line() holds a complete line, without the line ending
+        UBX_FRAME, // frameClass/frameId/payload describe a UBX frame with a valid checksum
+        CAS_FRAME, // frameClass/frameId/payload describe a CASIC frame
+    };
+
+    /// Feed one byte, returns what (if anything) it completed. Results stay valid until the next feed().
+    Event feed(uint8_t c);
+
+    /// Drop any partial line or frame
+    void reset();
+
+    const char *line() const { return lineBuf; }
+    uint16_t lineLength() const { return lineLen; }
+
+    uint8_t frameClass = 0;
+    uint8_t frameId = 0;
+    const uint8_t *payload() const { return payloadBuf; }
+    uint16_t payloadLength() const { return frameLen; }
+
+  private:
+    enum State : uint8_t {
+        IDLE,
+        UBX_SYNC2,
+        UBX_CLASS,
+        UBX_ID,
+        UBX_LEN1,
+        UBX_LEN2,
+        UBX_PAYLOAD,
+        UBX_CK_A,
+        UBX_CK_B,
+        CAS_SYNC2,
+        CAS_LEN1,
+        CAS_LEN2,
+        CAS_CLASS,
+        CAS_ID,
+        CAS_PAYLOAD,
+        CAS_CK,
+    };
+
+    Event feedText(uint8_t c);
+    void ubxChecksum(uint8_t c);
+    void storePayload(uint8_t c);
+
+    State state = IDLE;
+
+    char lineBuf[GNSS_PARSER_MAX_LINE + 1] = {0};
+    uint16_t lineLen = 0;
+    bool lineDone = false; // lineBuf holds a line that was already reported
+
+    uint8_t payloadBuf[GNSS_PARSER_MAX_PAYLOAD] = {0};
+    uint16_t frameLen = 0; // Length announced in the frame header
+    uint16_t frameRead = 0;
+    uint8_t ckA = 0, ckB = 0;
+};
@@ -1,5 +1,6 @@
 #include "configuration.h"
 #if !MESHTASTIC_EXCLUDE_GPS
+#include "BootTimeline.h"
 #include "Default.h"
 #include "GPS.h"
 #include "GpioLogic.h"
@@ -396,403 +397,634 @@ int GPS::getACK(uint8_t *buffer, uint16_t size, uint8_t requestedClass, uint8_t
     return 0;
 }
 
-bool GPS::setup()
+// Helpers to describe the steps of the probe / configuration sequences
+static GPSInitStep nmeaStep(const char *command, uint16_t settleMs)
 {
-    int msglen = 0;
+    GPSInitStep step = {};
+    step.kind = GPSInitStep::NMEA;
+    step.command = command;
+    step.settleMs = settleMs;
+    return step;
+}
 
-    if (!didSerialInit) {
-        if (tx_gpio && gnssModel == GNSS_MODEL_UNKNOWN) {
+// Send an NMEA command, and if the expected text comes back within timeoutMs we have found our model
+static GPSInitStep nmeaProbeStep(const char *command, const char *response, GnssModel_t model, uint16_t timeoutMs = 500)
+{
+    GPSInitStep step = nmeaStep(command, 0);
+    step.expect = GPSInitStep::EXPECT_TEXT;
+    step.response = response;
+    step.model = model;
+    step.timeoutMs = timeoutMs;
+    step.flags = GPSInitStep::CLEAR_FIRST;
+    return step;
+}
+
+static GPSInitStep ubxStep(uint8_t cls, uint8_t id, const uint8_t *payload, uint8_t payloadLen, uint16_t timeoutMs,
+                           const char *failMsg, uint16_t settleMs = 0, uint8_t flags = 0)
+{
+    GPSInitStep step = {};
+    step.kind = GPSInitStep::UBX;
+    step.expect = GPSInitStep::EXPECT_UBX_ACK;
+    step.cls = cls;
+    step.id = id;
+    step.payload = payload;
+    step.payloadLen = payloadLen;
+    step.timeoutMs = timeoutMs;
+    step.failMsg = failMsg;
+    step.settleMs = settleMs;
+    step.flags = flags;
+    return step;
+}
+
+static GPSInitStep casStep(uint8_t cls, uint8_t id, const uint8_t *payload, uint8_t payloadLen, uint16_t timeoutMs,
+                           const char *failMsg)
+{
+    GPSInitStep step = ubxStep(cls, id, payload, payloadLen, timeoutMs, failMsg);
+    step.kind = GPSInitStep::CAS;
+    step.expect = GPSInitStep::EXPECT_CAS_ACK;
+    return step;
+}
+
+static GPSInitStep baudStep(uint32_t baud, uint16_t settleMs)
+{
+    GPSInitStep step = {};
+    step.kind = GPSInitStep::BAUD;
+    step.baud = baud;
+    step.settleMs = settleMs;
+    return step;
+}
+
+static GPSInitStep waitStep(uint16_t settleMs)
+{
+    GPSInitStep step = {};
+    step.kind = GPSInitStep::WAIT;
+    step.settleMs = settleMs;
+    return step;
+}
+
+// UBX-CFG-PRT payload: UART1 at 9600 baud, 8N1, UBX+NMEA+RTCM in, UBX+NMEA out
+static const uint8_t _message_PRT_9600[] = {0x01, 0x00, 0x00, 0x00, 0xD0, 0x08, 0x00, 0x00, 0x80, 0x25,
+                                            0x00, 0x00, 0x07, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+// CAS-CFG-MSG payloads, ask the ATGM336H for only RMC and GGA
+static const uint8_t _message_CAS_CFG_MSG_RMC[] = {0x4e, CAS_NEMA_RMC, 0x01, 0x00};
+static const uint8_t _message_CAS_CFG_MSG_GGA[] = {0x4e, CAS_NEMA_GGA, 0x01, 0x00};
+
+void GPS::addInitStep(const GPSInitStep &step)
+{
+    if (initStepCount < GPS_MAX_INIT_STEPS)
+        initSteps[initStepCount++] = step;
+    else
+        LOG_ERROR("GPS init sequence too long, dropping step\n");
+}
+
+void GPS::clearInitSteps()
+{
+    initStepCount = 0;
+    initStepIndex = 0;
+    initStepState = STEP_PENDING;
+}
 
+void GPS::setBaud(uint32_t serialSpeed)
+{
+#if defined(ARCH_NRF52) || defined(ARCH_PORTDUINO) || defined(ARCH_RP2040) || defined(ARCH_STM32WL)
+    _serial_gps->end();
+    _serial_gps->begin(serialSpeed);
+#else
+    if (_serial_gps->baudRate() != serialSpeed) {
+        LOG_DEBUG("Setting Baud to %i\n", serialSpeed);
+        _serial_gps->updateBaudRate(serialSpeed);
+    }
+#endif
+}
+
+/**
+ * Probe for and configure the GNSS module without blocking.
+ *
+ * The work is a queue of steps (send a command, wait for its response or a timeout, let the module settle). Each call
+ * advances the queue as far as it can without waiting.
+ *
+ * @return 0 once probing and configuration are finished, otherwise the number of msecs until we should be called again
+ */
+int32_t GPS::runInit()
+{
+    if (initPhase == INIT_START) {
+        if (didSerialInit) {
+            initPhase = INIT_DONE;
+            return 0;
+        }
+        if (tx_gpio && gnssModel == GNSS_MODEL_UNKNOWN) {
             // if GPS_BAUDRATE is specified in variant (i.e. not 9600), skip to the specified rate.
             if (speedSelect == 0 && GPS_BAUDRATE != serialSpeeds[speedSelect]) {
                 speedSelect = std::find(serialSpeeds, std::end(serialSpeeds), GPS_BAUDRATE) - serialSpeeds;
             }
-
-            LOG_DEBUG("Probing for GPS at %d \n", serialSpeeds[speedSelect]);
-            gnssModel = probe(serialSpeeds[speedSelect]);
-            if (gnssModel == GNSS_MODEL_UNKNOWN) {
-                if (++speedSelect == sizeof(serialSpeeds) / sizeof(int)) {
-                    speedSelect = 0;
-                    if (--probeTries == 0) {
-                        LOG_WARN("Giving up on GPS probe and setting to 9600.\n");
-                        return true;
-                    }
-                }
-                return false;
-            }
+            queueProbe(serialSpeeds[speedSelect]);
+            initPhase = INIT_PROBING;
         } else {
             gnssModel = GNSS_MODEL_UNKNOWN;
+            queueConfig();
+            initPhase = INIT_CONFIGURING;
         }
+    }
 
-        if (gnssModel == GNSS_MODEL_MTK) {
-            /*
-             * t-beam-s3-core uses the same L76K GNSS module as t-echo.
-             * Unlike t-echo, L76K uses 9600 baud rate for communication by default.
-             * */
-
-            // Initialize the L76K Chip, use GPS + GLONASS + BEIDOU
-            _serial_gps->write("$PCAS04,7*1E\r\n");
-            delay(250);
-            // only ask for RMC and GGA
-            _serial_gps->write("$PCAS03,1,0,0,0,1,0,0,0,0,0,,,0,0*02\r\n");
-            delay(250);
-            // Switch to Vehicle Mode, since SoftRF enables Aviation < 2g
-            _serial_gps->write("$PCAS11,3*1E\r\n");
-            delay(250);
-        } else if (gnssModel == GNSS_MODEL_MTK_L76B) {
-            // Waveshare Pico-GPS hat uses the L76B with 9600 baud
-            // Initialize the L76B Chip, use GPS + GLONASS
-            // See note in L76_Series_GNSS_Protocol_Specification, chapter 3.29
-            _serial_gps->write("$PMTK353,1,1,0,0,0*2B\r\n");
-            // Above command will reset the GPS and takes longer before it will accept new commands
-            delay(1000);
-            // only ask for RMC and GGA (GNRMC and GNGGA)
-            // See note in L76_Series_GNSS_Protocol_Specification, chapter 2.1
-            _serial_gps->write("$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*28\r\n");
-            delay(250);
-            // Enable SBAS
-            _serial_gps->write("$PMTK301,2*2E\r\n");
-            delay(250);
-            // Enable PPS for 2D/3D fix only
-            _serial_gps->write("$PMTK285,3,100*3F\r\n");
-            delay(250);
-            // Switch to Fitness Mode, for running and walking purpose with low speed (<5 m/s)
-            _serial_gps->write("$PMTK886,1*29\r\n");
-            delay(250);
-        } else if (gnssModel == GNSS_MODEL_ATGM336H) {
-            // Set the intial configuration of the device - these _should_ work for most AT6558 devices
-            msglen = makeCASPacket(0x06, 0x07, sizeof(_message_CAS_CFG_NAVX_CONF), _message_CAS_CFG_NAVX_CONF);
-            _serial_gps->write(UBXscratch, msglen);
-            if (getACKCas(0x06, 0x07, 250) != GNSS_RESPONSE_OK) {
-                LOG_WARN("ATGM336H - Could not set Configuration");
-            }
+    if (initPhase == INIT_DONE)
+        return 0;
 
-            // Set the update frequence to 1Hz
-            msglen = makeCASPacket(0x06, 0x04, sizeof(_message_CAS_CFG_RATE_1HZ), _message_CAS_CFG_RATE_1HZ);
-            _serial_gps->write(UBXscratch, msglen);
-            if (getACKCas(0x06, 0x04, 250) != GNSS_RESPONSE_OK) {
-                LOG_WARN("ATGM336H - Could not set Update Frequency");
-            }
+    int32_t wait = runInitSteps();
+    if (wait > 0)
+        return wait;
+
+    if (initPhase == INIT_PROBING) {
+        if (gnssModel == GNSS_MODEL_UNKNOWN && ubloxResponded)
+            gnssModel = GNSS_MODEL_UBLOX;
 
-            // Set the NEMA output messages
-            // Ask for only RMC and GGA
-            uint8_t fields[] = {CAS_NEMA_RMC, CAS_NEMA_GGA};
-            for (unsigned int i = 0; i < sizeof(fields); i++) {
-                // Construct a CAS-CFG-MSG packet
-                uint8_t cas_cfg_msg_packet[] = {0x4e, fields[i], 0x01, 0x00};
-                msglen = makeCASPacket(0x06, 0x01, sizeof(cas_cfg_msg_packet), cas_cfg_msg_packet);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACKCas(0x06, 0x01, 250) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("ATGM336H - Could not enable NMEA MSG: %d\n", fields[i]);
+        if (gnssModel == GNSS_MODEL_UNKNOWN) {
+            if (++speedSelect == sizeof(serialSpeeds) / sizeof(int)) {
+                speedSelect = 0;
+                if (--probeTries == 0) {
+                    LOG_WARN("Giving up on GPS probe and setting to 9600.\n");
+                    initPhase = INIT_DONE;
+                    return 0;
                 }
             }
-        } else if (gnssModel == GNSS_MODEL_UC6580) {
-            // The Unicore UC6580 can use a lot of sat systems, enable it to
-            // use GPS L1 & L5 + BDS B1I & B2a + GLONASS L1 + GALILEO E1 & E5a + SBAS
-            // This will reset the receiver, so wait a bit afterwards
-            // The paranoid will wait for the OK*04 confirmation response after each command.
-            _serial_gps->write("$CFGSYS,h25155\r\n");
-            delay(750);
-            // Must be done after the CFGSYS command
-            // Turn off GSV messages, we don't really care about which and where the sats are, maybe someday.
-            _serial_gps->write("$CFGMSG,0,3,0\r\n");
-            delay(250);
-            // Turn off GSA messages, TinyGPS++ doesn't use this message.
-            _serial_gps->write("$CFGMSG,0,2,0\r\n");
-            delay(250);
-            // Turn off NOTICE __TXT messages, these may provide Unicore some info but we don't care.
-            _serial_gps->write("$CFGMSG,6,0,0\r\n");
-            delay(250);
-            _serial_gps->write("$CFGMSG,6,1,0\r\n");
-            delay(250);
-        } else if (gnssModel == GNSS_MODEL_AG3335 || gnssModel == GNSS_MODEL_AG3352) {
-
-            _serial_gps->write("$PAIR066,1,0,1,0,0,1*3B\r\n"); // Enable GPS+GALILEO+NAVIC
-
-            // Configure NMEA (sentences will output once per fix)
-            _serial_gps->write("$PAIR062,0,1*3F\r\n"); // GGA ON
-            _serial_gps->write("$PAIR062,1,0*3F\r\n"); // GLL OFF
-            _serial_gps->write("$PAIR062,2,0*3C\r\n"); // GSA OFF
-            _serial_gps->write("$PAIR062,3,0*3D\r\n"); // GSV OFF
-            _serial_gps->write("$PAIR062,4,1*3B\r\n"); // RMC ON
-            _serial_gps->write("$PAIR062,5,0*3B\r\n"); // VTG OFF
-            _serial_gps->write("$PAIR062,6,0*38\r\n"); // ZDA ON
-
-            delay(250);
-            _serial_gps->write("$PAIR513*3D\r\n"); // save configuration
-
-        } else if (gnssModel == GNSS_MODEL_UBLOX) {
-            // Configure GNSS system to GPS+SBAS+GLONASS (Module may restart after this command)
-            // We need set it because by default it is GPS only, and we want to use GLONASS too
-            // Also we need SBAS for better accuracy and extra features
-            // ToDo: Dynamic configure GNSS systems depending of LoRa region
-
-            if (strncmp(info.hwVersion, "000A0000", 8) != 0) {
-                if (strncmp(info.hwVersion, "00040007", 8) != 0) {
-                    // The original ublox Neo-6 is GPS only and doesn't support the UBX-CFG-GNSS message
-                    // Max7 seems to only support GPS *or* GLONASS
-                    // Neo-7 is supposed to support GPS *and* GLONASS but NAKs the CFG-GNSS command to do it
-                    // So treat all the u-blox 7 series as GPS only
-                    // M8 can support 3 constallations at once so turn on GPS, GLONASS and Galileo (or BeiDou)
-
-                    if (strncmp(info.hwVersion, "00070000", 8) == 0) {
-                        LOG_DEBUG("Setting GPS+SBAS\n");
-                        msglen = makeUBXPacket(0x06, 0x3e, sizeof(_message_GNSS_7), _message_GNSS_7);
-                        _serial_gps->write(UBXscratch, msglen);
-                    } else {
-                        msglen = makeUBXPacket(0x06, 0x3e, sizeof(_message_GNSS_8), _message_GNSS_8);
-                        _serial_gps->write(UBXscratch, msglen);
-                    }
-
-                    if (getACK(0x06, 0x3e, 800) == GNSS_RESPONSE_NAK) {
-                        // It's not critical if the module doesn't acknowledge this configuration.
-                        LOG_INFO("Unable to reconfigure GNSS - defaults maintained. Is this module GPS-only?\n");
-                    } else {
-                        if (strncmp(info.hwVersion, "00070000", 8) == 0) {
-                            LOG_INFO("GNSS configured for GPS+SBAS. Pause for 0.75s before sending next command.\n");
-                        } else {
-                            LOG_INFO(
-                                "GNSS configured for GPS+SBAS+GLONASS+Galileo. Pause for 0.75s before sending next command.\n");
-                        }
-                        // Documentation say, we need wait atleast 0.5s after reconfiguration of GNSS module, before sending next
-                        // commands for the M8 it tends to be more... 1 sec should be enough ;>)
-                        delay(1000);
-                    }
-                }
-                // Disable Text Info messages
-                msglen = makeUBXPacket(0x06, 0x02, sizeof(_message_DISABLE_TXT_INFO), _message_DISABLE_TXT_INFO);
+            initPhase = INIT_START; // Try again at the next speed
+            return 2000;
+        }
+
+        queueConfig();
+        initPhase = INIT_CONFIGURING;
+        return GPS_INIT_POLL_MS;
+    }
+
+    // Configuration sequence has finished
+    didSerialInit = true;
+    initPhase = INIT_DONE;
+    return 0;
+}
+
+/// Advance the step queue as far as possible. Returns 0 when the queue is empty, else msecs until it needs attention.
+int32_t GPS::runInitSteps()
+{
+    while (initStepIndex < initStepCount) {
+        const GPSInitStep &step = initSteps[initStepIndex];
+
+        if (initStepState == STEP_PENDING) {
+            if (step.flags & GPSInitStep::CLEAR_FIRST)
                 clearBuffer();
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x02, 500) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to disable text info messages.\n");
-                }
-                // ToDo add M10 tests for below
-                if (strncmp(info.hwVersion, "00080000", 8) == 0) {
-                    msglen = makeUBXPacket(0x06, 0x39, sizeof(_message_JAM_8), _message_JAM_8);
-                    clearBuffer();
-                    _serial_gps->write(UBXscratch, msglen);
-                    if (getACK(0x06, 0x39, 500) != GNSS_RESPONSE_OK) {
-                        LOG_WARN("Unable to enable interference resistance.\n");
-                    }
+            parser.reset();
+            sendInitStep(step);
+            initStepResponse = GNSS_RESPONSE_NONE;
+            initStepStartMs = millis();
+            initStepState = (step.expect == GPSInitStep::EXPECT_NONE) ? STEP_SETTLING : STEP_AWAITING;
+        }
 
-                    msglen = makeUBXPacket(0x06, 0x23, sizeof(_message_NAVX5_8), _message_NAVX5_8);
-                    clearBuffer();
-                    _serial_gps->write(UBXscratch, msglen);
-                    if (getACK(0x06, 0x23, 500) != GNSS_RESPONSE_OK) {
-                        LOG_WARN("Unable to configure NAVX5_8 settings.\n");
-                    }
-                } else {
-                    msglen = makeUBXPacket(0x06, 0x39, sizeof(_message_JAM_6_7), _message_JAM_6_7);
-                    _serial_gps->write(UBXscratch, msglen);
-                    if (getACK(0x06, 0x39, 500) != GNSS_RESPONSE_OK) {
-                        LOG_WARN("Unable to enable interference resistance.\n");
-                    }
-
-                    msglen = makeUBXPacket(0x06, 0x23, sizeof(_message_NAVX5), _message_NAVX5);
-                    _serial_gps->write(UBXscratch, msglen);
-                    if (getACK(0x06, 0x23, 500) != GNSS_RESPONSE_OK) {
-                        LOG_WARN("Unable to configure NAVX5 settings.\n");
-                    }
-                }
-                // Turn off unwanted NMEA messages, set update rate
+        if (initStepState == STEP_AWAITING) {
+            initStepResponse = pollInitStep(step);
+            if (initStepResponse == GNSS_RESPONSE_NONE && millis() - initStepStartMs < step.timeoutMs)
+                return GPS_INIT_POLL_MS; // Nothing yet, come back for more bytes
 
-                msglen = makeUBXPacket(0x06, 0x08, sizeof(_message_1HZ), _message_1HZ);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x08, 500) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to set GPS update rate.\n");
-                }
+            finishInitStep(step, initStepResponse);
+            initStepStartMs = millis();
+            initStepState = STEP_SETTLING;
+        }
 
-                msglen = makeUBXPacket(0x06, 0x01, sizeof(_message_GLL), _message_GLL);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x01, 500) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to disable NMEA GLL.\n");
-                }
+        // Give the module time to act on the command before the next one
+        uint32_t settleMs = step.settleMs;
+        if ((step.flags & GPSInitStep::ALLOW_NAK) && initStepResponse == GNSS_RESPONSE_NAK)
+            settleMs = 0;
+        uint32_t elapsed = millis() - initStepStartMs;
+        if (elapsed < settleMs)
+            return settleMs - elapsed;
 
-                msglen = makeUBXPacket(0x06, 0x01, sizeof(_message_GSA), _message_GSA);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x01, 500) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to Enable NMEA GSA.\n");
-                }
+        initStepIndex++;
+        initStepState = STEP_PENDING;
+    }
+    return 0;
+}
 
-                msglen = makeUBXPacket(0x06, 0x01, sizeof(_message_GSV), _message_GSV);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x01, 500) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to disable NMEA GSV.\n");
-                }
+void GPS::sendInitStep(const GPSInitStep &step)
+{
+    int msglen = 0;
 
-                msglen = makeUBXPacket(0x06, 0x01, sizeof(_message_VTG), _message_VTG);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x01, 500) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to disable NMEA VTG.\n");
-                }
+    switch (step.kind) {
+    case GPSInitStep::NMEA:
+        if (step.expect == GPSInitStep::EXPECT_TEXT)
+            LOG_DEBUG("Trying %s ...\n", step.response);
+        _serial_gps->write(step.command);
+        break;
+    case GPSInitStep::UBX:
+        msglen = makeUBXPacket(step.cls, step.id, step.payloadLen, step.payload);
+        _serial_gps->write(UBXscratch, msglen);
+        break;
+    case GPSInitStep::CAS:
+        msglen = makeCASPacket(step.cls, step.id, step.payloadLen, step.payload);
+        _serial_gps->write(UBXscratch, msglen);
+        break;
+    case GPSInitStep::BAUD:
+        setBaud(step.baud);
+        break;
+    case GPSInitStep::WAIT:
+        break;
+    }
+}
 
-                msglen = makeUBXPacket(0x06, 0x01, sizeof(_message_RMC), _message_RMC);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x01, 500) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to enable NMEA RMC.\n");
-                }
+/// Consume whatever bytes the UART has buffered, looking for the response this step expects
+GPS_RESPONSE GPS::pollInitStep(const GPSInitStep &step)
+{
+    while (_serial_gps->available() > 0) {
+        GNSSStreamParser::Event event = parser.feed(_serial_gps->read());
 
-                msglen = makeUBXPacket(0x06, 0x01, sizeof(_message_GGA), _message_GGA);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x01, 500) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to enable NMEA GGA.\n");
-                }
+        switch (step.expect) {
+        case GPSInitStep::EXPECT_TEXT:
+            if (event == GNSSStreamParser::TEXT_LINE && strstr(parser.line(), step.response))
+                return GNSS_RESPONSE_OK;
+            break;
+        case GPSInitStep::EXPECT_UBX_ACK:
+            if (event == GNSSStreamParser::TEXT_LINE && strstr(parser.line(), "More than 100 frame errors"))
+                return GNSS_RESPONSE_FRAME_ERRORS;
+            // UBX-ACK-ACK (05 01) or UBX-ACK-NAK (05 00), payload is the class and id being acknowledged
+            if (event == GNSSStreamParser::UBX_FRAME && parser.frameClass == 0x05 && parser.payloadLength() >= 2 &&
+                parser.payload()[0] == step.cls && parser.payload()[1] == step.id)
+                return parser.frameId == 0x01 ? GNSS_RESPONSE_OK : GNSS_RESPONSE_NAK;
+            break;
+        case GPSInitStep::EXPECT_CAS_ACK:
+            // CAS-ACK-ACK (05 01) or CAS-ACK-NACK (05 00), same layout as UBX
+            if (event == GNSSStreamParser::CAS_FRAME && parser.frameClass == 0x05 && parser.payloadLength() >= 2 &&
+                parser.payload()[0] == step.cls && parser.payload()[1] == step.id)
+                return parser.frameId == 0x01 ? GNSS_RESPONSE_OK : GNSS_RESPONSE_NAK;
+            break;
+        case GPSInitStep::EXPECT_UBX_REPLY:
+            if (event == GNSSStreamParser::UBX_FRAME && parser.frameClass == step.cls && parser.frameId == step.id) {
+                // The payload is only valid until the next byte is fed, so use it now
+                if (step.flags & GPSInitStep::READ_MONVER)
+                    parseMonVer(parser.payload(), parser.payloadLength());
+                return GNSS_RESPONSE_OK;
+            }
+            break;
+        case GPSInitStep::EXPECT_NONE:
+            break;
+        }
+    }
+    return GNSS_RESPONSE_NONE;
+}
 
-                if (uBloxProtocolVersion >= 18) {
-                    msglen = makeUBXPacket(0x06, 0x86, sizeof(_message_PMS), _message_PMS);
-                    clearBuffer();
-                    _serial_gps->write(UBXscratch, msglen);
-                    if (getACK(0x06, 0x86, 500) != GNSS_RESPONSE_OK) {
-                        LOG_WARN("Unable to enable powersaving for GPS.\n");
-                    }
-                    msglen = makeUBXPacket(0x06, 0x3B, sizeof(_message_CFG_PM2), _message_CFG_PM2);
-                    _serial_gps->write(UBXscratch, msglen);
-                    if (getACK(0x06, 0x3B, 500) != GNSS_RESPONSE_OK) {
-                        LOG_WARN("Unable to enable powersaving details for GPS.\n");
-                    }
-                    // For M8 we want to enable NMEA vserion 4.10 so we can see the additional sats.
-                    if (strncmp(info.hwVersion, "00080000", 8) == 0) {
-                        msglen = makeUBXPacket(0x06, 0x17, sizeof(_message_NMEA), _message_NMEA);
-                        clearBuffer();
-                        _serial_gps->write(UBXscratch, msglen);
-                        if (getACK(0x06, 0x17, 500) != GNSS_RESPONSE_OK) {
-                            LOG_WARN("Unable to enable NMEA 4.10.\n");
-                        }
-                    }
-                } else {
-                    if (strncmp(info.hwVersion, "00040007", 8) == 0) { // This PSM mode is only for Neo-6
-                        msglen = makeUBXPacket(0x06, 0x11, 0x2, _message_CFG_RXM_ECO);
-                        _serial_gps->write(UBXscratch, msglen);
-                        if (getACK(0x06, 0x11, 500) != GNSS_RESPONSE_OK) {
-                            LOG_WARN("Unable to enable powersaving ECO mode for Neo-6.\n");
-                        }
-                        msglen = makeUBXPacket(0x06, 0x3B, sizeof(_message_CFG_PM2), _message_CFG_PM2);
-                        _serial_gps->write(UBXscratch, msglen);
-                        if (getACK(0x06, 0x3B, 500) != GNSS_RESPONSE_OK) {
-                            LOG_WARN("Unable to enable powersaving details for GPS.\n");
-                        }
-                        msglen = makeUBXPacket(0x06, 0x01, sizeof(_message_AID), _message_AID);
-                        _serial_gps->write(UBXscratch, msglen);
-                        if (getACK(0x06, 0x01, 500) != GNSS_RESPONSE_OK) {
-                            LOG_WARN("Unable to disable UBX-AID.\n");
-                        }
-                    } else {
-                        msglen = makeUBXPacket(0x06, 0x11, 0x2, _message_CFG_RXM_PSM);
-                        _serial_gps->write(UBXscratch, msglen);
-                        if (getACK(0x06, 0x11, 500) != GNSS_RESPONSE_OK) {
-                            LOG_WARN("Unable to enable powersaving mode for GPS.\n");
-                        }
-
-                        msglen = makeUBXPacket(0x06, 0x3B, sizeof(_message_CFG_PM2), _message_CFG_PM2);
-                        _serial_gps->write(UBXscratch, msglen);
-                        if (getACK(0x06, 0x3B, 500) != GNSS_RESPONSE_OK) {
-                            LOG_WARN("Unable to enable powersaving details for GPS.\n");
-                        }
-                    }
-                }
-            } else {
-                // LOG_INFO("u-blox M10 hardware found.\n");
-                delay(1000);
-                // First disable all NMEA messages in RAM layer
-                msglen = makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_DISABLE_NMEA_RAM), _message_VALSET_DISABLE_NMEA_RAM);
-                clearBuffer();
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to disable NMEA messages for M10 GPS RAM.\n");
-                }
-                delay(250);
-                // Next disable unwanted NMEA messages in BBR layer
-                msglen = makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_DISABLE_NMEA_BBR), _message_VALSET_DISABLE_NMEA_BBR);
-                clearBuffer();
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to disable NMEA messages for M10 GPS BBR.\n");
-                }
-                delay(250);
-                // Disable Info txt messages in RAM layer
-                msglen =
-                    makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_DISABLE_TXT_INFO_RAM), _message_VALSET_DISABLE_TXT_INFO_RAM);
-                clearBuffer();
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to disable Info messages for M10 GPS RAM.\n");
-                }
-                delay(250);
-                // Next disable Info txt messages in BBR layer
-                msglen =
-                    makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_DISABLE_TXT_INFO_BBR), _message_VALSET_DISABLE_TXT_INFO_BBR);
-                clearBuffer();
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to disable Info messages for M10 GPS BBR.\n");
-                }
-                // Do M10 configuration for Power Management.
+void GPS::finishInitStep(const GPSInitStep &step, GPS_RESPONSE response)
+{
+    // A probe matched, we know our model so skip the remaining probes
+    if (step.model != GNSS_MODEL_UNKNOWN && response == GNSS_RESPONSE_OK) {
+        LOG_INFO("%s detected, using GNSS model %d\n", step.response, step.model);
+        gnssModel = step.model;
+        initStepCount = initStepIndex + 1;
+        return;
+    }
 
-                msglen = makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_PM_RAM), _message_VALSET_PM_RAM);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to enable powersaving for M10 GPS RAM.\n");
-                }
-                msglen = makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_PM_BBR), _message_VALSET_PM_BBR);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to enable powersaving for M10 GPS BBR.\n");
-                }
+    if (step.flags & GPSInitStep::UBLOX_PROBE) {
+        uint32_t baud = serialSpeeds[speedSelect];
+        if (response == GNSS_RESPONSE_NONE) {
+            LOG_WARN("Failed to find UBlox & MTK GNSS Module using baudrate %d\n", baud);
+            initStepCount = initStepIndex + 1; // Nothing left to try at this speed
+            return;
+        } else if (response == GNSS_RESPONSE_FRAME_ERRORS) {
+            LOG_INFO("UBlox Frame Errors using baudrate %d\n", baud);
+        } else if (response == GNSS_RESPONSE_OK) {
+            LOG_INFO("Found a UBlox Module using baudrate %d\n", baud);
+        }
+        ubloxResponded = true;
+        return;
+    }
 
-                delay(250);
-                msglen = makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_ITFM_RAM), _message_VALSET_ITFM_RAM);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to enable Jamming detection M10 GPS RAM.\n");
-                }
-                msglen = makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_ITFM_BBR), _message_VALSET_ITFM_BBR);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to enable Jamming detection M10 GPS BBR.\n");
-                }
+    if (response == GNSS_RESPONSE_OK) {
+        if (step.okMsg)
+            LOG_INFO("%s", step.okMsg);
+    } else if (step.failMsg) {
+        // Optional settings are allowed to time out, only report an explicit refusal
+        if (!(step.flags & GPSInitStep::ALLOW_NAK))
+            LOG_WARN("%s", step.failMsg);
+        else if (response == GNSS_RESPONSE_NAK)
+            LOG_INFO("%s", step.failMsg);
+    }
+}
 
-                // Here is where the init commands should go to do further M10 initialization.
-                delay(250);
-                msglen = makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_DISABLE_SBAS_RAM), _message_VALSET_DISABLE_SBAS_RAM);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to disable SBAS M10 GPS RAM.\n");
-                }
-                delay(750); // will cause a receiver restart so wait a bit
-                msglen = makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_DISABLE_SBAS_BBR), _message_VALSET_DISABLE_SBAS_BBR);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to disable SBAS M10 GPS BBR.\n");
-                }
-                delay(750); // will cause a receiver restart so wait a bit
-                // Done with initialization, Now enable wanted NMEA messages in BBR layer so they will survive a periodic sleep.
-                msglen = makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_ENABLE_NMEA_BBR), _message_VALSET_ENABLE_NMEA_BBR);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to enable messages for M10 GPS BBR.\n");
-                }
-                delay(250);
-                // Next enable wanted NMEA messages in RAM layer
-                msglen = makeUBXPacket(0x06, 0x8A, sizeof(_message_VALSET_ENABLE_NMEA_RAM), _message_VALSET_ENABLE_NMEA_RAM);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACK(0x06, 0x8A, 300) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("Unable to enable messages for M10 GPS RAM.\n");
-                }
-                // As the M10 has no flash, the best we can do to preserve the config is to set it in RAM and BBR.
-                // BBR will survive a restart, and power off for a while, but modules with small backup
-                // batteries or super caps will not retain the config for a long power off time.
+// Queue the probe sequence for one baud rate
+void GPS::queueProbe(int serialSpeed)
+{
+    clearInitSteps();
+    ubloxResponded = false;
+    memset(&info, 0, sizeof(struct uBloxGnssModelInfo));
+
+    LOG_DEBUG("Probing for GPS at %d \n", serialSpeed);
+    addInitStep(baudStep(serialSpeed, 100));
+
+    // Close all NMEA sentences, valid for L76K, ATGM336H (and likely other AT6558 devices)
+    addInitStep(nmeaStep("$PCAS03,0,0,0,0,0,0,0,0,0,0,,,0,0*02\r\n", 20));
+
+    // Unicore UFirebirdII Series: UC6580, UM620, UM621, UM670A, UM680A, or UM681A
+    addInitStep(nmeaProbeStep("$PDTINFO\r\n", "UC6580", GNSS_MODEL_UC6580));
+    addInitStep(nmeaProbeStep("$PDTINFO\r\n", "UM600", GNSS_MODEL_UC6580));
+    addInitStep(nmeaProbeStep("$PCAS06,1*1A\r\n", "$GPTXT,01,01,02,HW=ATGM336H", GNSS_MODEL_ATGM336H));
+    /* ATGM332D series (-11(GPS), -21(BDS), -31(GPS+BDS), -51(GPS+GLONASS), -71-0(GPS+BDS+GLONASS))
+    based on AT6558 */
+    addInitStep(nmeaProbeStep("$PCAS06,1*1A\r\n", "$GPTXT,01,01,02,HW=ATGM332D", GNSS_MODEL_ATGM336H));
+
+    /* Airoha (Mediatek) AG3335A/M/S, A3352Q, Quectel L89 2.0, SimCom SIM65M */
+    addInitStep(nmeaStep("$PAIR062,2,0*3C\r\n", 0)); // GSA OFF to reduce volume
+    addInitStep(nmeaStep("$PAIR062,3,0*3D\r\n", 0)); // GSV OFF to reduce volume
+    addInitStep(nmeaStep("$PAIR513*3D\r\n", 0));     // save configuration
+    addInitStep(nmeaProbeStep("$PAIR021*39\r\n", "$PAIR021,AG3335", GNSS_MODEL_AG3335));
+    addInitStep(nmeaProbeStep("$PAIR021*39\r\n", "$PAIR021,AG3352", GNSS_MODEL_AG3352));
+    addInitStep(nmeaProbeStep("$PQTMVERNO*58\r\n", "$PQTMVERNO,LC86", GNSS_MODEL_AG3352));
+
+    addInitStep(nmeaProbeStep("$PCAS06,0*1B\r\n", "$GPTXT,01,01,02,SW=", GNSS_MODEL_MTK));
+
+    // Close all NMEA sentences, valid for L76B MTK platform (Waveshare Pico GPS)
+    addInitStep(nmeaStep("$PMTK514,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*2E\r\n", 20));
+
+    addInitStep(nmeaProbeStep("$PMTK605*31\r\n", "Quectel-L76B", GNSS_MODEL_MTK_L76B));
+
+    // Poll UBX-CFG-RATE and check that the returned response class and message ID are correct
+    addInitStep(ubxStep(0x06, 0x08, NULL, 0, 750, NULL, 0, GPSInitStep::CLEAR_FIRST | GPSInitStep::UBLOX_PROBE));
+
+    // tips: NMEA Only should not be set here, otherwise initializing Ublox gnss module again after
+    // setting will not output command messages in UART1, resulting in unrecognized module information
+    if (serialSpeed != 9600) {
+        // Set the UART port to 9600
+        GPSInitStep prt = ubxStep(0x06, 0x00, _message_PRT_9600, sizeof(_message_PRT_9600), 0, NULL, 500);
+        prt.expect = GPSInitStep::EXPECT_NONE;
+        addInitStep(prt);
+        addInitStep(baudStep(9600, 200));
+    }
+
+    //  Get Ublox gnss module hardware and software info (UBX-MON-VER)
+    GPSInitStep monver = ubxStep(0x0A, 0x04, NULL, 0, 1200, NULL, 0, GPSInitStep::CLEAR_FIRST | GPSInitStep::READ_MONVER);
+    monver.expect = GPSInitStep::EXPECT_UBX_REPLY;
+    addInitStep(monver);
+}
+
+// Parse a UBX-MON-VER reply into info and uBloxProtocolVersion
+void GPS::parseMonVer(const uint8_t *buffer, uint16_t len)
+{
+    char text[32] = {0};
+    uint16_t position = 0;
+
+    if (len < 40)
+        return;
+
+    for (int i = 0; i < 30; i++) {
+        info.swVersion[i] = buffer[position];
+        position++;
+    }
+    for (int i = 0; i < 10; i++) {
+        info.hwVersion[i] = buffer[position];
+        position++;
+    }
+
+    while (len >= position + 30) {
+        for (int i = 0; i < 30; i++) {
+            info.extension[info.extensionNo][i] = buffer[position];
+            position++;
+        }
+        info.extensionNo++;
+        if (info.extensionNo > 9)
+            break;
+    }
+
+    LOG_DEBUG("Module Info : \n");
+    LOG_DEBUG("Soft version: %s\n", info.swVersion);
+    LOG_DEBUG("Hard version: %s\n", info.hwVersion);
+    LOG_DEBUG("Extensions:%d\n", info.extensionNo);
+    for (int i = 0; i < info.extensionNo; i++) {
+        LOG_DEBUG("  %s\n", info.extension[i]);
+    }
+
+    // tips: extensionNo field is 0 on some 6M GNSS modules
+    for (int i = 0; i < info.extensionNo; ++i) {
+        if (!strncmp(info.extension[i], "MOD=", 4)) {
+            strncpy(text, &(info.extension[i][4]), sizeof(text) - 1);
+            if (strlen(text)) {
+                LOG_INFO("UBlox GNSS probe succeeded, using UBlox %s GNSS Module\n", text);
+            } else {
+                LOG_INFO("UBlox GNSS probe succeeded, using UBlox GNSS Module\n");
             }
-            msglen = makeUBXPacket(0x06, 0x09, sizeof(_message_SAVE), _message_SAVE);
-            _serial_gps->write(UBXscratch, msglen);
-            if (getACK(0x06, 0x09, 2000) != GNSS_RESPONSE_OK) {
-                LOG_WARN("Unable to save GNSS module configuration.\n");
+        } else if (!strncmp(info.extension[i], "PROTVER", 7)) {
+            char *ptr = nullptr;
+            memset(text, 0, sizeof(text));
+            strncpy(text, &(info.extension[i][8]), sizeof(text) - 1);
+            LOG_DEBUG("Protocol Version:%s\n", text);
+            if (strlen(text)) {
+                uBloxProtocolVersion = strtoul(text, &ptr, 10);
+                LOG_DEBUG("ProtVer=%d\n", uBloxProtocolVersion);
             } else {
-                LOG_INFO("GNSS module configuration saved!\n");
+                uBloxProtocolVersion = 0;
             }
         }
-        didSerialInit = true;
     }
+}
 
+// Queue the configuration sequence for the model we found
+void GPS::queueConfig()
+{
+    clearInitSteps();
+
+    if (gnssModel == GNSS_MODEL_MTK) {
+        /*
+         * t-beam-s3-core uses the same L76K GNSS module as t-echo.
+         * Unlike t-echo, L76K uses 9600 baud rate for communication by default.
+         * */
+
+        // Initialize the L76K Chip, use GPS + GLONASS + BEIDOU
+        addInitStep(nmeaStep("$PCAS04,7*1E\r\n", 250));
+        // only ask for RMC and GGA
+        addInitStep(nmeaStep("$PCAS03,1,0,0,0,1,0,0,0,0,0,,,0,0*02\r\n", 250));
+        // Switch to Vehicle Mode, since SoftRF enables Aviation < 2g
+        addInitStep(nmeaStep("$PCAS11,3*1E\r\n", 250));
+    } else if (gnssModel == GNSS_MODEL_MTK_L76B) {
+        // Waveshare Pico-GPS hat uses the L76B with 9600 baud
+        // Initialize the L76B Chip, use GPS + GLONASS
+        // See note in L76_Series_GNSS_Protocol_Specification, chapter 3.29
+        // This command will reset the GPS and takes longer before it will accept new commands
+        addInitStep(nmeaStep("$PMTK353,1,1,0,0,0*2B\r\n", 1000));
+        // only ask for RMC and GGA (GNRMC and GNGGA)
+        // See note in L76_Series_GNSS_Protocol_Specification, chapter 2.1
+        addInitStep(nmeaStep("$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*28\r\n", 250));
+        // Enable SBAS
+        addInitStep(nmeaStep("$PMTK301,2*2E\r\n", 250));
+        // Enable PPS for 2D/3D fix only
+        addInitStep(nmeaStep("$PMTK285,3,100*3F\r\n", 250));
+        // Switch to Fitness Mode, for running and walking purpose with low speed (<5 m/s)
+        addInitStep(nmeaStep("$PMTK886,1*29\r\n", 250));
+    } else if (gnssModel == GNSS_MODEL_ATGM336H) {
+        // Set the intial configuration of the device - these _should_ work for most AT6558 devices
+        addInitStep(casStep(0x06, 0x07, _message_CAS_CFG_NAVX_CONF, sizeof(_message_CAS_CFG_NAVX_CONF), 250,
+                            "ATGM336H - Could not set Configuration\n"));
+        // Set the update frequence to 1Hz
+        addInitStep(casStep(0x06, 0x04, _message_CAS_CFG_RATE_1HZ, sizeof(_message_CAS_CFG_RATE_1HZ), 250,
+                            "ATGM336H - Could not set Update Frequency\n"));
+        // Set the NEMA output messages
+        // Ask for only RMC and GGA
+        addInitStep(casStep(0x06, 0x01, _message_CAS_CFG_MSG_RMC, sizeof(_message_CAS_CFG_MSG_RMC), 250,
+                            "ATGM336H - Could not enable NMEA MSG: RMC\n"));
+        addInitStep(casStep(0x06, 0x01, _message_CAS_CFG_MSG_GGA, sizeof(_message_CAS_CFG_MSG_GGA), 250,
+                            "ATGM336H - Could not enable NMEA MSG: GGA\n"));
+    } else if (gnssModel == GNSS_MODEL_UC6580) {
+        // The Unicore UC6580 can use a lot of sat systems, enable it to
+        // use GPS L1 & L5 + BDS B1I & B2a + GLONASS L1 + GALILEO E1 & E5a + SBAS
+        // This will reset the receiver, so wait a bit afterwards
+        // The paranoid will wait for the OK*04 confirmation response after each command.
+        addInitStep(nmeaStep("$CFGSYS,h25155\r\n", 750));
+        // Must be done after the CFGSYS command
+        // Turn off GSV messages, we don't really care about which and where the sats are, maybe someday.
+        addInitStep(nmeaStep("$CFGMSG,0,3,0\r\n", 250));
+        // Turn off GSA messages, TinyGPS++ doesn't use this message.
+        addInitStep(nmeaStep("$CFGMSG,0,2,0\r\n", 250));
+        // Turn off NOTICE __TXT messages, these may provide Unicore some info but we don't care.
+        addInitStep(nmeaStep("$CFGMSG,6,0,0\r\n", 250));
+        addInitStep(nmeaStep("$CFGMSG,6,1,0\r\n", 250));
+    } else if (gnssModel == GNSS_MODEL_AG3335 || gnssModel == GNSS_MODEL_AG3352) {
+        addInitStep(nmeaStep("$PAIR066,1,0,1,0,0,1*3B\r\n", 0)); // Enable GPS+GALILEO+NAVIC
+
+        // Configure NMEA (sentences will output once per fix)
+        addInitStep(nmeaStep("$PAIR062,0,1*3F\r\n", 0)); // GGA ON
+        addInitStep(nmeaStep("$PAIR062,1,0*3F\r\n", 0)); // GLL OFF
+        addInitStep(nmeaStep("$PAIR062,2,0*3C\r\n", 0)); // GSA OFF
+        addInitStep(nmeaStep("$PAIR062,3,0*3D\r\n", 0)); // GSV OFF
+        addInitStep(nmeaStep("$PAIR062,4,1*3B\r\n", 0)); // RMC ON
+        addInitStep(nmeaStep("$PAIR062,5,0*3B\r\n", 0)); // VTG OFF
+        addInitStep(nmeaStep("$PAIR062,6,0*38\r\n", 250)); // ZDA ON
+        addInitStep(nmeaStep("$PAIR513*3D\r\n", 0));       // save configuration
+    } else if (gnssModel == GNSS_MODEL_UBLOX) {
+        queueConfigUBlox();
+    }
+}
+
+void GPS::queueConfigUBlox()
+{
+    // Configure GNSS system to GPS+SBAS+GLONASS (Module may restart after this command)
+    // We need set it because by default it is GPS only, and we want to use GLONASS too
+    // Also we need SBAS for better accuracy and extra features
+    // ToDo: Dynamic configure GNSS systems depending of LoRa region
+
+    if (strncmp(info.hwVersion, "000A0000", 8) != 0) {
+        if (strncmp(info.hwVersion, "00040007", 8) != 0) {
+            // The original ublox Neo-6 is GPS only and doesn't support the UBX-CFG-GNSS message
+            // Max7 seems to only support GPS *or* GLONASS
+            // Neo-7 is supposed to support GPS *and* GLONASS but NAKs the CFG-GNSS command to do it
+            // So treat all the u-blox 7 series as GPS only
+            // M8 can support 3 constallations at once so turn on GPS, GLONASS and Galileo (or BeiDou)
+
+            // It's not critical if the module doesn't acknowledge this configuration.
+            // Documentation say, we need wait atleast 0.5s after reconfiguration of GNSS module, before sending next
+            // commands for the M8 it tends to be more... 1 sec should be enough ;>)
+            GPSInitStep gnss;
+            if (strncmp(info.hwVersion, "00070000", 8) == 0) {
+                LOG_DEBUG("Setting GPS+SBAS\n");
+                gnss = ubxStep(0x06, 0x3e, _message_GNSS_7, sizeof(_message_GNSS_7), 800,
+                               "Unable to reconfigure GNSS - defaults maintained. Is this module GPS-only?\n", 1000,
+                               GPSInitStep::ALLOW_NAK);
+                gnss.okMsg = "GNSS configured for GPS+SBAS.\n";
+            } else {
+                gnss = ubxStep(0x06, 0x3e, _message_GNSS_8, sizeof(_message_GNSS_8), 800,
+                               "Unable to reconfigure GNSS - defaults maintained. Is this module GPS-only?\n", 1000,
+                               GPSInitStep::ALLOW_NAK);
+                gnss.okMsg = "GNSS configured for GPS+SBAS+GLONASS+Galileo.\n";
+            }
+            addInitStep(gnss);
+        }
+        // Disable Text Info messages
+        addInitStep(ubxStep(0x06, 0x02, _message_DISABLE_TXT_INFO, sizeof(_message_DISABLE_TXT_INFO), 500,
+                            "Unable to disable text info messages.\n", 0, GPSInitStep::CLEAR_FIRST));
+        // ToDo add M10 tests for below
+        if (strncmp(info.hwVersion, "00080000", 8) == 0) {
+            addInitStep(ubxStep(0x06, 0x39, _message_JAM_8, sizeof(_message_JAM_8), 500,
+                                "Unable to enable interference resistance.\n", 0, GPSInitStep::CLEAR_FIRST));
+            addInitStep(ubxStep(0x06, 0x23, _message_NAVX5_8, sizeof(_message_NAVX5_8), 500,
+                                "Unable to configure NAVX5_8 settings.\n", 0, GPSInitStep::CLEAR_FIRST));
+        } else {
+            addInitStep(ubxStep(0x06, 0x39, _message_JAM_6_7, sizeof(_message_JAM_6_7), 500,
+                                "Unable to enable interference resistance.\n"));
+            addInitStep(
+                ubxStep(0x06, 0x23, _message_NAVX5, sizeof(_message_NAVX5), 500, "Unable to configure NAVX5 settings.\n"));
+        }
+        // Turn off unwanted NMEA messages, set update rate
+        addInitStep(ubxStep(0x06, 0x08, _message_1HZ, sizeof(_message_1HZ), 500, "Unable to set GPS update rate.\n"));
+        addInitStep(ubxStep(0x06, 0x01, _message_GLL, sizeof(_message_GLL), 500, "Unable to disable NMEA GLL.\n"));
+        addInitStep(ubxStep(0x06, 0x01, _message_GSA, sizeof(_message_GSA), 500, "Unable to Enable NMEA GSA.\n"));
+        addInitStep(ubxStep(0x06, 0x01, _message_GSV, sizeof(_message_GSV), 500, "Unable to disable NMEA GSV.\n"));
+        addInitStep(ubxStep(0x06, 0x01, _message_VTG, sizeof(_message_VTG), 500, "Unable to disable NMEA VTG.\n"));
+        addInitStep(ubxStep(0x06, 0x01, _message_RMC, sizeof(_message_RMC), 500, "Unable to enable NMEA RMC.\n"));
+        addInitStep(ubxStep(0x06, 0x01, _message_GGA, sizeof(_message_GGA), 500, "Unable to enable NMEA GGA.\n"));
+
+        if (uBloxProtocolVersion >= 18) {
+            addInitStep(ubxStep(0x06, 0x86, _message_PMS, sizeof(_message_PMS), 500, "Unable to enable powersaving for GPS.\n",
+                                0, GPSInitStep::CLEAR_FIRST));
+            addInitStep(ubxStep(0x06, 0x3B, _message_CFG_PM2, sizeof(_message_CFG_PM2), 500,
+                                "Unable to enable powersaving details for GPS.\n"));
+            // For M8 we want to enable NMEA vserion 4.10 so we can see the additional sats.
+            if (strncmp(info.hwVersion, "00080000", 8) == 0) {
+                addInitStep(ubxStep(0x06, 0x17, _message_NMEA, sizeof(_message_NMEA), 500, "Unable to enable NMEA 4.10.\n", 0,
+                                    GPSInitStep::CLEAR_FIRST));
+            }
+        } else {
+            if (strncmp(info.hwVersion, "00040007", 8) == 0) { // This PSM mode is only for Neo-6
+                addInitStep(ubxStep(0x06, 0x11, _message_CFG_RXM_ECO, 0x2, 500,
+                                    "Unable to enable powersaving ECO mode for Neo-6.\n"));
+                addInitStep(ubxStep(0x06, 0x3B, _message_CFG_PM2, sizeof(_message_CFG_PM2), 500,
+                                    "Unable to enable powersaving details for GPS.\n"));
+                addInitStep(ubxStep(0x06, 0x01, _message_AID, sizeof(_message_AID), 500, "Unable to disable UBX-AID.\n"));
+            } else {
+                addInitStep(
+                    ubxStep(0x06, 0x11, _message_CFG_RXM_PSM, 0x2, 500, "Unable to enable powersaving mode for GPS.\n"));
+                addInitStep(ubxStep(0x06, 0x3B, _message_CFG_PM2, sizeof(_message_CFG_PM2), 500,
+                                    "Unable to enable powersaving details for GPS.\n"));
+            }
+        }
+    } else {
+        // LOG_INFO("u-blox M10 hardware found.\n");
+        addInitStep(waitStep(1000));
+        // First disable all NMEA messages in RAM layer
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_DISABLE_NMEA_RAM, sizeof(_message_VALSET_DISABLE_NMEA_RAM), 300,
+                            "Unable to disable NMEA messages for M10 GPS RAM.\n", 250, GPSInitStep::CLEAR_FIRST));
+        // Next disable unwanted NMEA messages in BBR layer
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_DISABLE_NMEA_BBR, sizeof(_message_VALSET_DISABLE_NMEA_BBR), 300,
+                            "Unable to disable NMEA messages for M10 GPS BBR.\n", 250, GPSInitStep::CLEAR_FIRST));
+        // Disable Info txt messages in RAM layer
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_DISABLE_TXT_INFO_RAM, sizeof(_message_VALSET_DISABLE_TXT_INFO_RAM), 300,
+                            "Unable to disable Info messages for M10 GPS RAM.\n", 250, GPSInitStep::CLEAR_FIRST));
+        // Next disable Info txt messages in BBR layer
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_DISABLE_TXT_INFO_BBR, sizeof(_message_VALSET_DISABLE_TXT_INFO_BBR), 300,
+                            "Unable to disable Info messages for M10 GPS BBR.\n", 0, GPSInitStep::CLEAR_FIRST));
+        // Do M10 configuration for Power Management.
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_PM_RAM, sizeof(_message_VALSET_PM_RAM), 300,
+                            "Unable to enable powersaving for M10 GPS RAM.\n"));
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_PM_BBR, sizeof(_message_VALSET_PM_BBR), 300,
+                            "Unable to enable powersaving for M10 GPS BBR.\n", 250));
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_ITFM_RAM, sizeof(_message_VALSET_ITFM_RAM), 300,
+                            "Unable to enable Jamming detection M10 GPS RAM.\n"));
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_ITFM_BBR, sizeof(_message_VALSET_ITFM_BBR), 300,
+                            "Unable to enable Jamming detection M10 GPS BBR.\n", 250));
+        // Here is where the init commands should go to do further M10 initialization.
+        // Disabling SBAS will cause a receiver restart so wait a bit
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_DISABLE_SBAS_RAM, sizeof(_message_VALSET_DISABLE_SBAS_RAM), 300,
+                            "Unable to disable SBAS M10 GPS RAM.\n", 750));
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_DISABLE_SBAS_BBR, sizeof(_message_VALSET_DISABLE_SBAS_BBR), 300,
+                            "Unable to disable SBAS M10 GPS BBR.\n", 750));
+        // Done with initialization, Now enable wanted NMEA messages in BBR layer so they will survive a periodic sleep.
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_ENABLE_NMEA_BBR, sizeof(_message_VALSET_ENABLE_NMEA_BBR), 300,
+                            "Unable to enable messages for M10 GPS BBR.\n", 250));
+        // Next enable wanted NMEA messages in RAM layer
+        addInitStep(ubxStep(0x06, 0x8A, _message_VALSET_ENABLE_NMEA_RAM, sizeof(_message_VALSET_ENABLE_NMEA_RAM), 300,
+                            "Unable to enable messages for M10 GPS RAM.\n"));
+        // As the M10 has no flash, the best we can do to preserve the config is to set it in RAM and BBR.
+        // BBR will survive a restart, and power off for a while, but modules with small backup
+        // batteries or super caps will not retain the config for a long power off time.
+    }
+    GPSInitStep save =
+        ubxStep(0x06, 0x09, _message_SAVE, sizeof(_message_SAVE), 2000, "Unable to save GNSS module configuration.\n");
+    save.okMsg = "GNSS module configuration saved!\n";
+    addInitStep(save);
+}
+
+bool GPS::setup()
+{
     notifyDeepSleepObserver.observe(&notifyDeepSleep);
 
     return true;
@@ -1074,8 +1306,16 @@ int32_t GPS::runOnce()
             LOG_INFO("GPS set to not-present. Skipping probe.\n");
             return disable();
         }
-        if (!setup())
-            return 2000; // Setup failed, re-run in two seconds
+        if (!GPSInitStarted) {
+            GPSInitStarted = true;
+            bootPhase = bootTimeline.begin("gps probe");
+        }
+        // Probing and configuring the module is done in steps, so we never stall the main loop waiting on it
+        int32_t initWait = runInit();
+        if (initWait > 0)
+            return initWait;
+        bootTimeline.end(bootPhase);
+        setup();
 
         // We have now loaded our saved preferences from flash
         if (config.position.gps_mode != meshtastic_Config_PositionConfig_GpsMode_ENABLED) {
@@ -1122,14 +1362,18 @@ int32_t GPS::runOnce()
     if (!config.position.fixed_position && powerState != GPS_ACTIVE && scheduling.isUpdateDue())
         up();
 
+    // Time and location only change when a sentence carrying them completes, so only look at them then
+    bool fixEvent = fixPending;
+    fixPending = false;
+
     // If we've already set time from the GPS, no need to ask the GPS
     bool gotTime = (getRTCQuality() >= RTCQualityGPS);
-    if (!gotTime && lookForTime()) { // Note: we count on this && short-circuiting and not resetting the RTC time
+    if (fixEvent && !gotTime && lookForTime()) { // Note: we count on this && short-circuiting and not resetting the RTC time
         gotTime = true;
         shouldPublish = true;
     }
 
-    bool gotLoc = lookForLocation();
+    bool gotLoc = fixEvent && lookForLocation();
     if (gotLoc && !hasValidLocation) { // declare that we have location ASAP
         LOG_DEBUG("hasValidLocation RISING EDGE\n");
         hasValidLocation = true;
@@ -1163,6 +1407,10 @@ int32_t GPS::runOnce()
     if (config.position.fixed_position == true && hasValidLocation)
         return disable(); // This should trigger when we have a fixed position, and get that first position
 
+    // Come straight back for whatever the ingest budget left in the receive buffer
+    if (powerState == GPS_ACTIVE && ingestBacklog)
+        return 0;
+
     // 9600bps is approx 1 byte per msec, so considering our buffer size we never need to wake more often than 200ms
     // if not awake we can run super infrquently (once every 5 secs?) to see if we need to wake.
     return (powerState == GPS_ACTIVE) ? GPS_THREAD_INTERVAL : 5000;
@@ -1184,166 +1432,6 @@ int GPS::prepareDeepSleep(void *unused)
     return 0;
 }
 
-#define PROBE_SIMPLE(CHIP, TOWRITE, RESPONSE, DRIVER, TIMEOUT, ...)                                                              \
-    LOG_DEBUG("Trying " TOWRITE " (" CHIP ") ...\n");                                                                            \
-    clearBuffer();                                                                                                               \
-    _serial_gps->write(TOWRITE "\r\n");                                                                                          \
-    if (getACK(RESPONSE, TIMEOUT) == GNSS_RESPONSE_OK) {                                                                         \
-        LOG_INFO(CHIP " detected, using " #DRIVER " Module\n");                                                                  \
-        return DRIVER;                                                                                                           \
-    }
-
-GnssModel_t GPS::probe(int serialSpeed)
-{
-#if defined(ARCH_NRF52) || defined(ARCH_PORTDUINO) || defined(ARCH_RP2040) || defined(ARCH_STM32WL)
-    _serial_gps->end();
-    _serial_gps->begin(serialSpeed);
-#else
-    if (_serial_gps->baudRate() != serialSpeed) {
-        LOG_DEBUG("Setting Baud to %i\n", serialSpeed);
-        _serial_gps->updateBaudRate(serialSpeed);
-    }
-#endif
-
-    memset(&info, 0, sizeof(struct uBloxGnssModelInfo));
-    uint8_t buffer[768] = {0};
-    delay(100);
-
-    // Close all NMEA sentences, valid for L76K, ATGM336H (and likely other AT6558 devices)
-    _serial_gps->write("$PCAS03,0,0,0,0,0,0,0,0,0,0,,,0,0*02\r\n");
-    delay(20);
-
-    // Unicore UFirebirdII Series: UC6580, UM620, UM621, UM670A, UM680A, or UM681A
-    PROBE_SIMPLE("UC6580", "$PDTINFO", "UC6580", GNSS_MODEL_UC6580, 500);
-    PROBE_SIMPLE("UM600", "$PDTINFO", "UM600", GNSS_MODEL_UC6580, 500);
-    PROBE_SIMPLE("ATGM336H", "$PCAS06,1*1A", "$GPTXT,01,01,02,HW=ATGM336H", GNSS_MODEL_ATGM336H, 500);
-    /* ATGM332D series (-11(GPS), -21(BDS), -31(GPS+BDS), -51(GPS+GLONASS), -71-0(GPS+BDS+GLONASS))
-    based on AT6558 */
-    PROBE_SIMPLE("ATGM332D", "$PCAS06,1*1A", "$GPTXT,01,01,02,HW=ATGM332D", GNSS_MODEL_ATGM336H, 500);
-
-    /* Airoha (Mediatek) AG3335A/M/S, A3352Q, Quectel L89 2.0, SimCom SIM65M */
-    _serial_gps->write("$PAIR062,2,0*3C\r\n"); // GSA OFF to reduce volume
-    _serial_gps->write("$PAIR062,3,0*3D\r\n"); // GSV OFF to reduce volume
-    _serial_gps->write("$PAIR513*3D\r\n");     // save configuration
-    PROBE_SIMPLE("AG3335", "$PAIR021*39", "$PAIR021,AG3335", GNSS_MODEL_AG3335, 500);
-    PROBE_SIMPLE("AG3352", "$PAIR021*39", "$PAIR021,AG3352", GNSS_MODEL_AG3352, 500);
-    PROBE_SIMPLE("LC86", "$PQTMVERNO*58", "$PQTMVERNO,LC86", GNSS_MODEL_AG3352, 500);
-
-    PROBE_SIMPLE("L76K", "$PCAS06,0*1B", "$GPTXT,01,01,02,SW=", GNSS_MODEL_MTK, 500);
-
-    // Close all NMEA sentences, valid for L76B MTK platform (Waveshare Pico GPS)
-    _serial_gps->write("$PMTK514,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*2E\r\n");
-    delay(20);
-
-    PROBE_SIMPLE("L76B", "$PMTK605*31", "Quectel-L76B", GNSS_MODEL_MTK_L76B, 500);
-
-    uint8_t cfg_rate[] = {0xB5, 0x62, 0x06, 0x08, 0x00, 0x00, 0x00, 0x00};
-    UBXChecksum(cfg_rate, sizeof(cfg_rate));
-    clearBuffer();
-    _serial_gps->write(cfg_rate, sizeof(cfg_rate));
-    // Check that the returned response class and message ID are correct
-    GPS_RESPONSE response = getACK(0x06, 0x08, 750);
-    if (response == GNSS_RESPONSE_NONE) {
-        LOG_WARN("Failed to find UBlox & MTK GNSS Module using baudrate %d\n", serialSpeed);
-        return GNSS_MODEL_UNKNOWN;
-    } else if (response == GNSS_RESPONSE_FRAME_ERRORS) {
-        LOG_INFO("UBlox Frame Errors using baudrate %d\n", serialSpeed);
-    } else if (response == GNSS_RESPONSE_OK) {
-        LOG_INFO("Found a UBlox Module using baudrate %d\n", serialSpeed);
-    }
-
-    // tips: NMEA Only should not be set here, otherwise initializing Ublox gnss module again after
-    // setting will not output command messages in UART1, resulting in unrecognized module information
-    if (serialSpeed != 9600) {
-        // Set the UART port to 9600
-        uint8_t _message_prt[] = {0xB5, 0x62, 0x06, 0x00, 0x14, 0x00, 0x01, 0x00, 0x00, 0x00, 0xD0, 0x08, 0x00, 0x00,
-                                  0x80, 0x25, 0x00, 0x00, 0x07, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-        UBXChecksum(_message_prt, sizeof(_message_prt));
-        _serial_gps->write(_message_prt, sizeof(_message_prt));
-        delay(500);
-        serialSpeed = 9600;
-#if defined(ARCH_NRF52) || defined(ARCH_PORTDUINO) || defined(ARCH_RP2040) || defined(ARCH_STM32WL)
-        _serial_gps->end();
-        _serial_gps->begin(serialSpeed);
-#else
-        _serial_gps->updateBaudRate(serialSpeed);
-#endif
-        delay(200);
-    }
-
-    memset(buffer, 0, sizeof(buffer));
-    uint8_t _message_MONVER[8] = {
-        0xB5, 0x62, // Sync message for UBX protocol
-        0x0A, 0x04, // Message class and ID (UBX-MON-VER)
-        0x00, 0x00, // Length of payload (we're asking for an answer, so no payload)
-        0x00, 0x00  // Checksum
-    };
-    //  Get Ublox gnss module hardware and software info
-    UBXChecksum(_message_MONVER, sizeof(_message_MONVER));
-    clearBuffer();
-    _serial_gps->write(_message_MONVER, sizeof(_message_MONVER));
-
-    uint16_t len = getACK(buffer, sizeof(buffer), 0x0A, 0x04, 1200);
-    if (len) {
-        // LOG_DEBUG("monver reply size = %d\n", len);
-        uint16_t position = 0;
-        for (int i = 0; i < 30; i++) {
-            info.swVersion[i] = buffer[position];
-            position++;
-        }
-        for (int i = 0; i < 10; i++) {
-            info.hwVersion[i] = buffer[position];
-            position++;
-        }
-
-        while (len >= position + 30) {
-            for (int i = 0; i < 30; i++) {
-                info.extension[info.extensionNo][i] = buffer[position];
-                position++;
-            }
-            info.extensionNo++;
-            if (info.extensionNo > 9)
-                break;
-        }
-
-        LOG_DEBUG("Module Info : \n");
-        LOG_DEBUG("Soft version: %s\n", info.swVersion);
-        LOG_DEBUG("Hard version: %s\n", info.hwVersion);
-        LOG_DEBUG("Extensions:%d\n", info.extensionNo);
-        for (int i = 0; i < info.extensionNo; i++) {
-            LOG_DEBUG("  %s\n", info.extension[i]);
-        }
-
-        memset(buffer, 0, sizeof(buffer));
-
-        // tips: extensionNo field is 0 on some 6M GNSS modules
-        for (int i = 0; i < info.extensionNo; ++i) {
-            if (!strncmp(info.extension[i], "MOD=", 4)) {
-                strncpy((char *)buffer, &(info.extension[i][4]), sizeof(buffer));
-                // LOG_DEBUG("GetModel:%s\n", (char *)buffer);
-                if (strlen((char *)buffer)) {
-                    LOG_INFO("UBlox GNSS probe succeeded, using UBlox %s GNSS Module\n", (char *)buffer);
-                } else {
-                    LOG_INFO("UBlox GNSS probe succeeded, using UBlox GNSS Module\n");
-                }
-            } else if (!strncmp(info.extension[i], "PROTVER", 7)) {
-                char *ptr = nullptr;
-                memset(buffer, 0, sizeof(buffer));
-                strncpy((char *)buffer, &(info.extension[i][8]), sizeof(buffer));
-                LOG_DEBUG("Protocol Version:%s\n", (char *)buffer);
-                if (strlen((char *)buffer)) {
-                    uBloxProtocolVersion = strtoul((char *)buffer, &ptr, 10);
-                    LOG_DEBUG("ProtVer=%d\n", uBloxProtocolVersion);
-                } else {
-                    uBloxProtocolVersion = 0;
-                }
-            }
-        }
-    }
-
-    return GNSS_MODEL_UBLOX;
-}
-
 GPS *GPS::createGps()
 {
     int8_t _rx_gpio = config.position.rx_gpio;
@@ -1732,7 +1820,6 @@ bool GPS::hasFlow()
 
 bool GPS::whileActive()
 {
-    unsigned int charsInBuf = 0;
     bool isValid = false;
     if (powerState != GPS_ACTIVE) {
         clearBuffer();
@@ -1746,23 +1833,27 @@ bool GPS::whileActive()
 #endif
     // if (_serial_gps->available() > 0)
     // LOG_DEBUG("GPS Bytes Waiting: %u\n", _serial_gps->available());
-    // First consume any chars that have piled up at the receiver
-    while (_serial_gps->available() > 0) {
+    // Consume the chars that have piled up at the receiver, at most GPS_INGEST_BUDGET of them per pass. Both parsers keep
+    // their state between bytes, so whatever is left is picked up by the next pass right where this one stopped.
+    uint16_t budget = GPS_INGEST_BUDGET;
+    while (budget > 0 && _serial_gps->available() > 0) {
+        budget--;
         int c = _serial_gps->read();
-        UBXscratch[charsInBuf] = c;
 #ifdef GPS_DEBUG
         LOG_DEBUG("%c", c);
 #endif
-        isValid |= reader.encode(c);
-        if (charsInBuf > sizeof(UBXscratch) - 10 || c == '\r') {
-            if (strnstr((char *)UBXscratch, "$GPTXT,01,01,02,u-blox ag - www.u-blox.com*50", charsInBuf)) {
-                rebootsSeen++;
-            }
-            charsInBuf = 0;
-        } else {
-            charsInBuf++;
+        if (reader.encode(c)) {
+            isValid = true;
+            // A sentence carrying a position or time just completed
+            if (reader.location.isUpdated() || reader.time.isUpdated())
+                fixPending = true;
+        }
+        if (parser.feed(c) == GNSSStreamParser::TEXT_LINE &&
+            strstr(parser.line(), "$GPTXT,01,01,02,u-blox ag - www.u-blox.com*50")) {
+            rebootsSeen++;
         }
     }
+    ingestBacklog = _serial_gps->available() > 0;
     return isValid;
 }
 void GPS::enable()
@@ -2,6 +2,7 @@
 #include "configuration.h"
 #if !MESHTASTIC_EXCLUDE_GPS
 
+#include "GNSSStreamParser.h"
 #include "GPSStatus.h"
 #include "GpioLogic.h"
 #include "Observer.h"
@@ -41,6 +42,52 @@ typedef enum {
     GNSS_RESPONSE_OK,
 } GPS_RESPONSE;
 
+// Longest probe or configuration sequence we queue
+#ifndef GPS_MAX_INIT_STEPS
+#define GPS_MAX_INIT_STEPS 24
+#endif
+
+// How often we come back to look for a response while a step is waiting on one
+#ifndef GPS_INIT_POLL_MS
+#define GPS_INIT_POLL_MS 5
+#endif
+
+// Most bytes one pass takes from the receiver, a backlog is worked off over several passes instead of in one
+#ifndef GPS_INGEST_BUDGET
+#define GPS_INGEST_BUDGET 256
+#endif
+
+/**
+ * One step of the non-blocking probe / configuration sequence: send something to the module, optionally wait for a
+ * response (up to timeoutMs), then give the module settleMs to act on it before the next step.
+ */
+struct GPSInitStep {
+    enum Kind : uint8_t { NMEA, UBX, CAS, BAUD, WAIT };
+    enum Expect : uint8_t { EXPECT_NONE, EXPECT_TEXT, EXPECT_UBX_ACK, EXPECT_CAS_ACK, EXPECT_UBX_REPLY };
+    enum Flags : uint8_t {
+        CLEAR_FIRST = 0x01, // Discard whatever is in the receive buffer before sending
+        ALLOW_NAK = 0x02,   // A NAK is expected on some modules, don't warn and don't wait settleMs
+        READ_MONVER = 0x04, // The reply is UBX-MON-VER, parse it into info
+        UBLOX_PROBE = 0x08  // Any answer means a u-blox module, no answer ends the probe at this speed
+    };
+
+    Kind kind = WAIT;
+    Expect expect = EXPECT_NONE;
+    uint8_t flags = 0;
+    uint8_t cls = 0; // UBX / CAS class, also what the ACK or reply must match
+    uint8_t id = 0;  // UBX / CAS message id
+    uint8_t payloadLen = 0;
+    const uint8_t *payload = NULL;
+    const char *command = NULL;  // NMEA sentence to send
+    const char *response = NULL; // Text to look for with EXPECT_TEXT
+    uint32_t baud = 0;           // New speed for BAUD steps
+    uint16_t timeoutMs = 0;
+    uint16_t settleMs = 0;
+    GnssModel_t model = GNSS_MODEL_UNKNOWN; // A probe that matches identifies this model
+    const char *okMsg = NULL;
+    const char *failMsg = NULL;
+};
+
 enum GPSPowerState : uint8_t {
     GPS_ACTIVE,    // Awake and want a position
     GPS_IDLE,      // Awake, but not wanting another position yet
@@ -79,6 +126,19 @@ class GPS : private concurrency::OSThread
     int speedSelect = 0;
     int probeTries = 2;
 
+    // State of the non-blocking probe / configuration sequence
+    enum : uint8_t { INIT_START, INIT_PROBING, INIT_CONFIGURING, INIT_DONE } initPhase = INIT_START;
+    enum : uint8_t { STEP_PENDING, STEP_AWAITING, STEP_SETTLING } initStepState = STEP_PENDING;
+    GPSInitStep initSteps[GPS_MAX_INIT_STEPS];
+    uint8_t initStepCount = 0;
+    uint8_t initStepIndex = 0;
+    uint32_t initStepStartMs = 0;
+    GPS_RESPONSE initStepResponse = GNSS_RESPONSE_NONE;
+    bool ubloxResponded = false;
+
+    // Frames the bytes from the module into text lines and UBX / CAS messages
+    GNSSStreamParser parser;
+
     /**
      * hasValidLocation - indicates that the position variables contain a complete
      *   GPS location, valid and fresh (< gps_update_interval + position_broadcast_secs)
@@ -92,7 +152,8 @@ class GPS : private concurrency::OSThread
     bool hasGPS = false; // Do we have a GPS we are talking to
 
     bool GPSInitFinished = false; // Init thread finished?
-    bool GPSInitStarted = false;  // Init thread finished?
+    bool GPSInitStarted = false;  // Init thread started?
+    int bootPhase = -1;           // The probe in bootTimeline
 
     GPSPowerState powerState = GPS_OFF; // GPS_ACTIVE if we want a location right now
 
@@ -207,6 +268,12 @@ class GPS : private concurrency::OSThread
 
     int rebootsSeen = 0;
 
+    // A sentence with a position or time completed since runOnce() last looked
+    bool fixPending = false;
+
+    // The last pass hit GPS_INGEST_BUDGET with bytes still waiting
+    bool ingestBacklog = false;
+
     int getACK(uint8_t *buffer, uint16_t size, uint8_t requestedClass, uint8_t requestedID, uint32_t waitMillis);
     GPS_RESPONSE getACK(uint8_t c, uint8_t i, uint32_t waitMillis);
     GPS_RESPONSE getACK(const char *message, uint32_t waitMillis);
@@ -297,8 +364,22 @@ class GPS : private concurrency::OSThread
 
     virtual int32_t runOnce() override;
 
-    // Get GNSS model
-    GnssModel_t probe(int serialSpeed);
+    int32_t runInit();
+    int32_t runInitSteps();
+    void addInitStep(const GPSInitStep &step);
+    void clearInitSteps();
+    void sendInitStep(const GPSInitStep &step);
+    GPS_RESPONSE pollInitStep(const GPSInitStep &step);
+    void finishInitStep(const GPSInitStep &step, GPS_RESPONSE response);
+    void setBaud(uint32_t serialSpeed);
+
+    // Queue the steps to find the GNSS model at this speed
+    void queueProbe(int serialSpeed);
+
+    // Queue the steps to configure the model we found
+    void queueConfig();
+    void queueConfigUBlox();
+    void parseMonVer(const uint8_t *buffer, uint16_t len);
 
     // delay counter to allow more sats before fixed position stops GPS thread
     uint8_t fixeddelayCtr = 0;
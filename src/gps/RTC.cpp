@@ -1,4 +1,5 @@
 #include "RTC.h"
+#include "NodeDB.h"
 #include "configuration.h"
 #include "detect/ScanI2C.h"
 #include "main.h"
@@ -120,6 +121,7 @@ bool perhapsSetRTC(RTCQuality q, const struct timeval *tv, bool forceUpdate)
     }
 
     if (shouldSet) {
+        uint32_t before = getTime();
         currentQuality = q;
         lastSetMsec = now;
         if (currentQuality >= RTCQualityNTP) {
@@ -166,6 +168,12 @@ bool perhapsSetRTC(RTCQuality q, const struct timeval *tv, bool forceUpdate)
         readFromRTC();
 #endif
 
+        // The online counts are bucketed by the time nodes were heard relative to our clock, a step (such as from the time
+        // since boot to the real time) puts them in the wrong buckets
+        int32_t step = getTime() - before;
+        if (nodeDB && (step > ONLINE_BUCKET_SECS || step < -ONLINE_BUCKET_SECS))
+            nodeDB->recountNodes();
+
         return true;
     } else {
         return false;
@@ -2,23 +2,34 @@
 
 #if defined(USE_EINK) && defined(USE_EINK_DYNAMICDISPLAY)
 #include "EInkDynamicDisplay.h"
+#include "EInkFrameOps.h"
 
 // Constructor
 EInkDynamicDisplay::EInkDynamicDisplay(uint8_t address, int sda, int scl, OLEDDISPLAY_GEOMETRY geometry, HW_I2C i2cBus)
     : EInkDisplay(address, sda, scl, geometry, i2cBus), NotifiedWorkerThread("EInkDynamicDisplay")
 {
+    // Framebuffer is hashed in regions, so unchanged regions can be recognized
+    regionCount = (EInkDisplay::displayBufferSize + EINK_HASH_REGION_BYTES - 1) / EINK_HASH_REGION_BYTES;
+    regionHashes = new uint32_t[regionCount]();
+
     // If tracking ghost pixels, grab memory
 #ifdef EINK_LIMIT_GHOSTING_PX
     dirtyPixels = new uint8_t[EInkDisplay::displayBufferSize](); // Init with zeros
+    ghostRegionHashes = new uint32_t[regionCount]();
+    ghostRegionCounts = new uint16_t[regionCount]();
 #endif
 }
 
 // Destructor
 EInkDynamicDisplay::~EInkDynamicDisplay()
 {
+    delete[] regionHashes;
+
     // If we were tracking ghost pixels, free the memory
 #ifdef EINK_LIMIT_GHOSTING_PX
     delete[] dirtyPixels;
+    delete[] ghostRegionHashes;
+    delete[] ghostRegionCounts;
 #endif
 }
 
@@ -373,9 +384,12 @@ void EInkDynamicDisplay::hashImage()
 {
     imageHash = 0;
 
-    // Sum all bytes of the image buffer together
-    for (uint16_t b = 0; b < (displayWidth / 8) * displayHeight; b++) {
-        imageHash ^= buffer[b] << b;
+    // Hash each region a word at a time, then fold the region hashes into the frame hash
+    for (uint16_t r = 0; r < regionCount; r++) {
+        uint32_t offset = r * EINK_HASH_REGION_BYTES;
+        uint32_t len = min((uint32_t)EINK_HASH_REGION_BYTES, (uint32_t)displayBufferSize - offset);
+        regionHashes[r] = einkHashRegion(buffer + offset, len);
+        imageHash = (imageHash ^ regionHashes[r]) * 16777619u;
     }
 }
 
@@ -406,21 +420,16 @@ void EInkDynamicDisplay::countGhostPixels()
     // Start a new count
     ghostPixelCount = 0;
 
-    // Check new image, bit by bit, for any white pixels at locations marked "dirty"
-    for (uint16_t i = 0; i < displayBufferSize; i++) {
-        for (uint8_t bit = 0; bit < 7; bit++) {
-
-            const bool dirty = (dirtyPixels[i] >> bit) & 1;       // Has pixel location been drawn to since full-refresh?
-            const bool shouldBeBlank = !((buffer[i] >> bit) & 1); // Is pixel location white in the new image?
-
-            // If pixel is (or has been) black since last full-refresh, and now is white: ghosting
-            if (dirty && shouldBeBlank)
-                ghostPixelCount++;
-
-            // Update the dirty status for this pixel - will this location become a ghost if set white in future?
-            if (!dirty && !shouldBeBlank)
-                dirtyPixels[i] |= (1 << bit);
+    // Check new image, a word at a time, for any white pixels at locations marked "dirty".
+    // A region whose content is unchanged since it was last counted has the same ghost count and dirty bits, so skip it.
+    for (uint16_t r = 0; r < regionCount; r++) {
+        if (ghostRegionHashes[r] != regionHashes[r]) {
+            uint32_t offset = r * EINK_HASH_REGION_BYTES;
+            uint32_t len = min((uint32_t)EINK_HASH_REGION_BYTES, (uint32_t)displayBufferSize - offset);
+            ghostRegionCounts[r] = einkCountGhostPixels(buffer + offset, dirtyPixels + offset, len);
+            ghostRegionHashes[r] = regionHashes[r];
         }
+        ghostPixelCount += ghostRegionCounts[r];
     }
 
     LOG_DEBUG("ghostPixels=%hu, ", ghostPixelCount);
@@ -448,6 +457,10 @@ void EInkDynamicDisplay::resetGhostPixelTracking()
 {
     // Copy the current frame into dirtyPixels[] from the display buffer
     memcpy(dirtyPixels, EInkDisplay::buffer, EInkDisplay::displayBufferSize);
+
+    // The frame was hashed earlier in determineMode(). Every region of it now has no ghosts.
+    memcpy(ghostRegionHashes, regionHashes, regionCount * sizeof(uint32_t));
+    memset(ghostRegionCounts, 0, regionCount * sizeof(uint16_t));
 }
 #endif // EINK_LIMIT_GHOSTING_PX
 
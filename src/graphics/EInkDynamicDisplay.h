@@ -8,6 +8,11 @@
 #include "GxEPD2_BW.h"
 #include "concurrency/NotifiedWorkerThread.h"
 
+// Size of the framebuffer regions hashed separately, to detect which parts of a frame changed
+#ifndef EINK_HASH_REGION_BYTES
+#define EINK_HASH_REGION_BYTES 64
+#endif
+
 /*
     Derives from the EInkDisplay adapter class.
     Accepts suggestions from Screen class about frame type.
@@ -104,6 +109,8 @@ class EInkDynamicDisplay : public EInkDisplay, protected concurrency::NotifiedWo
     bool initialized = false;          // Have we drawn at least one frame yet?
     uint32_t previousRunMs = -1;       // When did determineMode() last run (rather than rejecting for rate-limiting)
     uint32_t imageHash = 0;            // Hash of the current frame. Don't bother updating if nothing has changed!
+    uint32_t *regionHashes;            // Hash of each EINK_HASH_REGION_BYTES region of the current frame
+    uint16_t regionCount = 0;          // Number of regions the framebuffer is split into
     uint32_t previousImageHash = 0;    // Hash of the previous update's frame
     uint32_t fastRefreshCount = 0;     // How many fast-refreshes consecutively since last full refresh?
     refreshTypes currentConfig = FULL; // Which refresh type is GxEPD2 currently configured for
@@ -116,6 +123,8 @@ class EInkDynamicDisplay : public EInkDisplay, protected concurrency::NotifiedWo
     void resetGhostPixelTracking(); // Clear the dirty pixels array. Call when full-refresh cleans the display.
     uint8_t *dirtyPixels;           // Any pixels that have been black since last full-refresh (dynamically allocated mem)
     uint32_t ghostPixelCount = 0;   // Number of pixels with problematic ghosting. Retained here for LOG_DEBUG use
+    uint32_t *ghostRegionHashes;    // Region hashes when ghost pixels were last counted. Unchanged regions are skipped
+    uint16_t *ghostRegionCounts;    // Ghost pixels in each region, as of last count
 #endif
 
     // Conditional - async full refresh - only with modified meshtastic/GxEPD2
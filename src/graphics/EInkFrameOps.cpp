@@ -0,0 +1,47 @@
+#include "EInkFrameOps.h"
+#include <string.h>
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+uint32_t einkHashRegion(const uint8_t *data, size_t len)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    size_t i = 0;
+
+    for (; i + sizeof(uint32_t) <= len; i += sizeof(uint32_t)) {
+        uint32_t word;
+        memcpy(&word, data + i, sizeof(word)); // Buffer is not guaranteed to be word aligned
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+    for (; i < len; i++)
+        hash = (hash ^ data[i]) * FNV_PRIME;
+
+    return hash;
+}
+
+uint32_t einkCountGhostPixels(const uint8_t *frame, uint8_t *dirty, size_t len)
+{
+    uint32_t ghosts = 0;
+    size_t i = 0;
+
+    for (; i + sizeof(uint32_t) <= len; i += sizeof(uint32_t)) {
+        uint32_t f, d;
+        memcpy(&f, frame + i, sizeof(f));
+        memcpy(&d, dirty + i, sizeof(d));
+
+        // Set bits are black. A dirty location which is white in the new frame is a ghost.
+        ghosts += __builtin_popcount(d & ~f);
+
+        if ((d | f) != d) {
+            d |= f;
+            memcpy(dirty + i, &d, sizeof(d));
+        }
+    }
+    for (; i < len; i++) {
+        ghosts += __builtin_popcount((uint8_t)(dirty[i] & ~frame[i]));
+        dirty[i] |= frame[i];
+    }
+
+    return ghosts;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Word-parallel helpers used by EInkDynamicDisplay to decide between fast and full refresh.
+    They work on the raw 1bpp framebuffer, 32 pixels at a time, and have no display dependencies,
+    so they can be exercised (and benchmarked) on native builds.
+*/
+
+// Hash a region of a framebuffer, one 32-bit word at a time (FNV-1a over words)
+uint32_t einkHashRegion(const uint8_t *data, size_t len);
+
+// Count pixels which are marked dirty but are white in the new frame (ghosts),
+// then mark every black pixel of the new frame as dirty
+uint32_t einkCountGhostPixels(const uint8_t *frame, uint8_t *dirty, size_t len);
@@ -547,37 +547,94 @@ TFTDisplay::TFTDisplay(uint8_t address, int sda, int scl, OLEDDISPLAY_GEOMETRY g
 #endif
 }
 
+TFTDisplay::~TFTDisplay()
+{
+    delete[] stripe;
+}
+
+// Changed runs in a page closer than this many columns are merged into one rectangle. Opening a new address window costs
+// about as much as resending a few 8 pixel high columns.
+#define TFT_DIRTY_MERGE_GAP 8
+
 // Write the buffer to the display memory
 void TFTDisplay::display(bool fromBlank)
 {
-    if (fromBlank)
+    if (fromBlank) {
         tft->fillScreen(TFT_BLACK);
+        // The panel is now blank, so compare against an empty back buffer and push every lit pixel
+        memset(buffer_back, 0, displayBufferSize);
+    }
     // tft->clear();
     concurrency::LockGuard g(spiLock);
 
-    uint16_t x, y;
+    if (!stripe)
+        stripe = new uint16_t[displayWidth * 8];
+
+    // Pixel data is pushed as big endian RGB565 unless the driver was told to swap bytes for us
+    uint16_t onColor = tft->getSwapBytes() ? TFT_MESH : __builtin_bswap16(TFT_MESH);
+
+    // The OLED lib uses page based ordering: each byte is a column of 8 vertical pixels, a page is a row of these bytes.
+    // Compare a word (4 columns) at a time and push each changed run of columns as one windowed block write.
+    uint16_t pages = (displayHeight + 7) / 8;
+    for (uint16_t page = 0; page < pages; page++) {
+        const uint8_t *cur = buffer + page * displayWidth;
+        const uint8_t *back = buffer_back + page * displayWidth;
+        int32_t runStart = -1, runEnd = -1; // runEnd is exclusive
+
+        uint16_t x = 0;
+        while (x < displayWidth) {
+            uint16_t step = 1;
+            bool changed;
+            if (x + 4 <= displayWidth) {
+                uint32_t a, b;
+                memcpy(&a, cur + x, sizeof(a));
+                memcpy(&b, back + x, sizeof(b));
+                changed = a != b;
+                step = 4;
+            } else {
+                changed = cur[x] != back[x];
+            }
 
-    for (y = 0; y < displayHeight; y++) {
-        for (x = 0; x < displayWidth; x++) {
-            auto isset = buffer[x + (y / 8) * displayWidth] & (1 << (y & 7));
-            if (!fromBlank) {
-                // get src pixel in the page based ordering the OLED lib uses FIXME, super inefficent
-                auto dblbuf_isset = buffer_back[x + (y / 8) * displayWidth] & (1 << (y & 7));
-                if (isset != dblbuf_isset) {
-                    tft->drawPixel(x, y, isset ? TFT_MESH : TFT_BLACK);
+            if (changed) {
+                // Narrow the word down to the columns that actually differ
+                uint16_t first = x, last = x + step - 1;
+                while (cur[first] == back[first])
+                    first++;
+                while (cur[last] == back[last])
+                    last--;
+
+                if (runStart >= 0 && first - runEnd > TFT_DIRTY_MERGE_GAP) {
+                    pushStripe(page, runStart, runEnd, onColor);
+                    runStart = -1;
                 }
-            } else if (isset) {
-                tft->drawPixel(x, y, TFT_MESH);
+                if (runStart < 0)
+                    runStart = first;
+                runEnd = last + 1;
             }
+            x += step;
         }
+        if (runStart >= 0)
+            pushStripe(page, runStart, runEnd, onColor);
     }
-    // Copy the Buffer to the Back Buffer
-    for (y = 0; y < (displayHeight / 8); y++) {
-        for (x = 0; x < displayWidth; x++) {
-            uint16_t pos = x + y * displayWidth;
-            buffer_back[pos] = buffer[pos];
-        }
+}
+
+// Push columns [x0, x1) of one page with a single block write and mark them as current in the back buffer
+void TFTDisplay::pushStripe(uint16_t page, uint16_t x0, uint16_t x1, uint16_t onColor)
+{
+    uint16_t y0 = page * 8;
+    uint16_t w = x1 - x0;
+    uint16_t h = min(8, displayHeight - y0);
+    const uint8_t *cur = buffer + page * displayWidth;
+
+    uint16_t *out = stripe;
+    for (uint16_t row = 0; row < h; row++) {
+        uint8_t mask = 1 << row;
+        for (uint16_t x = x0; x < x1; x++)
+            *out++ = (cur[x] & mask) ? onColor : TFT_BLACK;
     }
+    tft->pushImage(x0, y0, w, h, stripe);
+
+    memcpy(buffer_back + page * displayWidth + x0, cur + x0, w);
 }
 
 // Send a command to the display (low level function)
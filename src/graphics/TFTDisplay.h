@@ -6,8 +6,9 @@
 /**
  * An adapter class that allows using the LovyanGFX library as if it was an OLEDDisplay implementation.
  *
+ * display() diffs the frame against the back buffer and pushes each changed run of columns as one windowed block write.
+ *
  * Remaining TODO:
- * optimize display() to only draw changed pixels (see other OLED subclasses for examples)
  * Use the fast NRF52 SPI API rather than the slow standard arduino version
  *
  * turn radio back on - currently with both on spi bus is fucked? or are we leaving chip select asserted?
@@ -19,6 +20,7 @@ class TFTDisplay : public OLEDDisplay
     FIXME - the parameters are not used, just a temporary hack to keep working like the old displays
     */
     TFTDisplay(uint8_t, int, int, OLEDDISPLAY_GEOMETRY, HW_I2C);
+    ~TFTDisplay();
 
     // Write the buffer to the display memory
     virtual void display() override { display(false); };
@@ -57,4 +59,11 @@ class TFTDisplay : public OLEDDisplay
 
     // Connect to the display
     virtual bool connect() override;
+
+  private:
+    // Push one changed run of columns [x0, x1) within an 8 pixel high page
+    void pushStripe(uint16_t page, uint16_t x0, uint16_t x1, uint16_t onColor);
+
+    // Scratch RGB565 pixels for one page wide stripe, allocated on first use
+    uint16_t *stripe = nullptr;
 };
\ No newline at end of file
@@ -1,13 +1,17 @@
 #include "configuration.h"
+#include "BootTimeline.h"
+#include "DeferredInit.h"
 #if !MESHTASTIC_EXCLUDE_GPS
 #include "GPS.h"
 #endif
 #include "MeshRadio.h"
 #include "MeshService.h"
 #include "NodeDB.h"
+#include "PacketBundler.h"
 #include "PowerFSM.h"
 #include "PowerMon.h"
 #include "ReliableRouter.h"
+#include "RouteCache.h"
 #include "airtime.h"
 #include "buzz.h"
 
@@ -38,6 +42,7 @@
 #include "target_specific.h"
 #include <memory>
 #include <utility>
+#include <vector>
 // #include <driver/rtc_io.h>
 
 #ifdef ARCH_ESP32
@@ -90,6 +95,12 @@ NRF52Bluetooth *nrf52Bluetooth = nullptr;
 #include "linux/LinuxHardwareI2C.h"
 #include "mesh/raspihttp/PiWebServer.h"
 #include "platform/portduino/PortduinoGlue.h"
+#if HAS_DECODE_WORKER_POOL
+#include "platform/portduino/DecodeWorkerPool.h"
+#endif
+#if HAS_UDP_MULTICAST
+#include "mesh/udp/UdpMulticastInterface.h"
+#endif
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -236,7 +247,105 @@ void printInfo()
 {
     LOG_INFO("S:B:%d,%s\n", HW_VENDOR, optstr(APP_VERSION));
 }
+
 #ifndef PIO_UNIT_TESTING
+#if !MESHTASTIC_EXCLUDE_I2C
+static ScanI2CTwoWire *i2cScanner;
+static std::vector<ScanI2C::I2CPort> i2cPorts; // The ports that still need the sensors scanned
+
+/**
+ * setup() only looks for the devices it needs itself, the sensors get found by detectI2CSensors() once it is done. If the
+ * scan cache still matches the bus, everything is found right here.
+ */
+static void scanI2CBootDevices(ScanI2C::I2CPort port)
+{
+#ifdef SENSOR_GPS_CONFLICT
+    // Finding any device at all decides about the GPS, so the sensors can't wait
+    i2cScanner->scanPort(port);
+#else
+    i2cScanner->scanBootDevices(port);
+    i2cPorts.push_back(port);
+#endif
+}
+
+#define STRING(S) #S
+
+#define SCANNER_TO_SENSORS_MAP(SCANNER_T, PB_T)                                                                                  \
+    {                                                                                                                            \
+        auto found = i2cScanner->find(SCANNER_T);                                                                                \
+        if (found.type != ScanI2C::DeviceType::NONE) {                                                                           \
+            nodeTelemetrySensorsMap[PB_T].first = found.address.address;                                                         \
+            nodeTelemetrySensorsMap[PB_T].second = i2cScanner->fetchI2CBus(found.address);                                       \
+            LOG_DEBUG("found i2c sensor %s\n", STRING(PB_T));                                                                    \
+        }                                                                                                                        \
+    }
+
+/**
+ * Deferred step: scan the rest of the addresses and stuff the sensors into the nodeTelemetrySensorsMap singleton. These
+ * have no further logic than to be found.
+ */
+static void detectI2CSensors()
+{
+    for (auto port : i2cPorts)
+        i2cScanner->scanOtherDevices(port);
+    i2cPorts.clear();
+    i2cScanner->saveScanCache();
+    LOG_INFO("%i I2C devices found in total\n", i2cScanner->countDevices());
+
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::BME_680, meshtastic_TelemetrySensorType_BME680)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::BME_280, meshtastic_TelemetrySensorType_BME280)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::BMP_280, meshtastic_TelemetrySensorType_BMP280)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::BMP_3XX, meshtastic_TelemetrySensorType_BMP3XX)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::BMP_085, meshtastic_TelemetrySensorType_BMP085)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::INA260, meshtastic_TelemetrySensorType_INA260)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::INA219, meshtastic_TelemetrySensorType_INA219)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::INA3221, meshtastic_TelemetrySensorType_INA3221)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::MCP9808, meshtastic_TelemetrySensorType_MCP9808)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::MCP9808, meshtastic_TelemetrySensorType_MCP9808)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::SHT31, meshtastic_TelemetrySensorType_SHT31)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::SHTC3, meshtastic_TelemetrySensorType_SHTC3)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::LPS22HB, meshtastic_TelemetrySensorType_LPS22)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::QMC6310, meshtastic_TelemetrySensorType_QMC6310)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::QMI8658, meshtastic_TelemetrySensorType_QMI8658)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::QMC5883L, meshtastic_TelemetrySensorType_QMC5883L)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::RCWL9620, meshtastic_TelemetrySensorType_RCWL9620)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::VEML7700, meshtastic_TelemetrySensorType_VEML7700)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::TSL2591, meshtastic_TelemetrySensorType_TSL25911FN)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::OPT3001, meshtastic_TelemetrySensorType_OPT3001)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::MLX90632, meshtastic_TelemetrySensorType_MLX90632)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::SHT4X, meshtastic_TelemetrySensorType_SHT4X)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::AHT10, meshtastic_TelemetrySensorType_AHT10)
+    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::DFROBOT_LARK, meshtastic_TelemetrySensorType_DFROBOT_LARK)
+
+    delete i2cScanner;
+    i2cScanner = NULL;
+}
+#endif
+
+/**
+ * Deferred step: nothing before the radio needs the display, and bringing it up takes a while on the bigger ones
+ */
+static void setupScreen()
+{
+#if !MESHTASTIC_EXCLUDE_I2C
+// Don't call screen setup until after nodedb is setup (because we need
+// the current region name)
+#if defined(ST7735_CS) || defined(USE_EINK) || defined(ILI9341_DRIVER) || defined(ST7789_CS) || defined(HX8357_CS) ||            \
+    defined(USE_ST7789)
+    screen->setup();
+#elif defined(ARCH_PORTDUINO)
+    if (screen_found.port != ScanI2C::I2CPort::NO_I2C || settingsMap[displayPanel]) {
+        screen->setup();
+    }
+#else
+    if (screen_found.port != ScanI2C::I2CPort::NO_I2C)
+        screen->setup();
+#endif
+#endif
+
+    screen->print("Started...\n");
+}
+
 void setup()
 {
     concurrency::hasBeenSetup = true;
@@ -277,6 +386,7 @@ void setup()
 
     initDeepSleep();
 
+    bootTimeline.phase("peripheral power");
     // power on peripherals
 #if defined(PIN_POWER_EN)
     pinMode(PIN_POWER_EN, OUTPUT);
@@ -336,8 +446,12 @@ void setup()
 
     OSThread::setup();
 
+    // Before any other thread, see DeferredInit
+    deferredInit = new DeferredInit();
+
     ledPeriodic = new Periodic("Blink", ledBlinker);
 
+    bootTimeline.phase("filesystem");
     fsInit();
 
 #if defined(_SEEED_XIAO_NRF52840_SENSE_H_)
@@ -353,6 +467,7 @@ void setup()
 
 #endif
 
+    bootTimeline.phase("i2c and pmu");
 #if !MESHTASTIC_EXCLUDE_I2C
 #if defined(I2C_SDA1) && defined(ARCH_RP2040)
     Wire1.setSDA(I2C_SDA1);
@@ -412,9 +527,10 @@ void setup()
     power->setup(); // Must be after status handler is installed, so that handler gets notified of the initial configuration
 
 #if !MESHTASTIC_EXCLUDE_I2C
+    bootTimeline.phase("i2c scan");
     // We need to scan here to decide if we have a screen for nodeDB.init() and because power has been applied to
-    // accessories
-    auto i2cScanner = std::unique_ptr<ScanI2CTwoWire>(new ScanI2CTwoWire());
+    // accessories. The sensors can wait until setup() is done.
+    i2cScanner = new ScanI2CTwoWire();
 #if HAS_WIRE
     LOG_INFO("Scanning for i2c devices...\n");
 #endif
@@ -423,27 +539,27 @@ void setup()
     Wire1.setSDA(I2C_SDA1);
     Wire1.setSCL(I2C_SCL1);
     Wire1.begin();
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE1);
+    scanI2CBootDevices(ScanI2C::I2CPort::WIRE1);
 #elif defined(I2C_SDA1) && !defined(ARCH_RP2040)
     Wire1.begin(I2C_SDA1, I2C_SCL1);
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE1);
+    scanI2CBootDevices(ScanI2C::I2CPort::WIRE1);
 #endif
 
 #if defined(I2C_SDA) && defined(ARCH_RP2040)
     Wire.setSDA(I2C_SDA);
     Wire.setSCL(I2C_SCL);
     Wire.begin();
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+    scanI2CBootDevices(ScanI2C::I2CPort::WIRE);
 #elif defined(I2C_SDA) && !defined(ARCH_RP2040)
     Wire.begin(I2C_SDA, I2C_SCL);
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+    scanI2CBootDevices(ScanI2C::I2CPort::WIRE);
 #elif defined(ARCH_PORTDUINO)
     if (settingsStrings[i2cdev] != "") {
         LOG_INFO("Scanning for i2c devices...\n");
-        i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+        scanI2CBootDevices(ScanI2C::I2CPort::WIRE);
     }
 #elif HAS_WIRE
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+    scanI2CBootDevices(ScanI2C::I2CPort::WIRE);
 #endif
 
     auto i2cCount = i2cScanner->countDevices();
@@ -515,12 +631,6 @@ void setup()
 
     pmu_found = i2cScanner->exists(ScanI2C::DeviceType::PMU_AXP192_AXP2101);
 
-/*
- * There are a bunch of sensors that have no further logic than to be found and stuffed into the
- * nodeTelemetrySensorsMap singleton. This wraps that logic in a temporary scope to declare the temporary field
- * "found".
- */
-
 // Only one supported RGB LED currently
 #ifdef HAS_NCP5623
     rgb_found = i2cScanner->find(ScanI2C::DeviceType::NCP5623);
@@ -532,45 +642,10 @@ void setup()
     LOG_DEBUG("acc_info = %i\n", acc_info.type);
 #endif
 
-#define STRING(S) #S
-
-#define SCANNER_TO_SENSORS_MAP(SCANNER_T, PB_T)                                                                                  \
-    {                                                                                                                            \
-        auto found = i2cScanner->find(SCANNER_T);                                                                                \
-        if (found.type != ScanI2C::DeviceType::NONE) {                                                                           \
-            nodeTelemetrySensorsMap[PB_T].first = found.address.address;                                                         \
-            nodeTelemetrySensorsMap[PB_T].second = i2cScanner->fetchI2CBus(found.address);                                       \
-            LOG_DEBUG("found i2c sensor %s\n", STRING(PB_T));                                                                    \
-        }                                                                                                                        \
-    }
-
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::BME_680, meshtastic_TelemetrySensorType_BME680)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::BME_280, meshtastic_TelemetrySensorType_BME280)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::BMP_280, meshtastic_TelemetrySensorType_BMP280)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::BMP_3XX, meshtastic_TelemetrySensorType_BMP3XX)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::BMP_085, meshtastic_TelemetrySensorType_BMP085)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::INA260, meshtastic_TelemetrySensorType_INA260)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::INA219, meshtastic_TelemetrySensorType_INA219)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::INA3221, meshtastic_TelemetrySensorType_INA3221)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::MCP9808, meshtastic_TelemetrySensorType_MCP9808)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::MCP9808, meshtastic_TelemetrySensorType_MCP9808)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::SHT31, meshtastic_TelemetrySensorType_SHT31)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::SHTC3, meshtastic_TelemetrySensorType_SHTC3)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::LPS22HB, meshtastic_TelemetrySensorType_LPS22)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::QMC6310, meshtastic_TelemetrySensorType_QMC6310)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::QMI8658, meshtastic_TelemetrySensorType_QMI8658)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::QMC5883L, meshtastic_TelemetrySensorType_QMC5883L)
+    // setupModules() only creates the air quality module if there is one, so this sensor can't wait for detectI2CSensors()
     SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::PMSA0031, meshtastic_TelemetrySensorType_PMSA003I)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::RCWL9620, meshtastic_TelemetrySensorType_RCWL9620)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::VEML7700, meshtastic_TelemetrySensorType_VEML7700)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::TSL2591, meshtastic_TelemetrySensorType_TSL25911FN)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::OPT3001, meshtastic_TelemetrySensorType_OPT3001)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::MLX90632, meshtastic_TelemetrySensorType_MLX90632)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::SHT4X, meshtastic_TelemetrySensorType_SHT4X)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::AHT10, meshtastic_TelemetrySensorType_AHT10)
-    SCANNER_TO_SENSORS_MAP(ScanI2C::DeviceType::DFROBOT_LARK, meshtastic_TelemetrySensorType_DFROBOT_LARK)
 
-    i2cScanner.reset();
+    deferredInit->add("i2c sensors", detectI2CSensors);
 #endif
 
 #ifdef HAS_SDCARD
@@ -601,16 +676,31 @@ void setup()
 
     // We do this as early as possible because this loads preferences from flash
     // but we need to do this after main cpu init (esp32setup), because we need the random seed set
+    bootTimeline.phase("nodedb");
     nodeDB = new NodeDB;
 
-    // If we're taking on the repeater role, use flood router and turn off 3V3_S rail because peripherals are not needed
+    routeCache = new RouteCache();
+
+    // If we're taking on the repeater role, use a router without retransmissions and turn off 3V3_S rail because peripherals
+    // are not needed
     if (config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER) {
-        router = new FloodingRouter();
+        router = new NextHopRouter();
 #ifdef PIN_3V3_EN
         digitalWrite(PIN_3V3_EN, LOW);
 #endif
     } else
         router = new ReliableRouter();
+#if HAS_DECODE_WORKER_POOL
+    if (settingsMap[decodeworkers] > 0)
+        decodeWorkerPool = new DecodeWorkerPool(settingsMap[decodeworkers]);
+#endif
+#if !MESHTASTIC_EXCLUDE_BUNDLING
+    packetBundler = new PacketBundler();
+#ifdef ARCH_PORTDUINO
+    if (settingsMap.count(bundlewindow) && settingsMap[bundlewindow] >= 0)
+        packetBundler->setWindow(settingsMap[bundlewindow] * 1000);
+#endif
+#endif
 
 #if HAS_BUTTON || defined(ARCH_PORTDUINO)
     // Buttons. Moved here cause we need NodeDB to be initialized
@@ -655,6 +745,7 @@ void setup()
     drv.setMode(DRV2605_MODE_INTTRIG);
 #endif
 
+    bootTimeline.phase("spi and screen");
     // Init our SPI controller (must be before screen and lora)
     initSPI();
 #ifdef ARCH_RP2040
@@ -697,6 +788,7 @@ void setup()
     readFromRTC(); // read the main CPU RTC at first (in case we can't get GPS time)
 
 #if !MESHTASTIC_EXCLUDE_GPS
+    bootTimeline.phase("gps");
     // If we're taking on the repeater role, ignore GPS
 #ifdef SENSOR_GPS_CONFLICT
     if (sensor_detected == false) {
@@ -724,6 +816,7 @@ void setup()
     LOG_DEBUG("Starting audio thread\n");
     audioThread = new AudioThread();
 #endif
+    bootTimeline.phase("modules");
     service = new MeshService();
     service->init();
 
@@ -742,23 +835,7 @@ void setup()
         RECORD_CRITICALERROR(meshtastic_CriticalErrorCode_NO_AXP192); // Record a hardware fault for missing hardware
 #endif
 
-#if !MESHTASTIC_EXCLUDE_I2C
-// Don't call screen setup until after nodedb is setup (because we need
-// the current region name)
-#if defined(ST7735_CS) || defined(USE_EINK) || defined(ILI9341_DRIVER) || defined(ST7789_CS) || defined(HX8357_CS) ||            \
-    defined(USE_ST7789)
-    screen->setup();
-#elif defined(ARCH_PORTDUINO)
-    if (screen_found.port != ScanI2C::I2CPort::NO_I2C || settingsMap[displayPanel]) {
-        screen->setup();
-    }
-#else
-    if (screen_found.port != ScanI2C::I2CPort::NO_I2C)
-        screen->setup();
-#endif
-#endif
-
-    screen->print("Started...\n");
+    deferredInit->add("screen", setupScreen);
 
 #ifdef SX126X_ANT_SW
     // make analog PA vs not PA switch on SX126x eval board work properly
@@ -841,6 +918,7 @@ void setup()
     LockingArduinoHal *RadioLibHAL = new LockingArduinoHal(SPI, spiSettings);
 #endif
 
+    bootTimeline.phase("radio");
     // radio init MUST BE AFTER service.init, so we have our radio config settings (from nodedb init)
 #if defined(USE_STM32WLx)
     if (!rIf) {
@@ -1015,6 +1093,7 @@ void setup()
 
     lateInitVariant(); // Do board specific init (see extra_variants/README.md for documentation)
 
+    bootTimeline.phase("network");
 #if !MESHTASTIC_EXCLUDE_MQTT
     mqttInit();
 #endif
@@ -1059,6 +1138,13 @@ void setup()
     if (!rIf)
         RECORD_CRITICALERROR(meshtastic_CriticalErrorCode_NO_RADIO);
     else {
+#ifdef ARCH_PORTDUINO
+        if (settingsMap[lorapreset] >= 0) {
+            rIf->setModemPreset((meshtastic_Config_LoRaConfig_ModemPreset)settingsMap[lorapreset]);
+            rIf->reconfigure();
+        }
+        rIf->rebroadcastPolicy = (RebroadcastPolicy)settingsMap[lorarebroadcast];
+#endif
         router->addInterface(rIf);
 
         // Log bit rate to debug output
@@ -1067,10 +1153,24 @@ void setup()
                                                          1000);
     }
 
+#if HAS_UDP_MULTICAST
+    // After the LoRa radio, which stays the primary interface
+    if (settingsMap[udpmulticast]) {
+        UdpMulticastInterface *udp = new UdpMulticastInterface(
+            settingsStrings[udpmulticastgroup].c_str(), settingsMap[udpmulticastport], settingsStrings[udpmulticastif].c_str());
+        udp->rebroadcastPolicy = (RebroadcastPolicy)settingsMap[udpmulticastrebroadcast];
+        if (udp->init())
+            router->addInterface(udp);
+        else
+            delete udp;
+    }
+#endif
+
     // This must be _after_ service.init because we need our preferences loaded from flash to have proper timeout values
     PowerFSM_setup(); // we will transition to ON in a couple of seconds, FIXME, only do this for cold boots, not waking from SDS
     powerFSMthread = new PowerFSMThread();
     setCPUFast(false); // 80MHz is fine for our slow peripherals
+    bootTimeline.setupDone();
 }
 #endif
 uint32_t rebootAtMsec;   // If not zero we will reboot at this time (used to reboot shortly after the update completes)
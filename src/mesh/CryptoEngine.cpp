@@ -54,6 +54,12 @@ void CryptoEngine::clearKeys()
 {
     memset(public_key, 0, sizeof(public_key));
     memset(private_key, 0, sizeof(private_key));
+    for (auto &k : aesKeys) {
+        memset(k.key, 0, sizeof(k.key));
+        k.lastUsed = 0;
+        k.schedule.clear();
+    }
+    aes = NULL;
 }
 
 /**
@@ -85,8 +91,7 @@ bool CryptoEngine::encryptCurve25519(uint32_t toNode, uint32_t fromNode, uint64_
     // Calculate the shared secret with the destination node and encrypt
     printBytes("Attempting encrypt using nonce: ", nonce, 13);
     printBytes("Attempting encrypt using shared_key: ", shared_key, 32);
-    aes_ccm_ae(shared_key, 32, nonce, 8, bytes, numBytes, nullptr, 0, bytesOut,
-               auth); // this can write up to 15 bytes longer than numbytes past bytesOut
+    ccmEncrypt(shared_key, 32, nonce, 8, bytes, numBytes, bytesOut, auth);
     *extraNonce = extraNonceTmp;
     return true;
 }
@@ -118,7 +123,19 @@ bool CryptoEngine::decryptCurve25519(uint32_t fromNode, uint64_t packetNum, size
     initNonce(fromNode, packetNum, *extraNonce);
     printBytes("Attempting decrypt using nonce: ", nonce, 13);
     printBytes("Attempting decrypt using shared_key: ", shared_key, 32);
-    return aes_ccm_ad(shared_key, 32, nonce, 8, bytes, numBytes - 12, nullptr, 0, auth, bytesOut);
+    return ccmDecrypt(shared_key, 32, nonce, 8, bytes, numBytes - 12, auth, bytesOut);
+}
+
+bool CryptoEngine::ccmEncrypt(const uint8_t *key, size_t keyLen, const uint8_t *nonce, size_t M, const uint8_t *plain,
+                              size_t len, uint8_t *crypt, uint8_t *auth)
+{
+    return aes_ccm_ae(key, keyLen, nonce, M, plain, len, nullptr, 0, crypt, auth) == 0;
+}
+
+bool CryptoEngine::ccmDecrypt(const uint8_t *key, size_t keyLen, const uint8_t *nonce, size_t M, const uint8_t *crypt,
+                              size_t len, const uint8_t *auth, uint8_t *plain)
+{
+    return aes_ccm_ad(key, keyLen, nonce, M, crypt, len, nullptr, 0, auth, plain);
 }
 
 void CryptoEngine::setDHPrivateKey(uint8_t *_private_key)
@@ -181,19 +198,32 @@ void CryptoEngine::hash(uint8_t *bytes, size_t numBytes)
 
 void CryptoEngine::aesSetKey(const uint8_t *key_bytes, size_t key_len)
 {
-    if (aes) {
-        delete aes;
-        aes = nullptr;
+    aes = NULL;
+    if (key_len != sizeof(aes->key))
+        return;
+
+    // PKI packets mostly go back and forth with the same few peers, so keep their key schedules around instead of expanding
+    // the shared key again for every packet. The least recently used one makes room for a new key.
+    AesKeySchedule *oldest = &aesKeys[0];
+    for (auto &k : aesKeys) {
+        if (k.lastUsed && memcmp(k.key, key_bytes, sizeof(k.key)) == 0) {
+            aes = &k;
+            break;
+        }
+        if (k.lastUsed < oldest->lastUsed)
+            oldest = &k;
     }
-    if (key_len != 0) {
-        aes = new AESSmall256();
-        aes->setKey(key_bytes, key_len);
+    if (!aes) {
+        aes = oldest;
+        memcpy(aes->key, key_bytes, sizeof(aes->key));
+        aes->schedule.setKey(key_bytes, key_len);
     }
+    aes->lastUsed = ++aesKeyUses;
 }
 
 void CryptoEngine::aesEncrypt(uint8_t *in, uint8_t *out)
 {
-    aes->encryptBlock(out, in);
+    aes->schedule.encryptBlock(out, in);
 }
 
 bool CryptoEngine::setDHPublicKey(uint8_t *pubKey)
@@ -242,6 +272,14 @@ void CryptoEngine::decrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes
     encryptPacket(fromNode, packetId, numBytes, bytes);
 }
 
+void CryptoEngine::decryptWithKey(const CryptoKey &k, uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes)
+{
+    if (k.length > 0 && numBytes <= MAX_BLOCKSIZE) {
+        initNonce(fromNode, packetId);
+        encryptAESCtr(k, nonce, numBytes, bytes);
+    }
+}
+
 // Generic implementation of AES-CTR encryption.
 void CryptoEngine::encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, uint8_t *bytes)
 {
@@ -21,6 +21,11 @@ struct CryptoKey {
  */
 
 #define MAX_BLOCKSIZE 256
+
+// AES key schedules kept for PKI, one per peer we exchanged PKI packets with most recently
+#ifndef AES_KEY_CACHE_SIZE
+#define AES_KEY_CACHE_SIZE 4
+#endif
 #define TEST_CURVE25519_FIELD_OPS // Exposes Curve25519::isWeakPoint() for testing keys
 
 class CryptoEngine
@@ -49,7 +54,15 @@ class CryptoEngine
     virtual void aesSetKey(const uint8_t *key, size_t key_len);
 
     virtual void aesEncrypt(uint8_t *in, uint8_t *out);
-    AESSmall256 *aes = NULL;
+
+    /**
+     * AES-CCM with a 13 byte nonce, an M byte auth tag and no additional data, see aes-ccm.h.
+     * Engines with a native CCM implementation override these.
+     */
+    virtual bool ccmEncrypt(const uint8_t *key, size_t keyLen, const uint8_t *nonce, size_t M, const uint8_t *plain, size_t len,
+                            uint8_t *crypt, uint8_t *auth);
+    virtual bool ccmDecrypt(const uint8_t *key, size_t keyLen, const uint8_t *nonce, size_t M, const uint8_t *crypt, size_t len,
+                            const uint8_t *auth, uint8_t *plain);
 
 #endif
 
@@ -71,6 +84,14 @@ class CryptoEngine
      */
     virtual void encryptPacket(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes);
     virtual void decrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes);
+
+    /**
+     * Decrypt a channel packet with the given key instead of the one from setKey(), and without logging. For engines owned
+     * by a worker thread, see DecodeWorkerPool.
+     *
+     * @param bytes is updated in place
+     */
+    void decryptWithKey(const CryptoKey &k, uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes);
     virtual void encryptAESCtr(CryptoKey key, uint8_t *nonce, size_t numBytes, uint8_t *bytes);
 #ifndef PIO_UNIT_TESTING
   protected:
@@ -82,6 +103,16 @@ class CryptoEngine
 #if !(MESHTASTIC_EXCLUDE_PKI)
     uint8_t shared_key[32] = {0};
     uint8_t private_key[32] = {0};
+
+    /// An expanded AES256 key schedule, and the key it was expanded from
+    struct AesKeySchedule {
+        uint8_t key[32];
+        uint32_t lastUsed; // 0 if the slot is free
+        AES256 schedule;
+    };
+    AesKeySchedule aesKeys[AES_KEY_CACHE_SIZE] = {};
+    AesKeySchedule *aes = NULL; // The one aesEncrypt() uses, set by aesSetKey()
+    uint32_t aesKeyUses = 0;
 #endif
     /**
      * Init our 128 bit nonce for a new packet
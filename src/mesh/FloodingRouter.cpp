@@ -25,7 +25,8 @@ bool FloodingRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
         if (config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER &&
             config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER) {
             // cancel rebroadcast of this message *if* there was already one, unless we're a router/repeater!
-            Router::cancelSending(p->from, p->id);
+            // Only on the interface we heard it on, the nodes on our other interfaces may not have it yet
+            Router::cancelSending(p->from, p->id, rxIface);
         }
         return true;
     }
@@ -33,6 +34,37 @@ bool FloodingRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
     return Router::shouldFilterReceived(p);
 }
 
+bool FloodingRouter::dropDuplicate(const PacketHeader *h, uint32_t packetLen, RadioInterface *from)
+{
+    if (h->from == getNodeNum() || !wasSeenRecently(h->from, h->id, false, h->next_hop))
+        return false;
+
+    wasSeenRecently(h->from, h->id, true, h->next_hop); // Refresh the record, like for duplicates that make it to shouldFilterReceived()
+    LOG_DEBUG("Dropping duplicate fr=0x%x,to=0x%x,id=0x%x before queueing it\n", h->from, h->to, h->id);
+    if (config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER &&
+        config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER) {
+        // cancel rebroadcast of this message *if* there was already one, unless we're a router/repeater!
+        Router::cancelSending(h->from, h->id, from);
+    }
+    return true;
+}
+
+void FloodingRouter::rebroadcast(meshtastic_MeshPacket *tosend)
+{
+    tosend->hop_limit--; // bump down the hop count
+#if EVENT_MODE
+    if (tosend->hop_limit > 2) {
+        // if we are "correcting" the hop_limit, "correct" the hop_start by the same amount to preserve hops away.
+        tosend->hop_start -= (tosend->hop_limit - 2);
+        tosend->hop_limit = 2;
+    }
+#endif
+
+    // Note: we are careful to resend using the original senders node id
+    // We are careful not to call our hooked version of send() - because we don't want to check this again
+    Router::send(tosend);
+}
+
 void FloodingRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Routing *c)
 {
     bool isAckorReply = (p->which_payload_variant == meshtastic_MeshPacket_decoded_tag) && (p->decoded.request_id != 0);
@@ -44,21 +76,8 @@ void FloodingRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtas
     if ((p->to != getNodeNum()) && (p->hop_limit > 0) && (getFrom(p) != getNodeNum())) {
         if (p->id != 0) {
             if (config.device.role != meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE) {
-                meshtastic_MeshPacket *tosend = packetPool.allocCopy(*p); // keep a copy because we will be sending it
-
-                tosend->hop_limit--; // bump down the hop count
-#if EVENT_MODE
-                if (tosend->hop_limit > 2) {
-                    // if we are "correcting" the hop_limit, "correct" the hop_start by the same amount to preserve hops away.
-                    tosend->hop_start -= (tosend->hop_limit - 2);
-                    tosend->hop_limit = 2;
-                }
-#endif
-
                 LOG_INFO("Rebroadcasting received floodmsg to neighbors\n");
-                // Note: we are careful to resend using the original senders node id
-                // We are careful not to call our hooked version of send() - because we don't want to check this again
-                Router::send(tosend);
+                rebroadcast(packetPool.allocCopy(*p)); // keep a copy because we will be sending it
             } else {
                 LOG_DEBUG("Not rebroadcasting. Role = Role_ClientMute\n");
             }
@@ -43,6 +43,14 @@ class FloodingRouter : public Router, protected PacketHistory
      */
     virtual ErrorCode send(meshtastic_MeshPacket *p) override;
 
+    /**
+     * Drop packets we already have from the header alone, and cancel our own rebroadcast of them like
+     * shouldFilterReceived() would. Our own packets coming back are left to the regular path.
+     */
+    virtual bool dropDuplicate(const PacketHeader *h, uint32_t packetLen, RadioInterface *from) override;
+
+    virtual bool hasSeen(NodeNum from, PacketId id) override { return wasSeenRecently(from, id, false); }
+
   protected:
     /**
      * Should this incoming filter be dropped?
@@ -56,4 +64,9 @@ class FloodingRouter : public Router, protected PacketHistory
      * Look for broadcasts we need to rebroadcast
      */
     virtual void sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Routing *c) override;
+
+    /**
+     * Send a packet we received on to our neighbors, one hop further. Takes ownership of tosend.
+     */
+    void rebroadcast(meshtastic_MeshPacket *tosend);
 };
\ No newline at end of file
@@ -36,26 +36,35 @@ void fixPriority(meshtastic_MeshPacket *p)
 {
     // We might receive acks from other nodes (and since generated remotely, they won't have priority assigned.  Check for that
     // and fix it
-    if (p->priority == meshtastic_MeshPacket_Priority_UNSET) {
-        // if a reliable message give a bit higher default priority
-        p->priority = (p->want_ack ? meshtastic_MeshPacket_Priority_RELIABLE : meshtastic_MeshPacket_Priority_DEFAULT);
-        if (p->which_payload_variant == meshtastic_MeshPacket_decoded_tag) {
-            // if acks/naks give very high priority
-            if (p->decoded.portnum == meshtastic_PortNum_ROUTING_APP) {
-                p->priority = meshtastic_MeshPacket_Priority_ACK;
-                // if text or admin, give high priority
-            } else if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP ||
-                       p->decoded.portnum == meshtastic_PortNum_ADMIN_APP) {
-                p->priority = meshtastic_MeshPacket_Priority_HIGH;
-                // if it is a response, give higher priority to let it arrive early and stop the request being relayed
-            } else if (p->decoded.request_id != 0) {
-                p->priority = meshtastic_MeshPacket_Priority_RESPONSE;
-                // Also if we want a response, give a bit higher priority
-            } else if (p->decoded.want_response) {
-                p->priority = meshtastic_MeshPacket_Priority_RELIABLE;
-            }
+    if (p->priority == meshtastic_MeshPacket_Priority_UNSET)
+        p->priority = getPriority(p);
+}
+
+meshtastic_MeshPacket_Priority getPriority(const meshtastic_MeshPacket *p)
+{
+    if (p->priority != meshtastic_MeshPacket_Priority_UNSET)
+        return p->priority;
+
+    // if a reliable message give a bit higher default priority
+    meshtastic_MeshPacket_Priority priority =
+        p->want_ack ? meshtastic_MeshPacket_Priority_RELIABLE : meshtastic_MeshPacket_Priority_DEFAULT;
+    if (p->which_payload_variant == meshtastic_MeshPacket_decoded_tag) {
+        // if acks/naks give very high priority
+        if (p->decoded.portnum == meshtastic_PortNum_ROUTING_APP) {
+            priority = meshtastic_MeshPacket_Priority_ACK;
+            // if text or admin, give high priority
+        } else if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP ||
+                   p->decoded.portnum == meshtastic_PortNum_ADMIN_APP) {
+            priority = meshtastic_MeshPacket_Priority_HIGH;
+            // if it is a response, give higher priority to let it arrive early and stop the request being relayed
+        } else if (p->decoded.request_id != 0) {
+            priority = meshtastic_MeshPacket_Priority_RESPONSE;
+            // Also if we want a response, give a bit higher priority
+        } else if (p->decoded.want_response) {
+            priority = meshtastic_MeshPacket_Priority_RELIABLE;
         }
     }
+    return priority;
 }
 
 /** enqueue a packet, return false if full */
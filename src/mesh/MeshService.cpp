@@ -285,7 +285,7 @@ void MeshService::sendToPhone(meshtastic_MeshPacket *p)
 {
     perhapsDecode(p);
 
-#ifdef ARCH_ESP32
+#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)
 #if !MESHTASTIC_EXCLUDE_STOREFORWARD
     if (moduleConfig.store_forward.enabled && storeForwardModule->isServer() &&
         p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP) {
@@ -357,8 +357,8 @@ meshtastic_NodeInfoLite *MeshService::refreshLocalMeshNode()
     meshtastic_PositionLite &position = node->position;
 
     // Update our local node info with our time (even if we don't decide to update anyone else)
-    node->last_heard =
-        getValidTime(RTCQualityFromNet); // This nodedb timestamp might be stale, so update it if our clock is kinda valid
+    // This nodedb timestamp might be stale, so update it if our clock is kinda valid
+    nodeDB->updateLastHeard(node, getValidTime(RTCQualityFromNet), node->via_mqtt);
 
     position.time = getValidTime(RTCQualityFromNet);
 
@@ -17,6 +17,7 @@ typedef uint32_t PacketId; // A packet sequence number
 #define ERRNO_UNKNOWN 32                   // pick something that doesn't conflict with RH_ROUTER_ERROR_UNABLE_TO_DELIVER
 #define ERRNO_DISABLED 34                  // the interface is disabled
 #define ID_COUNTER_MASK (UINT32_MAX >> 22) // mask to select the counter portion of the ID
+#define NO_NEXT_HOP_PREFERENCE 0           // next_hop of a packet that is flooded
 
 /*
  * Source of a received message
@@ -50,5 +51,14 @@ extern Allocator<meshtastic_MeshPacket> &packetPool;
  */
 NodeNum getFrom(const meshtastic_MeshPacket *p);
 
+/**
+ * The last byte of a node number, which is how next_hop and relay_node refer to nodes in the packet header. As 0 means no
+ * next hop preference, a node number ending in 0x00 maps to 0xFF.
+ */
+uint8_t getLastByteOfNodeNum(NodeNum num);
+
 /* Some clients might not properly set priority, therefore we fix it here. */
-void fixPriority(meshtastic_MeshPacket *p);
\ No newline at end of file
+void fixPriority(meshtastic_MeshPacket *p);
+
+/// The priority of a packet, or the one fixPriority() would give it if it has none yet
+meshtastic_MeshPacket_Priority getPriority(const meshtastic_MeshPacket *p);
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "NextHopRouter.h"
+#include "RouteCache.h"
+#include "airtime.h"
+#include "configuration.h"
+
+NextHopRouter::NextHopRouter() {}
+
+bool NextHopRouter::isForOtherRelay(const meshtastic_MeshPacket *p)
+{
+    return p->to != NODENUM_BROADCAST && p->next_hop != NO_NEXT_HOP_PREFERENCE &&
+           p->next_hop != getLastByteOfNodeNum(getNodeNum());
+}
+
+void NextHopRouter::learnRoutes(const meshtastic_MeshPacket *p)
+{
+    // We need to know how far it came and who handed it to us, older firmware doesn't tell
+    if (!routeCache || p->from == 0 || p->from == getNodeNum() || p->via_mqtt || p->hop_start == 0 ||
+        p->hop_limit > p->hop_start || p->relay_node == NO_NEXT_HOP_PREFERENCE)
+        return;
+
+    if (p->hop_start == p->hop_limit) {
+        routeCache->learn(p->from, getLastByteOfNodeNum(p->from), ROUTE_SRC_DIRECT);
+    } else if (p->which_payload_variant == meshtastic_MeshPacket_decoded_tag && p->decoded.request_id &&
+               p->next_hop == NO_NEXT_HOP_PREFERENCE && p->relay_node != getLastByteOfNodeNum(getNodeNum())) {
+        // The first copy of a flooded ack or reply came along the quickest path, the node that relayed it is our way back
+        routeCache->learn(p->from, p->relay_node, ROUTE_SRC_RESPONSE);
+    }
+}
+
+void NextHopRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Routing *c)
+{
+    learnRoutes(p);
+
+    if (p->to == NODENUM_BROADCAST || p->next_hop == NO_NEXT_HOP_PREFERENCE) {
+        FloodingRouter::sniffReceived(p, c);
+        return;
+    }
+
+    // Only the relay the sender picked passes a routed packet on
+    if (!isForOtherRelay(p) && p->to != getNodeNum() && p->hop_limit > 0 && getFrom(p) != getNodeNum()) {
+        if (config.device.role != meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE) {
+            meshtastic_MeshPacket *tosend = packetPool.allocCopy(*p); // keep a copy because we will be sending it
+
+            // Along our own route if we have one, never back to where it came from, else flood it from here on
+            tosend->next_hop = routeCache ? routeCache->lookup(p->to, p->relay_node) : NO_NEXT_HOP_PREFERENCE;
+            LOG_INFO("Relaying routed packet to next hop 0x%x\n", tosend->next_hop);
+            rebroadcast(tosend);
+        } else {
+            LOG_DEBUG("Not relaying. Role = Role_ClientMute\n");
+        }
+    }
+
+    // handle the packet as normal
+    Router::sniffReceived(p, c);
+}
+
+bool NextHopRouter::forwardHeaderOnly(meshtastic_MeshPacket *p)
+{
+    // MQTT wants the packets published, and anything for us needs the full treatment
+    if (config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER ||
+        config.device.rebroadcast_mode != meshtastic_Config_DeviceConfig_RebroadcastMode_ALL_SKIP_DECODING ||
+        moduleConfig.mqtt.enabled || p->to == getNodeNum())
+        return false;
+
+    if (p->id == 0 || is_in_repeated(config.lora.ignore_incoming, p->from) || (config.lora.ignore_mqtt && p->via_mqtt) ||
+        wasSeenRecently(p->from, p->id, true, p->next_hop)) {
+        packetPool.release(p);
+        return true;
+    }
+
+    learnRoutes(p);
+    if (rxIface)
+        rxIface->getAirTime()->logPortnumAirtime(RX_LOG, meshtastic_PortNum_UNKNOWN_APP, rxIface->getPacketTime(p));
+
+    if (p->hop_limit == 0 || p->from == getNodeNum() || isForOtherRelay(p)) {
+        packetPool.release(p);
+        return true;
+    }
+
+    if (p->to != NODENUM_BROADCAST && p->next_hop != NO_NEXT_HOP_PREFERENCE)
+        p->next_hop = routeCache ? routeCache->lookup(p->to, p->relay_node) : NO_NEXT_HOP_PREFERENCE;
+    rebroadcast(p);
+    return true;
+}
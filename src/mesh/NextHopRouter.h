@@ -0,0 +1,38 @@
+#pragma once
+
+#include "FloodingRouter.h"
+
+/**
+ * Extends FloodingRouter with next hop routing of direct messages.
+ *
+ * A direct message can carry the last byte of the node that should relay it in next_hop. Only that node passes it on,
+ * along its own route to the destination if it knows one or by flooding if it doesn't. Everything without a next hop is
+ * flooded as before.
+ *
+ * The routes come from the packets we hear: anyone we hear without hops in between is a neighbor, and the first copy of
+ * a flooded ack or reply tells us which of them is on the quickest path back to its sender. TraceRouteModule and
+ * NeighborInfoModule add what they learn to the same routeCache.
+ */
+class NextHopRouter : public FloodingRouter
+{
+  public:
+    NextHopRouter();
+
+  protected:
+    /**
+     * Learn routes from what we hear, and relay direct messages that picked us as their next hop
+     */
+    virtual void sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Routing *c) override;
+
+    /// Is this a routed packet that someone other than us should relay?
+    bool isForOtherRelay(const meshtastic_MeshPacket *p);
+
+    /**
+     * Dedicated repeaters that don't decode anything only need the header: check for duplicates, take a hop off and queue
+     * the received packet itself for sending, without the copies, module calls and tracing of the regular receive path.
+     */
+    virtual bool forwardHeaderOnly(meshtastic_MeshPacket *p) override;
+
+  private:
+    void learnRoutes(const meshtastic_MeshPacket *p);
+};
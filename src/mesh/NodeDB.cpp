@@ -203,6 +203,11 @@ NodeNum getFrom(const meshtastic_MeshPacket *p)
     return (p->from == 0) ? nodeDB->getNodeNum() : p->from;
 }
 
+uint8_t getLastByteOfNodeNum(NodeNum num)
+{
+    return (num & 0xFF) ? (num & 0xFF) : 0xFF;
+}
+
 bool NodeDB::resetRadioConfig(bool factory_reset)
 {
     bool didFactoryReset = false;
@@ -542,6 +547,7 @@ void NodeDB::resetNodes()
     clearLocalPosition();
     numMeshNodes = 1;
     std::fill(devicestate.node_db_lite.begin() + 1, devicestate.node_db_lite.end(), meshtastic_NodeInfoLite());
+    recountNodes();
     saveDeviceStateToDisk();
     if (neighborInfoModule && moduleConfig.neighbor_info.enabled)
         neighborInfoModule->resetNeighbors();
@@ -559,6 +565,7 @@ void NodeDB::removeNodeByNum(NodeNum nodeNum)
     numMeshNodes -= removed;
     std::fill(devicestate.node_db_lite.begin() + numMeshNodes, devicestate.node_db_lite.begin() + numMeshNodes + 1,
               meshtastic_NodeInfoLite());
+    recountNodes();
     LOG_DEBUG("NodeDB::removeNodeByNum purged %d entries. Saving changes...\n", removed);
     saveDeviceStateToDisk();
 }
@@ -591,6 +598,7 @@ void NodeDB::cleanupMeshDB()
     numMeshNodes -= removed;
     std::fill(devicestate.node_db_lite.begin() + numMeshNodes, devicestate.node_db_lite.begin() + numMeshNodes + removed,
               meshtastic_NodeInfoLite());
+    recountNodes();
     LOG_DEBUG("cleanupMeshDB purged %d entries\n", removed);
 }
 
@@ -601,6 +609,7 @@ void NodeDB::installDefaultDeviceState()
 
     numMeshNodes = 0;
     meshNodes = &devicestate.node_db_lite;
+    recountNodes();
 
     // init our devicestate with valid flags so protobuf writing/reading will work
     devicestate.has_my_node = true;
@@ -660,6 +669,43 @@ static const char *moduleConfigFileName = "/prefs/module.proto";
 static const char *channelFileName = "/prefs/channels.proto";
 static const char *oemConfigFile = "/oem/oem.proto";
 
+#ifdef FSCom
+// pb_decode asks for a few bytes at a time, so read the file in blocks instead of going to the filesystem for every field
+struct ProtoFileReader {
+    File *file;
+    size_t pos;
+    size_t len;
+    uint8_t block[256];
+};
+
+static bool readProtoBlock(pb_istream_t *stream, uint8_t *buf, size_t count)
+{
+    auto reader = (ProtoFileReader *)stream->state;
+
+    while (count) {
+        if (reader->pos == reader->len) {
+            int got = reader->file->read(reader->block, sizeof(reader->block));
+            if (got <= 0)
+                return false;
+            reader->pos = 0;
+            reader->len = got;
+        }
+        size_t n = reader->len - reader->pos < count ? reader->len - reader->pos : count;
+        if (buf) {
+            memcpy(buf, reader->block + reader->pos, n);
+            buf += n;
+        }
+        reader->pos += n;
+        count -= n;
+    }
+
+    // protoSize is only an upper bound, tell pb_decode where the file ends so it stops there
+    if (reader->pos == reader->len && reader->file->available() == 0)
+        stream->bytes_left = 0;
+    return true;
+}
+#endif
+
 /** Load a protobuf from a file, return LoadFileResult */
 LoadFileResult NodeDB::loadProto(const char *filename, size_t protoSize, size_t objSize, const pb_msgdesc_t *fields,
                                  void *dest_struct)
@@ -671,7 +717,8 @@ LoadFileResult NodeDB::loadProto(const char *filename, size_t protoSize, size_t
 
     if (f) {
         LOG_INFO("Loading %s\n", filename);
-        pb_istream_t stream = {&readcb, &f, protoSize};
+        ProtoFileReader reader = {&f, 0, 0};
+        pb_istream_t stream = {&readProtoBlock, &reader, protoSize};
 
         memset(dest_struct, 0, objSize);
         if (!pb_decode(&stream, fields, dest_struct)) {
@@ -940,23 +987,74 @@ uint32_t sinceReceived(const meshtastic_MeshPacket *p)
     return delta;
 }
 
-#define NUM_ONLINE_SECS (60 * 60 * 2) // 2 hrs to consider someone offline
-
 size_t NodeDB::getNumOnlineMeshNodes(bool localOnly)
 {
     size_t numseen = 0;
 
-    // FIXME this implementation is kinda expensive
-    for (int i = 0; i < numMeshNodes; i++) {
-        if (localOnly && meshNodes->at(i).via_mqtt)
-            continue;
-        if (sinceLastSeen(&meshNodes->at(i)) < NUM_ONLINE_SECS)
-            numseen++;
+    // A bucket ahead of our clock, because it was set back, counts as just now
+    uint32_t period = getTime() / ONLINE_BUCKET_SECS;
+    for (const OnlineBucket &b : onlineBuckets) {
+        if ((int32_t)(period - b.period) < NUM_ONLINE_BUCKETS)
+            numseen += localOnly ? b.local : b.local + b.mqtt;
     }
 
     return numseen;
 }
 
+void NodeDB::updateLastHeard(meshtastic_NodeInfoLite *n, uint32_t lastHeard, bool viaMqtt)
+{
+    countNode(n, -1);
+    n->last_heard = lastHeard;
+    n->via_mqtt = viaMqtt;
+    countNode(n, 1);
+}
+
+void NodeDB::countNode(const meshtastic_NodeInfoLite *n, int delta)
+{
+    if (n->via_mqtt)
+        numMqttMeshNodes += delta;
+
+    uint32_t period = n->last_heard / ONLINE_BUCKET_SECS;
+    if (delta > 0) {
+        // Like sinceLastSeen(), a last_heard ahead of our clock counts as just now
+        uint32_t now = getTime() / ONLINE_BUCKET_SECS;
+        if ((int32_t)(period - now) > 0) {
+            aheadPeriods[n->num] = now;
+            period = now;
+        }
+    } else {
+        auto ahead = aheadPeriods.find(n->num);
+        if (ahead != aheadPeriods.end()) {
+            period = ahead->second;
+            aheadPeriods.erase(ahead);
+        }
+    }
+
+    OnlineBucket &b = onlineBuckets[period % NUM_ONLINE_BUCKETS];
+    if (b.period != period) {
+        // A bucket holds one period at a time. If the node is newer, the period in it expired and the node starts the next one.
+        // If the node is older, it expired along with its period and isn't counted (anymore).
+        if (delta < 0 || (int32_t)(b.period - period) > 0)
+            return;
+        b = {period, 0, 0};
+    }
+
+    uint16_t &count = n->via_mqtt ? b.mqtt : b.local;
+    if (delta > 0)
+        count++;
+    else if (count > 0)
+        count--;
+}
+
+void NodeDB::recountNodes()
+{
+    memset(onlineBuckets, 0, sizeof(onlineBuckets));
+    aheadPeriods.clear();
+    numMqttMeshNodes = 0;
+    for (int i = 0; i < numMeshNodes; i++)
+        countNode(&meshNodes->at(i), 1);
+}
+
 #include "MeshModule.h"
 #include "Throttle.h"
 
@@ -1090,14 +1188,12 @@ void NodeDB::updateFrom(const meshtastic_MeshPacket &mp)
             return;
         }
 
-        if (mp.rx_time) // if the packet has a valid timestamp use it to update our last_heard
-            info->last_heard = mp.rx_time;
+        // if the packet has a valid timestamp use it to update our last_heard, and store if we received it via MQTT
+        updateLastHeard(info, mp.rx_time ? mp.rx_time : info->last_heard, mp.via_mqtt);
 
         if (mp.rx_snr)
             info->snr = mp.rx_snr; // keep the most recent SNR we received for this node.
 
-        info->via_mqtt = mp.via_mqtt; // Store if we received this packet via MQTT
-
         // If hopStart was set and there wasn't someone messing with the limit in the middle, add hopsAway
         if (mp.hop_start != 0 && mp.hop_limit <= mp.hop_start)
             info->hops_away = mp.hop_start - mp.hop_limit;
@@ -1157,6 +1253,8 @@ meshtastic_NodeInfoLite *NodeDB::getOrCreateMeshNode(NodeNum n)
             if (oldestBoringIndex != -1) {
                 oldestIndex = oldestBoringIndex;
             }
+            if (oldestIndex != -1)
+                countNode(&meshNodes->at(oldestIndex), -1);
             // Shove the remaining nodes down the chain
             for (int i = oldestIndex; i < numMeshNodes - 1; i++) {
                 meshNodes->at(i) = meshNodes->at(i + 1);
@@ -1169,6 +1267,7 @@ meshtastic_NodeInfoLite *NodeDB::getOrCreateMeshNode(NodeNum n)
         // everything is missing except the nodenum
         memset(lite, 0, sizeof(*lite));
         lite->num = n;
+        countNode(lite, 1);
         LOG_INFO("Adding node to database with %i nodes and %i bytes free!\n", numMeshNodes, memGet.getFreeHeap());
     }
 
@@ -3,6 +3,7 @@
 #include "Observer.h"
 #include <Arduino.h>
 #include <assert.h>
+#include <map>
 #include <vector>
 
 #include "MeshTypes.h"
@@ -24,6 +25,11 @@ DeviceState versions used to be defined in the .proto file but really only this
 #define DEVICESTATE_CUR_VER 23
 #define DEVICESTATE_MIN_VER 22
 
+#define NUM_ONLINE_SECS (60 * 60 * 2) // 2 hrs to consider someone offline
+// Online nodes are counted per period of NUM_ONLINE_SECS / NUM_ONLINE_BUCKETS, so they go offline to within one period
+#define NUM_ONLINE_BUCKETS 16
+#define ONLINE_BUCKET_SECS (NUM_ONLINE_SECS / NUM_ONLINE_BUCKETS)
+
 extern meshtastic_DeviceState devicestate;
 extern meshtastic_ChannelFile channelFile;
 extern meshtastic_MyNodeInfo &myNodeInfo;
@@ -125,6 +131,9 @@ class NodeDB
      */
     size_t getNumOnlineMeshNodes(bool localOnly = false);
 
+    /// Set when we last heard from a node and how, use this instead of writing last_heard or via_mqtt so the counts stay right
+    void updateLastHeard(meshtastic_NodeInfoLite *n, uint32_t lastHeard, bool viaMqtt);
+
     void initConfigIntervals(), initModuleConfigIntervals(), resetNodes(), removeNodeByNum(NodeNum nodeNum);
 
     bool factoryReset(bool eraseBleBonds = false);
@@ -145,7 +154,7 @@ class NodeDB
     }
 
     meshtastic_NodeInfoLite *getMeshNode(NodeNum n);
-    size_t getNumMeshNodes() { return numMeshNodes; }
+    size_t getNumMeshNodes(bool localOnly = false) { return localOnly ? numMeshNodes - numMqttMeshNodes : numMeshNodes; }
 
     void clearLocalPosition();
 
@@ -162,8 +171,29 @@ class NodeDB
         localPosition = position;
     }
 
+    /// Count all nodes from scratch, after the DB changed wholesale or our clock stepped
+    void recountNodes();
+
   private:
     uint32_t lastNodeDbSave = 0; // when we last saved our db to flash
+
+    /// The nodes last heard in one period of ONLINE_BUCKET_SECS
+    struct OnlineBucket {
+        uint32_t period; // getTime() / ONLINE_BUCKET_SECS
+        uint16_t local;
+        uint16_t mqtt;
+    };
+
+    /// Kept up to date as nodes come, go and are heard from, so counting doesn't need a scan of the whole DB
+    OnlineBucket onlineBuckets[NUM_ONLINE_BUCKETS] = {};
+    pb_size_t numMqttMeshNodes = 0;
+
+    /// The period the nodes last heard ahead of our clock were counted in, so they come out of the same bucket again
+    std::map<NodeNum, uint32_t> aheadPeriods;
+
+    /// Add a node to the counts (delta 1) or take it out of them (delta -1)
+    void countNode(const meshtastic_NodeInfoLite *n, int delta);
+
     /// Find a node in our DB, create an empty NodeInfoLite if missing
     meshtastic_NodeInfoLite *getOrCreateMeshNode(NodeNum n);
 
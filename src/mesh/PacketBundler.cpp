@@ -0,0 +1,202 @@
+#include "PacketBundler.h"
+#include "NodeDB.h"
+#include "Router.h"
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+#include "mesh/generated/meshtastic/telemetry.pb.h"
+#include <algorithm>
+#include <vector>
+
+PacketBundler *packetBundler;
+
+PacketBundler::PacketBundler() : concurrency::OSThread("PacketBundler")
+{
+    disable(); // Only runs while we hold something
+}
+
+bool PacketBundler::isEligible(const meshtastic_MeshPacket *p) const
+{
+    if (p->to != NODENUM_BROADCAST || p->which_payload_variant != meshtastic_MeshPacket_decoded_tag ||
+        getFrom(p) != nodeDB->getNodeNum() || p->priority != meshtastic_MeshPacket_Priority_BACKGROUND || p->want_ack)
+        return false;
+
+    // Records only carry the port, id and payload
+    const meshtastic_Data &d = p->decoded;
+    if (d.want_response || d.request_id || d.reply_id || d.dest || d.source || d.emoji)
+        return false;
+
+    return isBundlePort(d.portnum) && recordSize(p) <= sizeof(d.payload.bytes);
+}
+
+bool PacketBundler::isBundlePort(meshtastic_PortNum portnum)
+{
+    switch (portnum) {
+    case meshtastic_PortNum_POSITION_APP:
+    case meshtastic_PortNum_NODEINFO_APP:
+    case meshtastic_PortNum_TELEMETRY_APP:
+    case meshtastic_PortNum_NEIGHBORINFO_APP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool PacketBundler::peersSupportBundles() const
+{
+    // Holding packets back only pays off if someone can split the bundle
+    bool anyPeer = false;
+    for (size_t i = 0; i < nodeDB->getNumMeshNodes(); i++) {
+        const meshtastic_NodeInfoLite *n = nodeDB->getMeshNodeByIndex(i);
+        if (n->num == nodeDB->getNodeNum() || n->via_mqtt || sinceLastSeen(n) > BUNDLE_PEER_SECS)
+            continue;
+        if (!isBundlingSupported(n->num))
+            return false;
+        anyPeer = true;
+    }
+    return anyPeer;
+}
+
+/// Which kind of metrics a telemetry payload carries, 0 if it doesn't decode
+static pb_size_t telemetryVariant(const meshtastic_MeshPacket *p)
+{
+    meshtastic_Telemetry t = meshtastic_Telemetry_init_zero;
+    if (!pb_decode_from_bytes(p->decoded.payload.bytes, p->decoded.payload.size, &meshtastic_Telemetry_msg, &t))
+        return 0;
+    return t.which_variant;
+}
+
+bool PacketBundler::replaces(const meshtastic_MeshPacket *newer, const meshtastic_MeshPacket *older)
+{
+    if (newer->decoded.portnum != older->decoded.portnum)
+        return false;
+    // Device metrics must not push out environment metrics that are still waiting, or the other way around
+    if (newer->decoded.portnum == meshtastic_PortNum_TELEMETRY_APP) {
+        pb_size_t variant = telemetryVariant(newer);
+        return variant && variant == telemetryVariant(older);
+    }
+    return true;
+}
+
+bool PacketBundler::hold(meshtastic_MeshPacket *p)
+{
+    if (!windowMs || moduleConfig.mqtt.enabled || !isEligible(p) || !peersSupportBundles())
+        return false;
+
+    // A newer broadcast of the same kind makes the one still waiting stale
+    for (uint8_t i = 0; i < numHeld; i++) {
+        if (replaces(p, held[i])) {
+            heldBytes -= recordSize(held[i]);
+            packetPool.release(held[i]);
+            memmove(&held[i], &held[i + 1], (numHeld - i - 1) * sizeof(held[0]));
+            numHeld--;
+            break;
+        }
+    }
+
+    if (numHeld && (held[0]->channel != p->channel || held[0]->hop_limit != p->hop_limit || numHeld == BUNDLE_MAX_RECORDS ||
+                    heldBytes + recordSize(p) > sizeof(p->decoded.payload.bytes)))
+        flush();
+
+    if (!numHeld) {
+        enabled = true;
+        setIntervalFromNow(windowMs);
+    }
+    held[numHeld++] = p;
+    heldBytes += recordSize(p);
+    LOG_DEBUG("Holding packet id=0x%08x for a bundle, %u held\n", p->id, numHeld);
+    return true;
+}
+
+void PacketBundler::flush()
+{
+    if (!numHeld)
+        return;
+
+    if (numHeld == 1) {
+        router->send(held[0]);
+    } else {
+        meshtastic_MeshPacket *b = router->allocForSending();
+        b->channel = held[0]->channel;
+        b->hop_limit = held[0]->hop_limit;
+        b->priority = meshtastic_MeshPacket_Priority_BACKGROUND;
+        b->decoded.portnum = BUNDLE_PORTNUM;
+
+        uint8_t *out = b->decoded.payload.bytes;
+        for (uint8_t i = 0; i < numHeld; i++) {
+            out += writeRecord(out, held[i]);
+            packetPool.release(held[i]);
+        }
+        b->decoded.payload.size = out - b->decoded.payload.bytes;
+
+        LOG_INFO("Sending %u broadcasts bundled in one packet of %u bytes\n", numHeld, b->decoded.payload.size);
+        router->send(b);
+    }
+    numHeld = 0;
+    heldBytes = 0;
+}
+
+int32_t PacketBundler::runOnce()
+{
+    flush();
+    return disable();
+}
+
+size_t PacketBundler::writeRecord(uint8_t *out, const meshtastic_MeshPacket *p)
+{
+    out[0] = p->decoded.portnum;
+    out[1] = p->decoded.payload.size;
+    for (int i = 0; i < 4; i++)
+        out[2 + i] = p->id >> (8 * i);
+    memcpy(out + 6, p->decoded.payload.bytes, p->decoded.payload.size);
+    return recordSize(p);
+}
+
+bool PacketBundler::unbundleNext(const meshtastic_MeshPacket &bundle, size_t &offset, meshtastic_MeshPacket &record)
+{
+    const uint8_t *in;
+    while (true) {
+        in = bundle.decoded.payload.bytes + offset;
+        size_t left = bundle.decoded.payload.size - offset;
+        if (offset >= bundle.decoded.payload.size || left < 6 || left - 6 < in[1])
+            return false;
+        // We never bundle anything else. Records would skip the checks Router does on packets (admin, acks), so drop them.
+        if (isBundlePort((meshtastic_PortNum)in[0]))
+            break;
+        LOG_WARN("Dropping bundled record on port %u from 0x%x\n", in[0], getFrom(&bundle));
+        offset += 6 + in[1];
+    }
+
+    record.decoded.portnum = (meshtastic_PortNum)in[0];
+    record.decoded.payload.size = in[1];
+    record.id = in[2] | (in[3] << 8) | (in[4] << 16) | ((uint32_t)in[5] << 24);
+    memcpy(record.decoded.payload.bytes, in + 6, in[1]);
+    record.decoded.want_response = false;
+    offset += 6 + in[1];
+    return true;
+}
+
+// Nodes that can split bundles, sorted. Bounded like the node DB, if it is full newcomers count as not supporting it.
+static std::vector<NodeNum> bundlingNodes;
+
+void setBundlingSupported(NodeNum node, bool supported)
+{
+    auto it = std::lower_bound(bundlingNodes.begin(), bundlingNodes.end(), node);
+    bool known = it != bundlingNodes.end() && *it == node;
+
+    if (supported && !known && bundlingNodes.size() < MAX_NUM_NODES)
+        bundlingNodes.insert(it, node);
+    else if (!supported && known)
+        bundlingNodes.erase(it);
+}
+
+void learnBundlingSupported(const meshtastic_MeshPacket *p)
+{
+    bool canSplit = p->decoded.has_bitfield && (p->decoded.bitfield & BITFIELD_BUNDLE_MASK);
+    if (canSplit || p->decoded.portnum == meshtastic_PortNum_NODEINFO_APP)
+        setBundlingSupported(p->from, canSplit);
+}
+
+bool isBundlingSupported(NodeNum node)
+{
+    return std::binary_search(bundlingNodes.begin(), bundlingNodes.end(), node);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "concurrency/OSThread.h"
+
+/// Port a bundle travels on. From the private range, until one gets assigned upstream.
+#define BUNDLE_PORTNUM ((meshtastic_PortNum)(meshtastic_PortNum_PRIVATE_APP + 48))
+
+// Longest one of our broadcasts waits for others to share a packet with, unless set otherwise with setWindow()
+#ifndef BUNDLE_WINDOW_MS
+#define BUNDLE_WINDOW_MS (30 * 1000)
+#endif
+
+#define BUNDLE_MAX_RECORDS 4
+
+// Only bundle when every node heard this recently (other than over MQTT) can split bundles
+#define BUNDLE_PEER_SECS (2 * 60 * 60)
+
+/**
+ * Coalesces the small periodic broadcasts of our own node (position, node info, device telemetry and neighbor info) into
+ * a single packet, so they share one header, preamble and contention window instead of paying for each.
+ *
+ * Eligible packets are held for up to the window (BUNDLE_WINDOW_MS by default). When the window ends, or the next one would
+ * not fit, whatever is held goes out as one packet on BUNDLE_PORTNUM: a portnum byte, a length byte and the packet id
+ * (little endian) for every record, followed by its payload. A lone packet is sent as it is. A newer broadcast of the
+ * same kind (port, and for telemetry the kind of metrics) replaces the one still waiting.
+ *
+ * Nodes that can split bundles set BITFIELD_BUNDLE on everything they send. As anyone may be listening to a broadcast, we
+ * only bundle while we heard at least one such node lately and no other ones. Nodes with an MQTT uplink don't bundle, and
+ * receivers with one publish the records instead of the bundle, so the broker keeps seeing the individual packets.
+ */
+class PacketBundler : private concurrency::OSThread
+{
+  public:
+    PacketBundler();
+
+    /**
+     * Called with a packet of ours that is about to be sent, after local delivery.
+     * @return true if we took the packet, false if it should be sent right away
+     */
+    bool hold(meshtastic_MeshPacket *p);
+
+    /// How long a packet may wait for others, 0 turns bundling off
+    void setWindow(uint32_t ms) { windowMs = ms; }
+
+    /// The ports we bundle, and the only ones accepted in a received bundle
+    static bool isBundlePort(meshtastic_PortNum portnum);
+
+    /// Does newer make older, still waiting to be sent, stale?
+    static bool replaces(const meshtastic_MeshPacket *newer, const meshtastic_MeshPacket *older);
+
+    /// Append p as a record of a bundle, returns the bytes written (recordSize())
+    static size_t writeRecord(uint8_t *out, const meshtastic_MeshPacket *p);
+    static size_t recordSize(const meshtastic_MeshPacket *p) { return 6 + p->decoded.payload.size; }
+
+    /**
+     * Get the next record out of a received bundle. Records on a port we wouldn't bundle ourselves (isBundlePort()) are
+     * skipped.
+     * @param offset Where in the payload to continue, start with 0
+     * @param record Set up as a copy of bundle, gets the port, id and payload of the record
+     * @return false when there are no more records, or the rest of the bundle is malformed
+     */
+    static bool unbundleNext(const meshtastic_MeshPacket &bundle, size_t &offset, meshtastic_MeshPacket &record);
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    meshtastic_MeshPacket *held[BUNDLE_MAX_RECORDS];
+    uint8_t numHeld = 0;
+    size_t heldBytes = 0; // Size the bundle payload would have
+    uint32_t windowMs = BUNDLE_WINDOW_MS;
+
+    bool isEligible(const meshtastic_MeshPacket *p) const;
+    bool peersSupportBundles() const;
+
+    /// Send what we hold
+    void flush();
+};
+
+extern PacketBundler *packetBundler;
+
+/// Remember whether a node told us it can split bundles
+void setBundlingSupported(NodeNum node, bool supported);
+
+/// Update what we know about the sender of a decoded packet, see learnCompressionSupported()
+void learnBundlingSupported(const meshtastic_MeshPacket *p);
+
+/// Did this node tell us it can split bundles?
+bool isBundlingSupported(NodeNum node);
@@ -1,4 +1,5 @@
 #include "PacketHistory.h"
+#include "NodeDB.h"
 #include "configuration.h"
 #include "mesh-pb-constants.h"
 
@@ -22,12 +23,33 @@ bool PacketHistory::wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpd
         return false; // Not a floodable message ID, so we don't care
     }
 
+    // Our own packets are seen, whatever way they went: the sender end of a fallback is the one sending it
+    bool ours = getFrom(p) == nodeDB->getNodeNum();
+    bool seenRecently = wasSeenRecently(getFrom(p), p->id, withUpdate, ours ? NEXT_HOP_UNKNOWN : p->next_hop);
+
+    if (seenRecently) {
+        LOG_DEBUG("Found existing packet record for fr=0x%x,to=0x%x,id=0x%x\n", p->from, p->to, p->id);
+    }
+
+    if (withUpdate) {
+        printPacket("Add packet record", p);
+    }
+
+    return seenRecently;
+}
+
+bool PacketHistory::wasSeenRecently(NodeNum sender, PacketId id, bool withUpdate, int16_t nextHop)
+{
+    if (id == 0)
+        return false;
+
     uint32_t now = millis();
 
     PacketRecord r;
-    r.id = p->id;
-    r.sender = getFrom(p);
+    r.id = id;
+    r.sender = sender;
     r.rxTimeMsec = now;
+    r.routed = nextHop != NEXT_HOP_UNKNOWN && nextHop != NO_NEXT_HOP_PREFERENCE;
 
     auto found = recentPackets.find(r);
     bool seenRecently = (found != recentPackets.end()); // found not equal to .end() means packet was seen recently
@@ -38,8 +60,12 @@ bool PacketHistory::wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpd
         seenRecently = false;
     }
 
-    if (seenRecently) {
-        LOG_DEBUG("Found existing packet record for fr=0x%x,to=0x%x,id=0x%x\n", p->from, p->to, p->id);
+    if (seenRecently && found->routed && nextHop == NO_NEXT_HOP_PREFERENCE) {
+        LOG_DEBUG("Packet fr=0x%x,id=0x%x was routed before, now it is flooded\n", sender, id);
+        seenRecently = false;
+    } else if (seenRecently) {
+        // Routed until the first flooded copy, a copy we don't know the next hop of changes nothing
+        r.routed = found->routed && nextHop != NO_NEXT_HOP_PREFERENCE;
     }
 
     if (withUpdate) {
@@ -47,7 +73,6 @@ bool PacketHistory::wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpd
             recentPackets.erase(found);     // as unsorted_set::iterator is const (can't update timestamp - so re-insert..)
         }
         recentPackets.insert(r);
-        printPacket("Add packet record", p);
     }
 
     // Capacity is reerved, so only purge expired packets if recentPackets fills past 90% capacity
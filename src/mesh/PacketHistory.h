@@ -6,6 +6,9 @@
 /// We clear our old flood record 10 minutes after we see the last of it
 #define FLOOD_EXPIRE_TIME (10 * 60 * 1000L)
 
+/// For wasSeenRecently() callers that don't know the next hop of what they saw
+#define NEXT_HOP_UNKNOWN -1
+
 /**
  * A record of a recent message broadcast
  */
@@ -13,6 +16,7 @@ struct PacketRecord {
     NodeNum sender;
     PacketId id;
     uint32_t rxTimeMsec; // Unix time in msecs - the time we received it
+    bool routed;         // Every copy we saw so far had a next hop
 
     bool operator==(const PacketRecord &p) const { return sender == p.sender && id == p.id; }
 };
@@ -42,4 +46,13 @@ class PacketHistory
      * @param withUpdate if true and not found we add an entry to recentPackets
      */
     bool wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpdate = true);
+
+    /**
+     * The same for the sender and id of a packet, without any logging, for paths that only look at the packet header
+     *
+     * @param nextHop of the copy we heard. A flooded copy of a packet we only saw routed so far is its sender falling back to
+     * flooding after the route failed, which doesn't count as seen: the nodes that overheard the routed attempt have to pass
+     * it on too.
+     */
+    bool wasSeenRecently(NodeNum sender, PacketId id, bool withUpdate = true, int16_t nextHop = NEXT_HOP_UNKNOWN);
 };
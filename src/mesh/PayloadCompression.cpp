@@ -0,0 +1,83 @@
+#include "PayloadCompression.h"
+#include "Router.h"
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+#include "mesh/compression/unishox2.h"
+#include <algorithm>
+#include <vector>
+
+bool isCompressiblePort(meshtastic_PortNum portnum)
+{
+    switch (portnum) {
+    case meshtastic_PortNum_TEXT_MESSAGE_APP:
+    case meshtastic_PortNum_STORE_FORWARD_APP: // Mostly history replays, which are text with a small header
+    case meshtastic_PortNum_DETECTION_SENSOR_APP:
+    case meshtastic_PortNum_RANGE_TEST_APP:
+    case meshtastic_PortNum_REPLY_APP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool compressPayload(meshtastic_Data &d)
+{
+    char compressed[sizeof(d.payload.bytes)];
+    if (d.payload.size < 2)
+        return false;
+
+    // unishox2 reports an overflow if the result doesn't fit, which also means it wouldn't be smaller
+    int len = unishox2_compress_lines((const char *)d.payload.bytes, d.payload.size, compressed, d.payload.size - 1,
+                                      USX_PSET_DFLT, NULL);
+    if (len <= 0 || len >= (int)d.payload.size)
+        return false;
+
+    memcpy(d.payload.bytes, compressed, len);
+    d.payload.size = len;
+    d.has_bitfield = true;
+    d.bitfield |= BITFIELD_COMPRESSED_MASK;
+    return true;
+}
+
+bool decompressPayload(meshtastic_Data &d)
+{
+    char decompressed[sizeof(d.payload.bytes) + 1]; // Room for the terminator unishox2 adds
+
+    int len = unishox2_decompress_lines((const char *)d.payload.bytes, d.payload.size, decompressed, sizeof(d.payload.bytes),
+                                        USX_PSET_DFLT, NULL);
+    if (len < 0 || len > (int)sizeof(d.payload.bytes))
+        return false;
+
+    memcpy(d.payload.bytes, decompressed, len);
+    d.payload.size = len;
+    d.bitfield &= ~BITFIELD_COMPRESSED_MASK;
+    return true;
+}
+
+// Nodes that can decompress, sorted. Bounded like the node DB, if it is full we just don't compress for newcomers.
+static std::vector<NodeNum> compressionNodes;
+
+void setCompressionSupported(NodeNum node, bool supported)
+{
+    auto it = std::lower_bound(compressionNodes.begin(), compressionNodes.end(), node);
+    bool known = it != compressionNodes.end() && *it == node;
+
+    if (supported && !known && compressionNodes.size() < MAX_NUM_NODES)
+        compressionNodes.insert(it, node);
+    else if (!supported && known)
+        compressionNodes.erase(it);
+}
+
+void learnCompressionSupported(const meshtastic_MeshPacket *p)
+{
+    // Any packet can tell us its sender takes compressed payloads, but only its NodeInfo that it no longer does (after a
+    // downgrade). A single older packet, say one replayed by S&F, must not turn it off.
+    bool canDecompress = p->decoded.has_bitfield && (p->decoded.bitfield & BITFIELD_COMPRESSION_MASK);
+    if (canDecompress || p->decoded.portnum == meshtastic_PortNum_NODEINFO_APP)
+        setCompressionSupported(p->from, canDecompress);
+}
+
+bool isCompressionSupported(NodeNum node)
+{
+    return std::binary_search(compressionNodes.begin(), compressionNodes.end(), node);
+}
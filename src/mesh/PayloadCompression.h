@@ -0,0 +1,31 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "mesh/generated/meshtastic/mesh.pb.h"
+
+/**
+ * unishox2 compression of packet payloads, negotiated per node.
+ *
+ * Nodes that can decompress set BITFIELD_COMPRESSION on everything they send (NodeInfo included), and we remember
+ * which nodes did until a NodeInfo from them comes without it. Payloads of text heavy ports sent directly to one of them
+ * are compressed and flagged with BITFIELD_COMPRESSED, as long as that actually makes them smaller. Broadcasts are never
+ * compressed, as not every node that hears them might understand it.
+ */
+
+/// Does this port carry mostly text, so it is worth trying to compress?
+bool isCompressiblePort(meshtastic_PortNum portnum);
+
+/// Compress the payload in place if that makes it smaller, returns true if it did
+bool compressPayload(meshtastic_Data &d);
+
+/// Undo compressPayload(), returns false if the payload can't be decompressed
+bool decompressPayload(meshtastic_Data &d);
+
+/// Remember whether a node told us it can decompress payloads
+void setCompressionSupported(NodeNum node, bool supported);
+
+/// Update what we know about the sender of a decoded packet
+void learnCompressionSupported(const meshtastic_MeshPacket *p);
+
+/// Did this node tell us it can decompress payloads?
+bool isCompressionSupported(NodeNum node);
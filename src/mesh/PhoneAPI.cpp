@@ -3,6 +3,7 @@
 #include "GPS.h"
 #endif
 
+#include "BootTimeline.h"
 #include "Channels.h"
 #include "Default.h"
 #include "FSCommon.h"
@@ -10,6 +11,7 @@
 #include "NodeDB.h"
 #include "PhoneAPI.h"
 #include "PowerFSM.h"
+#include "RTC.h"
 #include "RadioInterface.h"
 #include "TypeConversions.h"
 #include "main.h"
@@ -55,6 +57,7 @@ void PhoneAPI::handleStartConfig()
 
     LOG_INFO("Starting API client config\n");
     nodeInfoForPhone.num = 0; // Don't keep returning old nodeinfos
+    bootPhaseForPhone = 0;
     resetReadIndex();
 }
 
@@ -410,6 +413,16 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
             fromRadioScratch.which_payload_variant = meshtastic_FromRadio_packet_tag;
             fromRadioScratch.packet = *packetForPhone;
             releasePhonePacket();
+        } else if (hasBootPhaseForPhone()) {
+            // The protos have nowhere else to put it, so the boot timeline goes out as log records
+            const BootTimeline::Phase &phase = bootTimeline.get(bootPhaseForPhone++);
+            fromRadioScratch.which_payload_variant = meshtastic_FromRadio_log_record_tag;
+            fromRadioScratch.log_record.time = getValidTime(RTCQualityFromNet);
+            fromRadioScratch.log_record.level = meshtastic_LogRecord_Level_INFO;
+            strncpy(fromRadioScratch.log_record.source, "BootTimeline", sizeof(fromRadioScratch.log_record.source));
+            snprintf(fromRadioScratch.log_record.message, sizeof(fromRadioScratch.log_record.message),
+                     "%s: %u ms, started at %u ms%s", phase.name, phase.durationMs, phase.startMs,
+                     phase.deferred ? " (deferred)" : "");
         }
         break;
 
@@ -432,6 +445,37 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
     return 0;
 }
 
+meshtastic_MeshPacket *PhoneAPI::getPacketForPhone()
+{
+    return service->getForPhone();
+}
+
+meshtastic_QueueStatus *PhoneAPI::getQueueStatusForPhone()
+{
+    return service->getQueueStatusForPhone();
+}
+
+meshtastic_MqttClientProxyMessage *PhoneAPI::getMqttClientProxyMessageForPhone()
+{
+    return service->getMqttClientProxyMessageForPhone();
+}
+
+meshtastic_XModem PhoneAPI::getXModemForPhone()
+{
+    meshtastic_XModem p = meshtastic_XModem_init_zero;
+#ifdef FSCom
+    p = xModem.getForPhone();
+    xModem.resetForPhone();
+#endif
+    return p;
+}
+
+/// Phases go out in the order they began, a deferred one that is still running holds back the rest
+bool PhoneAPI::hasBootPhaseForPhone() const
+{
+    return bootPhaseForPhone < bootTimeline.size() && bootTimeline.get(bootPhaseForPhone).done;
+}
+
 void PhoneAPI::sendConfigComplete()
 {
     LOG_INFO("getFromRadio=STATE_SEND_COMPLETE_ID\n");
@@ -504,23 +548,19 @@ bool PhoneAPI::available()
         return true; // Always say we have something, because we might need to advance our state machine
     case STATE_SEND_PACKETS: {
         if (!queueStatusPacketForPhone)
-            queueStatusPacketForPhone = service->getQueueStatusForPhone();
+            queueStatusPacketForPhone = getQueueStatusForPhone();
         if (!mqttClientProxyMessageForPhone)
-            mqttClientProxyMessageForPhone = service->getMqttClientProxyMessageForPhone();
+            mqttClientProxyMessageForPhone = getMqttClientProxyMessageForPhone();
         bool hasPacket = !!queueStatusPacketForPhone || !!mqttClientProxyMessageForPhone;
         if (hasPacket)
             return true;
 
-#ifdef FSCom
         if (xmodemPacketForPhone.control == meshtastic_XModem_Control_NUL)
-            xmodemPacketForPhone = xModem.getForPhone();
-        if (xmodemPacketForPhone.control != meshtastic_XModem_Control_NUL) {
-            xModem.resetForPhone();
+            xmodemPacketForPhone = getXModemForPhone();
+        if (xmodemPacketForPhone.control != meshtastic_XModem_Control_NUL)
             return true;
-        }
-#endif
 
-#ifdef ARCH_ESP32
+#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)
 #if !MESHTASTIC_EXCLUDE_STOREFORWARD
         // Check if StoreForward has packets stored for us.
         if (!packetForPhone && storeForwardModule)
@@ -529,8 +569,8 @@ bool PhoneAPI::available()
 #endif
 
         if (!packetForPhone)
-            packetForPhone = service->getForPhone();
-        hasPacket = !!packetForPhone;
+            packetForPhone = getPacketForPhone();
+        hasPacket = !!packetForPhone || hasBootPhaseForPhone();
         // LOG_DEBUG("available hasPacket=%d\n", hasPacket);
         return hasPacket;
     }
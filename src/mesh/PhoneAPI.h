@@ -72,6 +72,9 @@ class PhoneAPI
     /// We temporarily keep the nodeInfo here between the call to available and getFromRadio
     meshtastic_NodeInfo nodeInfoForPhone = meshtastic_NodeInfo_init_default;
 
+    /// The next bootTimeline phase to send, once it is done
+    uint8_t bootPhaseForPhone = 0;
+
     meshtastic_ToRadio toRadioScratch = {
         0}; // this is a static scratch object, any data must be copied elsewhere before returning
 
@@ -83,6 +86,8 @@ class PhoneAPI
 
     void resetReadIndex() { readIndex = 0; }
 
+    bool hasBootPhaseForPhone() const;
+
   public:
     PhoneAPI();
 
@@ -137,6 +142,17 @@ class PhoneAPI
      */
     virtual void onNowHasData(uint32_t fromRadioNum) {}
 
+    /// Where the packets for the phone come from, subclasses that share them between several clients can override this
+    virtual meshtastic_MeshPacket *getPacketForPhone();
+
+    /// The same for queue status and MQTT proxy messages, which have to come from queueStatusPool and
+    /// mqttClientProxyMessagePool
+    virtual meshtastic_QueueStatus *getQueueStatusForPhone();
+    virtual meshtastic_MqttClientProxyMessage *getMqttClientProxyMessageForPhone();
+
+    /// The reply to the last xmodem packet, control is NUL if there is none
+    virtual meshtastic_XModem getXModemForPhone();
+
     /**
      * Subclasses can use this to find out when a client drops the link
      */
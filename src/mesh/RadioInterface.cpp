@@ -226,7 +226,7 @@ uint32_t RadioInterface::getRetransmissionMsec(const meshtastic_MeshPacket *p)
     uint32_t packetAirtime = getPacketTime(numbytes + sizeof(PacketHeader));
     // Make sure enough time has elapsed for this packet to be sent and an ACK is received.
     // LOG_DEBUG("Waiting for flooding message with airtime %d and slotTime is %d\n", packetAirtime, slotTimeMsec);
-    float channelUtil = airTime->channelUtilizationPercent();
+    float channelUtil = getAirTime()->channelUtilizationPercent();
     uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
     // Assuming we pick max. of CWsize and there will be a client with SNR at half the range
     return 2 * packetAirtime + (pow(2, CWsize) + 2 * CWmax + pow(2, int((CWmax + CWmin) / 2))) * slotTimeMsec +
@@ -239,7 +239,7 @@ uint32_t RadioInterface::getTxDelayMsec()
     /** We wait a random multiple of 'slotTimes' (see definition in header file) in order to avoid collisions.
     The pool to take a random multiple from is the contention window (CW), which size depends on the
     current channel utilization. */
-    float channelUtil = airTime->channelUtilizationPercent();
+    float channelUtil = getAirTime()->channelUtilizationPercent();
     uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
     // LOG_DEBUG("Current channel utilization is %f so setting CWsize to %d\n", channelUtil, CWsize);
     return random(0, pow(2, CWsize)) * slotTimeMsec;
@@ -416,9 +416,9 @@ void RadioInterface::applyModemConfig()
     meshtastic_Config_LoRaConfig &loraConfig = config.lora;
     bool validConfig = false; // We need to check for a valid configuration
     while (!validConfig) {
-        if (loraConfig.use_preset) {
+        if (loraConfig.use_preset || hasPresetOverride) {
 
-            switch (loraConfig.modem_preset) {
+            switch (hasPresetOverride ? presetOverride : loraConfig.modem_preset) {
             case meshtastic_Config_LoRaConfig_ModemPreset_SHORT_TURBO:
                 bw = (myRegion->wideLora) ? 1625.0 : 500;
                 cr = 5;
@@ -524,9 +524,10 @@ void RadioInterface::applyModemConfig()
     // channel_num is actually (channel_num - 1), since modulus (%) returns values from 0 to (numChannels - 1)
     uint32_t channel_num = (loraConfig.channel_num ? loraConfig.channel_num - 1 : hash(channelName)) % numChannels;
 
-    // Check if we use the default frequency slot
-    RadioInterface::uses_default_frequency_slot =
-        channel_num == hash(DisplayFormatters::getModemPresetDisplayName(config.lora.modem_preset, false)) % numChannels;
+    // Check if we use the default frequency slot, that is about the radio that runs the configured preset
+    if (!hasPresetOverride)
+        RadioInterface::uses_default_frequency_slot =
+            channel_num == hash(DisplayFormatters::getModemPresetDisplayName(config.lora.modem_preset, false)) % numChannels;
 
     // Old frequency selection formula
     // float freq = myRegion->freqStart + ((((myRegion->freqEnd - myRegion->freqStart) / numChannels) / 2) * channel_num);
@@ -548,8 +549,8 @@ void RadioInterface::applyModemConfig()
     maxPacketTimeMsec = getPacketTime(meshtastic_Constants_DATA_PAYLOAD_LEN + sizeof(PacketHeader));
 
     LOG_INFO("Radio freq=%.3f, config.lora.frequency_offset=%.3f\n", freq, loraConfig.frequency_offset);
-    LOG_INFO("Set radio: region=%s, name=%s, config=%u, ch=%d, power=%d\n", myRegion->name, channelName, loraConfig.modem_preset,
-             channel_num, power);
+    LOG_INFO("Set radio: region=%s, name=%s, config=%u, ch=%d, power=%d\n", myRegion->name, channelName,
+             hasPresetOverride ? presetOverride : loraConfig.modem_preset, channel_num, power);
     LOG_INFO("Radio myRegion->freqStart -> myRegion->freqEnd: %f -> %f (%f MHz)\n", myRegion->freqStart, myRegion->freqEnd,
              myRegion->freqEnd - myRegion->freqStart);
     LOG_INFO("Radio myRegion->numChannels: %d x %.3fkHz\n", numChannels, bw);
@@ -580,7 +581,7 @@ void RadioInterface::limitPower()
 void RadioInterface::deliverToReceiver(meshtastic_MeshPacket *p)
 {
     if (router)
-        router->enqueueReceivedMessage(p);
+        router->enqueueReceivedMessage(p, this);
 }
 
 /***
@@ -601,8 +602,8 @@ size_t RadioInterface::beginSending(meshtastic_MeshPacket *p)
     h->to = p->to;
     h->id = p->id;
     h->channel = p->channel;
-    h->next_hop = 0;   // *** For future use ***
-    h->relay_node = 0; // *** For future use ***
+    h->next_hop = p->next_hop;
+    h->relay_node = p->relay_node;
     if (p->hop_limit > HOP_MAX) {
         LOG_WARN("hop limit %d is too high, setting to %d\n", p->hop_limit, HOP_RELIABLE);
         p->hop_limit = HOP_RELIABLE;
@@ -36,13 +36,20 @@ typedef struct {
     /** The channel hash - used as a hint for the decoder to limit which channels we consider */
     uint8_t channel;
 
-    // ***For future use*** Last byte of the NodeNum of the next-hop for this packet
+    // Last byte of the NodeNum of the next-hop for this packet, NO_NEXT_HOP_PREFERENCE if it is flooded
     uint8_t next_hop;
 
-    // ***For future use*** Last byte of the NodeNum of the node that will relay/relayed this packet
+    // Last byte of the NodeNum of the node that will relay/relayed this packet
     uint8_t relay_node;
 } PacketHeader;
 
+/// How a router with several interfaces relays packets from others on one of them
+enum RebroadcastPolicy : uint8_t {
+    REBROADCAST_ALL,         // Relay everything, also packets heard on this interface itself
+    REBROADCAST_BRIDGE_ONLY, // Only relay packets heard on another interface, e.g. for a backbone link between two meshes
+    REBROADCAST_NONE,        // Only send our own packets
+};
+
 /**
  * Basic operations all radio chipsets must implement.
  *
@@ -64,6 +71,13 @@ class RadioInterface
   protected:
     bool disabled = false;
 
+    /// Our own airtime accounting, NULL if we use the global airTime
+    AirTime *ownAirTime = NULL;
+
+    /// Use presetOverride instead of the modem preset in config.lora
+    bool hasPresetOverride = false;
+    meshtastic_Config_LoRaConfig_ModemPreset presetOverride;
+
     float bw = 125;
     uint8_t sf = 9;
     uint8_t cr = 5;
@@ -140,6 +154,33 @@ class RadioInterface
     /** Attempt to cancel a previously sent packet.  Returns true if a packet was found we could cancel */
     virtual bool cancelSending(NodeNum from, PacketId id) { return false; }
 
+    /**
+     * Only consulted when the router has more than one interface, a lone interface relays whatever the router decides to
+     */
+    RebroadcastPolicy rebroadcastPolicy = REBROADCAST_ALL;
+
+    /// Should we relay a packet from someone else here, given whether we heard it on this interface?
+    bool shouldRelay(bool heardHere) const
+    {
+        return rebroadcastPolicy == REBROADCAST_ALL || (rebroadcastPolicy == REBROADCAST_BRIDGE_ONLY && !heardHere);
+    }
+
+    /// The airtime (and duty cycle) accounting for this interface
+    AirTime *getAirTime() { return ownAirTime ? ownAirTime : airTime; }
+
+    /// Keep our own airtime accounting, for interfaces on another channel than the primary one
+    void setAirTime(AirTime *a) { ownAirTime = a; }
+
+    /**
+     * Use this modem preset instead of the one in config.lora, so a second radio can run a different one.
+     * Takes effect on the next reconfigure().
+     */
+    void setModemPreset(meshtastic_Config_LoRaConfig_ModemPreset preset)
+    {
+        presetOverride = preset;
+        hasPresetOverride = true;
+    }
+
     // methods from radiohead
 
     /// Initialise the Driver transport hardware and software.
@@ -169,7 +210,7 @@ class RadioInterface
      * @return num msecs for the packet
      */
     uint32_t getPacketTime(const meshtastic_MeshPacket *p);
-    uint32_t getPacketTime(uint32_t totalPacketLen);
+    virtual uint32_t getPacketTime(uint32_t totalPacketLen);
 
     /**
      * Get the channel we saved.
@@ -238,4 +279,7 @@ class RadioInterface
 };
 
 /// Debug printing for packets
-void printPacket(const char *prefix, const meshtastic_MeshPacket *p);
\ No newline at end of file
+void printPacket(const char *prefix, const meshtastic_MeshPacket *p);
+
+/// djb2 hash of a string, picks the frequency slot of a channel name
+uint32_t hash(const char *str);
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "MeshTypes.h"
 #include "NodeDB.h"
 #include "PowerMon.h"
+#include "Router.h"
 #include "SPILock.h"
 #include "configuration.h"
 #include "error.h"
@@ -163,7 +164,7 @@ ErrorCode RadioLibInterface::send(meshtastic_MeshPacket *p)
 #ifndef LORA_DISABLE_SENDING
     printPacket("enqueuing for send", p);
 
-    LOG_DEBUG("txGood=%d,rxGood=%d,rxBad=%d\n", txGood, rxGood, rxBad);
+    LOG_DEBUG("txGood=%d,rxGood=%d,rxBad=%d,rxDupe=%d\n", txGood, rxGood, rxBad, rxDupe);
     ErrorCode res = txQueue.enqueue(p) ? ERRNO_OK : ERRNO_UNKNOWN;
 
     if (res != ERRNO_OK) { // we weren't able to queue it, so we must drop it to prevent leaks
@@ -259,7 +260,7 @@ void RadioLibInterface::onNotify(uint32_t notification)
 
                     // Packet has been sent, count it toward our TX airtime utilization.
                     uint32_t xmitMsec = getPacketTime(txp);
-                    airTime->logAirtime(TX_LOG, xmitMsec);
+                    getAirTime()->logTransmit(txp, xmitMsec);
                 }
             }
         } else {
@@ -361,7 +362,7 @@ void RadioLibInterface::handleReceiveInterrupt()
         LOG_ERROR("ignoring received packet due to error=%d\n", state);
         rxBad++;
 
-        airTime->logAirtime(RX_ALL_LOG, xmitMsec);
+        getAirTime()->logAirtime(RX_ALL_LOG, xmitMsec);
 
     } else {
         // Skip the 4 headers that are at the beginning of the rxBuf
@@ -372,7 +373,7 @@ void RadioLibInterface::handleReceiveInterrupt()
         if (payloadLen < 0) {
             LOG_WARN("ignoring received packet too short\n");
             rxBad++;
-            airTime->logAirtime(RX_ALL_LOG, xmitMsec);
+            getAirTime()->logAirtime(RX_ALL_LOG, xmitMsec);
         } else {
             const PacketHeader *h = (PacketHeader *)radiobuf;
             rxGood++;
@@ -382,6 +383,14 @@ void RadioLibInterface::handleReceiveInterrupt()
                 return;
             }
 
+            // On a busy mesh most of what we hear are copies of packets we already have, drop those before they take a
+            // packet buffer and a slot in the router queue
+            if (router && router->dropDuplicate(h, length, this)) {
+                rxDupe++;
+                getAirTime()->logAirtime(RX_LOG, xmitMsec);
+                return;
+            }
+
             // Note: we deliver _all_ packets to our router (i.e. our interface is intentionally promiscuous).
             // This allows the router and other apps on our node to sniff packets (usually routing) between other
             // nodes.
@@ -396,6 +405,8 @@ void RadioLibInterface::handleReceiveInterrupt()
             mp->hop_start = (h->flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
             mp->want_ack = !!(h->flags & PACKET_FLAGS_WANT_ACK_MASK);
             mp->via_mqtt = !!(h->flags & PACKET_FLAGS_VIA_MQTT_MASK);
+            mp->next_hop = h->next_hop;
+            mp->relay_node = h->relay_node;
 
             addReceiveMetadata(mp);
 
@@ -407,7 +418,7 @@ void RadioLibInterface::handleReceiveInterrupt()
 
             printPacket("Lora RX", mp);
 
-            airTime->logAirtime(RX_LOG, xmitMsec);
+            getAirTime()->logAirtime(RX_LOG, xmitMsec);
 
             deliverToReceiver(mp);
         }
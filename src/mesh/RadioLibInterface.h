@@ -105,9 +105,9 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     virtual void enableInterrupt(void (*)()) = 0;
 
     /**
-     * Debugging counts
+     * Debugging counts, rxDupe are the rxGood we dropped right away as we already had them
      */
-    uint32_t rxBad = 0, rxGood = 0, txGood = 0;
+    uint32_t rxBad = 0, rxGood = 0, txGood = 0, rxDupe = 0;
 
   public:
     RadioLibInterface(LockingArduinoHal *hal, RADIOLIB_PIN_TYPE cs, RADIOLIB_PIN_TYPE irq, RADIOLIB_PIN_TYPE rst,
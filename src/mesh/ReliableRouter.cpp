@@ -2,6 +2,7 @@
 #include "Default.h"
 #include "MeshModule.h"
 #include "MeshTypes.h"
+#include "RouteCache.h"
 #include "configuration.h"
 #include "mesh-pb-constants.h"
 #include "modules/NodeInfoModule.h"
@@ -14,6 +15,9 @@
  */
 ErrorCode ReliableRouter::send(meshtastic_MeshPacket *p)
 {
+    // Only acked direct messages are routed, as only for those we notice when the route stopped working
+    p->next_hop = NO_NEXT_HOP_PREFERENCE;
+
     if (p->want_ack) {
         // If someone asks for acks on broadcast, we need the hop limit to be at least one, so that first node that receives our
         // message will rebroadcast.  But asking for hop_limit 0 in that context means the client app has no preference on hop
@@ -22,6 +26,10 @@ ErrorCode ReliableRouter::send(meshtastic_MeshPacket *p)
             p->hop_limit = Default::getConfiguredOrDefaultHopLimit(config.lora.hop_limit);
         }
 
+        // Send direct messages along a route if we know one, the copy remembers it so we can tell if it failed
+        if (p->to != NODENUM_BROADCAST && routeCache)
+            p->next_hop = routeCache->lookup(p->to);
+
         auto copy = packetPool.allocCopy(*p);
         startRetransmission(copy);
     }
@@ -35,7 +43,23 @@ ErrorCode ReliableRouter::send(meshtastic_MeshPacket *p)
         }
     }
 
-    return FloodingRouter::send(p);
+    return NextHopRouter::send(p);
+}
+
+bool ReliableRouter::dropDuplicate(const PacketHeader *h, uint32_t packetLen, RadioInterface *from)
+{
+    uint8_t hopLimit = h->flags & PACKET_FLAGS_HOP_LIMIT_MASK;
+    uint8_t hopStart = (h->flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
+    bool isRepeated = hopStart == 0 ? (hopLimit == HOP_RELIABLE) : (hopStart == hopLimit);
+    if (isRepeated || !NextHopRouter::dropDuplicate(h, packetLen, from))
+        return false;
+
+    // While we were receiving it we could not have received an (implicit) ACK, see shouldFilterReceived()
+    uint32_t airtime = from->getPacketTime(packetLen);
+    for (auto i = pending.begin(); i != pending.end(); i++) {
+        i->second.nextTxMsec += airtime;
+    }
+    return true;
 }
 
 bool ReliableRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
@@ -52,7 +76,11 @@ bool ReliableRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
         // from the intended recipient.
         auto key = GlobalPacketId(getFrom(p), p->id);
         auto old = findPendingPacket(key);
-        if (old) {
+        if (old && old->packet->next_hop != NO_NEXT_HOP_PREFERENCE) {
+            // A relay passing on a routed message only confirms a hop, give the real ack time to come back along the route
+            LOG_DEBUG("Next hop relayed our packet, waiting for the ack\n");
+            old->nextTxMsec = millis() + iface->getRetransmissionMsec(old->packet) * max((uint32_t)old->packet->hop_limit, 1u);
+        } else if (old) {
             LOG_DEBUG("generating implicit ack\n");
             // NOTE: we do NOT check p->wantAck here because p is the INCOMING rebroadcast and that packet is not expected to be
             // marked as wantAck
@@ -78,14 +106,15 @@ bool ReliableRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
      * Resending real ACKs is omitted, as you might receive a packet multiple times due to flooding and
      * flooding this ACK back to the original sender already adds redundancy. */
     bool isRepeated = p->hop_start == 0 ? (p->hop_limit == HOP_RELIABLE) : (p->hop_start == p->hop_limit);
-    if (wasSeenRecently(p, false) && isRepeated && !MeshModule::currentReply && p->to != nodeDB->getNodeNum()) {
+    if (wasSeenRecently(p, false) && isRepeated && !MeshModule::currentReply && p->to != nodeDB->getNodeNum() &&
+        !isForOtherRelay(p)) {
         LOG_DEBUG("Resending implicit ack for a repeated floodmsg\n");
         meshtastic_MeshPacket *tosend = packetPool.allocCopy(*p);
         tosend->hop_limit--; // bump down the hop count
         Router::send(tosend);
     }
 
-    return FloodingRouter::shouldFilterReceived(p);
+    return NextHopRouter::shouldFilterReceived(p);
 }
 
 /**
@@ -147,7 +176,7 @@ void ReliableRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtas
     }
 
     // handle the packet as normal
-    FloodingRouter::sniffReceived(p, c);
+    NextHopRouter::sniffReceived(p, c);
 }
 
 #define NUM_RETRANSMISSIONS 3
@@ -240,9 +269,16 @@ int32_t ReliableRouter::doRetransmissions()
                 LOG_DEBUG("Sending reliable retransmission fr=0x%x,to=0x%x,id=0x%x, tries left=%d\n", p.packet->from,
                           p.packet->to, p.packet->id, p.numRetransmissions);
 
+                if (p.packet->next_hop != NO_NEXT_HOP_PREFERENCE) {
+                    // No ack along the route we picked, flood the remaining tries
+                    if (routeCache)
+                        routeCache->forget(p.packet->to);
+                    p.packet->next_hop = NO_NEXT_HOP_PREFERENCE;
+                }
+
                 // Note: we call the superclass version because we don't want to have our version of send() add a new
                 // retransmission record
-                FloodingRouter::send(packetPool.allocCopy(*p.packet));
+                NextHopRouter::send(packetPool.allocCopy(*p.packet));
 
                 // Queue again
                 --p.numRetransmissions;
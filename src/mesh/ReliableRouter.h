@@ -1,6 +1,6 @@
 #pragma once
 
-#include "FloodingRouter.h"
+#include "NextHopRouter.h"
 #include <unordered_map>
 
 /**
@@ -50,8 +50,11 @@ class GlobalPacketIdHashFunction
 
 /**
  * This is a mixin that extends Router with the ability to do (one hop only) reliable message sends.
+ *
+ * Direct messages we send with want_ack go to the next hop toward their destination if we know a route. As relays only
+ * confirm a hop, those wait for the real ack, and if it doesn't come we forget the route and flood the retransmissions.
  */
-class ReliableRouter : public FloodingRouter
+class ReliableRouter : public NextHopRouter
 {
   private:
     std::unordered_map<GlobalPacketId, PendingPacket, GlobalPacketIdHashFunction> pending;
@@ -70,13 +73,18 @@ class ReliableRouter : public FloodingRouter
      */
     virtual ErrorCode send(meshtastic_MeshPacket *p) override;
 
+    /**
+     * Repeated packets from their originator may need our implicit ack again, those go the regular way
+     */
+    virtual bool dropDuplicate(const PacketHeader *h, uint32_t packetLen, RadioInterface *from) override;
+
     /** Do our retransmission handling */
     virtual int32_t runOnce() override
     {
         // Note: We must doRetransmissions FIRST, because it might queue up work for the base class runOnce implementation
         auto d = doRetransmissions();
 
-        int32_t r = FloodingRouter::runOnce();
+        int32_t r = NextHopRouter::runOnce();
 
         return min(d, r);
     }
@@ -0,0 +1,65 @@
+#include "RouteCache.h"
+#include "configuration.h"
+
+RouteCache *routeCache;
+
+static uint32_t nowSecs()
+{
+    return millis() / 1000;
+}
+
+void RouteCache::learn(NodeNum dest, uint8_t nextHop, RouteSource source)
+{
+    if (dest == NODENUM_BROADCAST || nextHop == NO_NEXT_HOP_PREFERENCE)
+        return;
+
+    uint32_t now = nowSecs();
+    auto it = routes.find(dest);
+    if (it != routes.end()) {
+        Route &r = it->second;
+        if (source < r.source && now - r.updated < ROUTE_MAX_AGE_SECS)
+            return; // What we know is better
+        if (r.nextHop != nextHop)
+            LOG_DEBUG("Route to 0x%x now via 0x%x (was 0x%x, source %d)\n", dest, nextHop, r.nextHop, source);
+        r = {now, nextHop, source};
+        return;
+    }
+
+    if (routes.size() >= MAX_NUM_NODES) {
+        // Make room by dropping the route we confirmed longest ago
+        auto oldest = routes.begin();
+        for (auto i = routes.begin(); i != routes.end(); i++) {
+            if (now - i->second.updated > now - oldest->second.updated)
+                oldest = i;
+        }
+        routes.erase(oldest);
+    }
+    LOG_DEBUG("Learned route to 0x%x via 0x%x (source %d)\n", dest, nextHop, source);
+    routes[dest] = {now, nextHop, source};
+}
+
+uint8_t RouteCache::lookup(NodeNum dest, uint8_t exclude)
+{
+    lookups++;
+    auto it = routes.find(dest);
+    if (it == routes.end())
+        return NO_NEXT_HOP_PREFERENCE;
+
+    if (nowSecs() - it->second.updated >= ROUTE_MAX_AGE_SECS) {
+        routes.erase(it);
+        return NO_NEXT_HOP_PREFERENCE;
+    }
+    if (it->second.nextHop == exclude)
+        return NO_NEXT_HOP_PREFERENCE;
+
+    hits++;
+    return it->second.nextHop;
+}
+
+void RouteCache::forget(NodeNum dest)
+{
+    if (routes.erase(dest)) {
+        fallbacks++;
+        LOG_INFO("Route to 0x%x failed, flooding instead\n", dest);
+    }
+}
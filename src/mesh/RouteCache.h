@@ -0,0 +1,56 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include <unordered_map>
+
+// Routes not confirmed for this long are forgotten
+#ifndef ROUTE_MAX_AGE_SECS
+#define ROUTE_MAX_AGE_SECS (60 * 60)
+#endif
+
+/// Where we learned a route from, in order of how much we trust it
+enum RouteSource : uint8_t {
+    ROUTE_SRC_NEIGHBORINFO, // A direct neighbor of ours lists the destination as one of its neighbors
+    ROUTE_SRC_RESPONSE,     // A flooded ack or reply from the destination reached us through the next hop first
+    ROUTE_SRC_TRACEROUTE,   // A traceroute we started went through the next hop
+    ROUTE_SRC_DIRECT,       // We heard the destination itself, without any hops in between
+};
+
+/**
+ * The next hop toward each node we learned a route to, so direct messages can go along one path instead of flooding the
+ * whole mesh.
+ *
+ * Next hops are kept as the last byte of their node number, as that is all the packet header has room for. A route is
+ * replaced by a newer one from an equal or more trusted source, or by anything once it is older than ROUTE_MAX_AGE_SECS.
+ */
+class RouteCache
+{
+  public:
+    void learn(NodeNum dest, uint8_t nextHop, RouteSource source);
+
+    /**
+     * @param exclude Don't route back to this node (the one that just handed the packet to us)
+     * @return the next hop toward dest, or NO_NEXT_HOP_PREFERENCE if we should flood
+     */
+    uint8_t lookup(NodeNum dest, uint8_t exclude = NO_NEXT_HOP_PREFERENCE);
+
+    /// Sending along the route to dest failed, we flood until we learn a new one
+    void forget(NodeNum dest);
+
+    size_t size() const { return routes.size(); }
+
+    uint32_t lookups = 0;   // Times we looked for a route
+    uint32_t hits = 0;      // Times we found one
+    uint32_t fallbacks = 0; // Routes that failed, so we went back to flooding
+
+  private:
+    struct Route {
+        uint32_t updated; // Seconds since boot
+        uint8_t nextHop;
+        RouteSource source;
+    };
+
+    std::unordered_map<NodeNum, Route> routes;
+};
+
+extern RouteCache *routeCache;
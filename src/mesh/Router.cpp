@@ -4,6 +4,8 @@
 #include "MeshRadio.h"
 #include "MeshService.h"
 #include "NodeDB.h"
+#include "PacketBundler.h"
+#include "PayloadCompression.h"
 #include "RTC.h"
 #include "configuration.h"
 #include "main.h"
@@ -17,10 +19,14 @@
 #if ARCH_PORTDUINO
 #include "platform/portduino/PortduinoGlue.h"
 #endif
+#if HAS_DECODE_WORKER_POOL
+#include "platform/portduino/DecodeWorkerPool.h"
+#endif
 #if ENABLE_JSON_LOGGING || ARCH_PORTDUINO
 #include "serialization/MeshPacketSerializer.h"
 #endif
 #include "../userPrefs.h"
+#include <pb_decode.h>
 
 #define MAX_RX_FROMRADIO                                                                                                         \
     4 // max number of packets destined to our queue, we dispatch packets quickly so it doesn't need to be big
@@ -36,13 +42,11 @@ static MemoryDynamic<meshtastic_MeshPacket> staticPool;
 
 Allocator<meshtastic_MeshPacket> &packetPool = staticPool;
 
-static uint8_t bytes[MAX_RHPACKETLEN];
-static uint8_t ScratchEncrypted[MAX_RHPACKETLEN];
+// For perhapsDecode() and perhapsEncode() on the main thread, under cryptLock
+static CryptContext mainContext;
 
 /**
  * Constructor
- *
- * Currently we only allow one interface, that may change in the future
  */
 Router::Router() : concurrency::OSThread("Router"), fromRadioQueue(MAX_RX_FROMRADIO)
 {
@@ -68,7 +72,14 @@ int32_t Router::runOnce()
     meshtastic_MeshPacket *mp;
     while ((mp = fromRadioQueue.dequeuePtr(0)) != NULL) {
         // printPacket("handle fromRadioQ", mp);
+        ReceivedInfo info = fromRadioInfo.front();
+        fromRadioInfo.pop_front();
+        rxIface = info.iface;
+        rxDecrypted = info.decrypted;
         perhapsHandleReceived(mp);
+        rxIface = NULL;
+        rxDecrypted = NULL;
+        delete info.decrypted;
     }
 
     // LOG_DEBUG("sleeping forever!\n");
@@ -79,18 +90,49 @@ int32_t Router::runOnce()
  * RadioInterface calls this to queue up packets that have been received from the radio.  The router is now responsible for
  * freeing the packet
  */
-void Router::enqueueReceivedMessage(meshtastic_MeshPacket *p)
+void Router::addInterface(RadioInterface *_iface)
+{
+    if (!iface) {
+        iface = _iface;
+    } else {
+        // Another interface is on another channel, with its own channel utilization and duty cycle
+        _iface->setAirTime(new AirTime());
+        LOG_INFO("Added radio interface %u\n", (unsigned)interfaces.size());
+    }
+    interfaces.push_back(_iface);
+}
+
+void Router::enqueueReceivedMessage(meshtastic_MeshPacket *p, RadioInterface *from)
+{
+#if HAS_DECODE_WORKER_POOL
+    // The workers decrypt it, it comes back through enqueueDecryptedMessage()
+    if (decodeWorkerPool && p->which_payload_variant == meshtastic_MeshPacket_encrypted_tag) {
+        decodeWorkerPool->submit(p, from);
+        return;
+    }
+#endif
+    enqueueDecryptedMessage(p, from, NULL);
+}
+
+void Router::enqueueDecryptedMessage(meshtastic_MeshPacket *p, RadioInterface *from, DecryptedPayload *decrypted)
 {
     if (fromRadioQueue.enqueue(p, 0)) { // NOWAIT - fixme, if queue is full, delete older messages
+        fromRadioInfo.push_back({from, decrypted});
 
         // Nasty hack because our threading is primitive.  interfaces shouldn't need to know about routers FIXME
         setReceivedMessage();
     } else {
         printPacket("BUG! fromRadioQueue is full! Discarding!", p);
         packetPool.release(p);
+        delete decrypted;
     }
 }
 
+size_t Router::getReceivedSpace() const
+{
+    return fromRadioInfo.size() < MAX_RX_FROMRADIO ? MAX_RX_FROMRADIO - fromRadioInfo.size() : 0;
+}
+
 /// Generate a unique packet id
 // FIXME, move this someplace better
 PacketId generatePacketId()
@@ -190,6 +232,12 @@ ErrorCode Router::sendLocal(meshtastic_MeshPacket *p, RxSource src)
             LOG_DEBUG("localSend to channel %d\n", p->channel);
         }
 
+#if !MESHTASTIC_EXCLUDE_BUNDLING
+        // Small periodic broadcasts of ours may wait a little to share a packet
+        if (packetBundler && packetBundler->hold(p))
+            return ERRNO_OK;
+#endif
+
         return send(p);
     }
 }
@@ -248,6 +296,9 @@ ErrorCode Router::send(meshtastic_MeshPacket *p)
     if (p->from == getNodeNum())
         p->hop_start = p->hop_limit;
 
+    // Whether we started it or are forwarding it, we are the ones relaying it now
+    p->relay_node = getLastByteOfNodeNum(getNodeNum());
+
     // If the packet hasn't yet been encrypted, do so now (it might already be encrypted if we are just forwarding it)
 
     if (!(p->which_payload_variant == meshtastic_MeshPacket_encrypted_tag ||
@@ -257,6 +308,11 @@ ErrorCode Router::send(meshtastic_MeshPacket *p)
 
     fixPriority(p); // Before encryption, fix the priority if it's unset
 
+    // Remember the portnum for airtime accounting, it is gone once the packet is encrypted. Forwarded packets are already
+    // encrypted and get counted as UNKNOWN_APP.
+    meshtastic_PortNum portnum =
+        p->which_payload_variant == meshtastic_MeshPacket_decoded_tag ? p->decoded.portnum : meshtastic_PortNum_UNKNOWN_APP;
+
     // If the packet is not yet encrypted, do so now
     if (p->which_payload_variant == meshtastic_MeshPacket_decoded_tag) {
         ChannelIndex chIndex = p->channel; // keep as a local because we are about to change it
@@ -278,13 +334,59 @@ ErrorCode Router::send(meshtastic_MeshPacket *p)
     }
 
     assert(iface); // This should have been detected already in sendLocal (or we just received a packet from outside)
-    return iface->send(p);
+    if (interfaces.size() > 1)
+        return sendOnInterfaces(p, portnum);
+    return sendOn(iface, p, portnum);
+}
+
+ErrorCode Router::sendOn(RadioInterface *i, meshtastic_MeshPacket *p, meshtastic_PortNum portnum)
+{
+    // Counted once the radio transmits it, it may still be cancelled or dropped before then
+    i->getAirTime()->expectTransmit(p, portnum);
+    return i->send(p); // p is no longer ours after this
+}
+
+ErrorCode Router::sendOnInterfaces(meshtastic_MeshPacket *p, meshtastic_PortNum portnum)
+{
+    bool relaying = p->from != getNodeNum();
+    ErrorCode res = ERRNO_NO_INTERFACES;
+    RadioInterface *last = NULL; // Gets p itself, the ones before it a copy
+    for (size_t n = 0; n < interfaces.size(); n++) {
+        RadioInterface *i = interfaces[n];
+        if (relaying && !i->shouldRelay(i == rxIface))
+            continue;
+        // The primary interface was checked in send(), the others have their own duty cycle
+        if (i != iface && !config.lora.override_duty_cycle && myRegion->dutyCycle < 100 &&
+            i->getAirTime()->utilizationTXPercent() > myRegion->dutyCycle) {
+            LOG_WARN("Duty cycle limit exceeded on radio interface %u, not sending there\n", (unsigned)n);
+            continue;
+        }
+        if (last && sendOn(last, packetPool.allocCopy(*p), portnum) == ERRNO_OK)
+            res = ERRNO_OK;
+        last = i;
+    }
+
+    if (!last) {
+        packetPool.release(p);
+        return res;
+    }
+    if (sendOn(last, p, portnum) == ERRNO_OK)
+        res = ERRNO_OK;
+    return res;
 }
 
 /** Attempt to cancel a previously sent packet.  Returns true if a packet was found we could cancel */
-bool Router::cancelSending(NodeNum from, PacketId id)
+bool Router::cancelSending(NodeNum from, PacketId id, RadioInterface *on)
 {
-    return iface ? iface->cancelSending(from, id) : false;
+    if (on)
+        return on->cancelSending(from, id);
+
+    bool cancelled = false;
+    for (auto i : interfaces) {
+        if (i->cancelSending(from, id))
+            cancelled = true;
+    }
+    return cancelled;
 }
 
 /**
@@ -296,10 +398,29 @@ void Router::sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Rout
     // FIXME, update nodedb here for any packet that passes through us
 }
 
-bool perhapsDecode(meshtastic_MeshPacket *p)
+bool decryptChannelPayload(const meshtastic_MeshPacket *p, const CryptoKey &key, CryptoEngine *engine, CryptContext &ctx,
+                           meshtastic_Data &decoded)
+{
+    size_t rawSize = p->encrypted.size;
+    if (rawSize > sizeof(ctx.bytes))
+        return false;
+    memcpy(ctx.bytes, p->encrypted.bytes, rawSize);
+    engine->decryptWithKey(key, p->from, p->id, rawSize, ctx.bytes);
+
+    // Not pb_decode_from_bytes(), a wrong key is no reason to log from a worker thread
+    memset(&decoded, 0, sizeof(decoded));
+    pb_istream_t stream = pb_istream_from_buffer(ctx.bytes, rawSize);
+    return pb_decode(&stream, &meshtastic_Data_msg, &decoded) && decoded.portnum != meshtastic_PortNum_UNKNOWN_APP;
+}
+
+bool perhapsDecode(meshtastic_MeshPacket *p, const DecryptedPayload *pre)
 {
     concurrency::LockGuard g(cryptLock);
+    return perhapsDecode(p, mainContext, pre);
+}
 
+bool perhapsDecode(meshtastic_MeshPacket *p, CryptContext &ctx, const DecryptedPayload *pre)
+{
     if (config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER &&
         config.device.rebroadcast_mode == meshtastic_Config_DeviceConfig_RebroadcastMode_ALL_SKIP_DECODING)
         return false;
@@ -314,23 +435,31 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
         return true; // If packet was already decoded just return
 
     size_t rawSize = p->encrypted.size;
-    if (rawSize > sizeof(bytes)) {
+    if (rawSize > sizeof(ctx.bytes)) {
         LOG_ERROR("Packet too large to attempt decryption! (rawSize=%d > 256)\n", rawSize);
         return false;
     }
     bool decrypted = false;
     ChannelIndex chIndex = 0;
+    uint8_t *bytes = ctx.bytes;
     memcpy(bytes, p->encrypted.bytes,
            rawSize); // we have to copy into a scratch buffer, because these bytes are a union with the decoded protobuf
-    memcpy(ScratchEncrypted, p->encrypted.bytes, rawSize);
+    memcpy(ctx.scratch, p->encrypted.bytes, rawSize);
+    if (pre) {
+        // A worker already did the work, and it only takes packets that aren't for PKI
+        decrypted = pre->ok;
+        chIndex = pre->chIndex;
+        if (decrypted)
+            p->decoded = pre->decoded;
+    }
 #if !(MESHTASTIC_EXCLUDE_PKI)
     // Attempt PKI decryption first
-    if (p->channel == 0 && p->to == nodeDB->getNodeNum() && p->to > 0 && p->to != NODENUM_BROADCAST &&
+    if (!pre && p->channel == 0 && p->to == nodeDB->getNodeNum() && p->to > 0 && p->to != NODENUM_BROADCAST &&
         nodeDB->getMeshNode(p->from) != nullptr && nodeDB->getMeshNode(p->from)->user.public_key.size > 0 &&
         nodeDB->getMeshNode(p->to)->user.public_key.size > 0 && rawSize > 12) {
         LOG_DEBUG("Attempting PKI decryption\n");
 
-        if (crypto->decryptCurve25519(p->from, p->id, rawSize, ScratchEncrypted, bytes)) {
+        if (crypto->decryptCurve25519(p->from, p->id, rawSize, ctx.scratch, bytes)) {
             LOG_INFO("PKI Decryption worked!\n");
             memset(&p->decoded, 0, sizeof(p->decoded));
             rawSize -= 12;
@@ -341,7 +470,7 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
                 p->pki_encrypted = true;
                 memcpy(&p->public_key.bytes, nodeDB->getMeshNode(p->from)->user.public_key.bytes, 32);
                 p->public_key.size = 32;
-                // memcpy(bytes, ScratchEncrypted, rawSize); // TODO: Rename the bytes buffers
+                // memcpy(bytes, ctx.scratch, rawSize); // TODO: Rename the bytes buffers
                 // chIndex = 8;
             } else {
                 return false;
@@ -351,7 +480,7 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
 #endif
 
     // assert(p->which_payloadVariant == MeshPacket_encrypted_tag);
-    if (!decrypted) {
+    if (!decrypted && !pre) {
         // Try to find a channel that works with this hash
         for (chIndex = 0; chIndex < channels.getNumChannels(); chIndex++) {
             // Try to use this hash/channel pair
@@ -381,6 +510,19 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
         if (p->decoded.has_bitfield)
             p->decoded.want_response |= p->decoded.bitfield & BITFIELD_WANT_RESPONSE_MASK;
 
+#if !MESHTASTIC_EXCLUDE_COMPRESSION
+        learnCompressionSupported(p);
+        if (p->decoded.has_bitfield && (p->decoded.bitfield & BITFIELD_COMPRESSED_MASK)) {
+            if (!decompressPayload(p->decoded)) {
+                LOG_ERROR("Can't decompress payload of packet id=0x%08x\n", p->id);
+                return false;
+            }
+        }
+#endif
+#if !MESHTASTIC_EXCLUDE_BUNDLING
+        learnBundlingSupported(p);
+#endif
+
         /* Not actually ever used.
         // Decompress if needed. jm
         if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP) {
@@ -421,7 +563,12 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
 meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p)
 {
     concurrency::LockGuard g(cryptLock);
+    return perhapsEncode(p, mainContext);
+}
 
+meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p, CryptContext &ctx)
+{
+    uint8_t *bytes = ctx.bytes;
     int16_t hash;
 
     // If the packet is not yet encrypted, do so now
@@ -430,9 +577,25 @@ meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p)
             p->decoded.has_bitfield = true;
             p->decoded.bitfield |= (config.lora.config_ok_to_mqtt << BITFIELD_OK_TO_MQTT_SHIFT);
             p->decoded.bitfield |= (p->decoded.want_response << BITFIELD_WANT_RESPONSE_SHIFT);
+#if !MESHTASTIC_EXCLUDE_COMPRESSION
+            p->decoded.bitfield |= BITFIELD_COMPRESSION_MASK;
+#endif
+#if !MESHTASTIC_EXCLUDE_BUNDLING
+            p->decoded.bitfield |= BITFIELD_BUNDLE_MASK;
+#endif
+        }
+
+#if !MESHTASTIC_EXCLUDE_COMPRESSION
+        // Only to a single node that told us it can decompress, anyone may be listening to a broadcast
+        if (p->to != NODENUM_BROADCAST && isCompressiblePort(p->decoded.portnum) && isCompressionSupported(p->to) &&
+            !(p->decoded.bitfield & BITFIELD_COMPRESSED_MASK)) {
+            size_t original = p->decoded.payload.size;
+            if (compressPayload(p->decoded))
+                LOG_DEBUG("Compressed payload from %u to %u bytes\n", (unsigned)original, p->decoded.payload.size);
         }
+#endif
 
-        size_t numbytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_Data_msg, &p->decoded);
+        size_t numbytes = pb_encode_to_bytes(bytes, sizeof(ctx.bytes), &meshtastic_Data_msg, &p->decoded);
 
         /* Not actually used, so save the cycles
         //  TODO: Allow modules to opt into compression.
@@ -491,9 +654,9 @@ meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p)
                          *p->public_key.bytes, *node->user.public_key.bytes);
                 return meshtastic_Routing_Error_PKI_FAILED;
             }
-            crypto->encryptCurve25519(p->to, getFrom(p), p->id, numbytes, bytes, ScratchEncrypted);
+            crypto->encryptCurve25519(p->to, getFrom(p), p->id, numbytes, bytes, ctx.scratch);
             numbytes += 12;
-            memcpy(p->encrypted.bytes, ScratchEncrypted, numbytes);
+            memcpy(p->encrypted.bytes, ctx.scratch, numbytes);
             p->channel = 0;
             p->pki_encrypted = true;
         } else {
@@ -555,7 +718,7 @@ void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
     meshtastic_MeshPacket *p_encrypted = packetPool.allocCopy(*p);
 
     // Take those raw bytes and convert them back into a well structured protobuf we can understand
-    bool decoded = perhapsDecode(p);
+    bool decoded = perhapsDecode(p, rxDecrypted);
     if (decoded) {
         // parsing was successful, queue for our recipient
         if (src == RX_SRC_LOCAL)
@@ -591,22 +754,70 @@ void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
         printPacket("packet decoding failed or skipped (no PSK?)", p);
     }
 
+    if (src == RX_SRC_RADIO && rxIface)
+        rxIface->getAirTime()->logPortnumAirtime(RX_LOG, decoded ? p->decoded.portnum : meshtastic_PortNum_UNKNOWN_APP,
+                                                 rxIface->getPacketTime(p_encrypted));
+
     // call modules here
     if (!skipHandle) {
-        MeshModule::callModules(*p, src);
+#if !MESHTASTIC_EXCLUDE_BUNDLING
+        // The records of a bundle are delivered and published one by one, the bundle itself never is
+        if (decoded && p->decoded.portnum == BUNDLE_PORTNUM)
+            handleBundle(p, src);
+        else
+#endif
+        {
+            MeshModule::callModules(*p, src);
 
 #if !MESHTASTIC_EXCLUDE_MQTT
-        // After potentially altering it, publish received message to MQTT if we're not the original transmitter of the packet
-        if (decoded && moduleConfig.mqtt.enabled && getFrom(p) != nodeDB->getNodeNum() && mqtt)
-            mqtt->onSend(*p_encrypted, *p, p->channel);
+            // After potentially altering it, publish received message to MQTT if we're not the original transmitter of the
+            // packet
+            if (decoded && moduleConfig.mqtt.enabled && getFrom(p) != nodeDB->getNodeNum() && mqtt)
+                mqtt->onSend(*p_encrypted, *p, p->channel);
 #endif
+        }
     }
 
     packetPool.release(p_encrypted); // Release the encrypted packet
 }
 
+#if !MESHTASTIC_EXCLUDE_BUNDLING
+void Router::handleBundle(meshtastic_MeshPacket *p, RxSource src)
+{
+    // The bundle is what gets forwarded, the records are only delivered here
+    sniffReceived(p, NULL);
+
+    meshtastic_MeshPacket *record = packetPool.allocCopy(*p);
+    record->hop_start = p->hop_start >= p->hop_limit ? p->hop_start - p->hop_limit : 0; // Keeps hops away the same
+    record->hop_limit = 0;
+
+    size_t offset = 0;
+    while (PacketBundler::unbundleNext(*p, offset, *record)) {
+        if (record->decoded.portnum == meshtastic_PortNum_NEIGHBORINFO_APP &&
+            (!moduleConfig.has_neighbor_info || !moduleConfig.neighbor_info.enabled))
+            continue;
+        printPacket("Unbundled", record);
+        MeshModule::callModules(*record, src);
+
+#if !MESHTASTIC_EXCLUDE_MQTT
+        // Published as if it had come on its own, the broker doesn't know about bundles
+        if (moduleConfig.mqtt.enabled && getFrom(record) != nodeDB->getNodeNum() && mqtt) {
+            meshtastic_MeshPacket *encrypted = packetPool.allocCopy(*record);
+            if (!moduleConfig.mqtt.encryption_enabled || perhapsEncode(encrypted) == meshtastic_Routing_Error_NONE)
+                mqtt->onSend(*encrypted, *record, p->channel);
+            packetPool.release(encrypted);
+        }
+#endif
+    }
+    packetPool.release(record);
+}
+
+#endif
 void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
 {
+    if (forwardHeaderOnly(p))
+        return;
+
 #if ENABLE_JSON_LOGGING
     // Even ignored packets get logged in the trace
     p->rx_time = getValidTime(RTCQualityFromNet); // store the arrival timestamp for the phone
@@ -7,6 +7,21 @@
 #include "PointerQueue.h"
 #include "RadioInterface.h"
 #include "concurrency/OSThread.h"
+#include <deque>
+#include <vector>
+
+/// Scratch buffers for one perhapsDecode() or perhapsEncode() call, threads that decode in parallel each bring their own
+struct CryptContext {
+    uint8_t bytes[MAX_RHPACKETLEN];
+    uint8_t scratch[MAX_RHPACKETLEN];
+};
+
+/// The payload of a received packet, decrypted and decoded ahead of perhapsDecode() by DecodeWorkerPool
+struct DecryptedPayload {
+    bool ok; // false if none of the channels with the hash of the packet could decrypt it
+    ChannelIndex chIndex;
+    meshtastic_Data decoded;
+};
 
 /**
  * A mesh aware router that supports multiple interfaces.
@@ -18,9 +33,26 @@ class Router : protected concurrency::OSThread
     /// forwarded to the phone.
     PointerQueue<meshtastic_MeshPacket> fromRadioQueue;
 
+    /// What we know about each packet in fromRadioQueue besides the packet itself
+    struct ReceivedInfo {
+        RadioInterface *iface;       // NULL for packets that didn't come from a radio
+        DecryptedPayload *decrypted; // Owned by us, NULL if it hasn't been decrypted ahead of time
+    };
+    std::deque<ReceivedInfo> fromRadioInfo;
+
+    /// The payload of the packet we are handling right now, if a worker already decrypted it
+    const DecryptedPayload *rxDecrypted = NULL;
+
   protected:
+    /// The primary interface, the first one added. Its airtime is the global airTime.
     RadioInterface *iface = NULL;
 
+    /// All interfaces, starting with the primary one
+    std::vector<RadioInterface *> interfaces;
+
+    /// The interface the packet we are handling right now came in on, NULL if it didn't come from a radio
+    RadioInterface *rxIface = NULL;
+
   public:
     /**
      * Constructor
@@ -29,9 +61,10 @@ class Router : protected concurrency::OSThread
     Router();
 
     /**
-     * Currently we only allow one interface, that may change in the future
+     * Add an interface to send and receive on. Our own packets go out on all of them, packets from others are relayed
+     * according to the rebroadcastPolicy of each. Interfaces after the first get their own airtime accounting.
      */
-    void addInterface(RadioInterface *_iface) { iface = _iface; }
+    void addInterface(RadioInterface *_iface);
 
     /**
      * do idle processing
@@ -47,14 +80,27 @@ class Router : protected concurrency::OSThread
      */
     ErrorCode sendLocal(meshtastic_MeshPacket *p, RxSource src = RX_SRC_RADIO);
 
-    /** Attempt to cancel a previously sent packet.  Returns true if a packet was found we could cancel */
-    bool cancelSending(NodeNum from, PacketId id);
+    /**
+     * Attempt to cancel a previously sent packet.  Returns true if a packet was found we could cancel
+     * @param on only cancel it on this interface, NULL for all of them
+     */
+    bool cancelSending(NodeNum from, PacketId id, RadioInterface *on = NULL);
 
     /** Allocate and return a meshpacket which defaults as send to broadcast from the current node.
      * The returned packet is guaranteed to have a unique packet ID already assigned
      */
     meshtastic_MeshPacket *allocForSending();
 
+    /**
+     * Called by the radio with the header of every packet it receives, before anything is allocated for it.
+     * @param from the interface that received it
+     * @return true if the packet is a duplicate we can drop right away
+     */
+    virtual bool dropDuplicate(const PacketHeader *h, uint32_t packetLen, RadioInterface *from) { return false; }
+
+    /// Is this packet in our packet history? Only looks, unlike handling the packet it doesn't add a record.
+    virtual bool hasSeen(NodeNum from, PacketId id) { return false; }
+
     /** Return Underlying interface's TX queue status */
     meshtastic_QueueStatus getQueueStatus();
 
@@ -70,8 +116,19 @@ class Router : protected concurrency::OSThread
     /**
      * RadioInterface calls this to queue up packets that have been received from the radio.  The router is now responsible for
      * freeing the packet
+     * @param from the interface that received it, NULL if it didn't come from a radio
      */
-    void enqueueReceivedMessage(meshtastic_MeshPacket *p);
+    void enqueueReceivedMessage(meshtastic_MeshPacket *p, RadioInterface *from = NULL);
+
+    /**
+     * Like enqueueReceivedMessage(), for packets a worker already decrypted. Those handed to the workers come back this way,
+     * in the order they were received.
+     * @param decrypted the payload of p or NULL, the router is now responsible for freeing it
+     */
+    void enqueueDecryptedMessage(meshtastic_MeshPacket *p, RadioInterface *from, DecryptedPayload *decrypted);
+
+    /// How many more received packets fit in our queue before the next runOnce()
+    size_t getReceivedSpace() const;
 
     /**
      * Send a packet on a suitable interface.  This routine will
@@ -95,6 +152,13 @@ class Router : protected concurrency::OSThread
      */
     virtual bool shouldFilterReceived(const meshtastic_MeshPacket *p) { return false; }
 
+    /**
+     * Called first thing for every packet from the radio. A router that can deal with the packet using only its header
+     * fields (from, to, id, hop limit, next hop) does so, frees it and returns true. Otherwise it goes through the regular
+     * receive path.
+     */
+    virtual bool forwardHeaderOnly(meshtastic_MeshPacket *p) { return false; }
+
     /**
      * Every (non duplicate) packet this node receives will be passed through this method.  This allows subclasses to
      * update routing tables etc... based on what we overhear (even for messages not destined to our node)
@@ -128,6 +192,15 @@ class Router : protected concurrency::OSThread
      */
     void handleReceived(meshtastic_MeshPacket *p, RxSource src = RX_SRC_RADIO);
 
+    /// Forward a bundle of broadcasts as a whole, and deliver the packets in it to the modules one by one
+    void handleBundle(meshtastic_MeshPacket *p, RxSource src);
+
+    /// Hand an encrypted packet to one interface, p is no longer ours after this
+    ErrorCode sendOn(RadioInterface *i, meshtastic_MeshPacket *p, meshtastic_PortNum portnum);
+
+    /// Send an encrypted packet on every interface that should carry it, each gets its own copy
+    ErrorCode sendOnInterfaces(meshtastic_MeshPacket *p, meshtastic_PortNum portnum);
+
     /** Frees the provided packet, and generates a NAK indicating the speicifed error while sending */
     void abortSendAndNak(meshtastic_Routing_Error err, meshtastic_MeshPacket *p);
 };
@@ -135,13 +208,25 @@ class Router : protected concurrency::OSThread
 /** FIXME - move this into a mesh packet class
  * Remove any encryption and decode the protobufs inside this packet (if necessary).
  *
+ * @param pre the payload if a worker already decrypted it, see DecodeWorkerPool
  * @return true for success, false for corrupt packet.
+ *
+ * The overloads taking a context still use the global crypto engine and channels, the caller holds cryptLock.
  */
-bool perhapsDecode(meshtastic_MeshPacket *p);
+bool perhapsDecode(meshtastic_MeshPacket *p, const DecryptedPayload *pre = NULL);
+bool perhapsDecode(meshtastic_MeshPacket *p, CryptContext &ctx, const DecryptedPayload *pre = NULL);
 
 /** Return 0 for success or a Routing_Errror code for failure
  */
 meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p);
+meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p, CryptContext &ctx);
+
+/**
+ * Try to decrypt and decode the payload of a channel (not PKI) encrypted packet with one key. Only touches its arguments,
+ * so workers can call it in parallel, each with their own engine and context.
+ */
+bool decryptChannelPayload(const meshtastic_MeshPacket *p, const CryptoKey &key, CryptoEngine *engine, CryptContext &ctx,
+                           meshtastic_Data &decoded);
 
 extern Router *router;
 
@@ -149,7 +234,15 @@ extern Router *router;
 // FIXME, move this someplace better
 PacketId generatePacketId();
 
+// Bits 0 and 1 are defined in mesh.proto. Bits 2 to 4 are claimed by this firmware for the capabilities below and must be
+// reserved in the Data.bitfield comment of protobufs/meshtastic/mesh.proto before anything else uses them.
+#define BITFIELD_BUNDLE_SHIFT 4      // The sender can split bundled broadcasts, see PacketBundler
+#define BITFIELD_COMPRESSED_SHIFT 3  // The payload is unishox2 compressed
+#define BITFIELD_COMPRESSION_SHIFT 2 // The sender can decompress payloads, so we may send it compressed ones
 #define BITFIELD_WANT_RESPONSE_SHIFT 1
 #define BITFIELD_OK_TO_MQTT_SHIFT 0
+#define BITFIELD_BUNDLE_MASK (1 << BITFIELD_BUNDLE_SHIFT)
+#define BITFIELD_COMPRESSED_MASK (1 << BITFIELD_COMPRESSED_SHIFT)
+#define BITFIELD_COMPRESSION_MASK (1 << BITFIELD_COMPRESSION_SHIFT)
 #define BITFIELD_WANT_RESPONSE_MASK (1 << BITFIELD_WANT_RESPONSE_SHIFT)
 #define BITFIELD_OK_TO_MQTT_MASK (1 << BITFIELD_OK_TO_MQTT_SHIFT)
\ No newline at end of file
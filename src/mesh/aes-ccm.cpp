@@ -51,48 +51,31 @@ static void aes_ccm_auth_start(size_t M, size_t L, const uint8_t *nonce, const u
         crypto->aesEncrypt(&aad_buf[AES_BLOCK_SIZE], x);
     }
 }
-static void aes_ccm_auth(const uint8_t *data, size_t len, uint8_t *x)
-{
-    size_t last = len % AES_BLOCK_SIZE;
-    size_t i;
-    for (i = 0; i < len / AES_BLOCK_SIZE; i++) {
-        /* X_i+1 = E(K, X_i XOR B_i) */
-        xor_aes_block(x, data);
-        data += AES_BLOCK_SIZE;
-        crypto->aesEncrypt(x, x);
-    }
-    if (last) {
-        /* XOR zero-padded last block */
-        for (i = 0; i < last; i++)
-            x[i] ^= *data++;
-        crypto->aesEncrypt(x, x);
-    }
-}
 static void aes_ccm_encr_start(size_t L, const uint8_t *nonce, uint8_t *a)
 {
     /* A_i = Flags | Nonce N | Counter i */
     a[0] = L - 1; /* Flags = L' */
     memcpy(&a[1], nonce, 15 - L);
 }
-static void aes_ccm_encr(size_t L, const uint8_t *in, size_t len, uint8_t *out, uint8_t *a)
+/* One pass over the message, CTR encryption (or decryption) and the CBC-MAC of the plaintext block by block */
+static void aes_ccm_crypt_auth(const uint8_t *in, size_t len, uint8_t *out, uint8_t *a, uint8_t *x, bool decrypt)
 {
-    size_t last = len % AES_BLOCK_SIZE;
-    size_t i;
-    /* crypt = msg XOR (S_1 | S_2 | ... | S_n) */
-    for (i = 1; i <= len / AES_BLOCK_SIZE; i++) {
+    uint8_t s[AES_BLOCK_SIZE];
+    for (uint16_t i = 1; len > 0; i++) {
+        size_t n = len < AES_BLOCK_SIZE ? len : AES_BLOCK_SIZE;
         WPA_PUT_BE16(&a[AES_BLOCK_SIZE - 2], i);
         /* S_i = E(K, A_i) */
-        crypto->aesEncrypt(a, out);
-        xor_aes_block(out, in);
-        out += AES_BLOCK_SIZE;
-        in += AES_BLOCK_SIZE;
-    }
-    if (last) {
-        WPA_PUT_BE16(&a[AES_BLOCK_SIZE - 2], i);
-        crypto->aesEncrypt(a, out);
-        /* XOR zero-padded last block */
-        for (i = 0; i < last; i++)
-            *out++ ^= *in++;
+        crypto->aesEncrypt(a, s);
+        for (size_t j = 0; j < n; j++) {
+            uint8_t b = in[j]; // in and out may be the same buffer
+            out[j] = b ^ s[j];
+            x[j] ^= decrypt ? out[j] : b; /* the last block is zero-padded */
+        }
+        /* X_i+1 = E(K, X_i XOR B_i) */
+        crypto->aesEncrypt(x, x);
+        in += n;
+        out += n;
+        len -= n;
     }
 }
 static void aes_ccm_encr_auth(size_t M, uint8_t *x, uint8_t *a, uint8_t *auth)
@@ -125,10 +108,8 @@ int aes_ccm_ae(const uint8_t *key, size_t key_len, const uint8_t *nonce, size_t
         return -1;
     crypto->aesSetKey(key, key_len);
     aes_ccm_auth_start(M, L, nonce, aad, aad_len, plain_len, x);
-    aes_ccm_auth(plain, plain_len, x);
-    /* Encryption */
     aes_ccm_encr_start(L, nonce, a);
-    aes_ccm_encr(L, plain, plain_len, crypt, a);
+    aes_ccm_crypt_auth(plain, plain_len, crypt, a, x, false);
     aes_ccm_encr_auth(M, x, a, auth);
     return 0;
 }
@@ -142,13 +123,11 @@ bool aes_ccm_ad(const uint8_t *key, size_t key_len, const uint8_t *nonce, size_t
     if (aad_len > 30 || M > AES_BLOCK_SIZE)
         return false;
     crypto->aesSetKey(key, key_len);
-    /* Decryption */
     aes_ccm_encr_start(L, nonce, a);
     aes_ccm_decr_auth(M, a, auth, t);
-    /* plaintext = msg XOR (S_1 | S_2 | ... | S_n) */
-    aes_ccm_encr(L, crypt, crypt_len, plain, a);
     aes_ccm_auth_start(M, L, nonce, aad, aad_len, crypt_len, x);
-    aes_ccm_auth(plain, crypt_len, x);
+    /* plaintext = msg XOR (S_1 | S_2 | ... | S_n) */
+    aes_ccm_crypt_auth(crypt, crypt_len, plain, a, x, true);
     if (memcmp(x, t, M) != 0) { // FIXME make const comp
         return false;
     }
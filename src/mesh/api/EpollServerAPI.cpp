@@ -0,0 +1,398 @@
+#include "EpollServerAPI.h"
+
+#if HAS_EPOLL_API_SERVER
+#include "MeshService.h"
+#include "WiFiServerAPI.h" // initApiServer()
+#include "main.h"
+#include "xmodem.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+EpollServerPort *epollServerPort;
+
+void initApiServer(int port)
+{
+    if (!epollServerPort) {
+        epollServerPort = new EpollServerPort(port);
+        if (!epollServerPort->init()) {
+            delete epollServerPort;
+            epollServerPort = NULL;
+        }
+    }
+}
+
+void deInitApiServer()
+{
+    delete epollServerPort;
+    epollServerPort = NULL;
+}
+
+EpollServerAPI::EpollServerAPI(EpollServerPort *_server, int _fd) : StreamAPI(&stream), fd(_fd), server(_server)
+{
+    LOG_INFO("Incoming API connection on fd %d\n", fd);
+}
+
+EpollServerAPI::~EpollServerAPI()
+{
+    close();
+    ::close(fd);
+    for (meshtastic_MeshPacket *p : packets)
+        packetPool.release(p);
+    for (meshtastic_QueueStatus *qs : queueStatuses)
+        queueStatusPool.release(qs);
+    for (meshtastic_MqttClientProxyMessage *m : mqttClientProxyMessages)
+        mqttClientProxyMessagePool.release(m);
+}
+
+/// Add to one of the queues of a client, dropping the oldest entry if it can't keep up
+template <class T> static void queueForClient(std::deque<T *> &queue, T *p, Allocator<T> &pool, int fd, const char *what)
+{
+    if (queue.size() >= MAX_RX_TOPHONE) {
+        LOG_WARN("API client on fd %d can't keep up, dropping a %s\n", fd, what);
+        pool.release(queue.front());
+        queue.pop_front();
+    }
+    queue.push_back(p);
+}
+
+/// Take the oldest entry of one of the queues of a client, NULL if there is none
+template <class T> static T *takeForClient(std::deque<T *> &queue)
+{
+    if (queue.empty())
+        return NULL;
+    T *p = queue.front();
+    queue.pop_front();
+    return p;
+}
+
+void EpollServerAPI::queuePacket(meshtastic_MeshPacket *p)
+{
+    queueForClient(packets, p, packetPool, fd, "packet");
+}
+
+void EpollServerAPI::queueQueueStatus(meshtastic_QueueStatus *qs)
+{
+    queueForClient(queueStatuses, qs, queueStatusPool, fd, "queue status");
+}
+
+void EpollServerAPI::queueMqttClientProxyMessage(meshtastic_MqttClientProxyMessage *m)
+{
+    queueForClient(mqttClientProxyMessages, m, mqttClientProxyMessagePool, fd, "MQTT proxy message");
+}
+
+bool EpollServerAPI::handleToRadio(const uint8_t *buf, size_t len)
+{
+    bool queued = StreamAPI::handleToRadio(buf, len);
+#ifdef FSCom
+    // xModem answers right away, in a single slot: keep the reply for this client before another one takes it
+    meshtastic_XModem reply = xModem.getForPhone();
+    if (reply.control != meshtastic_XModem_Control_NUL) {
+        xModem.resetForPhone();
+        xmodemReply = reply;
+    }
+#endif
+    return queued;
+}
+
+void EpollServerAPI::process()
+{
+    // Backpressure: if the client doesn't read what we send, the packets wait in our queue instead
+    canWrite = stream.tx.size() < EPOLL_API_HIGH_WATER;
+    runOncePart();
+
+    stream.rx.erase(0, stream.rxPos);
+    stream.rxPos = 0;
+}
+
+meshtastic_MeshPacket *EpollServerAPI::getPacketForPhone()
+{
+    return takeForClient(packets);
+}
+
+meshtastic_QueueStatus *EpollServerAPI::getQueueStatusForPhone()
+{
+    return takeForClient(queueStatuses);
+}
+
+meshtastic_MqttClientProxyMessage *EpollServerAPI::getMqttClientProxyMessageForPhone()
+{
+    return takeForClient(mqttClientProxyMessages);
+}
+
+meshtastic_XModem EpollServerAPI::getXModemForPhone()
+{
+    meshtastic_XModem reply = xmodemReply;
+    xmodemReply = meshtastic_XModem_init_zero;
+    return reply;
+}
+
+void EpollServerAPI::onNowHasData(uint32_t fromRadioNum)
+{
+    server->wake();
+}
+
+EpollServerPort::EpollServerPort(int _port) : concurrency::OSThread("ApiServer"), port(_port) {}
+
+EpollServerPort::~EpollServerPort()
+{
+    if (watcher.joinable()) {
+        {
+            std::lock_guard<std::mutex> g(lock);
+            stopping = true;
+        }
+        handled.notify_one();
+        uint64_t one = 1;
+        if (write(stopFd, &one, sizeof(one)) < 0)
+            LOG_WARN("Can't stop the API server watcher: %s\n", strerror(errno));
+        watcher.join();
+    }
+    for (EpollServerAPI *client : clients)
+        delete client;
+    if (listenFd >= 0)
+        ::close(listenFd);
+    if (epollFd >= 0)
+        ::close(epollFd);
+    if (stopFd >= 0)
+        ::close(stopFd);
+}
+
+bool EpollServerPort::init()
+{
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (listenFd < 0 || bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, 16) < 0) {
+        LOG_ERROR("Can't listen on TCP port %d: %s\n", port, strerror(errno));
+        return false;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL; // The listening socket, the clients have themselves here
+    if (epollFd < 0 || stopFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev) < 0) {
+        LOG_ERROR("Can't set up epoll for the API server: %s\n", strerror(errno));
+        return false;
+    }
+
+    fromNumObserver.observe(&service->fromNumChanged);
+    watcher = std::thread(&EpollServerPort::watch, this);
+    LOG_INFO("API server listening on TCP port %d, for up to %d clients\n", port, EPOLL_API_MAX_CLIENTS);
+    return true;
+}
+
+void EpollServerPort::wake()
+{
+    setIntervalFromNow(0);
+}
+
+void EpollServerPort::watch()
+{
+    struct pollfd fds[2] = {{epollFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            LOG_ERROR("API server watcher failed: %s\n", strerror(errno));
+            return;
+        }
+        if (fds[1].revents)
+            return;
+
+        std::unique_lock<std::mutex> g(lock);
+        eventsPending = true;
+        // Same as NotifiedWorkerThread::notify()
+        setInterval(0);
+        runASAP = true;
+        concurrency::mainDelay.interrupt();
+        handled.wait(g, [this] { return !eventsPending || stopping; });
+        if (stopping)
+            return;
+    }
+}
+
+int EpollServerPort::onFromNumChanged(uint32_t fromNum)
+{
+    if (!clients.empty())
+        wake();
+    return 0;
+}
+
+int32_t EpollServerPort::runOnce()
+{
+    struct epoll_event events[EPOLL_API_MAX_CLIENTS + 1];
+    int n = epoll_wait(epollFd, events, EPOLL_API_MAX_CLIENTS + 1, 0);
+    for (int i = 0; i < n; i++) {
+        EpollServerAPI *client = (EpollServerAPI *)events[i].data.ptr;
+        if (!client) {
+            acceptClients();
+            continue;
+        }
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            receive(client);
+        if (events[i].events & EPOLLOUT)
+            send(client);
+    }
+
+    distributePackets();
+
+    for (auto it = clients.begin(); it != clients.end();) {
+        EpollServerAPI *client = *it;
+        if (client->open) {
+            client->process();
+            send(client);
+        }
+        if (client->open) {
+            updateEvents(client);
+            ++it;
+        } else {
+            LOG_INFO("API client on fd %d disconnected\n", client->fd);
+            delete client; // Closing the socket takes it out of the epoll set
+            it = clients.erase(it);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> g(lock);
+        eventsPending = false;
+    }
+    handled.notify_one();
+
+    // Events wake us, the rest is for what doesn't notify fromNumChanged (queue status, MQTT proxy messages), like StreamAPI
+    return clients.empty() ? 1000 : 250;
+}
+
+void EpollServerPort::acceptClients()
+{
+    while (true) {
+        int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                LOG_WARN("API server accept failed: %s\n", strerror(errno));
+            return;
+        }
+        if (clients.size() >= EPOLL_API_MAX_CLIENTS) {
+            LOG_WARN("Already %d API clients, refusing another one\n", EPOLL_API_MAX_CLIENTS);
+            ::close(fd);
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        EpollServerAPI *client = new EpollServerAPI(this, fd);
+        struct epoll_event ev = {};
+        ev.events = client->events = EPOLLIN;
+        ev.data.ptr = client;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            LOG_WARN("Can't add API client to epoll: %s\n", strerror(errno));
+            delete client;
+            continue;
+        }
+        clients.push_back(client);
+    }
+}
+
+void EpollServerPort::receive(EpollServerAPI *client)
+{
+    uint8_t buf[1024];
+    // The rest stays in the socket until the next run, level triggered epoll reports it again
+    while (client->stream.rx.size() < EPOLL_API_HIGH_WATER) {
+        ssize_t got = recv(client->fd, buf, sizeof(buf), 0);
+        if (got > 0) {
+            client->stream.rx.append((const char *)buf, got);
+        } else if (got < 0 && errno == EINTR) {
+            continue;
+        } else if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return; // Got it all
+        } else {
+            client->open = false; // Closed by the client, or failed
+            return;
+        }
+    }
+}
+
+void EpollServerPort::send(EpollServerAPI *client)
+{
+    std::string &tx = client->stream.tx;
+    size_t sent = 0;
+    while (sent < tx.size()) {
+        ssize_t n = ::send(client->fd, tx.data() + sent, tx.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break; // The rest goes out on EPOLLOUT
+        } else if (errno != EINTR) {
+            client->open = false;
+            break;
+        }
+    }
+    tx.erase(0, sent);
+}
+
+void EpollServerPort::updateEvents(EpollServerAPI *client)
+{
+    uint32_t wanted = 0;
+    if (client->stream.tx.size() < EPOLL_API_HIGH_WATER)
+        wanted |= EPOLLIN;
+    if (!client->stream.tx.empty())
+        wanted |= EPOLLOUT;
+    if (wanted == client->events)
+        return;
+
+    struct epoll_event ev = {};
+    ev.events = client->events = wanted;
+    ev.data.ptr = client;
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, client->fd, &ev) < 0)
+        client->open = false;
+}
+
+void EpollServerPort::distributePackets()
+{
+    // Without clients the packets stay queued for the next one, as they would with a single connection
+    if (clients.empty())
+        return;
+
+    meshtastic_MeshPacket *p;
+    while ((p = service->getForPhone()) != NULL) {
+        for (EpollServerAPI *client : clients) {
+            meshtastic_MeshPacket *copy = packetPool.allocCopy(*p);
+            if (copy)
+                client->queuePacket(copy);
+        }
+        service->releaseToPool(p);
+    }
+
+    meshtastic_QueueStatus *qs;
+    while ((qs = service->getQueueStatusForPhone()) != NULL) {
+        for (EpollServerAPI *client : clients) {
+            meshtastic_QueueStatus *copy = queueStatusPool.allocCopy(*qs);
+            if (copy)
+                client->queueQueueStatus(copy);
+        }
+        service->releaseQueueStatusToPool(qs);
+    }
+
+    meshtastic_MqttClientProxyMessage *m;
+    while ((m = service->getMqttClientProxyMessageForPhone()) != NULL) {
+        for (EpollServerAPI *client : clients) {
+            meshtastic_MqttClientProxyMessage *copy = mqttClientProxyMessagePool.allocCopy(*m);
+            if (copy)
+                client->queueMqttClientProxyMessage(copy);
+        }
+        service->releaseMqttClientProxyMessageToPool(m);
+    }
+}
+#endif
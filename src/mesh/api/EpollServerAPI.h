@@ -0,0 +1,178 @@
+#pragma once
+
+#include "configuration.h"
+
+#if HAS_EPOLL_API_SERVER
+#include "Observer.h"
+#include "StreamAPI.h"
+#include "concurrency/OSThread.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef EPOLL_API_MAX_CLIENTS
+#define EPOLL_API_MAX_CLIENTS 16
+#endif
+
+// Once this much is waiting to go out to a client we stop reading from it and stop handing it FromRadio packets
+#ifndef EPOLL_API_HIGH_WATER
+#define EPOLL_API_HIGH_WATER (16 * MAX_STREAM_BUF_SIZE)
+#endif
+
+class EpollServerPort;
+
+/**
+ * The Stream that StreamAPI reads and writes for one client: the bytes the socket has received, and the ones still to be
+ * sent. It never blocks, EpollServerPort moves the bytes between these buffers and the socket.
+ */
+class EpollClientStream : public Stream
+{
+  public:
+    std::string rx;
+    size_t rxPos = 0;
+    std::string tx;
+
+    virtual int available() override { return rx.size() - rxPos; }
+    virtual int read() override { return rxPos < rx.size() ? (uint8_t)rx[rxPos++] : -1; }
+    virtual int peek() override { return rxPos < rx.size() ? (uint8_t)rx[rxPos] : -1; }
+    virtual size_t write(uint8_t c) override
+    {
+        tx.push_back(c);
+        return 1;
+    }
+    virtual size_t write(const uint8_t *buffer, size_t size) override
+    {
+        tx.append((const char *)buffer, size);
+        return size;
+    }
+    virtual void flush() override {} // Goes out once the socket is writable
+};
+
+/**
+ * One client of EpollServerPort, speaking the binary stream of StreamAPI: ToRadio and FromRadio protobufs, each framed with
+ * 0x94C3 and its length. There is no text mode as on the serial console, the debug log only goes out as log records.
+ *
+ * Every client gets its own copy of the packets, queue status and MQTT proxy messages for the phone, so several of them can
+ * watch the mesh at once. So with more than one client connected, only one of them should act as the MQTT proxy. An xmodem
+ * reply goes to the client that sent the request.
+ */
+class EpollServerAPI : public StreamAPI
+{
+  public:
+    EpollServerAPI(EpollServerPort *server, int fd);
+
+    /// Closes the socket
+    virtual ~EpollServerAPI();
+
+    const int fd;
+
+    /// Cleared once the socket is closed or failed, the server deletes us then
+    bool open = true;
+
+    /// The epoll events we are registered for
+    uint32_t events = 0;
+
+    EpollClientStream stream;
+
+    /// Take a copy of a packet for this client, dropping the oldest one if it can't keep up
+    void queuePacket(meshtastic_MeshPacket *p);
+
+    /// The same for queue status and MQTT proxy messages, from their pools
+    void queueQueueStatus(meshtastic_QueueStatus *qs);
+    void queueMqttClientProxyMessage(meshtastic_MqttClientProxyMessage *m);
+
+    virtual bool handleToRadio(const uint8_t *buf, size_t len) override;
+
+    /// Handle what was received and put whatever we have for the client in stream.tx
+    void process();
+
+  protected:
+    /// The TCP clients shouldn't change the power state, see ServerAPI
+    virtual void onConnectionChanged(bool connected) override {}
+
+    virtual bool checkIsConnected() override { return open; }
+
+    virtual meshtastic_MeshPacket *getPacketForPhone() override;
+
+    virtual meshtastic_QueueStatus *getQueueStatusForPhone() override;
+
+    virtual meshtastic_MqttClientProxyMessage *getMqttClientProxyMessageForPhone() override;
+
+    virtual meshtastic_XModem getXModemForPhone() override;
+
+    virtual void onNowHasData(uint32_t fromRadioNum) override;
+
+  private:
+    EpollServerPort *server;
+    std::deque<meshtastic_MeshPacket *> packets;
+    std::deque<meshtastic_QueueStatus *> queueStatuses;
+    std::deque<meshtastic_MqttClientProxyMessage *> mqttClientProxyMessages;
+    meshtastic_XModem xmodemReply = meshtastic_XModem_init_zero;
+};
+
+/**
+ * The TCP API server on Linux native: accepts any number of clients (up to EPOLL_API_MAX_CLIENTS) and does all socket IO
+ * through one epoll set, so nothing polls the sockets.
+ *
+ * All the sockets and the PhoneAPI instances are only touched from the main thread. A watcher thread blocks until the
+ * epoll set has events and then wakes the main loop out of mainDelay to handle them, and waits for that to be done before
+ * it looks again.
+ */
+class EpollServerPort : private concurrency::OSThread
+{
+  public:
+    explicit EpollServerPort(int port);
+
+    ~EpollServerPort();
+
+    /// Start listening, false if we couldn't
+    bool init();
+
+    /// Run ASAP, main thread only
+    void wake();
+
+    size_t numClients() const { return clients.size(); }
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    int port;
+    int listenFd = -1;
+    int epollFd = -1;
+    int stopFd = -1; // eventfd that tells the watcher to quit
+
+    std::vector<EpollServerAPI *> clients;
+
+    CallbackObserver<EpollServerPort, uint32_t> fromNumObserver =
+        CallbackObserver<EpollServerPort, uint32_t>(this, &EpollServerPort::onFromNumChanged);
+
+    std::thread watcher;
+    std::mutex lock; // For the two below
+    std::condition_variable handled;
+    bool eventsPending = false;
+    bool stopping = false;
+
+    int onFromNumChanged(uint32_t fromNum);
+
+    void acceptClients();
+
+    void receive(EpollServerAPI *client);
+
+    void send(EpollServerAPI *client);
+
+    /// Register for the events the client needs now: reads unless it is backed up, writes while there is something to send
+    void updateEvents(EpollServerAPI *client);
+
+    /// Hand every client a copy of the packets, queue status and MQTT proxy messages the mesh service has for the phone
+    void distributePackets();
+
+    /// Body of the watcher thread
+    void watch();
+};
+
+extern EpollServerPort *epollServerPort;
+#endif
@@ -4,6 +4,8 @@
 #if HAS_WIFI
 #include "WiFiServerAPI.h"
 
+// Linux native has its own server for any number of clients, see EpollServerAPI
+#if !HAS_EPOLL_API_SERVER
 static WiFiServerPort *apiPort;
 
 void initApiServer(int port)
@@ -19,6 +21,7 @@ void deInitApiServer()
 {
     delete apiPort;
 }
+#endif
 
 WiFiServerAPI::WiFiServerAPI(WiFiClient &_client) : ServerAPI(_client)
 {
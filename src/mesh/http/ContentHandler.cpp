@@ -2,6 +2,7 @@
 #include "NodeDB.h"
 #include "PowerFSM.h"
 #include "RadioLibInterface.h"
+#include "RouteCache.h"
 #include "airtime.h"
 #include "main.h"
 #include "mesh/http/ContentHelper.h"
@@ -17,6 +18,10 @@
 #include <HTTPMultipartBodyParser.hpp>
 #include <HTTPURLEncodedBodyParser.hpp>
 
+#if !MESHTASTIC_EXCLUDE_MQTT
+#include "mqtt/MQTT.h"
+#endif
+
 #ifdef ARCH_ESP32
 #include "esp_task_wdt.h"
 #endif
@@ -609,11 +614,45 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
         rxAllLogValues.push_back(new JSONValue((int)logArray[i]));
     }
 
+    // data->airtime->portnum_tx, portnum_rx (only ports that used any airtime)
+    JSONObject portnumTxValues;
+    JSONObject portnumRxValues;
+    for (int i = 0; i < AIRTIME_PORTNUM_SLOTS; i++) {
+        uint32_t tx = airTime->getPortnumAirtime(TX_LOG, (meshtastic_PortNum)i);
+        uint32_t rx = airTime->getPortnumAirtime(RX_LOG, (meshtastic_PortNum)i);
+        if (tx)
+            portnumTxValues[std::to_string(i)] = new JSONValue((int)tx);
+        if (rx)
+            portnumRxValues[std::to_string(i)] = new JSONValue((int)rx);
+    }
+
+    // data->airtime->priority_tx
+    JSONObject priorityTxValues;
+    const meshtastic_MeshPacket_Priority priorities[] = {
+        meshtastic_MeshPacket_Priority_UNSET,
+        meshtastic_MeshPacket_Priority_MIN,
+        meshtastic_MeshPacket_Priority_BACKGROUND,
+        meshtastic_MeshPacket_Priority_DEFAULT,
+        meshtastic_MeshPacket_Priority_RELIABLE,
+        meshtastic_MeshPacket_Priority_RESPONSE,
+        meshtastic_MeshPacket_Priority_HIGH,
+        meshtastic_MeshPacket_Priority_ACK,
+        meshtastic_MeshPacket_Priority_MAX,
+    };
+    for (auto priority : priorities) {
+        uint32_t tx = airTime->getPriorityAirtime(priority);
+        if (tx)
+            priorityTxValues[std::to_string(priority)] = new JSONValue((int)tx);
+    }
+
     // data->airtime
     JSONObject jsonObjAirtime;
     jsonObjAirtime["tx_log"] = new JSONValue(txLogValues);
     jsonObjAirtime["rx_log"] = new JSONValue(rxLogValues);
     jsonObjAirtime["rx_all_log"] = new JSONValue(rxAllLogValues);
+    jsonObjAirtime["portnum_tx"] = new JSONValue(portnumTxValues);
+    jsonObjAirtime["portnum_rx"] = new JSONValue(portnumRxValues);
+    jsonObjAirtime["priority_tx"] = new JSONValue(priorityTxValues);
     jsonObjAirtime["channel_utilization"] = new JSONValue(airTime->channelUtilizationPercent());
     jsonObjAirtime["utilization_tx"] = new JSONValue(airTime->utilizationTXPercent());
     jsonObjAirtime["seconds_since_boot"] = new JSONValue(int(airTime->getSecondsSinceBoot()));
@@ -651,6 +690,32 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     JSONObject jsonObjRadio;
     jsonObjRadio["frequency"] = new JSONValue(RadioLibInterface::instance->getFreq());
     jsonObjRadio["lora_channel"] = new JSONValue((int)RadioLibInterface::instance->getChannelNum() + 1);
+    jsonObjRadio["rx_good"] = new JSONValue((int)RadioLibInterface::instance->rxGood);
+    jsonObjRadio["rx_bad"] = new JSONValue((int)RadioLibInterface::instance->rxBad);
+    jsonObjRadio["rx_dupe"] = new JSONValue((int)RadioLibInterface::instance->rxDupe);
+    jsonObjRadio["tx_good"] = new JSONValue((int)RadioLibInterface::instance->txGood);
+
+    // data->routing
+    JSONObject jsonObjRouting;
+    if (routeCache) {
+        jsonObjRouting["routes"] = new JSONValue((int)routeCache->size());
+        jsonObjRouting["lookups"] = new JSONValue((int)routeCache->lookups);
+        jsonObjRouting["hits"] = new JSONValue((int)routeCache->hits);
+        jsonObjRouting["fallbacks"] = new JSONValue((int)routeCache->fallbacks);
+    }
+
+    // data->mqtt_downlink
+    JSONObject jsonObjDownlink;
+#if !MESHTASTIC_EXCLUDE_MQTT
+    if (mqtt) {
+        const DownlinkStats &downlink = mqtt->getDownlinkStats();
+        jsonObjDownlink["admitted"] = new JSONValue((int)downlink.admitted);
+        jsonObjDownlink["duplicates"] = new JSONValue((int)downlink.duplicates);
+        jsonObjDownlink["shed_busy"] = new JSONValue((int)downlink.shedBusy);
+        jsonObjDownlink["shed_channel"] = new JSONValue((int)downlink.shedChannel);
+        jsonObjDownlink["shed_source"] = new JSONValue((int)downlink.shedSource);
+    }
+#endif
 
     // collect data to inner data object
     JSONObject jsonObjInner;
@@ -660,6 +725,8 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjInner["power"] = new JSONValue(jsonObjPower);
     jsonObjInner["device"] = new JSONValue(jsonObjDevice);
     jsonObjInner["radio"] = new JSONValue(jsonObjRadio);
+    jsonObjInner["routing"] = new JSONValue(jsonObjRouting);
+    jsonObjInner["mqtt_downlink"] = new JSONValue(jsonObjDownlink);
 
     // create json output structure
     JSONObject jsonObjOuter;
@@ -0,0 +1,218 @@
+#include "UdpMulticastInterface.h"
+
+#if HAS_UDP_MULTICAST
+#include "Router.h"
+#include "main.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/// Tells our own datagrams apart from those of other processes on this host. The PRNG is seeded with the time, so two of us
+/// started in the same second would draw the same number from it.
+static uint32_t newInstanceId()
+{
+    uint32_t id;
+    if (getrandom(&id, sizeof(id), 0) == sizeof(id))
+        return id;
+    return random(INT32_MAX) ^ ((uint32_t)getpid() << 16) ^ getpid();
+}
+
+UdpMulticastInterface::UdpMulticastInterface(const char *_group, int _port, const char *_ifAddress)
+    : concurrency::OSThread("UdpMulticast"), group(_group), port(_port), ifAddress(_ifAddress), instance(newInstanceId())
+{
+    // Everyone in the group hears what we send, only pass on what we heard elsewhere
+    rebroadcastPolicy = REBROADCAST_BRIDGE_ONLY;
+}
+
+UdpMulticastInterface::~UdpMulticastInterface()
+{
+    if (watcher.joinable()) {
+        uint64_t one = 1;
+        if (write(stopFd, &one, sizeof(one)) < 0)
+            LOG_WARN("Can't stop the UDP multicast watcher: %s\n", strerror(errno));
+        watcher.join();
+    }
+    if (sock >= 0)
+        close(sock);
+    if (stopFd >= 0)
+        close(stopFd);
+}
+
+bool UdpMulticastInterface::init()
+{
+    struct ip_mreq mreq = {};
+    struct in_addr localIf = {};
+    localIf.s_addr = htonl(INADDR_ANY);
+    if (inet_pton(AF_INET, group.c_str(), &mreq.imr_multiaddr) != 1 || !IN_MULTICAST(ntohl(mreq.imr_multiaddr.s_addr)) ||
+        (!ifAddress.empty() && inet_pton(AF_INET, ifAddress.c_str(), &localIf) != 1)) {
+        LOG_ERROR("Bad UDP multicast group %s or interface address %s\n", group.c_str(), ifAddress.c_str());
+        return false;
+    }
+    mreq.imr_interface = localIf;
+
+    sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    uint8_t ttl = 1;  // Stay on the LAN
+    uint8_t loop = 1; // Other instances on this host are in the group too
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (sock < 0 || setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 ||
+        bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0 ||
+        setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &localIf, sizeof(localIf)) < 0 ||
+        setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0 ||
+        setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0) {
+        LOG_ERROR("Can't join UDP multicast group %s:%d: %s\n", group.c_str(), port, strerror(errno));
+        return false;
+    }
+
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (stopFd < 0) {
+        LOG_ERROR("Can't set up the UDP multicast watcher: %s\n", strerror(errno));
+        return false;
+    }
+    watcher = std::thread(&UdpMulticastInterface::watch, this);
+    LOG_INFO("Sharing mesh packets with UDP multicast group %s:%d\n", group.c_str(), port);
+    return true;
+}
+
+ErrorCode UdpMulticastInterface::send(meshtastic_MeshPacket *p)
+{
+    if (disabled || sock < 0) {
+        packetPool.release(p);
+        return ERRNO_DISABLED;
+    }
+
+    size_t frameLen = beginSending(p);
+    sendingPacket = NULL; // Sent right away, nothing waits for a TX done interrupt
+
+    uint8_t datagram[sizeof(UdpMulticastHeader) + MAX_RHPACKETLEN];
+    UdpMulticastHeader *u = (UdpMulticastHeader *)datagram;
+    u->magic[0] = UDP_MULTICAST_MAGIC0;
+    u->magic[1] = UDP_MULTICAST_MAGIC1;
+    u->version = UDP_MULTICAST_VERSION;
+    u->reserved = 0;
+    u->instance = instance;
+    memcpy(datagram + sizeof(UdpMulticastHeader), radiobuf, frameLen);
+
+    struct sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(port);
+    inet_pton(AF_INET, group.c_str(), &to.sin_addr);
+
+    printPacket("UDP TX", p);
+    packetPool.release(p);
+    if (sendto(sock, datagram, sizeof(UdpMulticastHeader) + frameLen, 0, (struct sockaddr *)&to, sizeof(to)) < 0) {
+        LOG_WARN("UDP multicast send failed: %s\n", strerror(errno));
+        return ERRNO_UNKNOWN;
+    }
+    txGood++;
+    return ERRNO_OK;
+}
+
+int32_t UdpMulticastInterface::runOnce()
+{
+    std::deque<std::string> datagrams;
+    {
+        std::lock_guard<std::mutex> g(lock);
+        datagrams.swap(received);
+    }
+    for (const std::string &datagram : datagrams)
+        handleDatagram(datagram);
+
+    return INT32_MAX; // The watcher wakes us when something arrives
+}
+
+void UdpMulticastInterface::handleDatagram(const std::string &datagram)
+{
+    UdpMulticastHeader u;
+    PacketHeader h;
+    if (datagram.size() < sizeof(u) + sizeof(h) || datagram.size() > sizeof(u) + MAX_RHPACKETLEN) {
+        rxBad++;
+        return;
+    }
+    memcpy(&u, datagram.data(), sizeof(u));
+    memcpy(&h, datagram.data() + sizeof(u), sizeof(h));
+    if (u.magic[0] != UDP_MULTICAST_MAGIC0 || u.magic[1] != UDP_MULTICAST_MAGIC1 || u.version != UDP_MULTICAST_VERSION) {
+        rxBad++;
+        return;
+    }
+    if (u.instance == instance)
+        return; // Our own, looped back by the group
+
+    // altered packet with "from == 0" can do Remote Node Administration without permission
+    if (disabled || h.from == 0) {
+        rxBad++;
+        return;
+    }
+
+    uint32_t frameLen = datagram.size() - sizeof(u);
+    if (router && router->dropDuplicate(&h, frameLen, this)) {
+        rxDupe++;
+        return;
+    }
+    rxGood++;
+
+    meshtastic_MeshPacket *mp = packetPool.allocZeroed();
+    mp->from = h.from;
+    mp->to = h.to;
+    mp->id = h.id;
+    mp->channel = h.channel;
+    mp->hop_limit = h.flags & PACKET_FLAGS_HOP_LIMIT_MASK;
+    mp->hop_start = (h.flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
+    mp->want_ack = !!(h.flags & PACKET_FLAGS_WANT_ACK_MASK);
+    mp->via_mqtt = !!(h.flags & PACKET_FLAGS_VIA_MQTT_MASK);
+    mp->next_hop = h.next_hop;
+    mp->relay_node = h.relay_node;
+
+    mp->which_payload_variant = meshtastic_MeshPacket_encrypted_tag; // Mark that the payload is still encrypted at this point
+    mp->encrypted.size = frameLen - sizeof(h);
+    memcpy(mp->encrypted.bytes, datagram.data() + sizeof(u) + sizeof(h), mp->encrypted.size);
+
+    printPacket("UDP RX", mp);
+    deliverToReceiver(mp);
+}
+
+void UdpMulticastInterface::watch()
+{
+    struct pollfd fds[2] = {{sock, POLLIN, 0}, {stopFd, POLLIN, 0}};
+    uint8_t buf[sizeof(UdpMulticastHeader) + MAX_RHPACKETLEN + 1]; // One more, to tell datagrams that are too long
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            LOG_ERROR("UDP multicast watcher failed: %s\n", strerror(errno));
+            return;
+        }
+        if (fds[1].revents)
+            return;
+
+        bool got = false;
+        ssize_t n;
+        while ((n = recv(sock, buf, sizeof(buf), 0)) >= 0 || errno == EINTR) {
+            if (n < 0)
+                continue;
+            std::lock_guard<std::mutex> g(lock);
+            if (received.size() >= UDP_MULTICAST_MAX_QUEUE)
+                received.pop_front(); // The main loop can't keep up, the newest ones are the most useful
+            received.emplace_back((const char *)buf, n);
+            got = true;
+        }
+
+        if (got) {
+            // Same as NotifiedWorkerThread::notify()
+            setInterval(0);
+            runASAP = true;
+            concurrency::mainDelay.interrupt();
+        }
+    }
+}
+#endif
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "configuration.h"
+
+#if HAS_UDP_MULTICAST
+#include "RadioInterface.h"
+#include "concurrency/OSThread.h"
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#define UDP_MULTICAST_DEFAULT_GROUP "224.0.0.69"
+#define UDP_MULTICAST_DEFAULT_PORT 4403
+
+// Received datagrams waiting for the main thread, the oldest ones are dropped beyond this
+#ifndef UDP_MULTICAST_MAX_QUEUE
+#define UDP_MULTICAST_MAX_QUEUE 32
+#endif
+
+#define UDP_MULTICAST_MAGIC0 'M'
+#define UDP_MULTICAST_MAGIC1 'U'
+#define UDP_MULTICAST_VERSION 1
+
+/**
+ * What goes in front of the radio frame (PacketHeader and the encrypted payload) in every datagram
+ */
+typedef struct {
+    uint8_t magic[2];
+    uint8_t version;
+    uint8_t reserved;
+    // Random for each interface, so we can skip our own datagrams when the group loops them back to us
+    uint32_t instance;
+} UdpMulticastHeader;
+
+/**
+ * Carries our packets between the nodes on the same LAN, over UDP multicast. The datagrams hold the same frame as LoRa
+ * does, so the payload stays encrypted with the channel key, and other nodes see our packets just as if they had heard them
+ * over the air.
+ *
+ * Add it to the router next to the LoRa radio. It relays with REBROADCAST_BRIDGE_ONLY: everyone in the group got the
+ * datagram already, so we only pass on what came from another interface. Duplicates, such as a packet that reached us both
+ * over LoRa and over the LAN, are dropped through the packet history of the router, before anything is allocated for them.
+ *
+ * Sending takes no airtime, so nothing on this interface counts towards channel utilization or the duty cycle.
+ *
+ * The socket is only read from a watcher thread, which queues the datagrams and wakes the main loop to handle them.
+ */
+class UdpMulticastInterface : public RadioInterface, private concurrency::OSThread
+{
+  public:
+    /**
+     * @param group the multicast group to send to and listen on
+     * @param ifAddress the local address of the network interface to use, empty for the one the system picks. Several
+     * instances on one host can use 127.0.0.1.
+     */
+    UdpMulticastInterface(const char *group = UDP_MULTICAST_DEFAULT_GROUP, int port = UDP_MULTICAST_DEFAULT_PORT,
+                          const char *ifAddress = "");
+
+    virtual ~UdpMulticastInterface();
+
+    /**
+     * Debugging counts
+     */
+    uint32_t rxBad = 0, rxGood = 0, rxDupe = 0, txGood = 0;
+
+    /// Join the group and start the watcher thread, false if we couldn't
+    virtual bool init() override;
+
+    /// Nothing in the LoRa config applies to us
+    virtual bool reconfigure() override { return true; }
+
+    virtual ErrorCode send(meshtastic_MeshPacket *p) override;
+
+    using RadioInterface::getPacketTime;
+
+    /// Datagrams take no airtime
+    virtual uint32_t getPacketTime(uint32_t totalPacketLen) override { return 0; }
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    std::string group;
+    int port;
+    std::string ifAddress;
+    uint32_t instance;
+
+    int sock = -1;
+    int stopFd = -1; // eventfd that tells the watcher to quit
+
+    std::thread watcher;
+    std::mutex lock; // For received
+    std::deque<std::string> received;
+
+    /// Check a datagram and hand the packet in it to the router
+    void handleDatagram(const std::string &datagram);
+
+    /// Body of the watcher thread
+    void watch();
+};
+#endif
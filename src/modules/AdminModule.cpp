@@ -38,6 +38,10 @@
 #include "AccelerometerThread.h"
 #endif
 
+#if !MESHTASTIC_EXCLUDE_I2C
+#include "detect/ScanI2CTwoWire.h"
+#endif
+
 AdminModule *adminModule;
 bool hasOpenEditTransaction;
 
@@ -595,6 +599,10 @@ void AdminModule::handleSetModuleConfig(const meshtastic_ModuleConfig &c)
         LOG_INFO("Setting module config: Telemetry\n");
         moduleConfig.has_telemetry = true;
         moduleConfig.telemetry = c.payload_variant.telemetry;
+#if !MESHTASTIC_EXCLUDE_I2C
+        // Most likely sensors were attached or swapped, find them on the reboot that follows
+        ScanI2CTwoWire::clearScanCache();
+#endif
         break;
     case meshtastic_ModuleConfig_canned_message_tag:
         LOG_INFO("Setting module config: Canned Message\n");
@@ -66,9 +66,9 @@
 #if !MESHTASTIC_EXCLUDE_PAXCOUNTER
 #include "modules/esp32/PaxcounterModule.h"
 #endif
-#if !MESHTASTIC_EXCLUDE_STOREFORWARD
-#include "modules/esp32/StoreForwardModule.h"
 #endif
+#if (defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)) && !MESHTASTIC_EXCLUDE_STOREFORWARD
+#include "modules/esp32/StoreForwardModule.h"
 #endif
 #if defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_RP2040)
 #if !MESHTASTIC_EXCLUDE_EXTERNALNOTIFICATION
@@ -213,6 +213,9 @@ void setupModules()
         paxcounterModule = new PaxcounterModule();
 #endif
 #endif
+#if defined(ARCH_PORTDUINO) && !MESHTASTIC_EXCLUDE_STOREFORWARD
+        storeForwardModule = new StoreForwardModule();
+#endif
 #if defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_RP2040)
 #if !MESHTASTIC_EXCLUDE_EXTERNALNOTIFICATION
         externalNotificationModule = new ExternalNotificationModule();
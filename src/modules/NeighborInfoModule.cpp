@@ -3,6 +3,7 @@
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "RTC.h"
+#include "RouteCache.h"
 
 NeighborInfoModule *neighborInfoModule;
 
@@ -133,6 +134,14 @@ bool NeighborInfoModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp,
     if (np) {
         printNeighborInfo("RECEIVED", np);
         updateNeighbors(mp, np);
+
+        // A direct neighbor of ours can take messages on to its own neighbors
+        if (routeCache && mp.from && mp.from != nodeDB->getNodeNum() && mp.hop_start != 0 && mp.hop_start == mp.hop_limit) {
+            for (pb_size_t i = 0; i < np->neighbors_count; i++) {
+                if (np->neighbors[i].node_id != nodeDB->getNodeNum())
+                    routeCache->learn(np->neighbors[i].node_id, getLastByteOfNodeNum(mp.from), ROUTE_SRC_NEIGHBORINFO);
+            }
+        }
     } else if (mp.hop_start != 0 && mp.hop_start == mp.hop_limit) {
         // If the hopLimit is the same as hopStart, then it is a neighbor
         getOrCreateNeighbor(mp.from, mp.from, 0, mp.rx_snr); // Set the broadcast interval to 0, as we don't know it
@@ -29,7 +29,7 @@ uint32_t packetSequence = 0;
 
 int32_t RangeTestModule::runOnce()
 {
-#if defined(ARCH_ESP32) || defined(ARCH_NRF52)
+#if defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_RP2040)
 
     /*
         Uncomment the preferences below if you want to use the module
@@ -128,7 +128,7 @@ void RangeTestModuleRadio::sendPayload(NodeNum dest, bool wantReplies)
 
 ProcessMessage RangeTestModuleRadio::handleReceived(const meshtastic_MeshPacket &mp)
 {
-#if defined(ARCH_ESP32) || defined(ARCH_NRF52)
+#if defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_RP2040)
 
     if (moduleConfig.range_test.enabled) {
 
@@ -181,7 +181,7 @@ ProcessMessage RangeTestModuleRadio::handleReceived(const meshtastic_MeshPacket
 
 bool RangeTestModuleRadio::appendFile(const meshtastic_MeshPacket &mp)
 {
-#ifdef ARCH_ESP32
+#ifdef FSCom
     auto &p = mp.decoded;
 
     meshtastic_NodeInfoLite *n = nodeDB->getMeshNode(getFrom(&mp));
@@ -208,46 +208,11 @@ bool RangeTestModuleRadio::appendFile(const meshtastic_MeshPacket &mp)
         LOG_DEBUG("gpsStatus->getDOP()          %d\n", gpsStatus->getDOP());
         LOG_DEBUG("-----------------------------------------\n");
     */
-    if (!FSBegin()) {
-        LOG_DEBUG("An Error has occurred while mounting the filesystem\n");
-        return 0;
-    }
-
-    if (FSCom.totalBytes() - FSCom.usedBytes() < 51200) {
-        LOG_DEBUG("Filesystem doesn't have enough free space. Aborting write.\n");
-        return 0;
-    }
-
-    FSCom.mkdir("/static");
-
-    // If the file doesn't exist, write the header.
-    if (!FSCom.exists("/static/rangetest.csv")) {
-        //--------- Write to file
-        File fileToWrite = FSCom.open("/static/rangetest.csv", FILE_WRITE);
-
-        if (!fileToWrite) {
-            LOG_ERROR("There was an error opening the file for writing\n");
-            return 0;
-        }
-
-        // Print the CSV header
-        if (fileToWrite.println(
-                "time,from,sender name,sender lat,sender long,rx lat,rx long,rx elevation,rx snr,distance,hop limit,payload")) {
-            LOG_INFO("File was written\n");
-        } else {
-            LOG_ERROR("File write failed\n");
-        }
-        fileToWrite.flush();
-        fileToWrite.close();
-    }
-
-    //--------- Append content to file
-    File fileToAppend = FSCom.open("/static/rangetest.csv", FILE_APPEND);
-
-    if (!fileToAppend) {
-        LOG_ERROR("There was an error opening the file for appending\n");
-        return 0;
-    }
+    if (!csvLog)
+        csvLog = new BufferedLogFile(
+            "/static/rangetest.csv",
+            "time,from,sender name,sender lat,sender long,rx lat,rx long,rx elevation,rx snr,distance,hop limit,payload",
+            RANGETEST_CSV_MAX_BYTES);
 
     struct timeval tv;
     if (!gettimeofday(&tv, NULL)) {
@@ -259,35 +224,33 @@ bool RangeTestModuleRadio::appendFile(const meshtastic_MeshPacket &mp)
         int min = (hms % SEC_PER_HOUR) / SEC_PER_MIN;
         int sec = (hms % SEC_PER_HOUR) % SEC_PER_MIN; // or hms % SEC_PER_MIN
 
-        fileToAppend.printf("%02d:%02d:%02d,", hour, min, sec); // Time
+        csvLog->printf("%02d:%02d:%02d,", hour, min, sec); // Time
     } else {
-        fileToAppend.printf("??:??:??,"); // Time
+        csvLog->printf("??:??:??,"); // Time
     }
 
-    fileToAppend.printf("%d,", getFrom(&mp));                     // From
-    fileToAppend.printf("%s,", n->user.long_name);                // Long Name
-    fileToAppend.printf("%f,", n->position.latitude_i * 1e-7);    // Sender Lat
-    fileToAppend.printf("%f,", n->position.longitude_i * 1e-7);   // Sender Long
-    fileToAppend.printf("%f,", gpsStatus->getLatitude() * 1e-7);  // RX Lat
-    fileToAppend.printf("%f,", gpsStatus->getLongitude() * 1e-7); // RX Long
-    fileToAppend.printf("%d,", gpsStatus->getAltitude());         // RX Altitude
+    csvLog->printf("%d,", getFrom(&mp));                     // From
+    csvLog->printf("%s,", n->user.long_name);                // Long Name
+    csvLog->printf("%f,", n->position.latitude_i * 1e-7);    // Sender Lat
+    csvLog->printf("%f,", n->position.longitude_i * 1e-7);   // Sender Long
+    csvLog->printf("%f,", gpsStatus->getLatitude() * 1e-7);  // RX Lat
+    csvLog->printf("%f,", gpsStatus->getLongitude() * 1e-7); // RX Long
+    csvLog->printf("%d,", gpsStatus->getAltitude());         // RX Altitude
 
-    fileToAppend.printf("%f,", mp.rx_snr); // RX SNR
+    csvLog->printf("%f,", mp.rx_snr); // RX SNR
 
     if (n->position.latitude_i && n->position.longitude_i && gpsStatus->getLatitude() && gpsStatus->getLongitude()) {
         float distance = GeoCoord::latLongToMeter(n->position.latitude_i * 1e-7, n->position.longitude_i * 1e-7,
                                                   gpsStatus->getLatitude() * 1e-7, gpsStatus->getLongitude() * 1e-7);
-        fileToAppend.printf("%f,", distance); // Distance in meters
+        csvLog->printf("%f,", distance); // Distance in meters
     } else {
-        fileToAppend.printf("0,");
+        csvLog->printf("0,");
     }
 
-    fileToAppend.printf("%d,", mp.hop_limit); // Packet Hop Limit
+    csvLog->printf("%d,", mp.hop_limit); // Packet Hop Limit
 
     // TODO: If quotes are found in the payload, it has to be escaped.
-    fileToAppend.printf("\"%s\"\n", p.payload.bytes);
-    fileToAppend.flush();
-    fileToAppend.close();
+    csvLog->printf("\"%.*s\"\n", (int)p.payload.size, p.payload.bytes);
 #endif
 
     return 1;
@@ -1,11 +1,22 @@
 #pragma once
 
+#include "BufferedLogFile.h"
 #include "SinglePortModule.h"
 #include "concurrency/OSThread.h"
 #include "configuration.h"
 #include <Arduino.h>
 #include <functional>
 
+// Largest the range test CSV may grow to. On ESP32 the free space of the filesystem is checked instead, elsewhere it has to
+// fit next to the config on the smallest filesystem we log to (28KB on nRF52).
+#ifndef RANGETEST_CSV_MAX_BYTES
+#ifdef ARCH_ESP32
+#define RANGETEST_CSV_MAX_BYTES 0
+#else
+#define RANGETEST_CSV_MAX_BYTES (16 * 1024)
+#endif
+#endif
+
 class RangeTestModule : private concurrency::OSThread
 {
     bool firstTime = 1;
@@ -27,6 +38,9 @@ extern RangeTestModule *rangeTestModule;
 class RangeTestModuleRadio : public SinglePortModule
 {
     uint32_t lastRxID = 0;
+#ifdef FSCom
+    BufferedLogFile *csvLog = nullptr; // Received packets, when range_test.save is set
+#endif
 
   public:
     RangeTestModuleRadio() : SinglePortModule("RangeTestModuleRadio", meshtastic_PortNum_RANGE_TEST_APP)
@@ -40,7 +54,7 @@ class RangeTestModuleRadio : public SinglePortModule
     void sendPayload(NodeNum dest = NODENUM_BROADCAST, bool wantReplies = false);
 
     /**
-     * Append range test data to the file on the Filesystem
+     * Append range test data to the file on the Filesystem. Rows are buffered and written out in batches.
      */
     bool appendFile(const meshtastic_MeshPacket &mp);
 
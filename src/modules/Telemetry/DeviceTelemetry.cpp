@@ -6,11 +6,15 @@
 #include "PowerFSM.h"
 #include "RTC.h"
 #include "RadioLibInterface.h"
+#include "RouteCache.h"
 #include "Router.h"
 #include "configuration.h"
 #include "main.h"
 #include <OLEDDisplay.h>
 #include <OLEDDisplayUi.h>
+#if !MESHTASTIC_EXCLUDE_MQTT
+#include "mqtt/MQTT.h"
+#endif
 
 #define MAGIC_USB_BATTERY_LEVEL 101
 
@@ -126,7 +130,15 @@ void DeviceTelemetryModule::sendLocalStatsToPhone()
         telemetry.variant.local_stats.num_packets_tx = RadioLibInterface::instance->txGood;
         telemetry.variant.local_stats.num_packets_rx = RadioLibInterface::instance->rxGood;
         telemetry.variant.local_stats.num_packets_rx_bad = RadioLibInterface::instance->rxBad;
+        LOG_INFO("num_packets_rx_dupe=%u\n", RadioLibInterface::instance->rxDupe);
+    }
+#if !MESHTASTIC_EXCLUDE_MQTT
+    if (mqtt) {
+        const DownlinkStats &downlink = mqtt->getDownlinkStats();
+        LOG_INFO("mqtt_downlink_admitted=%u, duplicates=%u, shed_busy=%u, shed_channel=%u, shed_source=%u\n", downlink.admitted,
+                 downlink.duplicates, downlink.shedBusy, downlink.shedChannel, downlink.shedSource);
     }
+#endif
 
     LOG_INFO(
         "(Sending local stats): uptime=%i, channel_utilization=%f, air_util_tx=%f, num_online_nodes=%i, num_total_nodes=%i\n",
@@ -136,6 +148,9 @@ void DeviceTelemetryModule::sendLocalStatsToPhone()
 
     LOG_INFO("num_packets_tx=%i, num_packets_rx=%i, num_packets_rx_bad=%i\n", telemetry.variant.local_stats.num_packets_tx,
              telemetry.variant.local_stats.num_packets_rx, telemetry.variant.local_stats.num_packets_rx_bad);
+    if (routeCache)
+        LOG_INFO("route_lookups=%u, route_hits=%u, route_fallbacks=%u, routes=%u\n", routeCache->lookups, routeCache->hits,
+                 routeCache->fallbacks, (unsigned)routeCache->size());
 
     meshtastic_MeshPacket *p = allocDataProtobuf(telemetry);
     p->to = NODENUM_BROADCAST;
@@ -143,6 +143,15 @@ int32_t EnvironmentTelemetryModule::runOnce()
                 result = mlx90632Sensor.runOnce();
             if (nau7802Sensor.hasSensor())
                 result = nau7802Sensor.runOnce();
+
+            // Same order as getEnvironmentTelemetry() reads them back
+            TelemetrySensor *sampled[] = {&dfRobotLarkSensor, &sht31Sensor,    &sht4xSensor,    &lps22hbSensor,  &shtc3Sensor,
+                                          &bmp085Sensor,      &bmp280Sensor,   &bme280Sensor,   &bmp3xxSensor,   &bme680Sensor,
+                                          &mcp9808Sensor,     &ina219Sensor,   &ina260Sensor,   &ina3221Sensor,  &veml7700Sensor,
+                                          &tsl2591Sensor,     &opt3001Sensor,  &mlx90632Sensor, &rcwl9620Sensor, &nau7802Sensor,
+                                          &aht10Sensor};
+            for (TelemetrySensor *sensor : sampled)
+                sampler.add(sensor);
 #endif
         }
         return result;
@@ -156,21 +165,38 @@ int32_t EnvironmentTelemetryModule::runOnce()
         }
 
         uint32_t now = millis();
-        if (((lastSentToMesh == 0) ||
-             ((now - lastSentToMesh) >=
-              Default::getConfiguredOrDefaultMsScaled(moduleConfig.telemetry.environment_update_interval,
-                                                      default_telemetry_broadcast_interval_secs, numOnlineNodes))) &&
-            airTime->isTxAllowedChannelUtil(config.device.role != meshtastic_Config_DeviceConfig_Role_SENSOR) &&
-            airTime->isTxAllowedAirUtil()) {
-            sendTelemetry();
-            lastSentToMesh = now;
-        } else if (((lastSentToPhone == 0) || ((now - lastSentToPhone) >= sendToPhoneIntervalMs)) &&
-                   (service->isToPhoneQueueEmpty())) {
-            // Just send to phone when it's not our time to send to mesh yet
-            // Only send while queue is empty (phone assumed connected)
-            sendTelemetry(NODENUM_BROADCAST, true);
-            lastSentToPhone = now;
+        if (sampler.isSampling()) {
+            // Conversions were started on an earlier pass, wait for the slowest sensor
+            uint32_t wait = sampler.msUntilReady();
+            if (wait > 0)
+                return wait;
+        } else {
+            if (((lastSentToMesh == 0) ||
+                 ((now - lastSentToMesh) >=
+                  Default::getConfiguredOrDefaultMsScaled(moduleConfig.telemetry.environment_update_interval,
+                                                          default_telemetry_broadcast_interval_secs, numOnlineNodes))) &&
+                airTime->isTxAllowedChannelUtil(config.device.role != meshtastic_Config_DeviceConfig_Role_SENSOR) &&
+                airTime->isTxAllowedAirUtil()) {
+                samplePhoneOnly = false;
+            } else if (((lastSentToPhone == 0) || ((now - lastSentToPhone) >= sendToPhoneIntervalMs)) &&
+                       (service->isToPhoneQueueEmpty())) {
+                // Just send to phone when it's not our time to send to mesh yet
+                // Only send while queue is empty (phone assumed connected)
+                samplePhoneOnly = true;
+            } else {
+                return min(sendToPhoneIntervalMs, result);
+            }
+            // Start every sensor converting at once, and come back to read them when they are done
+            uint32_t wait = sampler.start();
+            if (wait > 0)
+                return wait;
         }
+        sampler.finish();
+        sendTelemetry(NODENUM_BROADCAST, samplePhoneOnly);
+        if (samplePhoneOnly)
+            lastSentToPhone = now;
+        else
+            lastSentToMesh = now;
     }
     return min(sendToPhoneIntervalMs, result);
 }
@@ -6,6 +6,7 @@
 #include "../mesh/generated/meshtastic/telemetry.pb.h"
 #include "NodeDB.h"
 #include "ProtobufModule.h"
+#include "Sensor/TelemetrySampler.h"
 #include <OLEDDisplay.h>
 #include <OLEDDisplayUi.h>
 
@@ -59,6 +60,8 @@ class EnvironmentTelemetryModule : private concurrency::OSThread, public Protobu
     uint32_t lastSentToMesh = 0;
     uint32_t lastSentToPhone = 0;
     uint32_t sensor_read_error_count = 0;
+    TelemetrySampler sampler;
+    bool samplePhoneOnly = false; // Where the measurement being sampled goes once it's ready
 };
 
 #endif
\ No newline at end of file
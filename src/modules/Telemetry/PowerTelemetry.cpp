@@ -59,6 +59,10 @@ int32_t PowerTelemetryModule::runOnce()
                 result = ina260Sensor.runOnce();
             if (ina3221Sensor.hasSensor() && !ina3221Sensor.isInitialized())
                 result = ina3221Sensor.runOnce();
+
+            sampler.add(&ina219Sensor);
+            sampler.add(&ina260Sensor);
+            sampler.add(&ina3221Sensor);
         }
         return result;
 #else
@@ -70,20 +74,37 @@ int32_t PowerTelemetryModule::runOnce()
             return disable();
 
         uint32_t now = millis();
-        if (((lastSentToMesh == 0) ||
-             ((now - lastSentToMesh) >= Default::getConfiguredOrDefaultMsScaled(moduleConfig.telemetry.power_update_interval,
-                                                                                default_telemetry_broadcast_interval_secs,
-                                                                                numOnlineNodes))) &&
-            airTime->isTxAllowedAirUtil()) {
-            sendTelemetry();
-            lastSentToMesh = now;
-        } else if (((lastSentToPhone == 0) || ((now - lastSentToPhone) >= sendToPhoneIntervalMs)) &&
-                   (service->isToPhoneQueueEmpty())) {
-            // Just send to phone when it's not our time to send to mesh yet
-            // Only send while queue is empty (phone assumed connected)
-            sendTelemetry(NODENUM_BROADCAST, true);
-            lastSentToPhone = now;
+        if (sampler.isSampling()) {
+            // Conversions were started on an earlier pass, wait for the slowest sensor
+            uint32_t wait = sampler.msUntilReady();
+            if (wait > 0)
+                return wait;
+        } else {
+            if (((lastSentToMesh == 0) ||
+                 ((now - lastSentToMesh) >= Default::getConfiguredOrDefaultMsScaled(moduleConfig.telemetry.power_update_interval,
+                                                                                    default_telemetry_broadcast_interval_secs,
+                                                                                    numOnlineNodes))) &&
+                airTime->isTxAllowedAirUtil()) {
+                samplePhoneOnly = false;
+            } else if (((lastSentToPhone == 0) || ((now - lastSentToPhone) >= sendToPhoneIntervalMs)) &&
+                       (service->isToPhoneQueueEmpty())) {
+                // Just send to phone when it's not our time to send to mesh yet
+                // Only send while queue is empty (phone assumed connected)
+                samplePhoneOnly = true;
+            } else {
+                return min(sendToPhoneIntervalMs, result);
+            }
+            // Start every sensor converting at once, and come back to read them when they are done
+            uint32_t wait = sampler.start();
+            if (wait > 0)
+                return wait;
         }
+        sampler.finish();
+        sendTelemetry(NODENUM_BROADCAST, samplePhoneOnly);
+        if (samplePhoneOnly)
+            lastSentToPhone = now;
+        else
+            lastSentToMesh = now;
     }
     return min(sendToPhoneIntervalMs, result);
 }
@@ -18,16 +18,29 @@ int32_t BME280Sensor::runOnce()
     }
     status = bme280.begin(nodeTelemetrySensorsMap[sensorType].first, nodeTelemetrySensorsMap[sensorType].second);
 
+    setForcedSampling();
+
+    return initI2CSensor();
+}
+
+void BME280Sensor::setup() {}
+
+void BME280Sensor::setForcedSampling()
+{
     bme280.setSampling(Adafruit_BME280::MODE_FORCED,
                        Adafruit_BME280::SAMPLING_X1, // Temp. oversampling
                        Adafruit_BME280::SAMPLING_X1, // Pressure oversampling
                        Adafruit_BME280::SAMPLING_X1, // Humidity oversampling
                        Adafruit_BME280::FILTER_OFF, Adafruit_BME280::STANDBY_MS_1000);
-
-    return initI2CSensor();
 }
 
-void BME280Sensor::setup() {}
+uint32_t BME280Sensor::startMeasurement()
+{
+    // Writing the forced mode to ctrl_meas triggers a single conversion, unlike takeForcedMeasurement() we don't wait for it
+    setForcedSampling();
+    measurementStarted = true;
+    return BME280_CONVERSION_MS;
+}
 
 bool BME280Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
@@ -36,7 +49,10 @@ bool BME280Sensor::getMetrics(meshtastic_Telemetry *measurement)
     measurement->variant.environment_metrics.has_barometric_pressure = true;
 
     LOG_DEBUG("BME280Sensor::getMetrics\n");
-    bme280.takeForcedMeasurement();
+    // Nothing to wait for if startMeasurement() ran long enough ago
+    if (!measurementStarted)
+        bme280.takeForcedMeasurement();
+    measurementStarted = false;
     measurement->variant.environment_metrics.temperature = bme280.readTemperature();
     measurement->variant.environment_metrics.relative_humidity = bme280.readHumidity();
     measurement->variant.environment_metrics.barometric_pressure = bme280.readPressure() / 100.0F;
@@ -6,10 +6,16 @@
 #include "TelemetrySensor.h"
 #include <Adafruit_BME280.h>
 
+// Worst case conversion time at 1x oversampling of temperature, pressure and humidity
+#define BME280_CONVERSION_MS 10
+
 class BME280Sensor : public TelemetrySensor
 {
   private:
     Adafruit_BME280 bme280;
+    bool measurementStarted = false;
+
+    void setForcedSampling();
 
   protected:
     virtual void setup() override;
@@ -17,6 +23,7 @@ class BME280Sensor : public TelemetrySensor
   public:
     BME280Sensor();
     virtual int32_t runOnce() override;
+    virtual uint32_t startMeasurement() override;
     virtual bool getMetrics(meshtastic_Telemetry *measurement) override;
 };
 
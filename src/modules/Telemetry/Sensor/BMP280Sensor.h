@@ -6,10 +6,16 @@
 #include "TelemetrySensor.h"
 #include <Adafruit_BMP280.h>
 
+// Worst case conversion time at 1x oversampling of temperature and pressure
+#define BMP280_CONVERSION_MS 7
+
 class BMP280Sensor : public TelemetrySensor
 {
   private:
     Adafruit_BMP280 bmp280;
+    bool measurementStarted = false;
+
+    void setForcedSampling();
 
   protected:
     virtual void setup() override;
@@ -17,6 +23,7 @@ class BMP280Sensor : public TelemetrySensor
   public:
     BMP280Sensor();
     virtual int32_t runOnce() override;
+    virtual uint32_t startMeasurement() override;
     virtual bool getMetrics(meshtastic_Telemetry *measurement) override;
 };
 
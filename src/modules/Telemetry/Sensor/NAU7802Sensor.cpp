@@ -32,14 +32,23 @@ int32_t NAU7802Sensor::runOnce()
 
 void NAU7802Sensor::setup() {}
 
+uint32_t NAU7802Sensor::startMeasurement()
+{
+    nau7802.powerUp();
+    measurementStarted = true;
+    return NAU7802_CONVERSION_MS;
+}
+
 bool NAU7802Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
     LOG_DEBUG("NAU7802Sensor::getMetrics\n");
-    nau7802.powerUp();
-    // Wait for the sensor to become ready for one second max
+    if (!measurementStarted)
+        nau7802.powerUp();
+    measurementStarted = false;
+    // Wait for the sensor to become ready for one second max, no wait if startMeasurement() ran long enough ago
     uint32_t start = millis();
     while (!nau7802.available()) {
-        delay(100);
+        delay(10);
         if (millis() - start > 1000) {
             nau7802.powerDown();
             return false;
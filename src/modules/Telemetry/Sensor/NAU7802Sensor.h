@@ -7,10 +7,14 @@
 #include "TelemetrySensor.h"
 #include <SparkFun_Qwiic_Scale_NAU7802_Arduino_Library.h>
 
+// Time from power up until a reading is available at 320 SPS
+#define NAU7802_CONVERSION_MS 100
+
 class NAU7802Sensor : public TelemetrySensor
 {
   private:
     NAU7802 nau7802;
+    bool measurementStarted = false;
 
   protected:
     virtual void setup() override;
@@ -21,6 +25,7 @@ class NAU7802Sensor : public TelemetrySensor
   public:
     NAU7802Sensor();
     virtual int32_t runOnce() override;
+    virtual uint32_t startMeasurement() override;
     virtual bool getMetrics(meshtastic_Telemetry *measurement) override;
     void tare();
     void calibrate(float weight);
@@ -0,0 +1,66 @@
+#include "configuration.h"
+
+#if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
+
+#include "TelemetrySampler.h"
+
+void TelemetrySampler::add(TelemetrySensor *sensor)
+{
+    for (uint8_t i = 0; i < numSensors; i++) {
+        if (sensors[i] == sensor)
+            return;
+    }
+    if (numSensors < TELEMETRY_SAMPLER_MAX_SENSORS)
+        sensors[numSensors++] = sensor;
+    else
+        LOG_ERROR("Too many telemetry sensors, not sampling %p\n", sensor);
+}
+
+uint32_t TelemetrySampler::start()
+{
+    uint32_t now = millis();
+    uint32_t longest = 0;
+
+    for (uint8_t i = 0; i < numSensors; i++)
+        readyAt[i] = now;
+
+    for (uint8_t i = 0; i < numSensors; i++) {
+        TwoWire *bus = sensors[i]->getBus();
+
+        // Skip buses that an earlier sensor already took care of
+        bool seen = false;
+        for (uint8_t j = 0; j < i && !seen; j++)
+            seen = sensors[j]->getBus() == bus;
+        if (seen)
+            continue;
+
+        for (uint8_t j = i; j < numSensors; j++) {
+            if (sensors[j]->getBus() != bus || !sensors[j]->hasSensor())
+                continue;
+            uint32_t conversionMs = sensors[j]->startMeasurement();
+            readyAt[j] = now + conversionMs;
+            if (conversionMs > longest)
+                longest = conversionMs;
+        }
+    }
+
+    sampling = longest > 0;
+    return longest;
+}
+
+uint32_t TelemetrySampler::msUntilReady() const
+{
+    if (!sampling)
+        return 0;
+
+    uint32_t now = millis();
+    uint32_t wait = 0;
+    for (uint8_t i = 0; i < numSensors; i++) {
+        int32_t left = (int32_t)(readyAt[i] - now);
+        if (left > 0 && (uint32_t)left > wait)
+            wait = left;
+    }
+    return wait;
+}
+
+#endif
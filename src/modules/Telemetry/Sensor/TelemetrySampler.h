@@ -0,0 +1,44 @@
+#include "configuration.h"
+
+#if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
+
+#pragma once
+#include "TelemetrySensor.h"
+
+#ifndef TELEMETRY_SAMPLER_MAX_SENSORS
+#define TELEMETRY_SAMPLER_MAX_SENSORS 24
+#endif
+
+/**
+ * Runs a measurement cycle over a set of sensors without blocking the caller.
+ *
+ * start() kicks off a conversion on every present sensor, one I2C bus at a time so each bus sees its transactions back to
+ * back, and notes when each sensor's result will be ready. The owning module keeps returning msUntilReady() from its
+ * runOnce() and reads the sensors back with getMetrics() once it reaches zero, instead of each driver sleeping through
+ * its own conversion time.
+ */
+class TelemetrySampler
+{
+  public:
+    /// Add a sensor to the cycle, sensors that turn out not to be present are skipped by start()
+    void add(TelemetrySensor *sensor);
+
+    /// Start a conversion on every present sensor, returns msecs until the slowest one is done
+    uint32_t start();
+
+    /// msecs until every conversion started by start() has finished, 0 once they all have
+    uint32_t msUntilReady() const;
+
+    /// Mark the cycle as read back
+    void finish() { sampling = false; }
+
+    bool isSampling() const { return sampling; }
+
+  private:
+    TelemetrySensor *sensors[TELEMETRY_SAMPLER_MAX_SENSORS] = {};
+    uint32_t readyAt[TELEMETRY_SAMPLER_MAX_SENSORS] = {};
+    uint8_t numSensors = 0;
+    bool sampling = false;
+};
+
+#endif
@@ -51,10 +51,19 @@ class TelemetrySensor
 
     bool hasSensor() { return nodeTelemetrySensorsMap[sensorType].first > 0; }
 
+    /// The I2C bus this sensor was detected on
+    TwoWire *getBus() { return nodeTelemetrySensorsMap[sensorType].second; }
+
     virtual int32_t runOnce() = 0;
     virtual bool isInitialized() { return initialized; }
     virtual bool isRunning() { return status > 0; }
 
+    /**
+     * Start a conversion without waiting for it, for sensors that need time between trigger and readback.
+     * @return msecs until getMetrics() can read the result, 0 if there is nothing to wait for
+     */
+    virtual uint32_t startMeasurement() { return 0; }
+
     virtual bool getMetrics(meshtastic_Telemetry *measurement) = 0;
 };
 
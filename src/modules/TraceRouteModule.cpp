@@ -1,10 +1,24 @@
 #include "TraceRouteModule.h"
 #include "MeshService.h"
+#include "RouteCache.h"
 
 TraceRouteModule *traceRouteModule;
 
 bool TraceRouteModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshtastic_RouteDiscovery *r)
 {
+    // A reply to our own traceroute tells us the way to the destination, and to every node on it
+    if (r && mp.decoded.request_id && mp.to == nodeDB->getNodeNum() && routeCache) {
+        NodeNum first = r->route_count ? r->route[0] : mp.from;
+        if (first != NODENUM_BROADCAST) { // Unknown hop
+            uint8_t nextHop = getLastByteOfNodeNum(first);
+            routeCache->learn(mp.from, nextHop, ROUTE_SRC_TRACEROUTE);
+            for (pb_size_t i = 0; i < r->route_count; i++) {
+                if (r->route[i] != NODENUM_BROADCAST)
+                    routeCache->learn(r->route[i], nextHop, ROUTE_SRC_TRACEROUTE);
+            }
+        }
+    }
+
     // We only alter the packet in alterReceivedProtobuf()
     return false; // let it be handled by RoutingModule
 }
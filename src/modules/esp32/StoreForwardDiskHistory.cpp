@@ -0,0 +1,417 @@
+#include "StoreForwardDiskHistory.h"
+#include "configuration.h"
+#include <ErriezCRC32.h>
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+#ifdef FSCom
+
+#define SEGMENT_SUFFIX ".sfl"
+
+void StoreForwardDiskHistory::segmentPath(char *path, size_t len, uint32_t segmentSeq, const char *suffix) const
+{
+    snprintf(path, len, "%s/%08x" SEGMENT_SUFFIX "%s", dir, segmentSeq, suffix);
+}
+
+bool StoreForwardDiskHistory::init(const char *dir, uint32_t maxRecords, uint32_t maxBytes)
+{
+    writer.close();
+    reader.close();
+    readerSegment = NONE;
+    entries.clear();
+    segments.clear();
+    directSeqs.clear();
+    firstSeq = nextSeq = lastTime = totalBytes = 0;
+
+    strncpy(this->dir, dir, sizeof(this->dir) - 1);
+    this->maxRecords = maxRecords;
+    this->maxBytes = maxBytes;
+
+    // Retention goes a segment at a time, keep them small enough that we never drop more than about a quarter of the history
+    segmentBytes = std::min<uint32_t>(STOREFORWARD_SEGMENT_BYTES, std::max<uint32_t>(maxBytes / 4, recordSize(0)));
+    segmentRecords = std::max<uint32_t>(maxRecords / 4, 1);
+
+    if (!FSCom.exists(dir) && !FSCom.mkdir(dir)) {
+        LOG_ERROR("*** S&F - Could not create %s\n", dir);
+        return false;
+    }
+
+    // Find the segments, their names are the hex sequence number of their first record
+    std::vector<uint32_t> found;
+    File root = FSCom.open(dir, FILE_O_READ);
+    if (!root || !root.isDirectory()) {
+        LOG_ERROR("*** S&F - %s is not a directory\n", dir);
+        return false;
+    }
+    for (File file = root.openNextFile(); file; file = root.openNextFile()) {
+        // Depending on the platform name() is either the full path or just the file name
+        const char *name = strrchr(file.name(), '/');
+        name = name ? name + 1 : file.name();
+        bool isDir = file.isDirectory();
+        file.close();
+        if (isDir)
+            continue;
+
+        char *end;
+        uint32_t seq = strtoul(name, &end, 16);
+        if (end != name && strcmp(end, SEGMENT_SUFFIX) == 0) {
+            found.push_back(seq);
+        } else if (end != name && strcmp(end, SEGMENT_SUFFIX ".tmp") == 0) {
+            // Left over from a repair we didn't get to finish, the segment itself is still there
+            char path[96];
+            segmentPath(path, sizeof(path), seq, ".tmp");
+            FSCom.remove(path);
+        }
+    }
+    root.close();
+    std::sort(found.begin(), found.end());
+
+    // Load the index, the log must be one unbroken run of sequence numbers
+    bool broken = false;
+    for (uint32_t seq : found) {
+        char path[96];
+        segmentPath(path, sizeof(path), seq);
+
+        if (broken || (!segments.empty() && seq != nextSeq)) {
+            LOG_WARN("*** S&F - Dropping segment %s, it doesn't follow the rest of the log\n", path);
+            broken = true;
+            FSCom.remove(path);
+            continue;
+        }
+        if (segments.empty())
+            firstSeq = nextSeq = seq;
+
+        bool complete;
+        uint32_t valid = scanSegment(seq, complete);
+        if (!complete) {
+            LOG_WARN("*** S&F - %s is damaged after %u bytes, cutting it off there\n", path, valid);
+            truncateSegment(seq, valid);
+            broken = true;
+        }
+        if (valid) {
+            segments.push_back({seq, valid});
+            totalBytes += valid;
+        } else {
+            FSCom.remove(path);
+        }
+    }
+    if (segments.empty())
+        firstSeq = nextSeq;
+
+    // Keep appending to the newest segment
+    if (!segments.empty()) {
+        char path[96];
+        segmentPath(path, sizeof(path), segments.back().firstSeq);
+        writer = FSCom.open(path, FILE_O_APPEND);
+    }
+
+    // The limits may have been lowered since the log was written
+    while (segments.size() > 1 && (size() > maxRecords || totalBytes > maxBytes))
+        dropOldestSegment();
+
+    LOG_INFO("*** S&F - Loaded %u records (%u bytes) in %u segments from %s\n", size(), totalBytes, (uint32_t)segments.size(),
+             dir);
+    return true;
+}
+
+uint32_t StoreForwardDiskHistory::scanSegment(uint32_t segmentSeq, bool &complete)
+{
+    char path[96];
+    segmentPath(path, sizeof(path), segmentSeq);
+    complete = false;
+
+    File file = FSCom.open(path, FILE_O_READ);
+    if (!file)
+        return 0;
+
+    uint32_t offset = 0;
+    while (true) {
+        StoreForwardRecord &r = scratch.record;
+        int got = file.read(scratch.bytes, sizeof(StoreForwardRecord));
+        if (got == 0) {
+            complete = true;
+            break;
+        }
+        if (got != sizeof(StoreForwardRecord) || r.seq != nextSeq || r.payload_size > meshtastic_Constants_DATA_PAYLOAD_LEN)
+            break;
+
+        uint32_t rest = r.payload_size + sizeof(uint32_t);
+        if (file.read(scratch.bytes + sizeof(StoreForwardRecord), rest) != (int)rest)
+            break;
+        uint32_t crc;
+        memcpy(&crc, scratch.bytes + sizeof(StoreForwardRecord) + r.payload_size, sizeof(crc));
+        if (crc != crc32Buffer(scratch.bytes, sizeof(StoreForwardRecord) + r.payload_size))
+            break;
+
+        if (r.time < lastTime)
+            r.time = lastTime;
+        lastTime = r.time;
+        entries.push_back({r.time, r.to, r.from, offset, r.payload_size, r.channel});
+        if (r.to != NODENUM_BROADCAST)
+            directSeqs[r.to].push_back(r.seq);
+        nextSeq++;
+        offset += recordSize(r.payload_size);
+    }
+    file.close();
+    return offset;
+}
+
+void StoreForwardDiskHistory::truncateSegment(uint32_t segmentSeq, uint32_t validBytes)
+{
+    char path[96], tmpPath[96];
+    segmentPath(path, sizeof(path), segmentSeq);
+    segmentPath(tmpPath, sizeof(tmpPath), segmentSeq, ".tmp");
+
+    if (!validBytes) {
+        FSCom.remove(path);
+        return;
+    }
+
+    // There is no truncate, so copy what is good to a new file and swap it in
+    File from = FSCom.open(path, FILE_O_READ);
+    File to = FSCom.open(tmpPath, FILE_O_WRITE);
+    if (!from || !to) {
+        LOG_ERROR("*** S&F - Could not repair %s\n", path);
+        return;
+    }
+    for (uint32_t left = validBytes; left;) {
+        int got = from.read(scratch.bytes, std::min<uint32_t>(left, sizeof(scratch.bytes)));
+        if (got <= 0)
+            break;
+        to.write(scratch.bytes, got);
+        left -= got;
+    }
+    to.flush();
+    to.close();
+    from.close();
+    // The rename replaces the damaged segment, if we don't get that far the .tmp file is deleted at the next start
+    renameFile(tmpPath, path);
+}
+
+void StoreForwardDiskHistory::startSegment()
+{
+    char path[96];
+    segmentPath(path, sizeof(path), nextSeq);
+    writer.close();
+    writer = FSCom.open(path, FILE_O_WRITE);
+    if (!writer)
+        LOG_ERROR("*** S&F - Could not create %s\n", path);
+    segments.push_back({nextSeq, 0});
+}
+
+void StoreForwardDiskHistory::dropOldestSegment()
+{
+    Segment oldest = segments.front();
+    segments.pop_front();
+    uint32_t end = segments.empty() ? nextSeq : segments.front().firstSeq;
+
+    for (; firstSeq < end; firstSeq++) {
+        uint32_t to = entries.front().to;
+        if (to != NODENUM_BROADCAST) {
+            auto direct = directSeqs.find(to);
+            if (direct != directSeqs.end()) {
+                direct->second.pop_front();
+                if (direct->second.empty())
+                    directSeqs.erase(direct);
+            }
+        }
+        entries.pop_front();
+    }
+    totalBytes -= oldest.bytes;
+
+    if (readerSegment == oldest.firstSeq) {
+        reader.close();
+        readerSegment = NONE;
+    }
+    char path[96];
+    segmentPath(path, sizeof(path), oldest.firstSeq);
+    FSCom.remove(path);
+}
+
+uint32_t StoreForwardDiskHistory::add(uint32_t time, uint32_t to, uint32_t from, uint8_t channel, const uint8_t *payload,
+                                      uint16_t payload_size)
+{
+    uint32_t need = recordSize(payload_size);
+    if (!maxRecords || need > maxBytes || payload_size > meshtastic_Constants_DATA_PAYLOAD_LEN)
+        return NONE;
+
+    // Make room, a segment can only be deleted once we stopped writing to it
+    while (!segments.empty() && (size() >= maxRecords || totalBytes + need > maxBytes)) {
+        if (segments.size() == 1)
+            startSegment();
+        dropOldestSegment();
+    }
+    if (segments.empty())
+        startSegment();
+    else if (segments.back().bytes &&
+             (segments.back().bytes + need > segmentBytes || nextSeq - segments.back().firstSeq >= segmentRecords))
+        startSegment();
+    if (!writer)
+        return NONE;
+
+    // Keep times in order, so a clock that stepped back doesn't break the search
+    if (time < lastTime)
+        time = lastTime;
+
+    StoreForwardRecord &r = scratch.record;
+    r.seq = nextSeq;
+    r.time = time;
+    r.to = to;
+    r.from = from;
+    r.nextSameTo = NONE; // Not used on disk
+    r.channel = channel;
+    r.reserved = 0;
+    r.payload_size = payload_size;
+    if (payload_size)
+        memcpy(scratch.bytes + sizeof(StoreForwardRecord), payload, payload_size);
+    uint32_t crc = crc32Buffer(scratch.bytes, sizeof(StoreForwardRecord) + payload_size);
+    memcpy(scratch.bytes + sizeof(StoreForwardRecord) + payload_size, &crc, sizeof(crc));
+
+    Segment &segment = segments.back();
+    if (writeRecord(scratch.bytes, need) != need) {
+        // Cut off whatever made it to disk, or the records after it would be written at the wrong offset
+        LOG_ERROR("*** S&F - Could not write to the history log\n");
+        char path[96];
+        segmentPath(path, sizeof(path), segment.firstSeq);
+        writer.close();
+        if (readerSegment == segment.firstSeq) {
+            reader.close();
+            readerSegment = NONE;
+        }
+        truncateSegment(segment.firstSeq, segment.bytes);
+        writer = FSCom.open(path, FILE_O_APPEND);
+        return NONE;
+    }
+    writer.flush();
+
+    lastTime = time;
+    entries.push_back({time, to, from, segment.bytes, payload_size, channel});
+    if (to != NODENUM_BROADCAST)
+        directSeqs[to].push_back(nextSeq);
+    segment.bytes += need;
+    totalBytes += need;
+    return nextSeq++;
+}
+
+size_t StoreForwardDiskHistory::writeRecord(const uint8_t *data, size_t len)
+{
+    return writer.write(data, len);
+}
+
+uint32_t StoreForwardDiskHistory::firstAfter(uint32_t last_time) const
+{
+    uint32_t lo = firstSeq, hi = nextSeq;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (entry(mid).time > last_time)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+const StoreForwardRecord *StoreForwardDiskHistory::load(uint32_t seq)
+{
+    // The segment holding seq is the last one starting at or before it
+    auto segment = std::upper_bound(segments.begin(), segments.end(), seq,
+                                    [](uint32_t s, const Segment &segment) { return s < segment.firstSeq; });
+    if (segment == segments.begin())
+        return nullptr;
+    segment--;
+
+    if (readerSegment != segment->firstSeq || !reader) {
+        char path[96];
+        segmentPath(path, sizeof(path), segment->firstSeq);
+        reader.close();
+        reader = FSCom.open(path, FILE_O_READ);
+        readerSegment = reader ? segment->firstSeq : NONE;
+        if (!reader)
+            return nullptr;
+    }
+
+    const Entry &e = entry(seq);
+    uint32_t len = recordSize(e.payload_size);
+    uint32_t crc;
+    if (!reader.seek(e.offset) || reader.read(scratch.bytes, len) != (int)len)
+        return nullptr;
+    memcpy(&crc, scratch.bytes + len - sizeof(crc), sizeof(crc));
+    if (scratch.record.seq != seq || crc != crc32Buffer(scratch.bytes, len - sizeof(crc))) {
+        LOG_ERROR("*** S&F - Record %u is damaged on disk\n", seq);
+        return nullptr;
+    }
+    scratch.record.time = e.time;
+    return &scratch.record;
+}
+
+const StoreForwardRecord *StoreForwardDiskHistory::findNext(NodeNum dest, uint32_t cursor, uint32_t last_time)
+{
+    if (!size())
+        return nullptr;
+
+    uint32_t seq = cursor > firstSeq ? cursor : firstSeq;
+    if (last_time) {
+        uint32_t after = firstAfter(last_time);
+        if (after > seq)
+            seq = after;
+    }
+
+    // The direct messages for dest from seq on, if any
+    std::deque<uint32_t>::const_iterator it, itEnd;
+    auto directs = directSeqs.find(dest);
+    if (directs != directSeqs.end()) {
+        it = std::lower_bound(directs->second.begin(), directs->second.end(), seq);
+        itEnd = directs->second.end();
+    }
+
+    // A record that can't be read back is skipped, the ones after it are still worth sending
+    while (true) {
+        uint32_t direct = NONE;
+        if (directs != directSeqs.end()) {
+            while (it != itEnd && entry(*it).from == dest)
+                it++;
+            if (it != itEnd)
+                direct = *it;
+        }
+
+        // Any broadcast before it comes first
+        uint32_t end = direct < nextSeq ? direct : nextSeq;
+        for (; seq < end; seq++) {
+            const Entry &e = entry(seq);
+            if (e.to == NODENUM_BROADCAST && e.from != dest) {
+                if (const StoreForwardRecord *record = load(seq))
+                    return record;
+            }
+        }
+        if (direct == NONE)
+            return nullptr;
+        if (const StoreForwardRecord *record = load(direct))
+            return record;
+        seq = direct + 1;
+        it++;
+    }
+}
+
+uint32_t StoreForwardDiskHistory::countAvailable(NodeNum dest, uint32_t cursor, uint32_t last_time, uint32_t max) const
+{
+    uint32_t count = 0;
+    if (!size())
+        return 0;
+
+    uint32_t seq = cursor > firstSeq ? cursor : firstSeq;
+    if (last_time) {
+        uint32_t after = firstAfter(last_time);
+        if (after > seq)
+            seq = after;
+    }
+
+    for (; seq < nextSeq && count < max; seq++) {
+        const Entry &e = entry(seq);
+        if (wanted(e.to, e.from, dest))
+            count++;
+    }
+    return count;
+}
+
+#endif
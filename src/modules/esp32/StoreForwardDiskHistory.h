@@ -0,0 +1,112 @@
+#pragma once
+
+#include "FSCommon.h"
+#include "StoreForwardStorage.h"
+#include "mesh/generated/meshtastic/mesh.pb.h"
+#include <deque>
+#include <unordered_map>
+
+#ifdef FSCom
+
+// Size at which we start a new segment file. Retention drops whole segments, so this is also how much goes at once.
+#ifndef STOREFORWARD_SEGMENT_BYTES
+#define STOREFORWARD_SEGMENT_BYTES (1024 * 1024)
+#endif
+
+/**
+ * The S&F message history on a filesystem, for targets with lots of flash or disk (meshtasticd on Linux).
+ *
+ * Messages are appended to a log split in segment files named after the sequence number of their first record. A record
+ * on disk is its StoreForwardRecord header, the payload and a CRC32 over both. Only an index of the headers is kept in
+ * RAM (about 20 bytes per message), so searching by time and destination never touches the disk, and replaying history
+ * reads just the records that are returned.
+ *
+ * Every record is flushed when it is added. At startup the log is scanned and anything after the last valid record (a
+ * write cut short by a crash or power loss) is cut off, so the history always continues from a consistent state.
+ * Retention drops the oldest segment whenever we would hold more than maxRecords messages or maxBytes bytes.
+ */
+class StoreForwardDiskHistory : public StoreForwardStorage
+{
+  public:
+    /**
+     * Open the log in dir, creating it if needed, and load the index of what is stored there.
+     * @return false if the directory could not be used
+     */
+    bool init(const char *dir, uint32_t maxRecords, uint32_t maxBytes);
+
+    virtual uint32_t add(uint32_t time, uint32_t to, uint32_t from, uint8_t channel, const uint8_t *payload,
+                         uint16_t payload_size) override;
+    virtual const StoreForwardRecord *findNext(NodeNum dest, uint32_t cursor, uint32_t last_time) override;
+    virtual uint32_t countAvailable(NodeNum dest, uint32_t cursor, uint32_t last_time, uint32_t max = NONE) const override;
+    virtual uint32_t size() const override { return nextSeq - firstSeq; }
+    virtual uint32_t capacity() const override { return maxRecords; }
+    virtual uint32_t totalAdded() const override { return nextSeq; }
+
+    uint32_t bytesUsed() const { return totalBytes; }
+
+    /// Bytes a record with this payload takes on disk
+    static uint32_t recordSize(uint32_t payloadSize) { return sizeof(StoreForwardRecord) + payloadSize + sizeof(uint32_t); }
+
+  protected:
+    /// Append a record to the newest segment, returns how many bytes were written
+    virtual size_t writeRecord(const uint8_t *data, size_t len);
+
+  private:
+    // What we keep in RAM about each record, entries[i] is sequence number firstSeq + i
+    struct Entry {
+        uint32_t time;
+        uint32_t to;
+        uint32_t from;
+        uint32_t offset; // Within its segment
+        uint16_t payload_size;
+        uint8_t channel;
+    };
+
+    struct Segment {
+        uint32_t firstSeq;
+        uint32_t bytes;
+    };
+
+    char dir[64] = "";
+    uint32_t maxRecords = 0;
+    uint32_t maxBytes = 0;
+    uint32_t segmentBytes = STOREFORWARD_SEGMENT_BYTES;
+    uint32_t segmentRecords = 0;
+
+    std::deque<Entry> entries;
+    std::deque<Segment> segments;
+    std::unordered_map<uint32_t, std::deque<uint32_t>> directSeqs; // Sequence numbers of the direct messages to each node
+
+    uint32_t firstSeq = 0;
+    uint32_t nextSeq = 0;
+    uint32_t lastTime = 0;
+    uint32_t totalBytes = 0;
+
+    File writer;                   // Open on the newest segment
+    File reader;                   // Kept open between reads of the same segment
+    uint32_t readerSegment = NONE; // firstSeq of the segment reader is open on
+
+    // A record read back from disk, or built up to be written
+    union {
+        StoreForwardRecord record;
+        uint8_t bytes[sizeof(StoreForwardRecord) + meshtastic_Constants_DATA_PAYLOAD_LEN + sizeof(uint32_t)];
+    } scratch;
+
+    const Entry &entry(uint32_t seq) const { return entries[seq - firstSeq]; }
+    void segmentPath(char *path, size_t len, uint32_t segmentSeq, const char *suffix = "") const;
+
+    /// Index the records of a segment, returns how many bytes at its start are valid
+    uint32_t scanSegment(uint32_t segmentSeq, bool &complete);
+    /// Cut a segment down to its first validBytes bytes
+    void truncateSegment(uint32_t segmentSeq, uint32_t validBytes);
+    void startSegment();
+    void dropOldestSegment();
+
+    /// First sequence number with a time newer than last_time
+    uint32_t firstAfter(uint32_t last_time) const;
+
+    /// Read a record into scratch, returns nullptr if it can't be read back intact
+    const StoreForwardRecord *load(uint32_t seq);
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "StoreForwardHistory.h"
+#include <string.h>
+
+void StoreForwardHistory::init(uint8_t *buffer, uint32_t size, uint32_t *index, uint32_t maxCount)
+{
+    this->buffer = buffer;
+    this->bufferSize = size & ~3u;
+    this->index = index;
+    this->maxCount = maxCount;
+    firstSeq = nextSeq = 0;
+    head = used = lastTime = 0;
+    directChains.clear();
+}
+
+void StoreForwardHistory::dropOldest()
+{
+    const StoreForwardRecord *r = record(firstSeq);
+
+    if (r->to != NODENUM_BROADCAST) {
+        auto chain = directChains.find(r->to);
+        if (chain != directChains.end()) {
+            if (r->nextSameTo == NONE)
+                directChains.erase(chain);
+            else
+                chain->second.first = r->nextSameTo;
+        }
+    }
+
+    used -= recordSize(r->payload_size);
+    firstSeq++;
+}
+
+uint32_t StoreForwardHistory::add(uint32_t time, uint32_t to, uint32_t from, uint8_t channel, const uint8_t *payload,
+                                  uint16_t payload_size)
+{
+    uint32_t need = recordSize(payload_size);
+    if (!buffer || !maxCount || need > bufferSize)
+        return NONE;
+
+    if (size() == maxCount)
+        dropOldest();
+
+    // Records never straddle the end of the buffer. The data just after head is always the oldest, so when we skip the
+    // tail end of the buffer, whatever is stored there goes first.
+    if (head + need > bufferSize) {
+        while (size() && index[firstSeq % maxCount] >= head)
+            dropOldest();
+        head = 0;
+    }
+    while (size() && index[firstSeq % maxCount] >= head && index[firstSeq % maxCount] < head + need)
+        dropOldest();
+
+    if (!size()) {
+        // Nothing left, so start over at the beginning of the buffer
+        head = 0;
+        used = 0;
+    }
+
+    // Keep times in order, so a clock that stepped back doesn't break the search
+    if (time < lastTime)
+        time = lastTime;
+    lastTime = time;
+
+    uint32_t seq = nextSeq++;
+    index[seq % maxCount] = head;
+    StoreForwardRecord *r = record(seq);
+    r->seq = seq;
+    r->time = time;
+    r->to = to;
+    r->from = from;
+    r->nextSameTo = NONE;
+    r->channel = channel;
+    r->reserved = 0;
+    r->payload_size = payload_size;
+    if (payload_size)
+        memcpy(buffer + head + sizeof(StoreForwardRecord), payload, payload_size);
+
+    if (to != NODENUM_BROADCAST) {
+        auto chain = directChains.find(to);
+        if (chain == directChains.end()) {
+            directChains[to] = {seq, seq};
+        } else {
+            record(chain->second.last)->nextSameTo = seq;
+            chain->second.last = seq;
+        }
+    }
+
+    head += need;
+    used += need;
+    return seq;
+}
+
+uint32_t StoreForwardHistory::firstAfter(uint32_t last_time) const
+{
+    uint32_t lo = firstSeq, hi = nextSeq;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (record(mid)->time > last_time)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+const StoreForwardRecord *StoreForwardHistory::findNext(NodeNum dest, uint32_t cursor, uint32_t last_time)
+{
+    if (!size())
+        return nullptr;
+
+    uint32_t seq = cursor > firstSeq ? cursor : firstSeq;
+    if (last_time) {
+        uint32_t after = firstAfter(last_time);
+        if (after > seq)
+            seq = after;
+    }
+
+    // The next direct message for dest, if any
+    uint32_t direct = NONE;
+    auto chain = directChains.find(dest);
+    if (chain != directChains.end()) {
+        for (direct = chain->second.first; direct != NONE; direct = record(direct)->nextSameTo) {
+            if (direct >= seq && record(direct)->from != dest)
+                break;
+        }
+    }
+
+    // Any broadcast before it comes first
+    uint32_t end = direct < nextSeq ? direct : nextSeq;
+    for (; seq < end; seq++) {
+        const StoreForwardRecord *r = record(seq);
+        if (r->to == NODENUM_BROADCAST && r->from != dest)
+            return r;
+    }
+    return direct == NONE ? nullptr : record(direct);
+}
+
+uint32_t StoreForwardHistory::countAvailable(NodeNum dest, uint32_t cursor, uint32_t last_time, uint32_t max) const
+{
+    uint32_t count = 0;
+    if (!size())
+        return 0;
+
+    uint32_t seq = cursor > firstSeq ? cursor : firstSeq;
+    if (last_time) {
+        uint32_t after = firstAfter(last_time);
+        if (after > seq)
+            seq = after;
+    }
+
+    for (; seq < nextSeq && count < max; seq++) {
+        const StoreForwardRecord *r = record(seq);
+        if (wanted(r->to, r->from, dest))
+            count++;
+    }
+    return count;
+}
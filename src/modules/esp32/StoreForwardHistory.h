@@ -0,0 +1,71 @@
+#pragma once
+
+#include "StoreForwardStorage.h"
+#include <unordered_map>
+
+/**
+ * The S&F message history in RAM: variable length records in a byte ring, so a message only takes the room its payload
+ * needs. Records are padded to 4 bytes so the next header stays aligned.
+ *
+ * A sequence number -> offset table finds any record in O(1), times are searched by bisection, and direct messages are
+ * chained per destination, so replaying history only touches the records that are actually returned plus any direct
+ * traffic interleaved with them.
+ *
+ * The memory is handed in by the owner (PSRAM on ESP32), the class itself doesn't allocate besides the small per
+ * destination map.
+ */
+class StoreForwardHistory : public StoreForwardStorage
+{
+  public:
+    /// Bytes a record with this payload takes in the ring
+    static uint32_t recordSize(uint32_t payloadSize)
+    {
+        return (sizeof(StoreForwardRecord) + payloadSize + 3) & ~3u;
+    }
+
+    /**
+     * @param buffer   Storage for the records, 4 byte aligned
+     * @param size     Size of buffer in bytes
+     * @param index    Storage for the sequence number -> offset table
+     * @param maxCount Number of entries in index, the most records we hold at once
+     */
+    void init(uint8_t *buffer, uint32_t size, uint32_t *index, uint32_t maxCount);
+
+    virtual uint32_t add(uint32_t time, uint32_t to, uint32_t from, uint8_t channel, const uint8_t *payload,
+                         uint16_t payload_size) override;
+    virtual const StoreForwardRecord *findNext(NodeNum dest, uint32_t cursor, uint32_t last_time) override;
+    virtual uint32_t countAvailable(NodeNum dest, uint32_t cursor, uint32_t last_time, uint32_t max = NONE) const override;
+    virtual uint32_t size() const override { return nextSeq - firstSeq; }
+    virtual uint32_t capacity() const override { return maxCount; }
+    virtual uint32_t totalAdded() const override { return nextSeq; }
+
+    uint32_t bytesUsed() const { return used; }
+
+  private:
+    uint8_t *buffer = nullptr;
+    uint32_t bufferSize = 0;
+    uint32_t *index = nullptr;
+    uint32_t maxCount = 0;
+
+    uint32_t firstSeq = 0; // Oldest record still stored
+    uint32_t nextSeq = 0;  // Sequence number of the next record we add
+    uint32_t head = 0;     // Offset the next record is written to
+    uint32_t used = 0;     // Bytes taken by live records
+    uint32_t lastTime = 0;
+
+    // Oldest and newest direct message to each destination, linked through nextSameTo
+    struct Chain {
+        uint32_t first;
+        uint32_t last;
+    };
+    std::unordered_map<uint32_t, Chain> directChains;
+
+    StoreForwardRecord *record(uint32_t seq) const
+    {
+        return reinterpret_cast<StoreForwardRecord *>(buffer + index[seq % maxCount]);
+    }
+    void dropOldest();
+
+    /// First sequence number with a time newer than last_time
+    uint32_t firstAfter(uint32_t last_time) const;
+};
@@ -31,7 +31,7 @@ StoreForwardModule *storeForwardModule;
 
 int32_t StoreForwardModule::runOnce()
 {
-#ifdef ARCH_ESP32
+#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)
     if (moduleConfig.store_forward.enabled && is_server) {
         // Send out the message queue.
         if (this->busy) {
@@ -59,10 +59,30 @@ int32_t StoreForwardModule::runOnce()
     return disable();
 }
 
+#ifdef STOREFORWARD_DISK
+/**
+ * Opens the message history log on the filesystem, picking up whatever was stored before a restart.
+ */
+bool StoreForwardModule::populateDisk()
+{
+    uint32_t maxRecords = this->records ? this->records : STOREFORWARD_DISK_RECORDS;
+
+    StoreForwardDiskHistory *disk = new StoreForwardDiskHistory();
+    if (!disk->init(STOREFORWARD_DISK_DIR, maxRecords, STOREFORWARD_DISK_BYTES)) {
+        delete disk;
+        return false;
+    }
+    this->records = maxRecords;
+    history = disk;
+    return true;
+}
+#endif
+
+#ifdef ARCH_ESP32
 /**
  * Populates the PSRAM with data to be sent later when a device is out of range.
  */
-void StoreForwardModule::populatePSRAM()
+bool StoreForwardModule::populatePSRAM()
 {
     /*
     For PSRAM usage, see:
@@ -72,18 +92,62 @@ void StoreForwardModule::populatePSRAM()
     LOG_DEBUG("*** Before PSRAM initialization: heap %d/%d PSRAM %d/%d\n", memGet.getFreeHeap(), memGet.getHeapSize(),
               memGet.getFreePsram(), memGet.getPsramSize());
 
-    /* Use a maximum of 2/3 the available PSRAM unless otherwise specified.
+    /* Use a maximum of 2/3 the available PSRAM.
+        Messages only take the room their payload needs, the index is sized for records of the average payload,
+        or for the number of records asked for in the config.
         Note: This needs to be done after every thing that would use PSRAM
     */
+    uint32_t budget = ((memGet.getFreePsram() / 3) * 2);
     uint32_t numberOfPackets =
-        (this->records ? this->records : (((memGet.getFreePsram() / 3) * 2) / sizeof(PacketHistoryStruct)));
+        (this->records ? this->records
+                       : budget / (StoreForwardHistory::recordSize(STOREFORWARD_AVERAGE_PAYLOAD) + sizeof(uint32_t)));
+    uint32_t maxPackets = budget / (StoreForwardHistory::recordSize(0) + sizeof(uint32_t));
+    if (numberOfPackets > maxPackets)
+        numberOfPackets = maxPackets;
     this->records = numberOfPackets;
 
-    this->packetHistory = static_cast<PacketHistoryStruct *>(ps_calloc(numberOfPackets, sizeof(PacketHistoryStruct)));
+    uint32_t *index = static_cast<uint32_t *>(ps_calloc(numberOfPackets, sizeof(uint32_t)));
+    uint32_t bufferSize = budget - numberOfPackets * sizeof(uint32_t);
+    uint8_t *buffer = static_cast<uint8_t *>(ps_malloc(bufferSize));
+    if (!index || !buffer) {
+        LOG_ERROR("*** S&F - Could not allocate %u bytes of PSRAM for the history\n", budget);
+        free(index);
+        free(buffer);
+        return false;
+    }
+    StoreForwardHistory *ram = new StoreForwardHistory();
+    ram->init(buffer, bufferSize, index, numberOfPackets);
+    history = ram;
 
     LOG_DEBUG("*** After PSRAM initialization: heap %d/%d PSRAM %d/%d\n", memGet.getFreeHeap(), memGet.getHeapSize(),
               memGet.getFreePsram(), memGet.getPsramSize());
-    LOG_DEBUG("*** numberOfPackets for packetHistory - %u\n", numberOfPackets);
+    LOG_DEBUG("*** S&F history - %u bytes for up to %u records\n", bufferSize, numberOfPackets);
+    return true;
+}
+#endif
+
+/**
+ * Reads the server settings from the module config.
+ */
+void StoreForwardModule::loadServerConfig()
+{
+    // Maximum number of records to return.
+    if (moduleConfig.store_forward.history_return_max)
+        this->historyReturnMax = moduleConfig.store_forward.history_return_max;
+
+    // Maximum time window for records to return (in minutes)
+    if (moduleConfig.store_forward.history_return_window)
+        this->historyReturnWindow = moduleConfig.store_forward.history_return_window;
+
+    // Maximum number of records to store
+    if (moduleConfig.store_forward.records)
+        this->records = moduleConfig.store_forward.records;
+
+    // send heartbeat advertising?
+    if (moduleConfig.store_forward.heartbeat)
+        this->heartbeat = moduleConfig.store_forward.heartbeat;
+    else
+        this->heartbeat = false;
 }
 
 /**
@@ -95,9 +159,7 @@ void StoreForwardModule::populatePSRAM()
 void StoreForwardModule::historySend(uint32_t secAgo, uint32_t to)
 {
     this->last_time = getTime() < secAgo ? 0 : getTime() - secAgo;
-    uint32_t queueSize = getNumAvailablePackets(to, last_time);
-    if (queueSize > this->historyReturnMax)
-        queueSize = this->historyReturnMax;
+    uint32_t queueSize = getNumAvailablePackets(to, last_time, this->historyReturnMax);
 
     if (queueSize) {
         LOG_INFO("*** S&F - Sending %u message(s)\n", queueSize);
@@ -121,24 +183,15 @@ void StoreForwardModule::historySend(uint32_t secAgo, uint32_t to)
  *
  * @param dest The destination node number.
  * @param last_time The relative time to start counting messages from.
+ * @param max Stop counting once this many are found.
  * @return The number of available packets in the message history.
  */
-uint32_t StoreForwardModule::getNumAvailablePackets(NodeNum dest, uint32_t last_time)
+uint32_t StoreForwardModule::getNumAvailablePackets(NodeNum dest, uint32_t last_time, uint32_t max)
 {
-    uint32_t count = 0;
     if (lastRequest.find(dest) == lastRequest.end()) {
         lastRequest[dest] = 0;
     }
-    for (uint32_t i = lastRequest[dest]; i < this->packetHistoryTotalCount; i++) {
-        if (this->packetHistory[i].time && (this->packetHistory[i].time > last_time)) {
-            // Client is only interested in packets not from itself and only in broadcast packets or packets towards it.
-            if (this->packetHistory[i].from != dest &&
-                (this->packetHistory[i].to == NODENUM_BROADCAST || this->packetHistory[i].to == dest)) {
-                count++;
-            }
-        }
-    }
-    return count;
+    return history->countAvailable(dest, lastRequest[dest], last_time, max);
 }
 
 /**
@@ -152,7 +205,7 @@ meshtastic_MeshPacket *StoreForwardModule::getForPhone()
         NodeNum to = nodeDB->getNodeNum();
         if (!this->busy) {
             // Get number of packets we're going to send in this loop
-            uint32_t histSize = getNumAvailablePackets(to, 0); // No time limit
+            uint32_t histSize = getNumAvailablePackets(to, 0, 1); // No time limit, we only need to know there is one
             if (histSize) {
                 this->busy = true;
                 this->busyTo = to;
@@ -181,22 +234,14 @@ void StoreForwardModule::historyAdd(const meshtastic_MeshPacket &mp)
 {
     const auto &p = mp.decoded;
 
-    if (this->packetHistoryTotalCount == this->records) {
-        LOG_WARN("*** S&F - PSRAM Full. Starting overwrite now.\n");
-        this->packetHistoryTotalCount = 0;
-        for (auto &i : lastRequest) {
-            i.second = 0; // Clear the last request index for each client device
-        }
-    }
+    uint32_t droppedBefore = history->totalAdded() - history->size();
 
-    this->packetHistory[this->packetHistoryTotalCount].time = getTime();
-    this->packetHistory[this->packetHistoryTotalCount].to = mp.to;
-    this->packetHistory[this->packetHistoryTotalCount].channel = mp.channel;
-    this->packetHistory[this->packetHistoryTotalCount].from = getFrom(&mp);
-    this->packetHistory[this->packetHistoryTotalCount].payload_size = p.payload.size;
-    memcpy(this->packetHistory[this->packetHistoryTotalCount].payload, p.payload.bytes, meshtastic_Constants_DATA_PAYLOAD_LEN);
+    // Client cursors are sequence numbers, so they stay valid when the oldest messages get overwritten
+    history->add(getTime(), mp.to, getFrom(&mp), mp.channel, p.payload.bytes, p.payload.size);
 
-    this->packetHistoryTotalCount++;
+    if (droppedBefore == 0 && history->totalAdded() - history->size() > 0) {
+        LOG_WARN("*** S&F - History full. Dropping the oldest messages now.\n");
+    }
 }
 
 /**
@@ -227,51 +272,45 @@ bool StoreForwardModule::sendPayload(NodeNum dest, uint32_t last_time)
  */
 meshtastic_MeshPacket *StoreForwardModule::preparePayload(NodeNum dest, uint32_t last_time, bool local)
 {
-    for (uint32_t i = lastRequest[dest]; i < this->packetHistoryTotalCount; i++) {
-        if (this->packetHistory[i].time && (this->packetHistory[i].time > last_time)) {
-            /*  Copy the messages that were received by the server in the last msAgo
-                to the packetHistoryTXQueue structure.
-                Client not interested in packets from itself and only in broadcast packets or packets towards it. */
-            if (this->packetHistory[i].from != dest &&
-                (this->packetHistory[i].to == NODENUM_BROADCAST || this->packetHistory[i].to == dest)) {
-
-                meshtastic_MeshPacket *p = allocDataPacket();
-
-                p->to = local ? this->packetHistory[i].to : dest; // PhoneAPI can handle original `to`
-                p->from = this->packetHistory[i].from;
-                p->channel = this->packetHistory[i].channel;
-                p->rx_time = this->packetHistory[i].time;
-
-                // Let's assume that if the server received the S&F request that the client is in range.
-                //   TODO: Make this configurable.
-                p->want_ack = false;
-
-                if (local) { // PhoneAPI gets normal TEXT_MESSAGE_APP
-                    p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
-                    memcpy(p->decoded.payload.bytes, this->packetHistory[i].payload, this->packetHistory[i].payload_size);
-                    p->decoded.payload.size = this->packetHistory[i].payload_size;
-                } else {
-                    meshtastic_StoreAndForward sf = meshtastic_StoreAndForward_init_zero;
-                    sf.which_variant = meshtastic_StoreAndForward_text_tag;
-                    sf.variant.text.size = this->packetHistory[i].payload_size;
-                    memcpy(sf.variant.text.bytes, this->packetHistory[i].payload, this->packetHistory[i].payload_size);
-                    if (this->packetHistory[i].to == NODENUM_BROADCAST) {
-                        sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_BROADCAST;
-                    } else {
-                        sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_DIRECT;
-                    }
-
-                    p->decoded.payload.size = pb_encode_to_bytes(p->decoded.payload.bytes, sizeof(p->decoded.payload.bytes),
-                                                                 &meshtastic_StoreAndForward_msg, &sf);
-                }
+    /*  Find the next message that was received by the server in the last msAgo.
+        Client not interested in packets from itself and only in broadcast packets or packets towards it. */
+    const StoreForwardRecord *record = history->findNext(dest, lastRequest[dest], last_time);
+    if (!record)
+        return nullptr;
 
-                lastRequest[dest] = i + 1; // Update the last request index for the client device
+    meshtastic_MeshPacket *p = allocDataPacket();
 
-                return p;
-            }
+    p->to = local ? record->to : dest; // PhoneAPI can handle original `to`
+    p->from = record->from;
+    p->channel = record->channel;
+    p->rx_time = record->time;
+
+    // Let's assume that if the server received the S&F request that the client is in range.
+    //   TODO: Make this configurable.
+    p->want_ack = false;
+
+    if (local) { // PhoneAPI gets normal TEXT_MESSAGE_APP
+        p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+        memcpy(p->decoded.payload.bytes, record->payload(), record->payload_size);
+        p->decoded.payload.size = record->payload_size;
+    } else {
+        meshtastic_StoreAndForward sf = meshtastic_StoreAndForward_init_zero;
+        sf.which_variant = meshtastic_StoreAndForward_text_tag;
+        sf.variant.text.size = record->payload_size;
+        memcpy(sf.variant.text.bytes, record->payload(), record->payload_size);
+        if (record->to == NODENUM_BROADCAST) {
+            sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_BROADCAST;
+        } else {
+            sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_DIRECT;
         }
+
+        p->decoded.payload.size = pb_encode_to_bytes(p->decoded.payload.bytes, sizeof(p->decoded.payload.bytes),
+                                                     &meshtastic_StoreAndForward_msg, &sf);
     }
-    return nullptr;
+
+    lastRequest[dest] = record->seq + 1; // Update the last request index for the client device
+
+    return p;
 }
 
 /**
@@ -351,7 +390,7 @@ void StoreForwardModule::statsSend(uint32_t to)
     sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_STATS;
     sf.which_variant = meshtastic_StoreAndForward_stats_tag;
     sf.variant.stats.messages_total = this->records;
-    sf.variant.stats.messages_saved = this->packetHistoryTotalCount;
+    sf.variant.stats.messages_saved = history ? history->size() : 0;
     sf.variant.stats.messages_max = this->records;
     sf.variant.stats.up_time = millis() / 1000;
     sf.variant.stats.requests = this->requests;
@@ -372,7 +411,7 @@ void StoreForwardModule::statsSend(uint32_t to)
  */
 ProcessMessage StoreForwardModule::handleReceived(const meshtastic_MeshPacket &mp)
 {
-#ifdef ARCH_ESP32
+#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)
     if (moduleConfig.store_forward.enabled) {
 
         if ((mp.decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP) && is_server) {
@@ -389,7 +428,7 @@ ProcessMessage StoreForwardModule::handleReceived(const meshtastic_MeshPacket &m
                 }
             } else {
                 storeForwardModule->historyAdd(mp);
-                LOG_INFO("*** S&F stored. Message history contains %u records now.\n", this->packetHistoryTotalCount);
+                LOG_INFO("*** S&F stored. Message history contains %u records now.\n", history->size());
             }
         } else if (getFrom(&mp) != nodeDB->getNodeNum() && mp.decoded.portnum == meshtastic_PortNum_STORE_FORWARD_APP) {
             auto &p = mp.decoded;
@@ -555,7 +594,7 @@ StoreForwardModule::StoreForwardModule()
       ProtobufModule("StoreForward", meshtastic_PortNum_STORE_FORWARD_APP, &meshtastic_StoreAndForward_msg)
 {
 
-#ifdef ARCH_ESP32
+#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)
 
     isPromiscuous = true; // Brown chicken brown cow
 
@@ -573,32 +612,20 @@ StoreForwardModule::StoreForwardModule()
         // Router
         if ((config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER || moduleConfig.store_forward.is_server)) {
             LOG_INFO("*** Initializing Store & Forward Module in Server mode\n");
+#ifdef STOREFORWARD_DISK
+            loadServerConfig();
+            is_server = this->populateDisk();
+            if (!is_server)
+                LOG_INFO("*** Store & Forward Module - disabling server.\n");
+#else
             if (memGet.getPsramSize() > 0) {
                 if (memGet.getFreePsram() >= 1024 * 1024) {
 
                     // Do the startup here
-
-                    // Maximum number of records to return.
-                    if (moduleConfig.store_forward.history_return_max)
-                        this->historyReturnMax = moduleConfig.store_forward.history_return_max;
-
-                    // Maximum time window for records to return (in minutes)
-                    if (moduleConfig.store_forward.history_return_window)
-                        this->historyReturnWindow = moduleConfig.store_forward.history_return_window;
-
-                    // Maximum number of records to store in memory
-                    if (moduleConfig.store_forward.records)
-                        this->records = moduleConfig.store_forward.records;
-
-                    // send heartbeat advertising?
-                    if (moduleConfig.store_forward.heartbeat)
-                        this->heartbeat = moduleConfig.store_forward.heartbeat;
-                    else
-                        this->heartbeat = false;
+                    loadServerConfig();
 
                     // Popupate PSRAM with our data structures.
-                    this->populatePSRAM();
-                    is_server = true;
+                    is_server = this->populatePSRAM();
                 } else {
                     LOG_INFO("*** Device has less than 1M of PSRAM free.\n");
                     LOG_INFO("*** Store & Forward Module - disabling server.\n");
@@ -607,6 +634,7 @@ StoreForwardModule::StoreForwardModule()
                 LOG_INFO("*** Device doesn't have PSRAM.\n");
                 LOG_INFO("*** Store & Forward Module - disabling server.\n");
             }
+#endif
 
             // Client
         } else {
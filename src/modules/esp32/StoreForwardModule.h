@@ -1,6 +1,8 @@
 #pragma once
 
 #include "ProtobufModule.h"
+#include "StoreForwardDiskHistory.h"
+#include "StoreForwardHistory.h"
 #include "concurrency/OSThread.h"
 #include "mesh/generated/meshtastic/storeforward.pb.h"
 
@@ -9,14 +11,28 @@
 #include <functional>
 #include <unordered_map>
 
-struct PacketHistoryStruct {
-    uint32_t time;
-    uint32_t to;
-    uint32_t from;
-    uint8_t channel;
-    uint8_t payload[meshtastic_Constants_DATA_PAYLOAD_LEN];
-    pb_size_t payload_size;
-};
+// Average payload we size the S&F record index for, most text messages are a lot shorter than the maximum
+#ifndef STOREFORWARD_AVERAGE_PAYLOAD
+#define STOREFORWARD_AVERAGE_PAYLOAD 32
+#endif
+
+// Keep the history in a log on the filesystem instead of PSRAM. Linux has the disk for it, large flash targets can opt in.
+#if defined(ARCH_PORTDUINO) && !defined(STOREFORWARD_DISK)
+#define STOREFORWARD_DISK
+#endif
+
+#ifdef STOREFORWARD_DISK
+#ifndef STOREFORWARD_DISK_DIR
+#define STOREFORWARD_DISK_DIR "/storeforward"
+#endif
+// Retention when store_forward.records is not set
+#ifndef STOREFORWARD_DISK_RECORDS
+#define STOREFORWARD_DISK_RECORDS 1000000
+#endif
+#ifndef STOREFORWARD_DISK_BYTES
+#define STOREFORWARD_DISK_BYTES (256 * 1024 * 1024)
+#endif
+#endif
 
 class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<meshtastic_StoreAndForward>
 {
@@ -24,8 +40,7 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
     uint32_t busyTo = 0;
     char routerMessage[meshtastic_Constants_DATA_PAYLOAD_LEN] = {0};
 
-    PacketHistoryStruct *packetHistory = 0;
-    uint32_t packetHistoryTotalCount = 0;
+    StoreForwardStorage *history = nullptr; // Set once we are a server
     uint32_t last_time = 0;
     uint32_t requestCount = 0;
 
@@ -34,7 +49,7 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
     bool is_client = false;
     bool is_server = false;
 
-    // Unordered_map stores the last request for each nodeNum (`to` field)
+    // Unordered_map stores the sequence number of the next record to look at for each nodeNum (`to` field)
     std::unordered_map<NodeNum, uint32_t> lastRequest;
 
   public:
@@ -50,7 +65,7 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
     void historyAdd(const meshtastic_MeshPacket &mp);
     void statsSend(uint32_t to);
     void historySend(uint32_t secAgo, uint32_t to);
-    uint32_t getNumAvailablePackets(NodeNum dest, uint32_t last_time);
+    uint32_t getNumAvailablePackets(NodeNum dest, uint32_t last_time, uint32_t max = StoreForwardStorage::NONE);
 
     /**
      * Send our payload into the mesh
@@ -61,7 +76,7 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
     void sendMessage(NodeNum dest, meshtastic_StoreAndForward_RequestResponse rr);
     void sendErrorTextMessage(NodeNum dest, bool want_response);
     meshtastic_MeshPacket *getForPhone();
-    // Returns true if we are configured as server AND we could allocate PSRAM.
+    // Returns true if we are configured as server AND we could set up the message history.
     bool isServer() { return is_server; }
 
     /*
@@ -79,7 +94,13 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
     }
 
   private:
-    void populatePSRAM();
+    void loadServerConfig();
+#ifdef ARCH_ESP32
+    bool populatePSRAM();
+#endif
+#ifdef STOREFORWARD_DISK
+    bool populateDisk();
+#endif
 
     // S&F Defaults
     uint32_t historyReturnMax = 25;     // Return maximum of 25 records by default.
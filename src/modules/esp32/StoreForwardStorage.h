@@ -0,0 +1,63 @@
+#pragma once
+
+#include "mesh/generated/meshtastic/mesh.pb.h"
+#include <stdint.h>
+
+/**
+ * Header of one stored message, followed directly by payload_size bytes of payload.
+ */
+struct StoreForwardRecord {
+    uint32_t seq;        // Sequence number, only ever grows so it stays a valid cursor when old records are dropped
+    uint32_t time;       // Receive time, never lower than the record before so it can be searched
+    uint32_t to;         // Original destination
+    uint32_t from;       // Original sender
+    uint32_t nextSameTo; // Sequence number of the next direct message to the same node, or NONE
+    uint8_t channel;
+    uint8_t reserved;
+    uint16_t payload_size;
+
+    const uint8_t *payload() const { return reinterpret_cast<const uint8_t *>(this + 1); }
+};
+
+/**
+ * Where the S&F server keeps its message history.
+ *
+ * Records are numbered with ever increasing sequence numbers, and client cursors are sequence numbers too, so they stay
+ * valid when the oldest records are dropped: a cursor that points before the oldest record starts at the oldest one.
+ */
+class StoreForwardStorage
+{
+  public:
+    static const uint32_t NONE = UINT32_MAX;
+
+    virtual ~StoreForwardStorage() {}
+
+    /// Store a message, dropping the oldest ones as needed to make room. Returns its sequence number, or NONE if it failed
+    virtual uint32_t add(uint32_t time, uint32_t to, uint32_t from, uint8_t channel, const uint8_t *payload,
+                         uint16_t payload_size) = 0;
+
+    /**
+     * Next record at or after cursor, newer than last_time, that dest is interested in (not from itself, and either a
+     * broadcast or sent to it). Returns nullptr if there is none. The record is only valid until the next call.
+     */
+    virtual const StoreForwardRecord *findNext(NodeNum dest, uint32_t cursor, uint32_t last_time) = 0;
+
+    /// How many records findNext() would return one after the other, stopping once max is reached
+    virtual uint32_t countAvailable(NodeNum dest, uint32_t cursor, uint32_t last_time, uint32_t max = NONE) const = 0;
+
+    /// Number of records currently stored
+    virtual uint32_t size() const = 0;
+
+    /// Most records we can hold
+    virtual uint32_t capacity() const = 0;
+
+    /// Total records ever stored, including the ones that were dropped since
+    virtual uint32_t totalAdded() const = 0;
+
+  protected:
+    /// Is this record something dest should get?
+    static bool wanted(uint32_t to, uint32_t from, NodeNum dest)
+    {
+        return from != dest && (to == NODENUM_BROADCAST || to == dest);
+    }
+};
@@ -0,0 +1,167 @@
+#include "DownlinkAdmission.h"
+#include "MeshRadio.h"
+#include "NodeDB.h"
+#include "RadioInterface.h"
+#include "Router.h"
+#include "airtime.h"
+
+DownlinkAdmission::DownlinkAdmission()
+{
+    for (TokenBucket &b : channelBuckets)
+        b = {MQTT_DOWNLINK_CHANNEL_BURST, 0};
+}
+
+void DownlinkAdmission::TokenBucket::refill(uint32_t nowMs, float perMinute, float burst)
+{
+    tokens += (nowMs - lastMs) * perMinute / MS_IN_MINUTE;
+    if (tokens > burst)
+        tokens = burst;
+    lastMs = nowMs;
+}
+
+uint32_t DownlinkAdmission::sourceKey(const char *source)
+{
+    return hash(source);
+}
+
+const char *DownlinkAdmission::verdictName(DownlinkVerdict v)
+{
+    switch (v) {
+    case DOWNLINK_ADMIT:
+        return "admitted";
+    case DOWNLINK_DUPLICATE:
+        return "duplicate";
+    case DOWNLINK_SHED_BUSY:
+        return "channel busy";
+    case DOWNLINK_SHED_CHANNEL:
+        return "over channel budget";
+    case DOWNLINK_SHED_SOURCE:
+        return "over source budget";
+    }
+    return "?";
+}
+
+DownlinkVerdict DownlinkAdmission::admit(uint32_t source, ChannelIndex chIndex, const meshtastic_MeshPacket &p, bool fromJson)
+{
+    uint32_t now = millis();
+    DownlinkVerdict verdict = DOWNLINK_ADMIT;
+
+    // The share of each bucket that is left to higher priority packets
+    meshtastic_MeshPacket_Priority priority = classify(p);
+    float reserve = priority >= meshtastic_MeshPacket_Priority_RELIABLE  ? 0
+                    : priority >= meshtastic_MeshPacket_Priority_DEFAULT ? 0.3f
+                                                                         : 0.6f;
+
+    float scale = airtimeScale();
+    TokenBucket &channel = channelBuckets[chIndex % MAX_NUM_CHANNELS];
+    TokenBucket &src = sourceBucket(source, now);
+    channel.refill(now, MQTT_DOWNLINK_CHANNEL_PER_MINUTE * scale, MQTT_DOWNLINK_CHANNEL_BURST);
+    src.refill(now, MQTT_DOWNLINK_SOURCE_PER_MINUTE * scale, MQTT_DOWNLINK_SOURCE_BURST);
+
+    if (isDuplicate(p, fromJson, now)) {
+        verdict = DOWNLINK_DUPLICATE;
+        stats.duplicates++;
+    } else if (p.to == nodeDB->getNodeNum()) {
+        stats.admitted++; // Only for us, it doesn't go out on the mesh
+    } else if (scale <= 0 && reserve > 0) {
+        verdict = DOWNLINK_SHED_BUSY;
+        stats.shedBusy++;
+    } else if (channel.tokens < 1 + reserve * MQTT_DOWNLINK_CHANNEL_BURST) {
+        verdict = DOWNLINK_SHED_CHANNEL;
+        stats.shedChannel++;
+    } else if (src.tokens < 1 + reserve * MQTT_DOWNLINK_SOURCE_BURST) {
+        verdict = DOWNLINK_SHED_SOURCE;
+        stats.shedSource++;
+    } else {
+        channel.tokens -= 1;
+        src.tokens -= 1;
+        stats.admitted++;
+        if (fromJson) {
+            recentJson[nextJson] = {true, contentKey(p), now};
+            nextJson = (nextJson + 1) % MQTT_DOWNLINK_JSON_DEDUP_SLOTS;
+        }
+    }
+
+    if (verdict != DOWNLINK_ADMIT)
+        LOG_DEBUG("Not sending MQTT downlink fr=0x%x,id=0x%x on channel %u to the mesh: %s\n", p.from, p.id, chIndex,
+                  verdictName(verdict));
+    return verdict;
+}
+
+meshtastic_MeshPacket_Priority DownlinkAdmission::classify(const meshtastic_MeshPacket &p)
+{
+    meshtastic_MeshPacket_Priority priority = getPriority(&p);
+    if (priority >= meshtastic_MeshPacket_Priority_RELIABLE || p.which_payload_variant != meshtastic_MeshPacket_encrypted_tag)
+        return priority;
+
+    // Acks and responses only show once decrypted, look at a decoded copy if we have the key
+    meshtastic_MeshPacket *copy = packetPool.allocCopy(p);
+    if (!copy)
+        return priority;
+    if (perhapsDecode(copy))
+        priority = getPriority(copy);
+    packetPool.release(copy);
+    return priority;
+}
+
+bool DownlinkAdmission::isDuplicate(const meshtastic_MeshPacket &p, bool fromJson, uint32_t nowMs)
+{
+    if (!fromJson)
+        return router && router->hasSeen(getFrom(&p), p.id);
+
+    uint32_t key = contentKey(p);
+    for (const JsonRecord &r : recentJson) {
+        if (r.used && r.key == key && nowMs - r.atMs < MQTT_DOWNLINK_JSON_DEDUP_MS)
+            return true;
+    }
+    return false;
+}
+
+DownlinkAdmission::TokenBucket &DownlinkAdmission::sourceBucket(uint32_t source, uint32_t nowMs)
+{
+    SourceBucket *oldest = NULL;
+    for (uint8_t i = 0; i < numSources; i++) {
+        if (sources[i].source == source)
+            return sources[i].bucket;
+        if (!oldest || nowMs - sources[i].bucket.lastMs > nowMs - oldest->bucket.lastMs)
+            oldest = &sources[i];
+    }
+
+    SourceBucket *s = numSources < MQTT_DOWNLINK_MAX_SOURCES ? &sources[numSources++] : oldest;
+    s->source = source;
+    s->bucket = {MQTT_DOWNLINK_SOURCE_BURST, nowMs};
+    return s->bucket;
+}
+
+float DownlinkAdmission::airtimeScale()
+{
+    if (!airTime)
+        return 1;
+
+    float scale = (MQTT_DOWNLINK_MAX_CHUTIL - airTime->channelUtilizationPercent()) /
+                  (MQTT_DOWNLINK_MAX_CHUTIL - MQTT_DOWNLINK_POLITE_CHUTIL);
+
+    // Like AirTime::isTxAllowedAirUtil(), half of the duty cycle is ours to spend freely
+    if (!config.lora.override_duty_cycle && myRegion && myRegion->dutyCycle < 100) {
+        float dutyScale = 2 * (1 - airTime->utilizationTXPercent() / myRegion->dutyCycle);
+        if (dutyScale < scale)
+            scale = dutyScale;
+    }
+
+    return scale < 0 ? 0 : scale > 1 ? 1 : scale;
+}
+
+uint32_t DownlinkAdmission::contentKey(const meshtastic_MeshPacket &p)
+{
+    // djb2, like hash(), over where it goes and what it carries
+    uint32_t key = 5381;
+    auto mix = [&key](const uint8_t *bytes, size_t len) {
+        for (size_t i = 0; i < len; i++)
+            key = ((key << 5) + key) + bytes[i];
+    };
+    mix((const uint8_t *)&p.to, sizeof(p.to));
+    mix(&p.channel, sizeof(p.channel));
+    mix((const uint8_t *)&p.decoded.portnum, sizeof(p.decoded.portnum));
+    mix(p.decoded.payload.bytes, p.decoded.payload.size);
+    return key;
+}
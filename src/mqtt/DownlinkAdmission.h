@@ -0,0 +1,118 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+
+// Each channel can inject a burst of this many downlink packets, and then this many per minute
+#ifndef MQTT_DOWNLINK_CHANNEL_BURST
+#define MQTT_DOWNLINK_CHANNEL_BURST 10
+#endif
+#ifndef MQTT_DOWNLINK_CHANNEL_PER_MINUTE
+#define MQTT_DOWNLINK_CHANNEL_PER_MINUTE 20
+#endif
+
+// The same for each source (a gateway, or the topic of JSON downlink)
+#ifndef MQTT_DOWNLINK_SOURCE_BURST
+#define MQTT_DOWNLINK_SOURCE_BURST 5
+#endif
+#ifndef MQTT_DOWNLINK_SOURCE_PER_MINUTE
+#define MQTT_DOWNLINK_SOURCE_PER_MINUTE 6
+#endif
+
+// Sources we keep a bucket for, the least recently seen one makes room for a new one
+#ifndef MQTT_DOWNLINK_MAX_SOURCES
+#define MQTT_DOWNLINK_MAX_SOURCES 8
+#endif
+
+// The buckets refill slower once the channel utilization is above the first, and not at all above the second. These are the
+// polite and the maximum channel utilization of AirTime.
+#define MQTT_DOWNLINK_POLITE_CHUTIL 25
+#define MQTT_DOWNLINK_MAX_CHUTIL 40
+
+// JSON downlink creates new packets, those are recognized as repeats by their content for this long
+#define MQTT_DOWNLINK_JSON_DEDUP_SLOTS 8
+#define MQTT_DOWNLINK_JSON_DEDUP_MS (60 * 1000)
+
+enum DownlinkVerdict : uint8_t {
+    DOWNLINK_ADMIT,
+    DOWNLINK_DUPLICATE,    // Already in the packet history, e.g. replayed by the broker after a reconnect
+    DOWNLINK_SHED_BUSY,    // The channel is too busy for anything but reliable traffic
+    DOWNLINK_SHED_CHANNEL, // Over the budget of the channel
+    DOWNLINK_SHED_SOURCE,  // Over the budget of the source
+};
+
+struct DownlinkStats {
+    uint32_t admitted;
+    uint32_t duplicates;
+    uint32_t shedBusy;
+    uint32_t shedChannel;
+    uint32_t shedSource;
+};
+
+/**
+ * Decides which packets from the MQTT downlink may go out on the mesh, so a chatty broker can't saturate the LoRa channel.
+ *
+ * Packets we have seen already are dropped first. The rest has to fit in two token buckets, one for the channel and one for
+ * the source. The buckets refill slower as the measured channel utilization goes up, and as we use up more than half of the
+ * duty cycle of the region. Low priority packets leave part of each bucket to higher priority ones, and when the channel is
+ * busy only reliable traffic (acks, responses, want_ack) gets through. Encrypted packets are judged by their decoded
+ * content when we have the key of their channel.
+ */
+class DownlinkAdmission
+{
+  public:
+    DownlinkAdmission();
+
+    /**
+     * @param source who sent it, see sourceKey()
+     * @param p the packet as it came from the broker. Those from JSON are built by us and can only be told apart by content.
+     */
+    DownlinkVerdict admit(uint32_t source, ChannelIndex chIndex, const meshtastic_MeshPacket &p, bool fromJson);
+
+    const DownlinkStats &getStats() const { return stats; }
+
+    static uint32_t sourceKey(const char *source);
+
+    static const char *verdictName(DownlinkVerdict v);
+
+  private:
+    struct TokenBucket {
+        float tokens;
+        uint32_t lastMs;
+
+        void refill(uint32_t nowMs, float perMinute, float burst);
+    };
+
+    struct SourceBucket {
+        uint32_t source;
+        TokenBucket bucket;
+    };
+
+    struct JsonRecord {
+        bool used;
+        uint32_t key;
+        uint32_t atMs;
+    };
+
+    TokenBucket channelBuckets[MAX_NUM_CHANNELS];
+    SourceBucket sources[MQTT_DOWNLINK_MAX_SOURCES];
+    uint8_t numSources = 0;
+
+    JsonRecord recentJson[MQTT_DOWNLINK_JSON_DEDUP_SLOTS] = {};
+    uint8_t nextJson = 0;
+
+    DownlinkStats stats = {};
+
+    /// Priority of p, for an encrypted packet that of its decoded content if we have the key
+    static meshtastic_MeshPacket_Priority classify(const meshtastic_MeshPacket &p);
+
+    bool isDuplicate(const meshtastic_MeshPacket &p, bool fromJson, uint32_t nowMs);
+
+    TokenBucket &sourceBucket(uint32_t source, uint32_t nowMs);
+
+    /// How fast the buckets refill right now, from 1 (full rate) to 0 (not at all)
+    float airtimeScale();
+
+    static uint32_t contentKey(const meshtastic_MeshPacket &p);
+};
@@ -19,7 +19,7 @@
 #include <WiFi.h>
 #endif
 #include "Default.h"
-#include "serialization/JSON.h"
+#include "serialization/JsonDoc.h"
 #include "serialization/MeshPacketSerializer.h"
 #include <assert.h>
 
@@ -50,12 +50,10 @@ void MQTT::onReceive(char *topic, byte *payload, size_t length)
         char payloadStr[length + 1];
         memcpy(payloadStr, payload, length);
         payloadStr[length] = 0; // null terminated string
-        JSONValue *json_value = JSON::Parse(payloadStr);
-        if (json_value != NULL) {
-            // check if it is a valid envelope
-            JSONObject json;
-            json = json_value->AsObject();
-
+        JsonDoc doc;
+        const JsonNode *json = doc.parse(payloadStr); // its strings point into payloadStr
+        uint32_t source = DownlinkAdmission::sourceKey(topic); // before strtok() takes it apart
+        if (json != NULL) {
             // parse the channel name from the topic string
             // the topic has been checked above for having jsonTopic prefix, so just move past it
             char *ptr = topic + jsonTopic.length();
@@ -64,57 +62,67 @@ void MQTT::onReceive(char *topic, byte *payload, size_t length)
             // We allow downlink JSON packets only on a channel named "mqtt"
             if (strncasecmp(channels.getGlobalId(sendChannel.index), Channels::mqttChannel, strlen(Channels::mqttChannel)) == 0 &&
                 sendChannel.settings.downlink_enabled) {
+                // check if it is a valid envelope
                 if (isValidJsonEnvelope(json)) {
                     // this is a valid envelope
-                    if (json["type"]->AsString().compare("sendtext") == 0 && json["payload"]->IsString()) {
-                        std::string jsonPayloadStr = json["payload"]->AsString();
-                        LOG_INFO("JSON payload %s, length %u\n", jsonPayloadStr.c_str(), jsonPayloadStr.length());
+                    const JsonNode *type = json->get("type");
+                    const JsonNode *jsonPayload = json->get("payload");
+                    const JsonNode *channel = json->get("channel", JSON_NUMBER);
+                    const JsonNode *to = json->get("to", JSON_NUMBER);
+                    const JsonNode *hopLimit = json->get("hopLimit", JSON_NUMBER);
+                    if (type->equals("sendtext") && jsonPayload->isString()) {
+                        LOG_INFO("JSON payload %s, length %u\n", jsonPayload->asString(), jsonPayload->size());
 
                         // construct protobuf data packet using TEXT_MESSAGE, send it to the mesh
                         meshtastic_MeshPacket *p = router->allocForSending();
                         p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
-                        if (json.find("channel") != json.end() && json["channel"]->IsNumber() &&
-                            (json["channel"]->AsNumber() < channels.getNumChannels()))
-                            p->channel = json["channel"]->AsNumber();
-                        if (json.find("to") != json.end() && json["to"]->IsNumber())
-                            p->to = json["to"]->AsNumber();
-                        if (json.find("hopLimit") != json.end() && json["hopLimit"]->IsNumber())
-                            p->hop_limit = json["hopLimit"]->AsNumber();
-                        if (jsonPayloadStr.length() <= sizeof(p->decoded.payload.bytes)) {
-                            memcpy(p->decoded.payload.bytes, jsonPayloadStr.c_str(), jsonPayloadStr.length());
-                            p->decoded.payload.size = jsonPayloadStr.length();
-                            service->sendToMesh(p, RX_SRC_LOCAL);
+                        if (channel && channel->asNumber() < channels.getNumChannels())
+                            p->channel = channel->asNumber();
+                        if (to)
+                            p->to = to->asNumber();
+                        if (hopLimit)
+                            p->hop_limit = hopLimit->asNumber();
+                        if (jsonPayload->size() <= sizeof(p->decoded.payload.bytes)) {
+                            memcpy(p->decoded.payload.bytes, jsonPayload->asString(), jsonPayload->size());
+                            p->decoded.payload.size = jsonPayload->size();
+                            if (downlink.admit(source, p->channel, *p, true) == DOWNLINK_ADMIT)
+                                service->sendToMesh(p, RX_SRC_LOCAL);
+                            else
+                                packetPool.release(p);
                         } else {
                             LOG_WARN("Received MQTT json payload too long, dropping\n");
+                            packetPool.release(p);
                         }
-                    } else if (json["type"]->AsString().compare("sendposition") == 0 && json["payload"]->IsObject()) {
+                    } else if (type->equals("sendposition") && jsonPayload->isObject()) {
                         // invent the "sendposition" type for a valid envelope
-                        JSONObject posit;
-                        posit = json["payload"]->AsObject(); // get nested JSON Position
+                        const JsonNode *posit = jsonPayload; // nested JSON Position
+                        const JsonNode *v;
                         meshtastic_Position pos = meshtastic_Position_init_default;
-                        if (posit.find("latitude_i") != posit.end() && posit["latitude_i"]->IsNumber())
-                            pos.latitude_i = posit["latitude_i"]->AsNumber();
-                        if (posit.find("longitude_i") != posit.end() && posit["longitude_i"]->IsNumber())
-                            pos.longitude_i = posit["longitude_i"]->AsNumber();
-                        if (posit.find("altitude") != posit.end() && posit["altitude"]->IsNumber())
-                            pos.altitude = posit["altitude"]->AsNumber();
-                        if (posit.find("time") != posit.end() && posit["time"]->IsNumber())
-                            pos.time = posit["time"]->AsNumber();
+                        if ((v = posit->get("latitude_i", JSON_NUMBER)))
+                            pos.latitude_i = v->asNumber();
+                        if ((v = posit->get("longitude_i", JSON_NUMBER)))
+                            pos.longitude_i = v->asNumber();
+                        if ((v = posit->get("altitude", JSON_NUMBER)))
+                            pos.altitude = v->asNumber();
+                        if ((v = posit->get("time", JSON_NUMBER)))
+                            pos.time = v->asNumber();
 
                         // construct protobuf data packet using POSITION, send it to the mesh
                         meshtastic_MeshPacket *p = router->allocForSending();
                         p->decoded.portnum = meshtastic_PortNum_POSITION_APP;
-                        if (json.find("channel") != json.end() && json["channel"]->IsNumber() &&
-                            (json["channel"]->AsNumber() < channels.getNumChannels()))
-                            p->channel = json["channel"]->AsNumber();
-                        if (json.find("to") != json.end() && json["to"]->IsNumber())
-                            p->to = json["to"]->AsNumber();
-                        if (json.find("hopLimit") != json.end() && json["hopLimit"]->IsNumber())
-                            p->hop_limit = json["hopLimit"]->AsNumber();
+                        if (channel && channel->asNumber() < channels.getNumChannels())
+                            p->channel = channel->asNumber();
+                        if (to)
+                            p->to = to->asNumber();
+                        if (hopLimit)
+                            p->hop_limit = hopLimit->asNumber();
                         p->decoded.payload.size =
                             pb_encode_to_bytes(p->decoded.payload.bytes, sizeof(p->decoded.payload.bytes),
                                                &meshtastic_Position_msg, &pos); // make the Data protobuf from position
-                        service->sendToMesh(p, RX_SRC_LOCAL);
+                        if (downlink.admit(source, p->channel, *p, true) == DOWNLINK_ADMIT)
+                            service->sendToMesh(p, RX_SRC_LOCAL);
+                        else
+                            packetPool.release(p);
                     } else {
                         LOG_DEBUG("JSON Ignoring downlink message with unsupported type.\n");
                     }
@@ -128,7 +136,6 @@ void MQTT::onReceive(char *topic, byte *payload, size_t length)
             // no json, this is an invalid payload
             LOG_ERROR("JSON Received payload on MQTT but not a valid JSON\n");
         }
-        delete json_value;
     } else {
         if (length == 0) {
             LOG_WARN("Empty MQTT payload received, topic %s!\n", topic);
@@ -151,9 +158,10 @@ void MQTT::onReceive(char *topic, byte *payload, size_t length)
                 else
                     LOG_INFO("Ignoring downlink message we originally sent.\n");
             } else {
-                // Find channel by channel_id and check downlink_enabled
-                if ((strcmp(e.channel_id, "PKI") == 0 && e.packet) ||
-                    (strcmp(e.channel_id, channels.getGlobalId(ch.index)) == 0 && e.packet && ch.settings.downlink_enabled)) {
+                // Find channel by channel_id and check downlink_enabled, then whether it fits in the downlink budget
+                if (((strcmp(e.channel_id, "PKI") == 0 && e.packet) ||
+                     (strcmp(e.channel_id, channels.getGlobalId(ch.index)) == 0 && e.packet && ch.settings.downlink_enabled)) &&
+                    downlink.admit(DownlinkAdmission::sourceKey(e.gateway_id), ch.index, *e.packet, false) == DOWNLINK_ADMIT) {
                     LOG_INFO("Received MQTT topic %s, len=%u\n", topic, length);
                     meshtastic_MeshPacket *p = packetPool.allocCopy(*e.packet);
                     p->via_mqtt = true; // Mark that the packet was received via MQTT
@@ -666,13 +674,15 @@ void MQTT::perhapsReportToMap()
     }
 }
 
-bool MQTT::isValidJsonEnvelope(JSONObject &json)
+bool MQTT::isValidJsonEnvelope(const JsonNode *json)
 {
+    const JsonNode *sender = json->get("sender");
+    const JsonNode *hopLimit = json->get("hopLimit");
+    const JsonNode *from = json->get("from", JSON_NUMBER);
     // if "sender" is provided, avoid processing packets we uplinked
-    return (json.find("sender") != json.end() ? (json["sender"]->AsString().compare(owner.id) != 0) : true) &&
-           (json.find("hopLimit") != json.end() ? json["hopLimit"]->IsNumber() : true) && // hop limit should be a number
-           (json.find("from") != json.end()) && json["from"]->IsNumber() &&
-           (json["from"]->AsNumber() == nodeDB->getNodeNum()) &&            // only accept message if the "from" is us
-           (json.find("type") != json.end()) && json["type"]->IsString() && // should specify a type
-           (json.find("payload") != json.end());                            // should have a payload
+    return (sender ? !sender->equals(owner.id) : true) &&
+           (hopLimit ? hopLimit->isNumber() : true) &&         // hop limit should be a number
+           from && (from->asNumber() == nodeDB->getNodeNum()) && // only accept message if the "from" is us
+           json->get("type", JSON_STRING) &&                     // should specify a type
+           json->get("payload");                                 // should have a payload
 }
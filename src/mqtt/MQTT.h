@@ -2,10 +2,11 @@
 
 #include "configuration.h"
 
+#include "DownlinkAdmission.h"
 #include "concurrency/OSThread.h"
 #include "mesh/Channels.h"
 #include "mesh/generated/meshtastic/mqtt.pb.h"
-#include "serialization/JSON.h"
+#include "serialization/JsonDoc.h"
 #if HAS_WIFI
 #include <WiFiClient.h>
 #if !defined(ARCH_PORTDUINO)
@@ -73,6 +74,9 @@ class MQTT : private concurrency::OSThread
 
     void start() { setIntervalFromNow(0); };
 
+    /// What happened to the packets from the broker we could have sent to the mesh
+    const DownlinkStats &getDownlinkStats() const { return downlink.getStats(); }
+
   protected:
     PointerQueue<meshtastic_ServiceEnvelope> mqttQueue;
 
@@ -92,6 +96,8 @@ class MQTT : private concurrency::OSThread
     uint32_t map_position_precision = default_map_position_precision;
     uint32_t map_publish_interval_msecs = default_map_publish_interval_secs * 1000;
 
+    DownlinkAdmission downlink;
+
     /** return true if we have a channel that wants uplink/downlink or map reporting is enabled
      */
     bool wantsLink() const;
@@ -114,7 +120,7 @@ class MQTT : private concurrency::OSThread
     void perhapsReportToMap();
 
     // returns true if this is a valid JSON envelope which we accept on downlink
-    bool isValidJsonEnvelope(JSONObject &json);
+    bool isValidJsonEnvelope(const JsonNode *json);
 
     /// Return 0 if sleep is okay, veto sleep if we are connected to pubsub server
     // int preflightSleepCb(void *unused = NULL) { return pubSub.connected() ? 1 : 0; }
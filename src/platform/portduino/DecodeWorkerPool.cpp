@@ -0,0 +1,120 @@
+#include "DecodeWorkerPool.h"
+
+#if HAS_DECODE_WORKER_POOL
+#include "Channels.h"
+#include "NodeDB.h"
+#include "PortduinoCryptoEngine.h"
+
+DecodeWorkerPool *decodeWorkerPool;
+
+DecodeWorkerPool::DecodeWorkerPool(unsigned numWorkers) : concurrency::OSThread("DecodeWorkers")
+{
+    for (unsigned i = 0; i < numWorkers; i++)
+        workers.emplace_back(&DecodeWorkerPool::work, this);
+    LOG_INFO("Decoding received packets on %u worker threads\n", numWorkers);
+    disable();
+}
+
+DecodeWorkerPool::~DecodeWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> g(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &t : workers)
+        t.join();
+    for (Job *job : jobs) {
+        packetPool.release(job->p);
+        delete job->result;
+        delete job;
+    }
+}
+
+void DecodeWorkerPool::submit(meshtastic_MeshPacket *p, RadioInterface *from)
+{
+    Job *job = new Job();
+    job->p = p;
+    job->from = from;
+
+    // Packets that could be for PKI go through perhapsDecode() as they are
+    if (!(p->channel == 0 && p->to == nodeDB->getNodeNum())) {
+        for (ChannelIndex chIndex = 0; chIndex < channels.getNumChannels(); chIndex++) {
+            if (channels.getHash(chIndex) == p->channel) {
+                job->chIndexes[job->numKeys] = chIndex;
+                job->keys[job->numKeys++] = channels.getKey(chIndex);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> g(lock);
+        jobs.push_back(job);
+        if (job->numKeys)
+            todo.push_back(job);
+        else
+            job->done = true;
+    }
+    if (job->numKeys)
+        wake.notify_one();
+    enabled = true;
+    setIntervalFromNow(0);
+}
+
+int32_t DecodeWorkerPool::runOnce()
+{
+    // No more than the router can queue, the rest waits here until it handled those
+    size_t space = router->getReceivedSpace();
+    std::vector<Job *> ready;
+    bool pending, moreReady;
+    {
+        std::lock_guard<std::mutex> g(lock);
+        while (ready.size() < space && !jobs.empty() && jobs.front()->done) {
+            ready.push_back(jobs.front());
+            jobs.pop_front();
+        }
+        pending = !jobs.empty();
+        moreReady = pending && jobs.front()->done;
+    }
+
+    for (Job *job : ready) {
+        router->enqueueDecryptedMessage(job->p, job->from, job->result);
+        delete job;
+    }
+
+    // The workers can't wake our scheduler, so check back soon while they are busy
+    return moreReady ? 0 : pending ? 1 : disable();
+}
+
+void DecodeWorkerPool::work()
+{
+    // The global engine and scratch buffers belong to the main thread
+    PortduinoCryptoEngine engine;
+    CryptContext *ctx = new CryptContext;
+
+    while (true) {
+        Job *job;
+        {
+            std::unique_lock<std::mutex> g(lock);
+            wake.wait(g, [this] { return stopping || !todo.empty(); });
+            if (stopping)
+                break;
+            job = todo.front();
+            todo.pop_front();
+        }
+
+        DecryptedPayload *result = new DecryptedPayload();
+        for (uint8_t i = 0; i < job->numKeys && !result->ok; i++) {
+            if (decryptChannelPayload(job->p, job->keys[i], &engine, *ctx, result->decoded)) {
+                result->ok = true;
+                result->chIndex = job->chIndexes[i];
+            }
+        }
+
+        std::lock_guard<std::mutex> g(lock);
+        job->result = result;
+        job->done = true;
+    }
+    delete ctx;
+}
+#endif
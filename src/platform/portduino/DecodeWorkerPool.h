@@ -0,0 +1,66 @@
+#pragma once
+
+#include "configuration.h"
+
+#if HAS_DECODE_WORKER_POOL
+#include "Router.h"
+#include "concurrency/OSThread.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Decrypts and decodes received packets on worker threads, so a Linux host with several radios or lots of traffic can use
+ * more than one core for it.
+ *
+ * The main thread looks up the keys of the channels that match the hash of a packet, a worker tries them with its own
+ * crypto engine and scratch buffers, and the main thread hands the packets back to the router in the order they came in,
+ * each with its DecryptedPayload. Everything else perhapsDecode() does (PKI, which needs the nodeDB and our private key,
+ * decompression, capability tracking and logging) stays on the main thread.
+ *
+ * Enabled with General.DecodeWorkers in config.yaml.
+ */
+class DecodeWorkerPool : private concurrency::OSThread
+{
+  public:
+    explicit DecodeWorkerPool(unsigned numWorkers);
+
+    ~DecodeWorkerPool();
+
+    /**
+     * Take an encrypted packet as it comes from the radio, it goes to router->enqueueDecryptedMessage() once decrypted.
+     * Main thread only.
+     */
+    void submit(meshtastic_MeshPacket *p, RadioInterface *from);
+
+  protected:
+    /// Hand the packets that are done to the router, stopping at the first one that isn't or when its queue is full
+    virtual int32_t runOnce() override;
+
+  private:
+    struct Job {
+        meshtastic_MeshPacket *p;
+        RadioInterface *from;
+        uint8_t numKeys;
+        ChannelIndex chIndexes[MAX_NUM_CHANNELS];
+        CryptoKey keys[MAX_NUM_CHANNELS];
+        DecryptedPayload *result; // NULL for packets left to perhapsDecode()
+        bool done;
+    };
+
+    /// Body of the worker threads
+    void work();
+
+    std::mutex lock; // For everything below
+    std::condition_variable wake;
+    std::deque<Job *> jobs; // All of them, in the order they were received
+    std::deque<Job *> todo; // Waiting for a worker
+    bool stopping = false;
+
+    std::vector<std::thread> workers;
+};
+
+extern DecodeWorkerPool *decodeWorkerPool;
+#endif
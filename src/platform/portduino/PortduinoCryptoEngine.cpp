@@ -0,0 +1,5 @@
+#include "PortduinoCryptoEngine.h"
+
+#if __has_include(<openssl/evp.h>)
+CryptoEngine *crypto = new PortduinoCryptoEngine();
+#endif
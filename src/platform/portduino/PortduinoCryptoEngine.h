@@ -0,0 +1,139 @@
+#pragma once
+
+#include "CryptoEngine.h"
+#include "configuration.h"
+
+#if __has_include(<openssl/evp.h>)
+#include <openssl/evp.h>
+
+/**
+ * Linux native crypto through OpenSSL, which uses AES-NI or the ARMv8 crypto extensions when the CPU has them.
+ *
+ * The results are the same as those of the portable implementations in CryptoEngine: OpenSSL increments the whole 128 bit
+ * CTR counter where CTRCommon only increments the last 4 bytes, but our nonces start that block counter at zero and a
+ * packet is at most MAX_BLOCKSIZE bytes, so it never carries over.
+ */
+class PortduinoCryptoEngine : public CryptoEngine
+{
+    EVP_CIPHER_CTX *ctrCtx;
+    EVP_CIPHER_CTX *blockCtx; // For aesEncrypt(), keyed by aesSetKey()
+    EVP_CIPHER_CTX *ccmCtx;
+
+  public:
+    PortduinoCryptoEngine() : ctrCtx(EVP_CIPHER_CTX_new()), blockCtx(EVP_CIPHER_CTX_new()), ccmCtx(EVP_CIPHER_CTX_new()) {}
+
+    ~PortduinoCryptoEngine()
+    {
+        EVP_CIPHER_CTX_free(ctrCtx);
+        EVP_CIPHER_CTX_free(blockCtx);
+        EVP_CIPHER_CTX_free(ccmCtx);
+    }
+
+    virtual void encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, uint8_t *bytes) override
+    {
+        if (_key.length > 0) {
+            int outLen;
+            const EVP_CIPHER *cipher = _key.length == 16 ? EVP_aes_128_ctr() : EVP_aes_256_ctr();
+            if (EVP_EncryptInit_ex(ctrCtx, cipher, NULL, _key.bytes, _nonce) != 1 ||
+                EVP_EncryptUpdate(ctrCtx, bytes, &outLen, bytes, numBytes) != 1)
+                LOG_ERROR("OpenSSL AES-CTR failed. noop encryption!\n");
+        }
+    }
+
+#if !(MESHTASTIC_EXCLUDE_PKI)
+#if !(MESHTASTIC_EXCLUDE_PKI_KEYGEN)
+    virtual void generateKeyPair(uint8_t *pubKey, uint8_t *privKey) override
+    {
+        LOG_DEBUG("Generating Curve25519 key pair...\n");
+        EVP_PKEY *pkey = NULL;
+        EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_X25519, NULL);
+        size_t privLen = sizeof(private_key), pubLen = sizeof(public_key);
+        bool ok = ctx && EVP_PKEY_keygen_init(ctx) == 1 && EVP_PKEY_keygen(ctx, &pkey) == 1 &&
+                  EVP_PKEY_get_raw_private_key(pkey, private_key, &privLen) == 1 &&
+                  EVP_PKEY_get_raw_public_key(pkey, public_key, &pubLen) == 1;
+        EVP_PKEY_free(pkey);
+        EVP_PKEY_CTX_free(ctx);
+        if (!ok) {
+            LOG_WARN("OpenSSL X25519 key generation failed, using the portable one\n");
+            CryptoEngine::generateKeyPair(pubKey, privKey);
+            return;
+        }
+        memcpy(pubKey, public_key, sizeof(public_key));
+        memcpy(privKey, private_key, sizeof(private_key));
+    }
+#endif
+
+    virtual bool setDHPublicKey(uint8_t *pubKey) override
+    {
+        EVP_PKEY *priv = EVP_PKEY_new_raw_private_key(EVP_PKEY_X25519, NULL, private_key, sizeof(private_key));
+        EVP_PKEY *peer = EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, NULL, pubKey, 32);
+        EVP_PKEY_CTX *ctx = priv ? EVP_PKEY_CTX_new(priv, NULL) : NULL;
+        size_t len = sizeof(shared_key);
+        // Like Curve25519::dh2(), OpenSSL refuses weak public keys that would give an all zero shared secret
+        bool ok = ctx && peer && EVP_PKEY_derive_init(ctx) == 1 && EVP_PKEY_derive_set_peer(ctx, peer) == 1 &&
+                  EVP_PKEY_derive(ctx, shared_key, &len) == 1;
+        EVP_PKEY_CTX_free(ctx);
+        EVP_PKEY_free(peer);
+        EVP_PKEY_free(priv);
+        if (!ok) {
+            LOG_WARN("Curve25519DH step 2 failed!\n");
+            return false;
+        }
+        return true;
+    }
+
+    virtual void hash(uint8_t *bytes, size_t numBytes) override
+    {
+        uint8_t digest[32];
+        if (EVP_Digest(bytes, numBytes, digest, NULL, EVP_sha256(), NULL) == 1)
+            memcpy(bytes, digest, sizeof(digest));
+        else
+            CryptoEngine::hash(bytes, numBytes);
+    }
+
+    virtual void aesSetKey(const uint8_t *key_bytes, size_t key_len) override
+    {
+        if (key_len != 0) {
+            EVP_EncryptInit_ex(blockCtx, key_len == 16 ? EVP_aes_128_ecb() : EVP_aes_256_ecb(), NULL, key_bytes, NULL);
+            EVP_CIPHER_CTX_set_padding(blockCtx, 0);
+        }
+    }
+
+    virtual void aesEncrypt(uint8_t *in, uint8_t *out) override
+    {
+        int outLen;
+        EVP_EncryptUpdate(blockCtx, out, &outLen, in, 16);
+    }
+
+    virtual bool ccmEncrypt(const uint8_t *key, size_t keyLen, const uint8_t *nonce, size_t M, const uint8_t *plain, size_t len,
+                            uint8_t *crypt, uint8_t *auth) override
+    {
+        int outLen;
+        return EVP_EncryptInit_ex(ccmCtx, ccmCipher(keyLen), NULL, NULL, NULL) == 1 &&
+               EVP_CIPHER_CTX_ctrl(ccmCtx, EVP_CTRL_CCM_SET_IVLEN, 13, NULL) == 1 &&
+               EVP_CIPHER_CTX_ctrl(ccmCtx, EVP_CTRL_CCM_SET_TAG, M, NULL) == 1 &&
+               EVP_EncryptInit_ex(ccmCtx, NULL, NULL, key, nonce) == 1 &&
+               EVP_EncryptUpdate(ccmCtx, NULL, &outLen, NULL, len) == 1 && // CCM needs the total length up front
+               EVP_EncryptUpdate(ccmCtx, crypt, &outLen, plain, len) == 1 &&
+               EVP_EncryptFinal_ex(ccmCtx, crypt + outLen, &outLen) == 1 &&
+               EVP_CIPHER_CTX_ctrl(ccmCtx, EVP_CTRL_CCM_GET_TAG, M, auth) == 1;
+    }
+
+    virtual bool ccmDecrypt(const uint8_t *key, size_t keyLen, const uint8_t *nonce, size_t M, const uint8_t *crypt, size_t len,
+                            const uint8_t *auth, uint8_t *plain) override
+    {
+        int outLen;
+        // The last update fails if the tag doesn't match
+        return EVP_DecryptInit_ex(ccmCtx, ccmCipher(keyLen), NULL, NULL, NULL) == 1 &&
+               EVP_CIPHER_CTX_ctrl(ccmCtx, EVP_CTRL_CCM_SET_IVLEN, 13, NULL) == 1 &&
+               EVP_CIPHER_CTX_ctrl(ccmCtx, EVP_CTRL_CCM_SET_TAG, M, (void *)auth) == 1 &&
+               EVP_DecryptInit_ex(ccmCtx, NULL, NULL, key, nonce) == 1 &&
+               EVP_DecryptUpdate(ccmCtx, NULL, &outLen, NULL, len) == 1 &&
+               EVP_DecryptUpdate(ccmCtx, plain, &outLen, crypt, len) > 0;
+    }
+
+  private:
+    static const EVP_CIPHER *ccmCipher(size_t keyLen) { return keyLen == 16 ? EVP_aes_128_ccm() : EVP_aes_256_ccm(); }
+#endif
+};
+#endif
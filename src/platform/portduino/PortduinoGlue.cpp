@@ -35,6 +35,31 @@ void updateBatteryLevel(uint8_t level) NOT_IMPLEMENTED("updateBatteryLevel");
 
 int TCPPort = 4403;
 
+/// A RebroadcastPolicy from all, bridge or none
+static int parseRebroadcastPolicy(const YAML::Node &node, int defaultPolicy)
+{
+    std::string policy = node.as<std::string>("");
+    if (policy == "all")
+        return REBROADCAST_ALL;
+    else if (policy == "bridge")
+        return REBROADCAST_BRIDGE_ONLY;
+    else if (policy == "none")
+        return REBROADCAST_NONE;
+    return defaultPolicy;
+}
+
+/// A modem preset by its name in the protobufs, e.g. LONG_FAST, or -1 to use the one in config.lora
+static int parseModemPreset(const YAML::Node &node)
+{
+    static const char *names[] = {"LONG_FAST",  "LONG_SLOW",  "VERY_LONG_SLOW", "MEDIUM_SLOW", "MEDIUM_FAST",
+                                  "SHORT_SLOW", "SHORT_FAST", "LONG_MODERATE",  "SHORT_TURBO"};
+    std::string preset = node.as<std::string>("");
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++)
+        if (preset == names[i])
+            return i;
+    return -1;
+}
+
 static error_t parse_opt(int key, char *arg, struct argp_state *state)
 {
     switch (key) {
@@ -291,6 +316,18 @@ void portduinoSetup()
 
         settingsMap[maxnodes] = (yamlConfig["General"]["MaxNodes"]).as<int>(200);
         settingsMap[maxtophone] = (yamlConfig["General"]["MaxMessageQueue"]).as<int>(100);
+        settingsMap[decodeworkers] = (yamlConfig["General"]["DecodeWorkers"]).as<int>(0);
+        settingsMap[bundlewindow] = (yamlConfig["General"]["BundleWindow"]).as<int>(-1);
+
+        settingsMap[udpmulticast] = (yamlConfig["UdpMulticast"]["Enabled"]).as<bool>(false);
+        settingsStrings[udpmulticastgroup] = (yamlConfig["UdpMulticast"]["Group"]).as<std::string>("224.0.0.69");
+        settingsMap[udpmulticastport] = (yamlConfig["UdpMulticast"]["Port"]).as<int>(4403);
+        settingsStrings[udpmulticastif] = (yamlConfig["UdpMulticast"]["Interface"]).as<std::string>("");
+        settingsMap[udpmulticastrebroadcast] =
+            parseRebroadcastPolicy(yamlConfig["UdpMulticast"]["RebroadcastPolicy"], REBROADCAST_BRIDGE_ONLY);
+
+        settingsMap[lorapreset] = parseModemPreset(yamlConfig["Lora"]["ModemPreset"]);
+        settingsMap[lorarebroadcast] = parseRebroadcastPolicy(yamlConfig["Lora"]["RebroadcastPolicy"], REBROADCAST_ALL);
 
     } catch (YAML::Exception &e) {
         std::cout << "*** Exception " << e.what() << std::endl;
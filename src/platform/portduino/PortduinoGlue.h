@@ -20,6 +20,8 @@ enum configNames {
     gpiochip,
     spidev,
     spiSpeed,
+    lorapreset,
+    lorarebroadcast,
     i2cdev,
     has_gps,
     touchscreenModule,
@@ -54,6 +56,13 @@ enum configNames {
     webserverrootpath,
     maxtophone,
     maxnodes,
+    decodeworkers,
+    bundlewindow,
+    udpmulticast,
+    udpmulticastgroup,
+    udpmulticastport,
+    udpmulticastif,
+    udpmulticastrebroadcast,
     ascii_logs
 };
 enum { no_screen, x11, st7789, st7735, st7735s, st7796, ili9341, ili9488, hx8357d };
@@ -4,7 +4,9 @@
 
 SimRadio::SimRadio() : NotifiedWorkerThread("SimRadio")
 {
-    instance = this;
+    // The simulator talks to the first one, any others are extra interfaces of the same node
+    if (!instance)
+        instance = this;
 }
 
 SimRadio *SimRadio::instance;
@@ -165,7 +167,7 @@ void SimRadio::onNotify(uint32_t notification)
                     startSend(txp);
                     // Packet has been sent, count it toward our TX airtime utilization.
                     uint32_t xmitMsec = getPacketTime(txp);
-                    airTime->logAirtime(TX_LOG, xmitMsec);
+                    getAirTime()->logTransmit(txp, xmitMsec);
 
                     notifyLater(xmitMsec, ISR_TX, false); // Model the time it is busy sending
                 }
@@ -244,7 +246,7 @@ void SimRadio::handleReceiveInterrupt(meshtastic_MeshPacket *p)
 
     printPacket("Lora RX", mp);
 
-    airTime->logAirtime(RX_LOG, xmitMsec);
+    getAirTime()->logAirtime(RX_LOG, xmitMsec);
 
     deliverToReceiver(mp);
 }
@@ -16,4 +16,20 @@
 #endif
 #ifndef HAS_TELEMETRY
 #define HAS_TELEMETRY 1
-#endif
\ No newline at end of file
+#endif
+
+// OpenSSL gets linked when it is installed, see variants/portduino/platformio.ini
+#if __has_include(<openssl/evp.h>)
+#ifndef HAS_CUSTOM_CRYPTO_ENGINE
+#define HAS_CUSTOM_CRYPTO_ENGINE 1
+#endif
+// Each decode worker gets an engine of its own, see DecodeWorkerPool
+#define HAS_DECODE_WORKER_POOL 1
+#endif
+
+#ifdef __linux__
+// Serves the TCP API to any number of clients, see EpollServerAPI
+#define HAS_EPOLL_API_SERVER 1
+// Shares mesh packets with the other nodes on the LAN, see UdpMulticastInterface
+#define HAS_UDP_MULTICAST 1
+#endif
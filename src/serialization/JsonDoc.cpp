@@ -0,0 +1,567 @@
+#include "JsonDoc.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JSON_ARENA_ALIGN (sizeof(double) > sizeof(void *) ? sizeof(double) : sizeof(void *))
+
+JsonArena::~JsonArena()
+{
+    while (chunks) {
+        Chunk *next = chunks->next;
+        free(chunks);
+        chunks = next;
+    }
+}
+
+void *JsonArena::alloc(size_t size)
+{
+    size = (size + JSON_ARENA_ALIGN - 1) & ~(JSON_ARENA_ALIGN - 1);
+    const size_t header = (sizeof(Chunk) + JSON_ARENA_ALIGN - 1) & ~(JSON_ARENA_ALIGN - 1);
+
+    if (!chunks || chunks->size - chunks->used < size) {
+        // Each chunk is twice the one before, so a large document still takes only a few allocations
+        size_t chunkBytes = chunks ? chunks->size * 2 : chunkSize;
+        if (chunkBytes < size)
+            chunkBytes = size;
+        Chunk *c = (Chunk *)malloc(header + chunkBytes);
+        if (!c)
+            return NULL;
+        c->next = chunks;
+        c->size = chunkBytes;
+        c->used = 0;
+        chunks = c;
+    }
+
+    void *p = (uint8_t *)chunks + header + chunks->used;
+    chunks->used += size;
+    used += size;
+    return p;
+}
+
+char *JsonArena::copy(const char *s, size_t len)
+{
+    char *c = (char *)alloc(len + 1);
+    if (c) {
+        memcpy(c, s, len);
+        c[len] = 0;
+    }
+    return c;
+}
+
+// FNV-1a, for the index of an object
+static uint32_t jsonHash(const char *key, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (uint8_t)key[i]) * 16777619u;
+    return h;
+}
+
+bool JsonNode::equals(const char *s) const
+{
+    return type == JSON_STRING && strlen(s) == count && memcmp(string, s, count) == 0;
+}
+
+const JsonNode *JsonNode::get(const char *key) const
+{
+    if (type != JSON_OBJECT)
+        return NULL;
+
+    size_t len = strlen(key);
+    if (list.index) {
+        // The index has at least twice the slots of the members, so there always is an empty one to stop at
+        uint32_t mask = indexSize - 1;
+        for (uint32_t i = jsonHash(key, len) & mask;; i = (i + 1) & mask) {
+            const JsonMember *m = list.index[i];
+            if (!m)
+                return NULL;
+            if (m->keyLen == len && memcmp(m->key, key, len) == 0)
+                return m->value;
+        }
+    }
+
+    for (const JsonMember *m = list.first; m; m = m->next) {
+        if (m->keyLen == len && memcmp(m->key, key, len) == 0)
+            return m->value;
+    }
+    return NULL;
+}
+
+const JsonNode *JsonNode::get(const char *key, JsonType t) const
+{
+    const JsonNode *v = get(key);
+    return v && v->type == t ? v : NULL;
+}
+
+const JsonNode *JsonNode::at(size_t i) const
+{
+    if (type != JSON_ARRAY || i >= count)
+        return NULL;
+    if (list.index)
+        return list.index[i]->value;
+
+    const JsonMember *m = list.first;
+    while (i--)
+        m = m->next;
+    return m->value;
+}
+
+JsonNode *JsonDoc::newNode(JsonType type)
+{
+    JsonNode *n = (JsonNode *)arena.alloc(sizeof(JsonNode));
+    if (n) {
+        memset(n, 0, sizeof(JsonNode));
+        n->type = type;
+    }
+    return n;
+}
+
+JsonNode *JsonDoc::boolean(bool b)
+{
+    JsonNode *n = newNode(JSON_BOOL);
+    if (n)
+        n->boolean = b;
+    return n;
+}
+
+JsonNode *JsonDoc::number(double d)
+{
+    JsonNode *n = newNode(JSON_NUMBER);
+    if (n)
+        n->number = d;
+    return n;
+}
+
+JsonNode *JsonDoc::string(const char *s)
+{
+    size_t len = strlen(s);
+    char *copy = arena.copy(s, len);
+    JsonNode *n = copy ? newNode(JSON_STRING) : NULL;
+    if (n) {
+        n->string = copy;
+        n->count = len;
+    }
+    return n;
+}
+
+void JsonDoc::append(JsonNode *container, JsonType type, const char *key, JsonNode *value)
+{
+    if (!container || !value || container->type != type)
+        return;
+
+    JsonMember *m = (JsonMember *)arena.alloc(sizeof(JsonMember));
+    if (!m)
+        return;
+    m->key = NULL;
+    m->keyLen = 0;
+    if (key) {
+        m->keyLen = strlen(key);
+        m->key = arena.copy(key, m->keyLen);
+        if (!m->key)
+            return;
+    }
+    m->value = value;
+    m->next = NULL;
+
+    if (container->list.last)
+        container->list.last->next = m;
+    else
+        container->list.first = m;
+    container->list.last = m;
+    container->count++;
+    container->list.index = NULL; // Stale now, lookups scan until it is built again
+    container->indexSize = 0;
+}
+
+bool JsonDoc::buildIndex(JsonNode *container)
+{
+    if (container->type == JSON_ARRAY) {
+        if (container->count == 0)
+            return true;
+        JsonMember **index = (JsonMember **)arena.alloc(container->count * sizeof(JsonMember *));
+        if (!index)
+            return false;
+        uint32_t i = 0;
+        for (JsonMember *m = container->list.first; m; m = m->next)
+            index[i++] = m;
+        container->list.index = index;
+        return true;
+    }
+
+    if (container->count < JSON_INDEX_MIN)
+        return true;
+    uint32_t size = 1;
+    while (size < container->count * 2)
+        size <<= 1;
+    JsonMember **index = (JsonMember **)arena.alloc(size * sizeof(JsonMember *));
+    if (!index)
+        return false;
+    memset(index, 0, size * sizeof(JsonMember *));
+
+    // A repeated key lands after the first one in the probe sequence, so like a scan a lookup finds the first
+    uint32_t mask = size - 1;
+    for (JsonMember *m = container->list.first; m; m = m->next) {
+        uint32_t i = jsonHash(m->key, m->keyLen) & mask;
+        while (index[i])
+            i = (i + 1) & mask;
+        index[i] = m;
+    }
+    container->list.index = index;
+    container->indexSize = size;
+    return true;
+}
+
+static void skipWhitespace(char *&p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+        p++;
+}
+
+JsonNode *JsonDoc::parse(char *text)
+{
+    char *p = text;
+    JsonNode *root = parseValue(p, 0);
+    if (!root)
+        return NULL;
+
+    // Nothing but white space may follow
+    skipWhitespace(p);
+    return *p == 0 ? root : NULL;
+}
+
+JsonNode *JsonDoc::parseCopy(const char *text)
+{
+    char *copy = arena.copy(text, strlen(text));
+    return copy ? parse(copy) : NULL;
+}
+
+JsonNode *JsonDoc::parseValue(char *&p, uint8_t depth)
+{
+    skipWhitespace(p);
+    JsonNode *n = NULL;
+    switch (*p) {
+    case '{':
+        return parseContainer(p, JSON_OBJECT, depth + 1);
+    case '[':
+        return parseContainer(p, JSON_ARRAY, depth + 1);
+    case '"':
+        n = newNode(JSON_STRING);
+        return n && parseString(p, n->string, n->count) ? n : NULL;
+    case 't':
+        if (strncmp(p, "true", 4) != 0)
+            return NULL;
+        p += 4;
+        return boolean(true);
+    case 'f':
+        if (strncmp(p, "false", 5) != 0)
+            return NULL;
+        p += 5;
+        return boolean(false);
+    case 'n':
+        if (strncmp(p, "null", 4) != 0)
+            return NULL;
+        p += 4;
+        return null();
+    default:
+        n = newNode(JSON_NUMBER);
+        return n && parseNumber(p, n->number) ? n : NULL;
+    }
+}
+
+JsonNode *JsonDoc::parseContainer(char *&p, JsonType type, uint8_t depth)
+{
+    if (depth > JSON_MAX_DEPTH)
+        return NULL;
+    JsonNode *container = newNode(type);
+    if (!container)
+        return NULL;
+
+    const char close = type == JSON_OBJECT ? '}' : ']';
+    p++;
+    skipWhitespace(p);
+    if (*p == close) {
+        p++;
+        return container;
+    }
+
+    while (true) {
+        JsonMember *m = (JsonMember *)arena.alloc(sizeof(JsonMember));
+        if (!m)
+            return NULL;
+        m->key = NULL;
+        m->keyLen = 0;
+        m->next = NULL;
+
+        if (type == JSON_OBJECT) {
+            skipWhitespace(p);
+            if (*p != '"' || !parseString(p, m->key, m->keyLen))
+                return NULL;
+            skipWhitespace(p);
+            if (*p != ':')
+                return NULL;
+            p++;
+        }
+        m->value = parseValue(p, depth);
+        if (!m->value)
+            return NULL;
+
+        if (container->list.last)
+            container->list.last->next = m;
+        else
+            container->list.first = m;
+        container->list.last = m;
+        container->count++;
+
+        skipWhitespace(p);
+        if (*p == close) {
+            p++;
+            return buildIndex(container) ? container : NULL;
+        }
+        if (*p != ',')
+            return NULL;
+        p++;
+    }
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool JsonDoc::parseNumber(char *&p, double &n)
+{
+    // Check the grammar of JSON, strtod() would take hex, inf and more
+    char *start = p;
+    if (*p == '-')
+        p++;
+    if (*p == '0')
+        p++;
+    else if (isDigit(*p))
+        while (isDigit(*p))
+            p++;
+    else
+        return false;
+    if (*p == '.') {
+        p++;
+        if (!isDigit(*p))
+            return false;
+        while (isDigit(*p))
+            p++;
+    }
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        if (*p == '+' || *p == '-')
+            p++;
+        if (!isDigit(*p))
+            return false;
+        while (isDigit(*p))
+            p++;
+    }
+
+    n = strtod(start, NULL);
+    return true;
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return 10 + c - 'A';
+    if (c >= 'a' && c <= 'f')
+        return 10 + c - 'a';
+    return -1;
+}
+
+// Reads the 4 hex digits after a \u
+static bool parseHex4(const char *p, uint32_t &cp)
+{
+    cp = 0;
+    for (int i = 0; i < 4; i++) {
+        int v = hexValue(p[i]);
+        if (v < 0)
+            return false;
+        cp = (cp << 4) | v;
+    }
+    return true;
+}
+
+bool JsonDoc::parseString(char *&p, const char *&s, uint32_t &len)
+{
+    // The unescaped string is never longer than the escaped one, so it is written over it
+    char *start = ++p;
+    char *w = start;
+    while (true) {
+        char c = *p;
+        if (c == '"') {
+            *w = 0; // At most where the closing quote was
+            p++;
+            s = start;
+            len = w - start;
+            return true;
+        }
+        // Tabs aren't allowed by the spec, but found in the wild
+        if ((uint8_t)c < ' ' && c != '\t')
+            return false; // Including the end of the text
+
+        if (c != '\\') {
+            *w++ = *p++;
+            continue;
+        }
+
+        p++;
+        switch (*p++) {
+        case '"':
+            *w++ = '"';
+            break;
+        case '\\':
+            *w++ = '\\';
+            break;
+        case '/':
+            *w++ = '/';
+            break;
+        case 'b':
+            *w++ = '\b';
+            break;
+        case 'f':
+            *w++ = '\f';
+            break;
+        case 'n':
+            *w++ = '\n';
+            break;
+        case 'r':
+            *w++ = '\r';
+            break;
+        case 't':
+            *w++ = '\t';
+            break;
+        case 'u': {
+            uint32_t cp;
+            if (!parseHex4(p, cp))
+                return false;
+            p += 4;
+            // A surrogate pair for what doesn't fit in 16 bits
+            uint32_t low;
+            if (cp >= 0xD800 && cp <= 0xDBFF && p[0] == '\\' && p[1] == 'u' && parseHex4(p + 2, low) && low >= 0xDC00 &&
+                low <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                p += 6;
+            }
+            // As UTF-8, which takes fewer bytes than the escape
+            if (cp < 0x80) {
+                *w++ = cp;
+            } else if (cp < 0x800) {
+                *w++ = 0xC0 | (cp >> 6);
+                *w++ = 0x80 | (cp & 0x3F);
+            } else if (cp < 0x10000) {
+                *w++ = 0xE0 | (cp >> 12);
+                *w++ = 0x80 | ((cp >> 6) & 0x3F);
+                *w++ = 0x80 | (cp & 0x3F);
+            } else {
+                *w++ = 0xF0 | (cp >> 18);
+                *w++ = 0x80 | ((cp >> 12) & 0x3F);
+                *w++ = 0x80 | ((cp >> 6) & 0x3F);
+                *w++ = 0x80 | (cp & 0x3F);
+            }
+            break;
+        }
+        default:
+            return false; // By the spec, only the above can be escaped
+        }
+    }
+}
+
+std::string JsonDoc::stringify(const JsonNode *value)
+{
+    std::string out;
+    if (value) {
+        out.reserve(256);
+        writeValue(out, value);
+    }
+    return out;
+}
+
+void JsonDoc::writeValue(std::string &out, const JsonNode *value)
+{
+    switch (value->type) {
+    case JSON_NULL:
+        out += "null";
+        break;
+    case JSON_BOOL:
+        out += value->boolean ? "true" : "false";
+        break;
+    case JSON_NUMBER: {
+        if (isinf(value->number) || isnan(value->number)) {
+            out += "null";
+        } else {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.15g", value->number);
+            out += buf;
+        }
+        break;
+    }
+    case JSON_STRING:
+        writeString(out, value->string, value->count);
+        break;
+    case JSON_ARRAY:
+    case JSON_OBJECT: {
+        bool isObject = value->type == JSON_OBJECT;
+        out += isObject ? '{' : '[';
+        for (const JsonMember *m = value->list.first; m; m = m->next) {
+            if (m != value->list.first)
+                out += ',';
+            if (isObject) {
+                writeString(out, m->key, m->keyLen);
+                out += ':';
+            }
+            writeValue(out, m->value);
+        }
+        out += isObject ? '}' : ']';
+        break;
+    }
+    }
+}
+
+void JsonDoc::writeString(std::string &out, const char *s, size_t len)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    out += '"';
+    for (size_t i = 0; i < len; i++) {
+        char c = s[i];
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\b':
+            out += "\\b";
+            break;
+        case '\f':
+            out += "\\f";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if ((uint8_t)c < ' ') {
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+            } else {
+                out += c; // UTF-8 goes through as it is
+            }
+        }
+    }
+    out += '"';
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// The first chunk of the arena of a document, enough for a typical downlink envelope or serialized packet
+#ifndef JSON_ARENA_CHUNK
+#define JSON_ARENA_CHUNK 1024
+#endif
+
+// Deeper documents are rejected instead of recursing further, nothing we exchange comes close
+#ifndef JSON_MAX_DEPTH
+#define JSON_MAX_DEPTH 16
+#endif
+
+// Parsed objects with at least this many members get a hash index, smaller ones are faster to scan
+#define JSON_INDEX_MIN 8
+
+/**
+ * A bump allocator. Allocations are never freed on their own, all of them go at once with the arena.
+ */
+class JsonArena
+{
+  public:
+    explicit JsonArena(size_t chunkSize = JSON_ARENA_CHUNK) : chunkSize(chunkSize) {}
+    ~JsonArena();
+
+    JsonArena(const JsonArena &) = delete;
+    JsonArena &operator=(const JsonArena &) = delete;
+
+    /// @return NULL if we are out of memory
+    void *alloc(size_t size);
+
+    /// A NUL terminated copy of len chars of s
+    char *copy(const char *s, size_t len);
+
+    /// Bytes handed out so far
+    size_t getUsed() const { return used; }
+
+  private:
+    struct Chunk {
+        Chunk *next;
+        size_t size;
+        size_t used;
+    };
+
+    Chunk *chunks = NULL;
+    size_t chunkSize;
+    size_t used = 0;
+};
+
+enum JsonType : uint8_t { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+struct JsonNode;
+
+/// A member of an object, or an element of an array (which has no key)
+struct JsonMember {
+    const char *key;
+    uint32_t keyLen;
+    JsonNode *value;
+    JsonMember *next;
+};
+
+/**
+ * A value in a JsonDoc. It lives in the arena of its document and must not be used after the document is gone.
+ */
+struct JsonNode {
+    JsonType type;
+    bool boolean;
+    uint32_t count;     // The length of a string, or the number of members or elements
+    uint32_t indexSize; // Slots in the index of an object
+    union {
+        double number;
+        const char *string; // NUL terminated, but may contain a NUL of its own if it was escaped
+        struct {
+            JsonMember *first;
+            JsonMember *last;
+            JsonMember **index; // Elements by position, or members by the hash of their key (linear probing)
+        } list;
+    };
+
+    bool isNull() const { return type == JSON_NULL; }
+    bool isBool() const { return type == JSON_BOOL; }
+    bool isNumber() const { return type == JSON_NUMBER; }
+    bool isString() const { return type == JSON_STRING; }
+    bool isArray() const { return type == JSON_ARRAY; }
+    bool isObject() const { return type == JSON_OBJECT; }
+
+    bool asBool() const { return type == JSON_BOOL && boolean; }
+    double asNumber() const { return type == JSON_NUMBER ? number : 0; }
+    const char *asString() const { return type == JSON_STRING ? string : ""; }
+
+    /// The length of a string, or the number of members or elements
+    size_t size() const { return type == JSON_STRING || type == JSON_ARRAY || type == JSON_OBJECT ? count : 0; }
+
+    /// Whether this is the string s
+    bool equals(const char *s) const;
+
+    /// @return the member of an object, or NULL if there is none (or this isn't an object)
+    const JsonNode *get(const char *key) const;
+
+    /// The same, but only if the member is of the given type
+    const JsonNode *get(const char *key, JsonType t) const;
+
+    /// @return the element of an array, or NULL if there is none (or this isn't an array)
+    const JsonNode *at(size_t i) const;
+
+    /// The first member or element, follow next for the others
+    const JsonMember *begin() const { return type == JSON_ARRAY || type == JSON_OBJECT ? list.first : NULL; }
+};
+
+/**
+ * A JSON document in a single arena, so parsing or building one takes a few large allocations instead of one per value, and
+ * everything is freed when the document goes away.
+ *
+ * Parsing is in place: strings are unescaped in the text they came from and point into it, so that text has to live as long
+ * as the document. Lookups in large objects go through a hash index, small ones are scanned.
+ */
+class JsonDoc
+{
+  public:
+    /**
+     * @param text NUL terminated JSON, which is modified (and used) by the result
+     * @return the root value, or NULL if the text isn't valid JSON or we ran out of memory
+     */
+    JsonNode *parse(char *text);
+
+    /// Parses a copy of text, made in the arena
+    JsonNode *parseCopy(const char *text);
+
+    JsonNode *object() { return newNode(JSON_OBJECT); }
+    JsonNode *array() { return newNode(JSON_ARRAY); }
+    JsonNode *null() { return newNode(JSON_NULL); }
+    JsonNode *boolean(bool b);
+    JsonNode *number(double n);
+    JsonNode *string(const char *s); // Copied into the arena
+
+    /// Adds a member to an object, the key is copied. A NULL object or value is ignored, so out of memory cascades quietly.
+    void add(JsonNode *object, const char *key, JsonNode *value) { append(object, JSON_OBJECT, key, value); }
+    void add(JsonNode *object, const char *key, const char *s) { add(object, key, string(s)); }
+    void add(JsonNode *object, const char *key, bool b) { add(object, key, boolean(b)); }
+    void add(JsonNode *object, const char *key, int n) { add(object, key, number(n)); }
+    void add(JsonNode *object, const char *key, unsigned int n) { add(object, key, number(n)); }
+    void add(JsonNode *object, const char *key, double n) { add(object, key, number(n)); }
+
+    /// Adds an element to an array
+    void push(JsonNode *array, JsonNode *value) { append(array, JSON_ARRAY, NULL, value); }
+
+    /// @return compact JSON for the value, or an empty string for NULL
+    static std::string stringify(const JsonNode *value);
+
+    const JsonArena &getArena() const { return arena; }
+
+  private:
+    JsonArena arena;
+
+    JsonNode *newNode(JsonType type);
+    void append(JsonNode *container, JsonType type, const char *key, JsonNode *value);
+    bool buildIndex(JsonNode *container);
+
+    JsonNode *parseValue(char *&p, uint8_t depth);
+    JsonNode *parseContainer(char *&p, JsonType type, uint8_t depth);
+    static bool parseNumber(char *&p, double &n);
+    static bool parseString(char *&p, const char *&s, uint32_t &len);
+    static void writeValue(std::string &out, const JsonNode *value);
+    static void writeString(std::string &out, const char *s, size_t len);
+};
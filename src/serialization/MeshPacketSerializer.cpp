@@ -1,5 +1,5 @@
 #include "MeshPacketSerializer.h"
-#include "JSON.h"
+#include "JsonDoc.h"
 #include "NodeDB.h"
 #include "mesh/generated/meshtastic/mqtt.pb.h"
 #include "mesh/generated/meshtastic/telemetry.pb.h"
@@ -13,13 +13,13 @@
 
 std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp, bool shouldLog)
 {
-    // the created jsonObj is immutable after creation, so
-    // we need to do the heavy lifting before assembling it.
+    // everything goes into the arena of doc, and is freed with it
+    JsonDoc doc;
     std::string msgType;
-    JSONObject jsonObj;
+    JsonNode *jsonObj = doc.object();
 
     if (mp->which_payload_variant == meshtastic_MeshPacket_decoded_tag) {
-        JSONObject msgPayload;
+        JsonNode *msgPayload = doc.object();
         switch (mp->decoded.portnum) {
         case meshtastic_PortNum_TEXT_MESSAGE_APP: {
             msgType = "text";
@@ -31,21 +31,21 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
             memcpy(payloadStr, mp->decoded.payload.bytes, mp->decoded.payload.size);
             payloadStr[mp->decoded.payload.size] = 0; // null terminated string
             // check if this is a JSON payload
-            JSONValue *json_value = JSON::Parse(payloadStr);
+            JsonNode *json_value = doc.parseCopy(payloadStr);
             if (json_value != NULL) {
                 if (shouldLog)
                     LOG_INFO("text message payload is of type json\n");
 
                 // if it is, then we can just use the json object
-                jsonObj["payload"] = json_value;
+                doc.add(jsonObj, "payload", json_value);
             } else {
                 // if it isn't, then we need to create a json object
                 // with the string as the value
                 if (shouldLog)
                     LOG_INFO("text message payload is of type plaintext\n");
 
-                msgPayload["text"] = new JSONValue(payloadStr);
-                jsonObj["payload"] = new JSONValue(msgPayload);
+                doc.add(msgPayload, "text", payloadStr);
+                doc.add(jsonObj, "payload", msgPayload);
             }
             break;
         }
@@ -57,41 +57,41 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
             if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_Telemetry_msg, &scratch)) {
                 decoded = &scratch;
                 if (decoded->which_variant == meshtastic_Telemetry_device_metrics_tag) {
-                    msgPayload["battery_level"] = new JSONValue((unsigned int)decoded->variant.device_metrics.battery_level);
-                    msgPayload["voltage"] = new JSONValue(decoded->variant.device_metrics.voltage);
-                    msgPayload["channel_utilization"] = new JSONValue(decoded->variant.device_metrics.channel_utilization);
-                    msgPayload["air_util_tx"] = new JSONValue(decoded->variant.device_metrics.air_util_tx);
-                    msgPayload["uptime_seconds"] = new JSONValue((unsigned int)decoded->variant.device_metrics.uptime_seconds);
+                    doc.add(msgPayload, "battery_level", (unsigned int)decoded->variant.device_metrics.battery_level);
+                    doc.add(msgPayload, "voltage", decoded->variant.device_metrics.voltage);
+                    doc.add(msgPayload, "channel_utilization", decoded->variant.device_metrics.channel_utilization);
+                    doc.add(msgPayload, "air_util_tx", decoded->variant.device_metrics.air_util_tx);
+                    doc.add(msgPayload, "uptime_seconds", (unsigned int)decoded->variant.device_metrics.uptime_seconds);
                 } else if (decoded->which_variant == meshtastic_Telemetry_environment_metrics_tag) {
-                    msgPayload["temperature"] = new JSONValue(decoded->variant.environment_metrics.temperature);
-                    msgPayload["relative_humidity"] = new JSONValue(decoded->variant.environment_metrics.relative_humidity);
-                    msgPayload["barometric_pressure"] = new JSONValue(decoded->variant.environment_metrics.barometric_pressure);
-                    msgPayload["gas_resistance"] = new JSONValue(decoded->variant.environment_metrics.gas_resistance);
-                    msgPayload["voltage"] = new JSONValue(decoded->variant.environment_metrics.voltage);
-                    msgPayload["current"] = new JSONValue(decoded->variant.environment_metrics.current);
-                    msgPayload["lux"] = new JSONValue(decoded->variant.environment_metrics.lux);
-                    msgPayload["white_lux"] = new JSONValue(decoded->variant.environment_metrics.white_lux);
-                    msgPayload["iaq"] = new JSONValue((uint)decoded->variant.environment_metrics.iaq);
-                    msgPayload["wind_speed"] = new JSONValue(decoded->variant.environment_metrics.wind_speed);
-                    msgPayload["wind_direction"] = new JSONValue((uint)decoded->variant.environment_metrics.wind_direction);
-                    msgPayload["wind_gust"] = new JSONValue(decoded->variant.environment_metrics.wind_gust);
-                    msgPayload["wind_lull"] = new JSONValue(decoded->variant.environment_metrics.wind_lull);
+                    doc.add(msgPayload, "temperature", decoded->variant.environment_metrics.temperature);
+                    doc.add(msgPayload, "relative_humidity", decoded->variant.environment_metrics.relative_humidity);
+                    doc.add(msgPayload, "barometric_pressure", decoded->variant.environment_metrics.barometric_pressure);
+                    doc.add(msgPayload, "gas_resistance", decoded->variant.environment_metrics.gas_resistance);
+                    doc.add(msgPayload, "voltage", decoded->variant.environment_metrics.voltage);
+                    doc.add(msgPayload, "current", decoded->variant.environment_metrics.current);
+                    doc.add(msgPayload, "lux", decoded->variant.environment_metrics.lux);
+                    doc.add(msgPayload, "white_lux", decoded->variant.environment_metrics.white_lux);
+                    doc.add(msgPayload, "iaq", (uint)decoded->variant.environment_metrics.iaq);
+                    doc.add(msgPayload, "wind_speed", decoded->variant.environment_metrics.wind_speed);
+                    doc.add(msgPayload, "wind_direction", (uint)decoded->variant.environment_metrics.wind_direction);
+                    doc.add(msgPayload, "wind_gust", decoded->variant.environment_metrics.wind_gust);
+                    doc.add(msgPayload, "wind_lull", decoded->variant.environment_metrics.wind_lull);
                 } else if (decoded->which_variant == meshtastic_Telemetry_air_quality_metrics_tag) {
-                    msgPayload["pm10"] = new JSONValue((unsigned int)decoded->variant.air_quality_metrics.pm10_standard);
-                    msgPayload["pm25"] = new JSONValue((unsigned int)decoded->variant.air_quality_metrics.pm25_standard);
-                    msgPayload["pm100"] = new JSONValue((unsigned int)decoded->variant.air_quality_metrics.pm100_standard);
-                    msgPayload["pm10_e"] = new JSONValue((unsigned int)decoded->variant.air_quality_metrics.pm10_environmental);
-                    msgPayload["pm25_e"] = new JSONValue((unsigned int)decoded->variant.air_quality_metrics.pm25_environmental);
-                    msgPayload["pm100_e"] = new JSONValue((unsigned int)decoded->variant.air_quality_metrics.pm100_environmental);
+                    doc.add(msgPayload, "pm10", (unsigned int)decoded->variant.air_quality_metrics.pm10_standard);
+                    doc.add(msgPayload, "pm25", (unsigned int)decoded->variant.air_quality_metrics.pm25_standard);
+                    doc.add(msgPayload, "pm100", (unsigned int)decoded->variant.air_quality_metrics.pm100_standard);
+                    doc.add(msgPayload, "pm10_e", (unsigned int)decoded->variant.air_quality_metrics.pm10_environmental);
+                    doc.add(msgPayload, "pm25_e", (unsigned int)decoded->variant.air_quality_metrics.pm25_environmental);
+                    doc.add(msgPayload, "pm100_e", (unsigned int)decoded->variant.air_quality_metrics.pm100_environmental);
                 } else if (decoded->which_variant == meshtastic_Telemetry_power_metrics_tag) {
-                    msgPayload["voltage_ch1"] = new JSONValue(decoded->variant.power_metrics.ch1_voltage);
-                    msgPayload["current_ch1"] = new JSONValue(decoded->variant.power_metrics.ch1_current);
-                    msgPayload["voltage_ch2"] = new JSONValue(decoded->variant.power_metrics.ch2_voltage);
-                    msgPayload["current_ch2"] = new JSONValue(decoded->variant.power_metrics.ch2_current);
-                    msgPayload["voltage_ch3"] = new JSONValue(decoded->variant.power_metrics.ch3_voltage);
-                    msgPayload["current_ch3"] = new JSONValue(decoded->variant.power_metrics.ch3_current);
+                    doc.add(msgPayload, "voltage_ch1", decoded->variant.power_metrics.ch1_voltage);
+                    doc.add(msgPayload, "current_ch1", decoded->variant.power_metrics.ch1_current);
+                    doc.add(msgPayload, "voltage_ch2", decoded->variant.power_metrics.ch2_voltage);
+                    doc.add(msgPayload, "current_ch2", decoded->variant.power_metrics.ch2_current);
+                    doc.add(msgPayload, "voltage_ch3", decoded->variant.power_metrics.ch3_voltage);
+                    doc.add(msgPayload, "current_ch3", decoded->variant.power_metrics.ch3_current);
                 }
-                jsonObj["payload"] = new JSONValue(msgPayload);
+                doc.add(jsonObj, "payload", msgPayload);
             } else if (shouldLog) {
                 LOG_ERROR("Error decoding protobuf for telemetry message!\n");
             }
@@ -104,12 +104,12 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
             memset(&scratch, 0, sizeof(scratch));
             if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_User_msg, &scratch)) {
                 decoded = &scratch;
-                msgPayload["id"] = new JSONValue(decoded->id);
-                msgPayload["longname"] = new JSONValue(decoded->long_name);
-                msgPayload["shortname"] = new JSONValue(decoded->short_name);
-                msgPayload["hardware"] = new JSONValue(decoded->hw_model);
-                msgPayload["role"] = new JSONValue((int)decoded->role);
-                jsonObj["payload"] = new JSONValue(msgPayload);
+                doc.add(msgPayload, "id", decoded->id);
+                doc.add(msgPayload, "longname", decoded->long_name);
+                doc.add(msgPayload, "shortname", decoded->short_name);
+                doc.add(msgPayload, "hardware", decoded->hw_model);
+                doc.add(msgPayload, "role", (int)decoded->role);
+                doc.add(jsonObj, "payload", msgPayload);
             } else if (shouldLog) {
                 LOG_ERROR("Error decoding protobuf for nodeinfo message!\n");
             }
@@ -123,38 +123,38 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
             if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_Position_msg, &scratch)) {
                 decoded = &scratch;
                 if ((int)decoded->time) {
-                    msgPayload["time"] = new JSONValue((unsigned int)decoded->time);
+                    doc.add(msgPayload, "time", (unsigned int)decoded->time);
                 }
                 if ((int)decoded->timestamp) {
-                    msgPayload["timestamp"] = new JSONValue((unsigned int)decoded->timestamp);
+                    doc.add(msgPayload, "timestamp", (unsigned int)decoded->timestamp);
                 }
-                msgPayload["latitude_i"] = new JSONValue((int)decoded->latitude_i);
-                msgPayload["longitude_i"] = new JSONValue((int)decoded->longitude_i);
+                doc.add(msgPayload, "latitude_i", (int)decoded->latitude_i);
+                doc.add(msgPayload, "longitude_i", (int)decoded->longitude_i);
                 if ((int)decoded->altitude) {
-                    msgPayload["altitude"] = new JSONValue((int)decoded->altitude);
+                    doc.add(msgPayload, "altitude", (int)decoded->altitude);
                 }
                 if ((int)decoded->ground_speed) {
-                    msgPayload["ground_speed"] = new JSONValue((unsigned int)decoded->ground_speed);
+                    doc.add(msgPayload, "ground_speed", (unsigned int)decoded->ground_speed);
                 }
                 if (int(decoded->ground_track)) {
-                    msgPayload["ground_track"] = new JSONValue((unsigned int)decoded->ground_track);
+                    doc.add(msgPayload, "ground_track", (unsigned int)decoded->ground_track);
                 }
                 if (int(decoded->sats_in_view)) {
-                    msgPayload["sats_in_view"] = new JSONValue((unsigned int)decoded->sats_in_view);
+                    doc.add(msgPayload, "sats_in_view", (unsigned int)decoded->sats_in_view);
                 }
                 if ((int)decoded->PDOP) {
-                    msgPayload["PDOP"] = new JSONValue((int)decoded->PDOP);
+                    doc.add(msgPayload, "PDOP", (int)decoded->PDOP);
                 }
                 if ((int)decoded->HDOP) {
-                    msgPayload["HDOP"] = new JSONValue((int)decoded->HDOP);
+                    doc.add(msgPayload, "HDOP", (int)decoded->HDOP);
                 }
                 if ((int)decoded->VDOP) {
-                    msgPayload["VDOP"] = new JSONValue((int)decoded->VDOP);
+                    doc.add(msgPayload, "VDOP", (int)decoded->VDOP);
                 }
                 if ((int)decoded->precision_bits) {
-                    msgPayload["precision_bits"] = new JSONValue((int)decoded->precision_bits);
+                    doc.add(msgPayload, "precision_bits", (int)decoded->precision_bits);
                 }
-                jsonObj["payload"] = new JSONValue(msgPayload);
+                doc.add(jsonObj, "payload", msgPayload);
             } else if (shouldLog) {
                 LOG_ERROR("Error decoding protobuf for position message!\n");
             }
@@ -167,14 +167,14 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
             memset(&scratch, 0, sizeof(scratch));
             if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_Waypoint_msg, &scratch)) {
                 decoded = &scratch;
-                msgPayload["id"] = new JSONValue((unsigned int)decoded->id);
-                msgPayload["name"] = new JSONValue(decoded->name);
-                msgPayload["description"] = new JSONValue(decoded->description);
-                msgPayload["expire"] = new JSONValue((unsigned int)decoded->expire);
-                msgPayload["locked_to"] = new JSONValue((unsigned int)decoded->locked_to);
-                msgPayload["latitude_i"] = new JSONValue((int)decoded->latitude_i);
-                msgPayload["longitude_i"] = new JSONValue((int)decoded->longitude_i);
-                jsonObj["payload"] = new JSONValue(msgPayload);
+                doc.add(msgPayload, "id", (unsigned int)decoded->id);
+                doc.add(msgPayload, "name", decoded->name);
+                doc.add(msgPayload, "description", decoded->description);
+                doc.add(msgPayload, "expire", (unsigned int)decoded->expire);
+                doc.add(msgPayload, "locked_to", (unsigned int)decoded->locked_to);
+                doc.add(msgPayload, "latitude_i", (int)decoded->latitude_i);
+                doc.add(msgPayload, "longitude_i", (int)decoded->longitude_i);
+                doc.add(jsonObj, "payload", msgPayload);
             } else if (shouldLog) {
                 LOG_ERROR("Error decoding protobuf for position message!\n");
             }
@@ -188,19 +188,19 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
             if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_NeighborInfo_msg,
                                      &scratch)) {
                 decoded = &scratch;
-                msgPayload["node_id"] = new JSONValue((unsigned int)decoded->node_id);
-                msgPayload["node_broadcast_interval_secs"] = new JSONValue((unsigned int)decoded->node_broadcast_interval_secs);
-                msgPayload["last_sent_by_id"] = new JSONValue((unsigned int)decoded->last_sent_by_id);
-                msgPayload["neighbors_count"] = new JSONValue(decoded->neighbors_count);
-                JSONArray neighbors;
+                doc.add(msgPayload, "node_id", (unsigned int)decoded->node_id);
+                doc.add(msgPayload, "node_broadcast_interval_secs", (unsigned int)decoded->node_broadcast_interval_secs);
+                doc.add(msgPayload, "last_sent_by_id", (unsigned int)decoded->last_sent_by_id);
+                doc.add(msgPayload, "neighbors_count", decoded->neighbors_count);
+                JsonNode *neighbors = doc.array();
                 for (uint8_t i = 0; i < decoded->neighbors_count; i++) {
-                    JSONObject neighborObj;
-                    neighborObj["node_id"] = new JSONValue((unsigned int)decoded->neighbors[i].node_id);
-                    neighborObj["snr"] = new JSONValue((int)decoded->neighbors[i].snr);
-                    neighbors.push_back(new JSONValue(neighborObj));
+                    JsonNode *neighborObj = doc.object();
+                    doc.add(neighborObj, "node_id", (unsigned int)decoded->neighbors[i].node_id);
+                    doc.add(neighborObj, "snr", (int)decoded->neighbors[i].snr);
+                    doc.push(neighbors, neighborObj);
                 }
-                msgPayload["neighbors"] = new JSONValue(neighbors);
-                jsonObj["payload"] = new JSONValue(msgPayload);
+                doc.add(msgPayload, "neighbors", neighbors);
+                doc.add(jsonObj, "payload", msgPayload);
             } else if (shouldLog) {
                 LOG_ERROR("Error decoding protobuf for neighborinfo message!\n");
             }
@@ -215,24 +215,24 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
                 if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_RouteDiscovery_msg,
                                          &scratch)) {
                     decoded = &scratch;
-                    JSONArray route; // Route this message took
+                    JsonNode *route = doc.array(); // Route this message took
                     // Lambda function for adding a long name to the route
-                    auto addToRoute = [](JSONArray *route, NodeNum num) {
+                    auto addToRoute = [&doc](JsonNode *route, NodeNum num) {
                         char long_name[40] = "Unknown";
                         meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(num);
                         bool name_known = node ? node->has_user : false;
                         if (name_known)
                             memcpy(long_name, node->user.long_name, sizeof(long_name));
-                        route->push_back(new JSONValue(long_name));
+                        doc.push(route, doc.string(long_name));
                     };
-                    addToRoute(&route, mp->to); // Started at the original transmitter (destination of response)
+                    addToRoute(route, mp->to); // Started at the original transmitter (destination of response)
                     for (uint8_t i = 0; i < decoded->route_count; i++) {
-                        addToRoute(&route, decoded->route[i]);
+                        addToRoute(route, decoded->route[i]);
                     }
-                    addToRoute(&route, mp->from); // Ended at the original destination (source of response)
+                    addToRoute(route, mp->from); // Ended at the original destination (source of response)
 
-                    msgPayload["route"] = new JSONValue(route);
-                    jsonObj["payload"] = new JSONValue(msgPayload);
+                    doc.add(msgPayload, "route", route);
+                    doc.add(jsonObj, "payload", msgPayload);
                 } else if (shouldLog) {
                     LOG_ERROR("Error decoding protobuf for traceroute message!\n");
                 }
@@ -244,8 +244,8 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
             char payloadStr[(mp->decoded.payload.size) + 1];
             memcpy(payloadStr, mp->decoded.payload.bytes, mp->decoded.payload.size);
             payloadStr[mp->decoded.payload.size] = 0; // null terminated string
-            msgPayload["text"] = new JSONValue(payloadStr);
-            jsonObj["payload"] = new JSONValue(msgPayload);
+            doc.add(msgPayload, "text", payloadStr);
+            doc.add(jsonObj, "payload", msgPayload);
             break;
         }
 #ifdef ARCH_ESP32
@@ -256,10 +256,10 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
             memset(&scratch, 0, sizeof(scratch));
             if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_Paxcount_msg, &scratch)) {
                 decoded = &scratch;
-                msgPayload["wifi_count"] = new JSONValue((unsigned int)decoded->wifi);
-                msgPayload["ble_count"] = new JSONValue((unsigned int)decoded->ble);
-                msgPayload["uptime"] = new JSONValue((unsigned int)decoded->uptime);
-                jsonObj["payload"] = new JSONValue(msgPayload);
+                doc.add(msgPayload, "wifi_count", (unsigned int)decoded->wifi);
+                doc.add(msgPayload, "ble_count", (unsigned int)decoded->ble);
+                doc.add(msgPayload, "uptime", (unsigned int)decoded->uptime);
+                doc.add(jsonObj, "payload", msgPayload);
             } else if (shouldLog) {
                 LOG_ERROR("Error decoding protobuf for Paxcount message!\n");
             }
@@ -275,13 +275,13 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
                 decoded = &scratch;
                 if (decoded->type == meshtastic_HardwareMessage_Type_GPIOS_CHANGED) {
                     msgType = "gpios_changed";
-                    msgPayload["gpio_value"] = new JSONValue((unsigned int)decoded->gpio_value);
-                    jsonObj["payload"] = new JSONValue(msgPayload);
+                    doc.add(msgPayload, "gpio_value", (unsigned int)decoded->gpio_value);
+                    doc.add(jsonObj, "payload", msgPayload);
                 } else if (decoded->type == meshtastic_HardwareMessage_Type_READ_GPIOS_REPLY) {
                     msgType = "gpios_read_reply";
-                    msgPayload["gpio_value"] = new JSONValue((unsigned int)decoded->gpio_value);
-                    msgPayload["gpio_mask"] = new JSONValue((unsigned int)decoded->gpio_mask);
-                    jsonObj["payload"] = new JSONValue(msgPayload);
+                    doc.add(msgPayload, "gpio_value", (unsigned int)decoded->gpio_value);
+                    doc.add(msgPayload, "gpio_mask", (unsigned int)decoded->gpio_mask);
+                    doc.add(jsonObj, "payload", msgPayload);
                 }
             } else if (shouldLog) {
                 LOG_ERROR("Error decoding protobuf for RemoteHardware message!\n");
@@ -296,61 +296,56 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
         LOG_WARN("Couldn't convert encrypted payload of MeshPacket to JSON\n");
     }
 
-    jsonObj["id"] = new JSONValue((unsigned int)mp->id);
-    jsonObj["timestamp"] = new JSONValue((unsigned int)mp->rx_time);
-    jsonObj["to"] = new JSONValue((unsigned int)mp->to);
-    jsonObj["from"] = new JSONValue((unsigned int)mp->from);
-    jsonObj["channel"] = new JSONValue((unsigned int)mp->channel);
-    jsonObj["type"] = new JSONValue(msgType.c_str());
-    jsonObj["sender"] = new JSONValue(owner.id);
+    doc.add(jsonObj, "id", (unsigned int)mp->id);
+    doc.add(jsonObj, "timestamp", (unsigned int)mp->rx_time);
+    doc.add(jsonObj, "to", (unsigned int)mp->to);
+    doc.add(jsonObj, "from", (unsigned int)mp->from);
+    doc.add(jsonObj, "channel", (unsigned int)mp->channel);
+    doc.add(jsonObj, "type", msgType.c_str());
+    doc.add(jsonObj, "sender", owner.id);
     if (mp->rx_rssi != 0)
-        jsonObj["rssi"] = new JSONValue((int)mp->rx_rssi);
+        doc.add(jsonObj, "rssi", (int)mp->rx_rssi);
     if (mp->rx_snr != 0)
-        jsonObj["snr"] = new JSONValue((float)mp->rx_snr);
+        doc.add(jsonObj, "snr", (float)mp->rx_snr);
     if (mp->hop_start != 0 && mp->hop_limit <= mp->hop_start) {
-        jsonObj["hops_away"] = new JSONValue((unsigned int)(mp->hop_start - mp->hop_limit));
-        jsonObj["hop_start"] = new JSONValue((unsigned int)(mp->hop_start));
+        doc.add(jsonObj, "hops_away", (unsigned int)(mp->hop_start - mp->hop_limit));
+        doc.add(jsonObj, "hop_start", (unsigned int)(mp->hop_start));
     }
 
     // serialize and write it to the stream
-    JSONValue *value = new JSONValue(jsonObj);
-    std::string jsonStr = value->Stringify();
+    std::string jsonStr = JsonDoc::stringify(jsonObj);
 
     if (shouldLog)
         LOG_INFO("serialized json message: %s\n", jsonStr.c_str());
 
-    delete value;
     return jsonStr;
 }
 
 std::string MeshPacketSerializer::JsonSerializeEncrypted(const meshtastic_MeshPacket *mp)
 {
-    JSONObject jsonObj;
+    JsonDoc doc;
+    JsonNode *jsonObj = doc.object();
 
-    jsonObj["id"] = new JSONValue((unsigned int)mp->id);
-    jsonObj["time_ms"] = new JSONValue((double)millis());
-    jsonObj["timestamp"] = new JSONValue((unsigned int)mp->rx_time);
-    jsonObj["to"] = new JSONValue((unsigned int)mp->to);
-    jsonObj["from"] = new JSONValue((unsigned int)mp->from);
-    jsonObj["channel"] = new JSONValue((unsigned int)mp->channel);
-    jsonObj["want_ack"] = new JSONValue(mp->want_ack);
+    doc.add(jsonObj, "id", (unsigned int)mp->id);
+    doc.add(jsonObj, "time_ms", (double)millis());
+    doc.add(jsonObj, "timestamp", (unsigned int)mp->rx_time);
+    doc.add(jsonObj, "to", (unsigned int)mp->to);
+    doc.add(jsonObj, "from", (unsigned int)mp->from);
+    doc.add(jsonObj, "channel", (unsigned int)mp->channel);
+    doc.add(jsonObj, "want_ack", mp->want_ack);
 
     if (mp->rx_rssi != 0)
-        jsonObj["rssi"] = new JSONValue((int)mp->rx_rssi);
+        doc.add(jsonObj, "rssi", (int)mp->rx_rssi);
     if (mp->rx_snr != 0)
-        jsonObj["snr"] = new JSONValue((float)mp->rx_snr);
+        doc.add(jsonObj, "snr", (float)mp->rx_snr);
     if (mp->hop_start != 0 && mp->hop_limit <= mp->hop_start) {
-        jsonObj["hops_away"] = new JSONValue((unsigned int)(mp->hop_start - mp->hop_limit));
-        jsonObj["hop_start"] = new JSONValue((unsigned int)(mp->hop_start));
+        doc.add(jsonObj, "hops_away", (unsigned int)(mp->hop_start - mp->hop_limit));
+        doc.add(jsonObj, "hop_start", (unsigned int)(mp->hop_start));
     }
-    jsonObj["size"] = new JSONValue((unsigned int)mp->encrypted.size);
+    doc.add(jsonObj, "size", (unsigned int)mp->encrypted.size);
     auto encryptedStr = bytesToHex(mp->encrypted.bytes, mp->encrypted.size);
-    jsonObj["bytes"] = new JSONValue(encryptedStr.c_str());
+    doc.add(jsonObj, "bytes", encryptedStr.c_str());
 
     // serialize and write it to the stream
-    JSONValue *value = new JSONValue(jsonObj);
-    std::string jsonStr = value->Stringify();
-
-    delete value;
-    return jsonStr;
+    return JsonDoc::stringify(jsonObj);
 }
\ No newline at end of file
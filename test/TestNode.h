@@ -0,0 +1,33 @@
+#pragma once
+
+#include "MeshRadio.h"
+#include "NodeDB.h"
+#include "RouteCache.h"
+#include "Router.h"
+#include "airtime.h"
+#include "modules/RoutingModule.h"
+
+/**
+ * The globals shared by the tests that run packets through a Router, included as "../TestNode.h".
+ *
+ * Call initTestNode() first, then set up the radios (reconfigure() needs the region) and hand the router to startTestRouter().
+ */
+
+/// A node in the default region, without duty cycle limits so the tests can send as fast as they like
+inline void initTestNode(meshtastic_Config_DeviceConfig_Role role = meshtastic_Config_DeviceConfig_Role_CLIENT)
+{
+    nodeDB = new NodeDB;
+    config.device.role = role;
+    config.lora.override_duty_cycle = true;
+
+    airTime = new AirTime();
+    routeCache = new RouteCache();
+    initRegion();
+}
+
+/// Makes r the router, with the routing module that acks and relays for it
+inline void startTestRouter(Router *r)
+{
+    router = r;
+    routingModule = new RoutingModule();
+}
@@ -0,0 +1,173 @@
+#include "Channels.h"
+#include "MeshService.h"
+#include "NodeDB.h"
+#include "mesh/api/EpollServerAPI.h"
+#include "mesh/api/WiFiServerAPI.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#if HAS_EPOLL_API_SERVER
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#define TEST_PORT 14403
+#define NUM_CLIENTS 5
+#define CONFIG_ID 1234
+
+// What one test client has received so far
+struct TestClient {
+    int fd;
+    std::vector<uint8_t> rx;
+};
+
+static TestClient clients[NUM_CLIENTS];
+
+// Let the main loop run, until done() or we give up
+template <typename F> static bool runUntil(F done, uint32_t timeoutMs = 5000)
+{
+    uint32_t start = millis();
+    while (!done()) {
+        if (millis() - start > timeoutMs)
+            return false;
+        concurrency::mainController.run();
+        delay(1);
+    }
+    return true;
+}
+
+static int connectClient()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT_EQUAL(0, connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+    return fd;
+}
+
+static void sendToRadio(int fd, const meshtastic_ToRadio &toRadio)
+{
+    uint8_t buf[MAX_STREAM_BUF_SIZE];
+    size_t len = pb_encode_to_bytes(buf + 4, sizeof(buf) - 4, &meshtastic_ToRadio_msg, &toRadio);
+    buf[0] = 0x94;
+    buf[1] = 0xc3;
+    buf[2] = len >> 8;
+    buf[3] = len & 0xff;
+    TEST_ASSERT_EQUAL(len + 4, send(fd, buf, len + 4, 0));
+}
+
+// Read whatever arrived and look for a FromRadio that matches
+template <typename F> static bool received(TestClient &c, F matches)
+{
+    uint8_t buf[1024];
+    ssize_t got;
+    while ((got = recv(c.fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+        c.rx.insert(c.rx.end(), buf, buf + got);
+
+    while (c.rx.size() >= 4) {
+        size_t len = (c.rx[2] << 8) | c.rx[3];
+        if (c.rx.size() < len + 4)
+            break;
+        meshtastic_FromRadio fromRadio = meshtastic_FromRadio_init_zero;
+        bool decoded = pb_decode_from_bytes(c.rx.data() + 4, len, &meshtastic_FromRadio_msg, &fromRadio);
+        c.rx.erase(c.rx.begin(), c.rx.begin() + len + 4);
+        if (decoded && matches(fromRadio))
+            return true;
+    }
+    return false;
+}
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_accepts_many_clients(void)
+{
+    for (int i = 0; i < NUM_CLIENTS; i++)
+        clients[i].fd = connectClient();
+    TEST_ASSERT_TRUE(runUntil([] { return epollServerPort->numClients() == NUM_CLIENTS; }));
+}
+
+void test_every_client_gets_config(void)
+{
+    meshtastic_ToRadio toRadio = meshtastic_ToRadio_init_zero;
+    toRadio.which_payload_variant = meshtastic_ToRadio_want_config_id_tag;
+    toRadio.want_config_id = CONFIG_ID;
+    for (int i = 0; i < NUM_CLIENTS; i++)
+        sendToRadio(clients[i].fd, toRadio);
+
+    for (int i = 0; i < NUM_CLIENTS; i++) {
+        TEST_ASSERT_TRUE(runUntil([i] {
+            return received(clients[i], [](const meshtastic_FromRadio &f) {
+                return f.which_payload_variant == meshtastic_FromRadio_config_complete_id_tag &&
+                       f.config_complete_id == CONFIG_ID;
+            });
+        }));
+    }
+}
+
+void test_every_client_gets_packets(void)
+{
+    meshtastic_MeshPacket *p = packetPool.allocZeroed();
+    p->from = 0x1234;
+    p->to = NODENUM_BROADCAST;
+    p->id = 42;
+    p->which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+    service->sendToPhone(p);
+
+    for (int i = 0; i < NUM_CLIENTS; i++) {
+        TEST_ASSERT_TRUE(runUntil([i] {
+            return received(clients[i], [](const meshtastic_FromRadio &f) {
+                return f.which_payload_variant == meshtastic_FromRadio_packet_tag && f.packet.id == 42;
+            });
+        }));
+    }
+}
+
+void test_drops_closed_clients(void)
+{
+    for (int i = 0; i < NUM_CLIENTS; i++)
+        close(clients[i].fd);
+    TEST_ASSERT_TRUE(runUntil([] { return epollServerPort->numClients() == 0; }));
+}
+#endif
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+#if HAS_EPOLL_API_SERVER
+    nodeDB = new NodeDB;
+    channels.initDefaults();
+    channels.onConfigChanged();
+    service = new MeshService();
+    initApiServer(TEST_PORT);
+#endif
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+#if HAS_EPOLL_API_SERVER
+    RUN_TEST(test_accepts_many_clients);
+    RUN_TEST(test_every_client_gets_config);
+    RUN_TEST(test_every_client_gets_packets);
+    RUN_TEST(test_drops_closed_clients);
+#endif
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
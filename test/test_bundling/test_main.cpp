@@ -0,0 +1,163 @@
+#include "mesh-pb-constants.h"
+#include "mesh/PacketBundler.h"
+#include "mesh/Router.h"
+#include "mesh/generated/meshtastic/telemetry.pb.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+static meshtastic_MeshPacket makePacket(meshtastic_PortNum portnum, uint32_t id, uint8_t size)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_default;
+    p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p.id = id;
+    p.decoded.portnum = portnum;
+    p.decoded.payload.size = size;
+    for (uint8_t i = 0; i < size; i++)
+        p.decoded.payload.bytes[i] = id + i;
+    return p;
+}
+
+static meshtastic_MeshPacket makeTelemetry(pb_size_t variant)
+{
+    meshtastic_Telemetry t = meshtastic_Telemetry_init_zero;
+    t.time = 1000;
+    t.which_variant = variant;
+    if (variant == meshtastic_Telemetry_device_metrics_tag) {
+        t.variant.device_metrics.has_battery_level = true;
+        t.variant.device_metrics.battery_level = 80;
+    } else {
+        t.variant.environment_metrics.has_temperature = true;
+        t.variant.environment_metrics.temperature = 21.5f;
+    }
+    meshtastic_MeshPacket p = makePacket(meshtastic_PortNum_TELEMETRY_APP, 1, 0);
+    p.decoded.payload.size =
+        pb_encode_to_bytes(p.decoded.payload.bytes, sizeof(p.decoded.payload.bytes), &meshtastic_Telemetry_msg, &t);
+    return p;
+}
+
+void test_roundtrip(void)
+{
+    meshtastic_MeshPacket position = makePacket(meshtastic_PortNum_POSITION_APP, 0x12345678, 20);
+    meshtastic_MeshPacket nodeInfo = makePacket(meshtastic_PortNum_NODEINFO_APP, 0x9abcdef0, 60);
+
+    meshtastic_MeshPacket bundle = makePacket(BUNDLE_PORTNUM, 1, 0);
+    uint8_t *out = bundle.decoded.payload.bytes;
+    out += PacketBundler::writeRecord(out, &position);
+    out += PacketBundler::writeRecord(out, &nodeInfo);
+    bundle.decoded.payload.size = out - bundle.decoded.payload.bytes;
+    TEST_ASSERT_EQUAL(PacketBundler::recordSize(&position) + PacketBundler::recordSize(&nodeInfo),
+                      bundle.decoded.payload.size);
+
+    size_t offset = 0;
+    meshtastic_MeshPacket record = bundle;
+    const meshtastic_MeshPacket *expected[] = {&position, &nodeInfo};
+    for (const meshtastic_MeshPacket *e : expected) {
+        TEST_ASSERT_TRUE(PacketBundler::unbundleNext(bundle, offset, record));
+        TEST_ASSERT_EQUAL(e->decoded.portnum, record.decoded.portnum);
+        TEST_ASSERT_EQUAL_UINT32(e->id, record.id);
+        TEST_ASSERT_EQUAL(e->decoded.payload.size, record.decoded.payload.size);
+        TEST_ASSERT_EQUAL_MEMORY(e->decoded.payload.bytes, record.decoded.payload.bytes, e->decoded.payload.size);
+    }
+    TEST_ASSERT_FALSE(PacketBundler::unbundleNext(bundle, offset, record));
+}
+
+void test_rejects_truncated_bundle(void)
+{
+    meshtastic_MeshPacket position = makePacket(meshtastic_PortNum_POSITION_APP, 7, 20);
+    meshtastic_MeshPacket bundle = makePacket(BUNDLE_PORTNUM, 1, 0);
+    bundle.decoded.payload.size = PacketBundler::writeRecord(bundle.decoded.payload.bytes, &position) - 1;
+
+    size_t offset = 0;
+    meshtastic_MeshPacket record = bundle;
+    TEST_ASSERT_FALSE(PacketBundler::unbundleNext(bundle, offset, record));
+    TEST_ASSERT_EQUAL(0, offset);
+}
+
+void test_drops_forged_records(void)
+{
+    meshtastic_MeshPacket admin = makePacket(meshtastic_PortNum_ADMIN_APP, 1, 10);
+    meshtastic_MeshPacket position = makePacket(meshtastic_PortNum_POSITION_APP, 2, 20);
+    meshtastic_MeshPacket ack = makePacket(meshtastic_PortNum_ROUTING_APP, 3, 2);
+    TEST_ASSERT_FALSE(PacketBundler::isBundlePort(meshtastic_PortNum_ADMIN_APP));
+    TEST_ASSERT_FALSE(PacketBundler::isBundlePort(meshtastic_PortNum_ROUTING_APP));
+
+    meshtastic_MeshPacket bundle = makePacket(BUNDLE_PORTNUM, 1, 0);
+    uint8_t *out = bundle.decoded.payload.bytes;
+    out += PacketBundler::writeRecord(out, &admin);
+    out += PacketBundler::writeRecord(out, &position);
+    out += PacketBundler::writeRecord(out, &ack);
+    bundle.decoded.payload.size = out - bundle.decoded.payload.bytes;
+
+    // Only the position comes out, the admin message and the ack are skipped
+    size_t offset = 0;
+    meshtastic_MeshPacket record = bundle;
+    TEST_ASSERT_TRUE(PacketBundler::unbundleNext(bundle, offset, record));
+    TEST_ASSERT_EQUAL(meshtastic_PortNum_POSITION_APP, record.decoded.portnum);
+    TEST_ASSERT_EQUAL_UINT32(2, record.id);
+    TEST_ASSERT_FALSE(PacketBundler::unbundleNext(bundle, offset, record));
+}
+
+void test_replaces_same_kind_only(void)
+{
+    meshtastic_MeshPacket position = makePacket(meshtastic_PortNum_POSITION_APP, 1, 20);
+    meshtastic_MeshPacket newerPosition = makePacket(meshtastic_PortNum_POSITION_APP, 2, 20);
+    meshtastic_MeshPacket nodeInfo = makePacket(meshtastic_PortNum_NODEINFO_APP, 3, 20);
+    TEST_ASSERT_TRUE(PacketBundler::replaces(&newerPosition, &position));
+    TEST_ASSERT_FALSE(PacketBundler::replaces(&nodeInfo, &position));
+
+    // Telemetry only replaces telemetry with the same kind of metrics
+    meshtastic_MeshPacket device = makeTelemetry(meshtastic_Telemetry_device_metrics_tag);
+    meshtastic_MeshPacket newerDevice = makeTelemetry(meshtastic_Telemetry_device_metrics_tag);
+    meshtastic_MeshPacket environment = makeTelemetry(meshtastic_Telemetry_environment_metrics_tag);
+    TEST_ASSERT_TRUE(PacketBundler::replaces(&newerDevice, &device));
+    TEST_ASSERT_FALSE(PacketBundler::replaces(&environment, &device));
+    TEST_ASSERT_FALSE(PacketBundler::replaces(&device, &environment));
+}
+
+void test_capability_latched(void)
+{
+    meshtastic_MeshPacket p = makePacket(meshtastic_PortNum_POSITION_APP, 1, 0);
+    p.from = 0x3000;
+    p.decoded.has_bitfield = true;
+    p.decoded.bitfield = BITFIELD_BUNDLE_MASK;
+    learnBundlingSupported(&p);
+    TEST_ASSERT_TRUE(isBundlingSupported(0x3000));
+
+    p.decoded.bitfield = 0;
+    learnBundlingSupported(&p);
+    TEST_ASSERT_TRUE(isBundlingSupported(0x3000));
+
+    p.decoded.portnum = meshtastic_PortNum_NODEINFO_APP;
+    learnBundlingSupported(&p);
+    TEST_ASSERT_FALSE(isBundlingSupported(0x3000));
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_roundtrip);
+    RUN_TEST(test_rejects_truncated_bundle);
+    RUN_TEST(test_drops_forged_records);
+    RUN_TEST(test_replaces_same_kind_only);
+    RUN_TEST(test_capability_latched);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,175 @@
+#include "mesh/PayloadCompression.h"
+#include "mesh/Router.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#define BENCH_ROUNDS 20
+
+// Typical traffic on a public channel
+static const char *corpus[] = {
+    "hi",
+    "ok",
+    "Hello from the north side, anyone copy?",
+    "Copy, 2 hops, SNR -7",
+    "Good morning everyone!",
+    "On my way, ETA 15 min",
+    "Testing 1 2 3",
+    "Is the repeater on the hill back up?",
+    "Yes, it came back about an hour ago after the power was restored.",
+    "Thanks! Signal is much better now.",
+    "Meet at the trailhead parking lot at 9am tomorrow",
+    "Weather looks good for the hike, bring water and a jacket though",
+    "Battery at 45%, heading home",
+    "Can you hear me now?",
+    "Loud and clear",
+    "Anyone going to the meetup on Saturday? We could set up a node on the roof of the community center.",
+    "lol",
+    "Checking in from downtown, 3 nodes visible",
+    "Roger that",
+    "Need a ride back, I'm at the north gate",
+    "Great work on the new antenna, range is way up",
+    "https://meshtastic.org/docs/getting-started/",
+    "Temperature dropped to 12C, wind picking up from the west",
+    "I'll relay the message to the group when I'm back in range",
+};
+#define CORPUS_SIZE (sizeof(corpus) / sizeof(corpus[0]))
+
+static void setText(meshtastic_Data &d, const char *text)
+{
+    memset(&d, 0, sizeof(d));
+    d.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+    d.payload.size = strlen(text);
+    memcpy(d.payload.bytes, text, d.payload.size);
+}
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_roundtrip(void)
+{
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        meshtastic_Data d;
+        setText(d, corpus[i]);
+        if (compressPayload(d)) {
+            TEST_ASSERT_TRUE(d.bitfield & BITFIELD_COMPRESSED_MASK);
+            TEST_ASSERT_LESS_THAN(strlen(corpus[i]), d.payload.size);
+            TEST_ASSERT_TRUE(decompressPayload(d));
+            TEST_ASSERT_FALSE(d.bitfield & BITFIELD_COMPRESSED_MASK);
+        }
+        TEST_ASSERT_EQUAL(strlen(corpus[i]), d.payload.size);
+        TEST_ASSERT_EQUAL_MEMORY(corpus[i], d.payload.bytes, d.payload.size);
+    }
+}
+
+void test_fallback_when_not_smaller(void)
+{
+    // Random bytes grow under unishox2, so they must go out as they are
+    meshtastic_Data d;
+    memset(&d, 0, sizeof(d));
+    randomSeed(1);
+    d.payload.size = 100;
+    for (int i = 0; i < 100; i++)
+        d.payload.bytes[i] = random(256);
+    uint8_t original[100];
+    memcpy(original, d.payload.bytes, sizeof(original));
+
+    TEST_ASSERT_FALSE(compressPayload(d));
+    TEST_ASSERT_FALSE(d.bitfield & BITFIELD_COMPRESSED_MASK);
+    TEST_ASSERT_EQUAL(100, d.payload.size);
+    TEST_ASSERT_EQUAL_MEMORY(original, d.payload.bytes, sizeof(original));
+}
+
+void test_capability(void)
+{
+    TEST_ASSERT_FALSE(isCompressionSupported(0x1234));
+    setCompressionSupported(0x1234, true);
+    setCompressionSupported(0x1000, true);
+    TEST_ASSERT_TRUE(isCompressionSupported(0x1234));
+    TEST_ASSERT_TRUE(isCompressionSupported(0x1000));
+    setCompressionSupported(0x1234, false);
+    TEST_ASSERT_FALSE(isCompressionSupported(0x1234));
+    TEST_ASSERT_TRUE(isCompressionSupported(0x1000));
+}
+
+void test_capability_latched(void)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_default;
+    p.from = 0x2000;
+    p.decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+    p.decoded.has_bitfield = true;
+    p.decoded.bitfield = BITFIELD_COMPRESSION_MASK;
+    learnCompressionSupported(&p);
+    TEST_ASSERT_TRUE(isCompressionSupported(0x2000));
+
+    // An older packet without the bit doesn't take it back
+    p.decoded.has_bitfield = false;
+    p.decoded.bitfield = 0;
+    learnCompressionSupported(&p);
+    TEST_ASSERT_TRUE(isCompressionSupported(0x2000));
+
+    // Its NodeInfo without the bit does
+    p.decoded.portnum = meshtastic_PortNum_NODEINFO_APP;
+    learnCompressionSupported(&p);
+    TEST_ASSERT_FALSE(isCompressionSupported(0x2000));
+}
+
+void test_benchmark(void)
+{
+    uint32_t originalBytes = 0, compressedBytes = 0, compressUs = 0, decompressUs = 0;
+
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < CORPUS_SIZE; i++) {
+            meshtastic_Data d;
+            setText(d, corpus[i]);
+            if (round == 0)
+                originalBytes += d.payload.size;
+
+            uint32_t start = micros();
+            bool compressed = compressPayload(d);
+            compressUs += micros() - start;
+            if (round == 0)
+                compressedBytes += d.payload.size;
+
+            if (compressed) {
+                start = micros();
+                decompressPayload(d);
+                decompressUs += micros() - start;
+            }
+        }
+    }
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%u messages: %lu -> %lu bytes (%lu%% saved), compress %luus, decompress %luus per message",
+             (unsigned)CORPUS_SIZE, (unsigned long)originalBytes, (unsigned long)compressedBytes,
+             (unsigned long)(100 - compressedBytes * 100 / originalBytes),
+             (unsigned long)(compressUs / (BENCH_ROUNDS * CORPUS_SIZE)),
+             (unsigned long)(decompressUs / (BENCH_ROUNDS * CORPUS_SIZE)));
+    TEST_MESSAGE(msg);
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_roundtrip);
+    RUN_TEST(test_fallback_when_not_smaller);
+    RUN_TEST(test_capability);
+    RUN_TEST(test_capability_latched);
+    RUN_TEST(test_benchmark);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -2,6 +2,11 @@
 
 #include <unity.h>
 
+#define BENCH_ROUNDS 2000
+
+// The portable implementations, to check and time a platform engine against
+static CryptoEngine portable;
+
 void HexToBytes(uint8_t *result, const std::string hex, size_t len = 0)
 {
     if (len) {
@@ -125,6 +130,137 @@ void test_AES_CTR(void)
     TEST_ASSERT_EQUAL_MEMORY(expected, plain, 16);
 }
 
+static void fillRandom(uint8_t *bytes, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        bytes[i] = random(256);
+}
+
+// aes-ccm.cpp always goes through the global crypto, so point that at the engine we want
+static bool ccmEncryptWith(CryptoEngine *engine, const uint8_t *key, const uint8_t *nonce, const uint8_t *plain, size_t len,
+                           uint8_t *out, uint8_t *auth)
+{
+    CryptoEngine *was = crypto;
+    crypto = engine;
+    bool ok = engine->ccmEncrypt(key, 32, nonce, 8, plain, len, out, auth);
+    crypto = was;
+    return ok;
+}
+
+void test_matches_portable(void)
+{
+    CryptoKey k;
+    uint8_t nonce[16], nonceCopy[16], a[MAX_BLOCKSIZE], b[MAX_BLOCKSIZE];
+    for (int round = 0; round < 50; round++) {
+        size_t len = 1 + random(MAX_BLOCKSIZE);
+        k.length = round % 2 ? 16 : 32;
+        fillRandom(k.bytes, k.length);
+        fillRandom(nonce, 12);
+        memset(nonce + 12, 0, 4); // The block counter, see CryptoEngine::initNonce()
+        memcpy(nonceCopy, nonce, sizeof(nonce));
+        fillRandom(a, len);
+        memcpy(b, a, len);
+        crypto->encryptAESCtr(k, nonce, len, a);
+        portable.encryptAESCtr(k, nonceCopy, len, b);
+        TEST_ASSERT_EQUAL_MEMORY(b, a, len);
+    }
+
+    uint8_t key[32], ccmNonce[13], plain[200], c1[216], c2[216], t1[8], t2[8], back[200];
+    for (int round = 0; round < 50; round++) {
+        size_t len = 1 + random(sizeof(plain));
+        fillRandom(key, sizeof(key));
+        fillRandom(ccmNonce, sizeof(ccmNonce));
+        fillRandom(plain, len);
+        TEST_ASSERT(ccmEncryptWith(crypto, key, ccmNonce, plain, len, c1, t1));
+        TEST_ASSERT(ccmEncryptWith(&portable, key, ccmNonce, plain, len, c2, t2));
+        TEST_ASSERT_EQUAL_MEMORY(c2, c1, len);
+        TEST_ASSERT_EQUAL_MEMORY(t2, t1, 8);
+
+        TEST_ASSERT(crypto->ccmDecrypt(key, 32, ccmNonce, 8, c2, len, t2, back));
+        TEST_ASSERT_EQUAL_MEMORY(plain, back, len);
+        t2[0] ^= 1;
+        TEST_ASSERT(!crypto->ccmDecrypt(key, 32, ccmNonce, 8, c2, len, t2, back));
+    }
+}
+
+// Microseconds per packet of AES256-CTR
+static uint32_t benchCtr(CryptoEngine *engine)
+{
+    CryptoKey k;
+    k.length = 32;
+    uint8_t nonce[16] = {0}, bytes[meshtastic_Constants_DATA_PAYLOAD_LEN];
+    fillRandom(k.bytes, sizeof(k.bytes));
+    fillRandom(bytes, sizeof(bytes));
+    uint32_t start = micros();
+    for (int i = 0; i < BENCH_ROUNDS; i++)
+        engine->encryptAESCtr(k, nonce, sizeof(bytes), bytes);
+    return (micros() - start) / BENCH_ROUNDS;
+}
+
+// Microseconds per packet of AES256-CCM, as used for PKI packets
+static uint32_t benchCcm(CryptoEngine *engine, size_t len)
+{
+    uint8_t key[32], nonce[13], plain[meshtastic_Constants_DATA_PAYLOAD_LEN], out[sizeof(plain) + 16], auth[8];
+    fillRandom(key, sizeof(key));
+    fillRandom(nonce, sizeof(nonce));
+    fillRandom(plain, len);
+    uint32_t start = micros();
+    for (int i = 0; i < BENCH_ROUNDS; i++)
+        ccmEncryptWith(engine, key, nonce, plain, len, out, auth);
+    return (micros() - start) / BENCH_ROUNDS;
+}
+
+void test_benchmark(void)
+{
+    uint32_t ctrEngine = benchCtr(crypto), ctrPortable = benchCtr(&portable);
+    uint32_t ccmEngine = benchCcm(crypto, 200), ccmPortable = benchCcm(&portable, 200);
+
+    char msg[120];
+    snprintf(msg, sizeof(msg), "AES-CTR %luus vs %luus portable, AES-CCM %luus vs %luus portable per packet",
+             (unsigned long)ctrEngine, (unsigned long)ctrPortable, (unsigned long)ccmEngine, (unsigned long)ccmPortable);
+    TEST_MESSAGE(msg);
+}
+
+void test_ccm_benchmark(void)
+{
+    const size_t sizes[] = {16, 64, 128, meshtastic_Constants_DATA_PAYLOAD_LEN};
+    char msg[120];
+    for (size_t len : sizes) {
+        snprintf(msg, sizeof(msg), "AES-CCM %u bytes: %luus portable, %luus engine", (unsigned)len,
+                 (unsigned long)benchCcm(&portable, len), (unsigned long)benchCcm(crypto, len));
+        TEST_MESSAGE(msg);
+    }
+}
+
+void test_aes_key_cache(void)
+{
+    uint8_t keys[AES_KEY_CACHE_SIZE + 1][32];
+    CryptoEngine::AesKeySchedule *slots[AES_KEY_CACHE_SIZE + 1];
+    for (int i = 0; i <= AES_KEY_CACHE_SIZE; i++)
+        fillRandom(keys[i], 32);
+    portable.clearKeys();
+
+    for (int i = 0; i < AES_KEY_CACHE_SIZE; i++) {
+        portable.aesSetKey(keys[i], 32);
+        slots[i] = portable.aes;
+    }
+    // A key we had is used again without expanding it
+    portable.aesSetKey(keys[0], 32);
+    TEST_ASSERT_EQUAL_PTR(slots[0], portable.aes);
+
+    // A new one takes the place of the least recently used
+    portable.aesSetKey(keys[AES_KEY_CACHE_SIZE], 32);
+    TEST_ASSERT_EQUAL_PTR(slots[1], portable.aes);
+
+    // And still encrypts like a fresh key schedule would
+    uint8_t plain[16] = {0}, cached[16], fresh[16];
+    portable.aesEncrypt(plain, cached);
+    AES256 aes;
+    aes.setKey(keys[AES_KEY_CACHE_SIZE], 32);
+    aes.encryptBlock(fresh, plain);
+    TEST_ASSERT_EQUAL_MEMORY(fresh, cached, 16);
+}
+
 void setup()
 {
     // NOTE!!! Wait for >2 secs
@@ -136,6 +272,10 @@ void setup()
     RUN_TEST(test_ECB_AES256);
     RUN_TEST(test_DH25519);
     RUN_TEST(test_AES_CTR);
+    RUN_TEST(test_matches_portable);
+    RUN_TEST(test_benchmark);
+    RUN_TEST(test_ccm_benchmark);
+    RUN_TEST(test_aes_key_cache);
 }
 
 void loop()
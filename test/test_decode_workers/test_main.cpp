@@ -0,0 +1,133 @@
+#include "../TestNode.h"
+#include "Channels.h"
+#include "CryptoEngine.h"
+#include "ReliableRouter.h"
+#include "SinglePortModule.h"
+#if HAS_DECODE_WORKER_POOL
+#include "platform/portduino/DecodeWorkerPool.h"
+#endif
+
+#include <Arduino.h>
+#include <unity.h>
+#include <vector>
+
+#define ORDER_PACKETS 50
+
+// Stands in for the radio, rebroadcasts go nowhere
+class NullInterface : public RadioInterface
+{
+  public:
+    virtual ErrorCode send(meshtastic_MeshPacket *p) override
+    {
+        packetPool.release(p);
+        return ERRNO_OK;
+    }
+};
+
+// Remembers the first payload byte of every packet the modules get
+class RecordingModule : public SinglePortModule
+{
+  public:
+    std::vector<uint8_t> seen;
+
+    RecordingModule() : SinglePortModule("recording", meshtastic_PortNum_PRIVATE_APP) {}
+
+  protected:
+    virtual ProcessMessage handleReceived(const meshtastic_MeshPacket &mp) override
+    {
+        seen.push_back(mp.decoded.payload.bytes[0]);
+        return ProcessMessage::CONTINUE;
+    }
+};
+
+static RecordingModule *recorder;
+static uint32_t nextId = 1;
+
+// A broadcast from someone else on the primary channel, encrypted like it comes from the radio
+static meshtastic_MeshPacket *allocEncrypted(uint8_t tag, size_t len)
+{
+    meshtastic_MeshPacket *p = packetPool.allocZeroed();
+    p->from = 0x1234;
+    p->to = NODENUM_BROADCAST;
+    p->id = nextId++;
+    p->hop_start = 3;
+    p->hop_limit = 2;
+    p->which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p->decoded.portnum = meshtastic_PortNum_PRIVATE_APP;
+    p->decoded.payload.size = len;
+    memset(p->decoded.payload.bytes, tag, len);
+    TEST_ASSERT_EQUAL(meshtastic_Routing_Error_NONE, perhapsEncode(p));
+    return p;
+}
+
+void setUp(void)
+{
+    recorder->seen.clear();
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_matches_main_thread(void)
+{
+    CryptoEngine engine;
+    CryptContext ctx;
+    meshtastic_Data decoded;
+    meshtastic_MeshPacket *p = allocEncrypted(0x5A, 100);
+
+    TEST_ASSERT_TRUE(decryptChannelPayload(p, channels.getKey(0), &engine, ctx, decoded));
+    TEST_ASSERT_TRUE(perhapsDecode(p));
+    TEST_ASSERT_EQUAL(meshtastic_PortNum_PRIVATE_APP, decoded.portnum);
+    TEST_ASSERT_EQUAL_UINT32(p->decoded.payload.size, decoded.payload.size);
+    TEST_ASSERT_EQUAL_MEMORY(p->decoded.payload.bytes, decoded.payload.bytes, decoded.payload.size);
+    packetPool.release(p);
+}
+
+#if HAS_DECODE_WORKER_POOL
+void test_arrival_order(void)
+{
+    // Different sizes, so the workers finish them out of order
+    for (uint8_t i = 0; i < ORDER_PACKETS; i++)
+        router->enqueueReceivedMessage(allocEncrypted(i, 1 + (i * 37) % 200));
+
+    uint32_t start = millis();
+    while (recorder->seen.size() < ORDER_PACKETS && millis() - start < 5000)
+        concurrency::mainController.run();
+
+    TEST_ASSERT_EQUAL_UINT32(ORDER_PACKETS, recorder->seen.size());
+    for (uint8_t i = 0; i < ORDER_PACKETS; i++)
+        TEST_ASSERT_EQUAL_UINT8(i, recorder->seen[i]);
+}
+#endif
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    initTestNode();
+    channels.initDefaults();
+    channels.onConfigChanged();
+    NullInterface *radio = new NullInterface();
+    radio->reconfigure();
+    startTestRouter(new ReliableRouter());
+    router->addInterface(radio);
+    recorder = new RecordingModule();
+#if HAS_DECODE_WORKER_POOL
+    decodeWorkerPool = new DecodeWorkerPool(4);
+#endif
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_matches_main_thread);
+#if HAS_DECODE_WORKER_POOL
+    RUN_TEST(test_arrival_order);
+#endif
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
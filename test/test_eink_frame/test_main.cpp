@@ -0,0 +1,133 @@
+#include "graphics/EInkFrameOps.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+// Framebuffer sizes as EInkDisplay allocates them: longSide * (shortSide / 8)
+#define FRAME_250x122 (250 * (122 / 8))
+#define FRAME_296x128 (296 * (128 / 8))
+#define BENCH_ITERATIONS 200
+
+static uint8_t frame[FRAME_296x128];
+static uint8_t dirty[FRAME_296x128];
+static uint8_t dirtyReference[FRAME_296x128];
+
+// Something resembling a screen of text: sparse black pixels, mostly white
+static void fillFrame(uint8_t *buf, size_t len, uint32_t seed)
+{
+    randomSeed(seed);
+    for (size_t i = 0; i < len; i++)
+        buf[i] = (random(4) == 0) ? random(256) : 0;
+}
+
+// The original pixel by pixel algorithm
+static uint32_t countGhostPixelsReference(const uint8_t *buf, uint8_t *dirtyPixels, size_t len)
+{
+    uint32_t ghosts = 0;
+    for (size_t i = 0; i < len; i++) {
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            const bool isDirty = (dirtyPixels[i] >> bit) & 1;
+            const bool shouldBeBlank = !((buf[i] >> bit) & 1);
+            if (isDirty && shouldBeBlank)
+                ghosts++;
+            if (!isDirty && !shouldBeBlank)
+                dirtyPixels[i] |= (1 << bit);
+        }
+    }
+    return ghosts;
+}
+
+static void checkGhostsMatchReference(size_t len)
+{
+    memset(dirty, 0, sizeof(dirty));
+    memset(dirtyReference, 0, sizeof(dirtyReference));
+    for (uint32_t seed = 1; seed < 10; seed++) {
+        fillFrame(frame, len, seed);
+        uint32_t expected = countGhostPixelsReference(frame, dirtyReference, len);
+        TEST_ASSERT_EQUAL_UINT32(expected, einkCountGhostPixels(frame, dirty, len));
+        TEST_ASSERT_EQUAL_MEMORY(dirtyReference, dirty, len);
+    }
+}
+
+static void benchmark(const char *label, size_t len)
+{
+    fillFrame(frame, len, 42);
+    memset(dirty, 0, sizeof(dirty));
+
+    uint32_t start = micros();
+    uint32_t sink = 0;
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+        sink += einkHashRegion(frame, len);
+    uint32_t hashUs = micros() - start;
+
+    start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+        sink += einkCountGhostPixels(frame, dirty, len);
+    uint32_t ghostUs = micros() - start;
+
+    start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+        sink += countGhostPixelsReference(frame, dirtyReference, len);
+    uint32_t referenceUs = micros() - start;
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%s: hash %luus, ghosts %luus (per pixel %luus) per frame [%lu]", label,
+             (unsigned long)(hashUs / BENCH_ITERATIONS), (unsigned long)(ghostUs / BENCH_ITERATIONS),
+             (unsigned long)(referenceUs / BENCH_ITERATIONS), (unsigned long)sink);
+    TEST_MESSAGE(msg);
+}
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_ghost_count_250x122(void)
+{
+    checkGhostsMatchReference(FRAME_250x122);
+}
+
+void test_ghost_count_296x128(void)
+{
+    checkGhostsMatchReference(FRAME_296x128);
+}
+
+void test_hash_detects_change(void)
+{
+    fillFrame(frame, FRAME_296x128, 7);
+    uint32_t before = einkHashRegion(frame, FRAME_296x128);
+    TEST_ASSERT_EQUAL_UINT32(before, einkHashRegion(frame, FRAME_296x128));
+
+    // Flip a single pixel near the end, which the old byte-shift hash could not see
+    frame[FRAME_296x128 - 3] ^= 0x10;
+    TEST_ASSERT_NOT_EQUAL(before, einkHashRegion(frame, FRAME_296x128));
+}
+
+void test_benchmark(void)
+{
+    benchmark("250x122", FRAME_250x122);
+    benchmark("296x128", FRAME_296x128);
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_ghost_count_250x122);
+    RUN_TEST(test_ghost_count_296x128);
+    RUN_TEST(test_hash_detects_change);
+    RUN_TEST(test_benchmark);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
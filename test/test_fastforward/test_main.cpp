@@ -0,0 +1,142 @@
+#include "../TestNode.h"
+#include "NextHopRouter.h"
+#include "RadioInterface.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#define BENCH_PACKETS 5000
+
+// Stands in for the radio, counting what would go out over the air
+class CountingInterface : public RadioInterface
+{
+  public:
+    uint32_t sent = 0;
+    uint8_t lastHopLimit = 0;
+
+    virtual ErrorCode send(meshtastic_MeshPacket *p) override
+    {
+        sent++;
+        lastHopLimit = p->hop_limit;
+        packetPool.release(p);
+        return ERRNO_OK;
+    }
+};
+
+static CountingInterface *radio;
+static uint32_t nextId = 1;
+
+// A direct message between two other nodes, as it comes from the radio
+static meshtastic_MeshPacket *allocReceived()
+{
+    meshtastic_MeshPacket *p = packetPool.allocZeroed();
+    p->from = 0x1000 + nextId % 50;
+    p->to = 0x2000 + nextId % 7;
+    p->id = nextId++;
+    p->hop_start = 3;
+    p->hop_limit = 2;
+    p->relay_node = 0x42;
+    p->which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+    p->encrypted.size = 40;
+    memset(p->encrypted.bytes, 0xA5, p->encrypted.size);
+    return p;
+}
+
+static void receive(meshtastic_MeshPacket *p)
+{
+    router->enqueueReceivedMessage(p);
+    router->runOnce();
+}
+
+// Microseconds the router takes per received packet
+static uint32_t runPackets(uint32_t count)
+{
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < count; i++)
+        receive(allocReceived());
+    return (micros() - start) / count;
+}
+
+void setUp(void)
+{
+    moduleConfig.mqtt.enabled = false;
+    radio->sent = 0;
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_forwards_once(void)
+{
+    meshtastic_MeshPacket *p = allocReceived();
+    meshtastic_MeshPacket *dup = packetPool.allocCopy(*p);
+    receive(p);
+    receive(dup);
+    TEST_ASSERT_EQUAL_UINT32(1, radio->sent);
+    TEST_ASSERT_EQUAL_UINT8(1, radio->lastHopLimit);
+}
+
+void test_last_hop_not_forwarded(void)
+{
+    meshtastic_MeshPacket *p = allocReceived();
+    p->hop_limit = 0;
+    receive(p);
+    TEST_ASSERT_EQUAL_UINT32(0, radio->sent);
+}
+
+void test_routed_for_other_relay(void)
+{
+    meshtastic_MeshPacket *p = allocReceived();
+    p->next_hop = getLastByteOfNodeNum(nodeDB->getNodeNum()) ^ 0x01;
+    receive(p);
+    TEST_ASSERT_EQUAL_UINT32(0, radio->sent);
+
+    p = allocReceived();
+    p->next_hop = getLastByteOfNodeNum(nodeDB->getNodeNum());
+    receive(p);
+    TEST_ASSERT_EQUAL_UINT32(1, radio->sent);
+}
+
+void test_benchmark(void)
+{
+    uint32_t fastUs = runPackets(BENCH_PACKETS);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_PACKETS, radio->sent);
+
+    // With MQTT on, repeaters take the regular receive path so packets get published
+    moduleConfig.mqtt.enabled = true;
+    radio->sent = 0;
+    uint32_t fullUs = runPackets(BENCH_PACKETS);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_PACKETS, radio->sent);
+
+    char msg[100];
+    snprintf(msg, sizeof(msg), "%d packets: header only %luus, regular path %luus per packet", BENCH_PACKETS,
+             (unsigned long)fastUs, (unsigned long)fullUs);
+    TEST_MESSAGE(msg);
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    initTestNode(meshtastic_Config_DeviceConfig_Role_REPEATER);
+    config.device.rebroadcast_mode = meshtastic_Config_DeviceConfig_RebroadcastMode_ALL_SKIP_DECODING;
+    radio = new CountingInterface();
+    radio->reconfigure();
+    startTestRouter(new NextHopRouter());
+    router->addInterface(radio);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_forwards_once);
+    RUN_TEST(test_last_hop_not_forwarded);
+    RUN_TEST(test_routed_for_other_relay);
+    RUN_TEST(test_benchmark);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,143 @@
+#include "gps/GNSSStreamParser.h"
+
+#include <Arduino.h>
+#include <string.h>
+#include <unity.h>
+#include <vector>
+
+static GNSSStreamParser parser;
+
+static const char *gga = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47";
+static const char *rmc = "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A";
+
+void setUp(void)
+{
+    parser.reset();
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+static void appendText(std::vector<uint8_t> &out, const char *line)
+{
+    out.insert(out.end(), line, line + strlen(line));
+    out.push_back('\r');
+    out.push_back('\n');
+}
+
+static void appendUbx(std::vector<uint8_t> &out, uint8_t cls, uint8_t id, const std::vector<uint8_t> &payload)
+{
+    std::vector<uint8_t> body = {cls, id, (uint8_t)payload.size(), (uint8_t)(payload.size() >> 8)};
+    body.insert(body.end(), payload.begin(), payload.end());
+    uint8_t ckA = 0, ckB = 0;
+    for (uint8_t c : body) {
+        ckA += c;
+        ckB += ckA;
+    }
+    out.push_back(0xB5);
+    out.push_back(0x62);
+    out.insert(out.end(), body.begin(), body.end());
+    out.push_back(ckA);
+    out.push_back(ckB);
+}
+
+/// Feeds everything, keeping the lines and the class/id of the frames that came out, in order
+static std::vector<std::string> feedAll(const std::vector<uint8_t> &in)
+{
+    std::vector<std::string> seen;
+    for (uint8_t c : in) {
+        switch (parser.feed(c)) {
+        case GNSSStreamParser::TEXT_LINE:
+            seen.push_back(parser.line());
+            break;
+        case GNSSStreamParser::UBX_FRAME:
+            seen.push_back("UBX " + std::to_string(parser.frameClass) + "/" + std::to_string(parser.frameId) + " " +
+                           std::to_string(parser.payloadLength()));
+            break;
+        case GNSSStreamParser::CAS_FRAME:
+            seen.push_back("CAS " + std::to_string(parser.frameClass) + "/" + std::to_string(parser.frameId));
+            break;
+        default:
+            break;
+        }
+    }
+    return seen;
+}
+
+void test_interleaved_nmea_and_ubx(void)
+{
+    std::vector<uint8_t> in;
+    appendText(in, gga);
+    appendUbx(in, 0x05, 0x01, {0x06, 0x8A}); // ACK-ACK for CFG-VALSET
+    appendText(in, rmc);
+    appendUbx(in, 0x0A, 0x04, std::vector<uint8_t>(160, 'x'));
+
+    std::vector<std::string> seen = feedAll(in);
+    TEST_ASSERT_EQUAL_UINT32(4, seen.size());
+    TEST_ASSERT_EQUAL_STRING(gga, seen[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("UBX 5/1 2", seen[1].c_str());
+    TEST_ASSERT_EQUAL_STRING(rmc, seen[2].c_str());
+    TEST_ASSERT_EQUAL_STRING("UBX 10/4 160", seen[3].c_str());
+    TEST_ASSERT_EQUAL_MEMORY(std::string(160, 'x').c_str(), parser.payload(), 160);
+}
+
+void test_bad_checksum_dropped(void)
+{
+    std::vector<uint8_t> in;
+    appendUbx(in, 0x05, 0x01, {0x06, 0x8A});
+    in.back() ^= 0xFF;
+    appendText(in, gga);
+
+    std::vector<std::string> seen = feedAll(in);
+    TEST_ASSERT_EQUAL_UINT32(1, seen.size());
+    TEST_ASSERT_EQUAL_STRING(gga, seen[0].c_str());
+}
+
+void test_bogus_length_resyncs(void)
+{
+    // A UBX header claiming 65535 bytes, right before the sentences we want
+    std::vector<uint8_t> in = {0xB5, 0x62, 0x01, 0x07, 0xFF, 0xFF};
+    appendText(in, gga);
+    appendText(in, rmc);
+    // And a CASIC header that is just as wrong
+    in.insert(in.end(), {0xBA, 0xCE, 0x00, 0xF0});
+    appendText(in, gga);
+
+    std::vector<std::string> seen = feedAll(in);
+    TEST_ASSERT_EQUAL_UINT32(3, seen.size());
+    TEST_ASSERT_EQUAL_STRING(gga, seen[0].c_str());
+    TEST_ASSERT_EQUAL_STRING(rmc, seen[1].c_str());
+    TEST_ASSERT_EQUAL_STRING(gga, seen[2].c_str());
+}
+
+void test_frame_split_across_feeds(void)
+{
+    std::vector<uint8_t> in;
+    appendUbx(in, 0x05, 0x00, {0x06, 0x8A}); // ACK-NAK
+    std::vector<uint8_t> first(in.begin(), in.begin() + 3), rest(in.begin() + 3, in.end());
+
+    TEST_ASSERT_EQUAL_UINT32(0, feedAll(first).size());
+    std::vector<std::string> seen = feedAll(rest);
+    TEST_ASSERT_EQUAL_UINT32(1, seen.size());
+    TEST_ASSERT_EQUAL_STRING("UBX 5/0 2", seen[0].c_str());
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_interleaved_nmea_and_ubx);
+    RUN_TEST(test_bad_checksum_dropped);
+    RUN_TEST(test_bogus_length_resyncs);
+    RUN_TEST(test_frame_split_across_feeds);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,117 @@
+#include "serialization/JsonDoc.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_parses_downlink_envelope(void)
+{
+    char text[] = " {\"from\": 305419896, \"type\": \"sendtext\", \"hopLimit\": 3, \"payload\": \"hi \\\"there\\\"\\n\"} ";
+    JsonDoc doc;
+    const JsonNode *json = doc.parse(text);
+    TEST_ASSERT_NOT_NULL(json);
+    TEST_ASSERT_TRUE(json->isObject());
+    TEST_ASSERT_EQUAL_UINT32(4, json->size());
+    TEST_ASSERT_EQUAL_DOUBLE(305419896, json->get("from")->asNumber());
+    TEST_ASSERT_TRUE(json->get("type")->equals("sendtext"));
+    TEST_ASSERT_NULL(json->get("type", JSON_NUMBER));
+    TEST_ASSERT_NULL(json->get("channel"));
+
+    // Unescaped in place, pointing into the text
+    const JsonNode *payload = json->get("payload");
+    TEST_ASSERT_EQUAL_STRING("hi \"there\"\n", payload->asString());
+    TEST_ASSERT_TRUE(payload->asString() >= text && payload->asString() < text + sizeof(text));
+}
+
+void test_parses_nested_values(void)
+{
+    JsonDoc doc;
+    const JsonNode *json = doc.parseCopy("[true, false, null, -1.5e2, {\"a\": [0]}, \"caf\\u00e9 \\ud83d\\ude00\"]");
+    TEST_ASSERT_NOT_NULL(json);
+    TEST_ASSERT_EQUAL_UINT32(6, json->size());
+    TEST_ASSERT_TRUE(json->at(0)->asBool());
+    TEST_ASSERT_TRUE(json->at(1)->isBool());
+    TEST_ASSERT_FALSE(json->at(1)->asBool());
+    TEST_ASSERT_TRUE(json->at(2)->isNull());
+    TEST_ASSERT_EQUAL_DOUBLE(-150, json->at(3)->asNumber());
+    TEST_ASSERT_TRUE(json->at(4)->get("a", JSON_ARRAY)->at(0)->isNumber());
+    TEST_ASSERT_EQUAL_STRING("caf\xc3\xa9 \xf0\x9f\x98\x80", json->at(5)->asString());
+    TEST_ASSERT_NULL(json->at(6));
+}
+
+void test_rejects_invalid_json(void)
+{
+    const char *invalid[] = {"",       "{",      "[1,]",  "{\"a\" 1}", "01",       "1.",        "-",
+                             "0x10",   "tru",    "\"abc", "{} x",      "\"\\q\"", "\"\\u12\"", "{\"a\":}",
+                             "[[[[[[[[[[[[[[[[[[[[1]]]]]]]]]]]]]]]]]]]]"};
+    for (const char *text : invalid) {
+        JsonDoc doc;
+        TEST_ASSERT_NULL_MESSAGE(doc.parseCopy(text), text);
+    }
+}
+
+void test_indexes_large_objects(void)
+{
+    std::string text = "{";
+    for (int i = 0; i < 100; i++)
+        text += (i ? ",\"key" : "\"key") + std::to_string(i) + "\":" + std::to_string(i);
+    text += ",\"key7\":-1}"; // A repeated key, the first one counts
+
+    JsonDoc doc;
+    const JsonNode *json = doc.parseCopy(text.c_str());
+    TEST_ASSERT_NOT_NULL(json);
+    TEST_ASSERT_NOT_NULL(json->list.index);
+    for (int i = 0; i < 100; i++)
+        TEST_ASSERT_EQUAL_DOUBLE(i, json->get(("key" + std::to_string(i)).c_str())->asNumber());
+    TEST_ASSERT_NULL(json->get("key100"));
+}
+
+void test_builds_and_stringifies(void)
+{
+    JsonDoc doc;
+    JsonNode *root = doc.object();
+    doc.add(root, "id", (unsigned int)4294967295u);
+    doc.add(root, "snr", (double)5.25f);
+    doc.add(root, "text", "a\"b\x01");
+    doc.add(root, "want_ack", true);
+    JsonNode *route = doc.array();
+    doc.push(route, doc.string("Base"));
+    doc.push(route, doc.null());
+    doc.add(root, "route", route);
+
+    TEST_ASSERT_EQUAL_STRING("{\"id\":4294967295,\"snr\":5.25,\"text\":\"a\\\"b\\u0001\",\"want_ack\":true,"
+                             "\"route\":[\"Base\",null]}",
+                             JsonDoc::stringify(root).c_str());
+    TEST_ASSERT_EQUAL_DOUBLE(5.25, root->get("snr")->asNumber());
+    TEST_ASSERT_TRUE(root->get("route")->at(0)->equals("Base"));
+    // Everything in one chunk
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(JSON_ARENA_CHUNK, doc.getArena().getUsed());
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_parses_downlink_envelope);
+    RUN_TEST(test_parses_nested_values);
+    RUN_TEST(test_rejects_invalid_json);
+    RUN_TEST(test_indexes_large_objects);
+    RUN_TEST(test_builds_and_stringifies);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
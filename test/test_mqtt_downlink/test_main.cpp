@@ -0,0 +1,154 @@
+#include "../TestNode.h"
+#include "ReliableRouter.h"
+#include "mqtt/DownlinkAdmission.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+// Lets us put packets in the packet history without handling them
+class TestRouter : public ReliableRouter
+{
+  public:
+    void remember(NodeNum from, PacketId id) { wasSeenRecently(from, id); }
+};
+
+static TestRouter *testRouter;
+static DownlinkAdmission *admission;
+static uint32_t nextId = 1;
+
+// A broadcast as a gateway publishes it, still encrypted
+static meshtastic_MeshPacket envelopePacket(bool wantAck = false)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.from = 0x1234;
+    p.to = NODENUM_BROADCAST;
+    p.id = nextId++;
+    p.want_ack = wantAck;
+    p.which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+    p.encrypted.size = 20;
+    return p;
+}
+
+// A text message built from a JSON envelope
+static meshtastic_MeshPacket jsonPacket(const char *text)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.from = nodeDB->getNodeNum();
+    p.to = NODENUM_BROADCAST;
+    p.id = nextId++;
+    p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p.decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+    p.decoded.payload.size = strlen(text);
+    memcpy(p.decoded.payload.bytes, text, p.decoded.payload.size);
+    return p;
+}
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_source_budget_keeps_room_for_reliable(void)
+{
+    uint32_t source = DownlinkAdmission::sourceKey("!gateway1");
+    // A full source bucket of 5, of which default priority packets leave 1.5 to reliable ones
+    for (int i = 0; i < 3; i++)
+        TEST_ASSERT_EQUAL(DOWNLINK_ADMIT, admission->admit(source, 0, envelopePacket(), false));
+    TEST_ASSERT_EQUAL(DOWNLINK_SHED_SOURCE, admission->admit(source, 0, envelopePacket(), false));
+    TEST_ASSERT_EQUAL(DOWNLINK_ADMIT, admission->admit(source, 0, envelopePacket(true), false));
+
+    // Another gateway has its own budget
+    TEST_ASSERT_EQUAL(DOWNLINK_ADMIT, admission->admit(DownlinkAdmission::sourceKey("!gateway2"), 0, envelopePacket(), false));
+}
+
+void test_channel_budget_across_sources(void)
+{
+    // A full channel bucket of 10, of which default priority packets leave 3
+    const char *gateways[] = {"!a", "!b", "!c", "!d"};
+    uint32_t admitted = 0;
+    for (const char *gateway : gateways) {
+        for (int i = 0; i < 3; i++) {
+            DownlinkVerdict v = admission->admit(DownlinkAdmission::sourceKey(gateway), 1, envelopePacket(), false);
+            if (v == DOWNLINK_ADMIT)
+                admitted++;
+            else
+                TEST_ASSERT_EQUAL(DOWNLINK_SHED_CHANNEL, v);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(7, admitted);
+}
+
+void test_drops_packets_in_history(void)
+{
+    meshtastic_MeshPacket p = envelopePacket();
+    testRouter->remember(p.from, p.id);
+    uint32_t before = admission->getStats().duplicates;
+    TEST_ASSERT_EQUAL(DOWNLINK_DUPLICATE, admission->admit(DownlinkAdmission::sourceKey("!e"), 2, p, false));
+    TEST_ASSERT_EQUAL_UINT32(before + 1, admission->getStats().duplicates);
+}
+
+void test_drops_repeated_json(void)
+{
+    uint32_t source = DownlinkAdmission::sourceKey("msh/2/json/mqtt/app");
+    TEST_ASSERT_EQUAL(DOWNLINK_ADMIT, admission->admit(source, 3, jsonPacket("hello"), true));
+    TEST_ASSERT_EQUAL(DOWNLINK_DUPLICATE, admission->admit(source, 3, jsonPacket("hello"), true));
+    TEST_ASSERT_EQUAL(DOWNLINK_ADMIT, admission->admit(source, 3, jsonPacket("hello again"), true));
+}
+
+void test_busy_channel_sheds_all_but_reliable(void)
+{
+    airTime->logAirtime(RX_LOG, 30 * 1000); // 50% channel utilization
+    uint32_t source = DownlinkAdmission::sourceKey("!f");
+    TEST_ASSERT_EQUAL(DOWNLINK_SHED_BUSY, admission->admit(source, 4, envelopePacket(), false));
+    TEST_ASSERT_EQUAL(DOWNLINK_ADMIT, admission->admit(source, 4, envelopePacket(true), false));
+}
+
+void test_busy_channel_admits_encrypted_ack(void)
+{
+    airTime->logAirtime(RX_LOG, 30 * 1000);
+    uint32_t source = DownlinkAdmission::sourceKey("!g");
+
+    // An ack as a gateway publishes it, encrypted on the primary channel. Only its decoded content shows what it is.
+    meshtastic_MeshPacket ack = meshtastic_MeshPacket_init_zero;
+    ack.from = 0x1234;
+    ack.to = 0x5678;
+    ack.id = nextId++;
+    ack.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    ack.decoded.portnum = meshtastic_PortNum_ROUTING_APP;
+    ack.decoded.request_id = 42;
+    TEST_ASSERT_EQUAL(meshtastic_Routing_Error_NONE, perhapsEncode(&ack));
+    TEST_ASSERT_EQUAL(meshtastic_MeshPacket_encrypted_tag, ack.which_payload_variant);
+    TEST_ASSERT_EQUAL(DOWNLINK_ADMIT, admission->admit(source, 5, ack, false));
+
+    // Something we can't decrypt still only gets the priority its header shows
+    TEST_ASSERT_EQUAL(DOWNLINK_SHED_BUSY, admission->admit(source, 5, envelopePacket(), false));
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    initTestNode();
+    router = testRouter = new TestRouter();
+    admission = new DownlinkAdmission();
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_source_budget_keeps_room_for_reliable);
+    RUN_TEST(test_channel_budget_across_sources);
+    RUN_TEST(test_drops_packets_in_history);
+    RUN_TEST(test_drops_repeated_json);
+    RUN_TEST(test_busy_channel_sheds_all_but_reliable);
+    RUN_TEST(test_busy_channel_admits_encrypted_ack);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
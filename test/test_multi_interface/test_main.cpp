@@ -0,0 +1,157 @@
+#include "../TestNode.h"
+#include "ReliableRouter.h"
+#include "platform/portduino/SimRadio.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+// A backbone node: a fast short range preset for the local mesh, and a slow long range one between meshes
+static SimRadio *fast, *slow;
+static uint32_t nextId = 1;
+
+// A broadcast from someone else, one hop away
+static meshtastic_MeshPacket *allocReceived()
+{
+    meshtastic_MeshPacket *p = packetPool.allocZeroed();
+    p->from = 0x1000 + nextId % 50;
+    p->to = NODENUM_BROADCAST;
+    p->id = nextId++;
+    p->hop_start = 3;
+    p->hop_limit = 2;
+    p->which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p->decoded.portnum = meshtastic_PortNum_PRIVATE_APP;
+    p->decoded.payload.size = 10;
+    memset(p->decoded.payload.bytes, 0xA5, p->decoded.payload.size);
+    return p;
+}
+
+// Let a radio receive the packet and the router handle it, p stays ours
+static void receive(SimRadio *radio, meshtastic_MeshPacket *p)
+{
+    radio->startReceive(p);
+    router->runOnce();
+}
+
+// Packets waiting in the TX queue of a radio
+static uint32_t queued(SimRadio *radio)
+{
+    return radio->getQueueStatus().maxlen - radio->getQueueStatus().free;
+}
+
+void setUp(void)
+{
+    fast->rebroadcastPolicy = REBROADCAST_ALL;
+    slow->rebroadcastPolicy = REBROADCAST_ALL;
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_relays_on_all_interfaces(void)
+{
+    uint32_t fastBefore = queued(fast), slowBefore = queued(slow);
+    meshtastic_MeshPacket *p = allocReceived();
+    receive(fast, p);
+    packetPool.release(p);
+    TEST_ASSERT_EQUAL_UINT32(fastBefore + 1, queued(fast));
+    TEST_ASSERT_EQUAL_UINT32(slowBefore + 1, queued(slow));
+}
+
+void test_bridge_only(void)
+{
+    slow->rebroadcastPolicy = REBROADCAST_BRIDGE_ONLY;
+    uint32_t fastBefore = queued(fast), slowBefore = queued(slow);
+    meshtastic_MeshPacket *p = allocReceived();
+    receive(slow, p);
+    packetPool.release(p);
+    TEST_ASSERT_EQUAL_UINT32(fastBefore + 1, queued(fast));
+    TEST_ASSERT_EQUAL_UINT32(slowBefore, queued(slow));
+
+    p = allocReceived();
+    receive(fast, p);
+    packetPool.release(p);
+    TEST_ASSERT_EQUAL_UINT32(fastBefore + 2, queued(fast));
+    TEST_ASSERT_EQUAL_UINT32(slowBefore + 1, queued(slow));
+}
+
+void test_no_relaying_but_own_packets(void)
+{
+    slow->rebroadcastPolicy = REBROADCAST_NONE;
+    uint32_t fastBefore = queued(fast), slowBefore = queued(slow);
+    meshtastic_MeshPacket *p = allocReceived();
+    receive(fast, p);
+    packetPool.release(p);
+    TEST_ASSERT_EQUAL_UINT32(fastBefore + 1, queued(fast));
+    TEST_ASSERT_EQUAL_UINT32(slowBefore, queued(slow));
+
+    p = router->allocForSending();
+    p->decoded.portnum = meshtastic_PortNum_PRIVATE_APP;
+    p->decoded.payload.size = 10;
+    router->sendLocal(p, RX_SRC_LOCAL);
+    TEST_ASSERT_EQUAL_UINT32(fastBefore + 2, queued(fast));
+    TEST_ASSERT_EQUAL_UINT32(slowBefore + 1, queued(slow));
+}
+
+void test_duplicate_cancels_only_its_interface(void)
+{
+    uint32_t fastBefore = queued(fast), slowBefore = queued(slow);
+    meshtastic_MeshPacket *p = allocReceived();
+    receive(fast, p);
+    TEST_ASSERT_EQUAL_UINT32(fastBefore + 1, queued(fast));
+    TEST_ASSERT_EQUAL_UINT32(slowBefore + 1, queued(slow));
+
+    // Another node on the slow link relayed it already, the local mesh still needs our copy
+    p->hop_limit--;
+    receive(slow, p);
+    packetPool.release(p);
+    TEST_ASSERT_EQUAL_UINT32(fastBefore + 1, queued(fast));
+    TEST_ASSERT_EQUAL_UINT32(slowBefore, queued(slow));
+}
+
+void test_airtime_per_interface(void)
+{
+    TEST_ASSERT_TRUE(slow->getAirTime() != airTime);
+    TEST_ASSERT_TRUE(fast->getAirTime() == airTime);
+
+    uint32_t fastBefore = airTime->getPortnumAirtime(RX_LOG, meshtastic_PortNum_PRIVATE_APP);
+    uint32_t slowBefore = slow->getAirTime()->getPortnumAirtime(RX_LOG, meshtastic_PortNum_PRIVATE_APP);
+    slow->rebroadcastPolicy = REBROADCAST_NONE;
+    fast->rebroadcastPolicy = REBROADCAST_NONE;
+    meshtastic_MeshPacket *p = allocReceived();
+    receive(slow, p);
+    packetPool.release(p);
+    TEST_ASSERT_EQUAL_UINT32(fastBefore, airTime->getPortnumAirtime(RX_LOG, meshtastic_PortNum_PRIVATE_APP));
+    TEST_ASSERT_GREATER_THAN_UINT32(slowBefore, slow->getAirTime()->getPortnumAirtime(RX_LOG, meshtastic_PortNum_PRIVATE_APP));
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    initTestNode();
+    fast = new SimRadio();
+    fast->setModemPreset(meshtastic_Config_LoRaConfig_ModemPreset_SHORT_FAST);
+    fast->reconfigure();
+    slow = new SimRadio();
+    slow->setModemPreset(meshtastic_Config_LoRaConfig_ModemPreset_LONG_SLOW);
+    slow->reconfigure();
+    startTestRouter(new ReliableRouter());
+    router->addInterface(fast);
+    router->addInterface(slow);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_relays_on_all_interfaces);
+    RUN_TEST(test_bridge_only);
+    RUN_TEST(test_no_relaying_but_own_packets);
+    RUN_TEST(test_duplicate_cancels_only_its_interface);
+    RUN_TEST(test_airtime_per_interface);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
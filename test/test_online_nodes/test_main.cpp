@@ -0,0 +1,108 @@
+#include "NodeDB.h"
+#include "RTC.h"
+
+#include <Arduino.h>
+#include <sys/time.h>
+#include <unity.h>
+
+// At the start of a period, so the offsets below are whole periods
+#define T0 (ONLINE_BUCKET_SECS * 3800000UL)
+
+static const NodeNum testNodes[] = {0x1001, 0x1002, 0x1003, 0x1004, 0x1005};
+
+static void setClock(uint32_t t)
+{
+    struct timeval tv = {};
+    tv.tv_sec = t;
+    perhapsSetRTC(RTCQualityNTP, &tv, true);
+}
+
+static void hear(NodeNum from, uint32_t rxTime)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p.from = from;
+    p.rx_time = rxTime;
+    nodeDB->updateFrom(p);
+}
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    for (NodeNum n : testNodes)
+        nodeDB->removeNodeByNum(n);
+}
+
+void test_goes_offline_with_its_period(void)
+{
+    setClock(T0);
+    size_t base = nodeDB->getNumOnlineMeshNodes();
+    hear(0x1001, T0 - 60);
+    hear(0x1002, T0 - NUM_ONLINE_SECS - 60);
+    TEST_ASSERT_EQUAL_UINT32(base + 1, nodeDB->getNumOnlineMeshNodes());
+
+    // Heard in the period before T0, which is the oldest one still online 15 periods later
+    setClock(T0 + (NUM_ONLINE_BUCKETS - 2) * ONLINE_BUCKET_SECS);
+    TEST_ASSERT_EQUAL_UINT32(base + 1, nodeDB->getNumOnlineMeshNodes());
+    setClock(T0 + (NUM_ONLINE_BUCKETS - 1) * ONLINE_BUCKET_SECS);
+    TEST_ASSERT_EQUAL_UINT32(base, nodeDB->getNumOnlineMeshNodes());
+
+    // Heard again, it takes the place of the expired period in the same bucket
+    hear(0x1001, T0 + (NUM_ONLINE_BUCKETS - 1) * ONLINE_BUCKET_SECS);
+    TEST_ASSERT_EQUAL_UINT32(base + 1, nodeDB->getNumOnlineMeshNodes());
+}
+
+void test_clock_ahead_counts_as_now(void)
+{
+    setClock(T0);
+    size_t base = nodeDB->getNumOnlineMeshNodes();
+    hear(0x1003, T0 + 100 * ONLINE_BUCKET_SECS);
+    TEST_ASSERT_EQUAL_UINT32(base + 1, nodeDB->getNumOnlineMeshNodes());
+
+    // Comes out of the bucket it was counted in, even after our clock moved on
+    setClock(T0 + ONLINE_BUCKET_SECS);
+    hear(0x1003, T0 + ONLINE_BUCKET_SECS);
+    TEST_ASSERT_EQUAL_UINT32(base + 1, nodeDB->getNumOnlineMeshNodes());
+
+    // And expires like any other node
+    setClock(T0 + (NUM_ONLINE_BUCKETS + 1) * ONLINE_BUCKET_SECS);
+    TEST_ASSERT_EQUAL_UINT32(base, nodeDB->getNumOnlineMeshNodes());
+}
+
+void test_clock_step_keeps_count(void)
+{
+    setClock(T0);
+    size_t base = nodeDB->getNumOnlineMeshNodes();
+
+    // Heard while we only had the time since boot, like nodes loaded from flash before we get the real time
+    setClock(1000);
+    hear(0x1004, T0 - 60);
+    hear(0x1005, T0 - 10 * ONLINE_BUCKET_SECS);
+
+    // Once the clock steps to the real time they are still online
+    setClock(T0);
+    TEST_ASSERT_EQUAL_UINT32(base + 2, nodeDB->getNumOnlineMeshNodes());
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    nodeDB = new NodeDB;
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_goes_offline_with_its_period);
+    RUN_TEST(test_clock_ahead_counts_as_now);
+    RUN_TEST(test_clock_step_keeps_count);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
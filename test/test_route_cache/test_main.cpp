@@ -0,0 +1,98 @@
+#include "mesh/PacketHistory.h"
+#include "mesh/RouteCache.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+static RouteCache *cache;
+
+void setUp(void)
+{
+    cache = new RouteCache();
+}
+
+void tearDown(void)
+{
+    delete cache;
+}
+
+void test_learn_and_lookup(void)
+{
+    TEST_ASSERT_EQUAL_UINT8(NO_NEXT_HOP_PREFERENCE, cache->lookup(0x1234));
+    cache->learn(0x1234, 0x56, ROUTE_SRC_RESPONSE);
+    TEST_ASSERT_EQUAL_UINT8(0x56, cache->lookup(0x1234));
+    TEST_ASSERT_EQUAL_UINT32(1, cache->size());
+    TEST_ASSERT_EQUAL_UINT32(2, cache->lookups);
+    TEST_ASSERT_EQUAL_UINT32(1, cache->hits);
+
+    // Nothing to learn about broadcasts or from packets without a next hop
+    cache->learn(NODENUM_BROADCAST, 0x56, ROUTE_SRC_DIRECT);
+    cache->learn(0x2000, NO_NEXT_HOP_PREFERENCE, ROUTE_SRC_DIRECT);
+    TEST_ASSERT_EQUAL_UINT32(1, cache->size());
+}
+
+void test_trusted_source_wins(void)
+{
+    cache->learn(0x1234, 0x34, ROUTE_SRC_DIRECT);
+    cache->learn(0x1234, 0x56, ROUTE_SRC_NEIGHBORINFO);
+    TEST_ASSERT_EQUAL_UINT8(0x34, cache->lookup(0x1234));
+
+    // The same or a more trusted source replaces the route
+    cache->learn(0x1234, 0x78, ROUTE_SRC_DIRECT);
+    TEST_ASSERT_EQUAL_UINT8(0x78, cache->lookup(0x1234));
+}
+
+void test_never_back_to_relayer(void)
+{
+    cache->learn(0x1234, 0x56, ROUTE_SRC_TRACEROUTE);
+    TEST_ASSERT_EQUAL_UINT8(NO_NEXT_HOP_PREFERENCE, cache->lookup(0x1234, 0x56));
+    TEST_ASSERT_EQUAL_UINT8(0x56, cache->lookup(0x1234, 0x99));
+}
+
+void test_forget_falls_back_to_flooding(void)
+{
+    cache->learn(0x1234, 0x56, ROUTE_SRC_RESPONSE);
+    cache->forget(0x1234);
+    TEST_ASSERT_EQUAL_UINT8(NO_NEXT_HOP_PREFERENCE, cache->lookup(0x1234));
+    TEST_ASSERT_EQUAL_UINT32(1, cache->fallbacks);
+
+    // Forgetting a route we don't have isn't a fallback
+    cache->forget(0x1234);
+    TEST_ASSERT_EQUAL_UINT32(1, cache->fallbacks);
+}
+
+void test_fallback_flood_is_not_a_duplicate(void)
+{
+    PacketHistory history;
+
+    // Overheard while it went along a route
+    TEST_ASSERT_FALSE(history.wasSeenRecently(0x1234, 42, true, 0x56));
+    TEST_ASSERT_TRUE(history.wasSeenRecently(0x1234, 42, true, 0x78));
+
+    // The sender gave up on the route and floods it, we have to pass that on
+    TEST_ASSERT_FALSE(history.wasSeenRecently(0x1234, 42, true, NO_NEXT_HOP_PREFERENCE));
+
+    // Further copies of the flood are duplicates
+    TEST_ASSERT_TRUE(history.wasSeenRecently(0x1234, 42, true, NO_NEXT_HOP_PREFERENCE));
+    TEST_ASSERT_TRUE(history.wasSeenRecently(0x1234, 42, true, 0x56));
+    TEST_ASSERT_TRUE(history.wasSeenRecently(0x1234, 42, false, NEXT_HOP_UNKNOWN));
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_learn_and_lookup);
+    RUN_TEST(test_trusted_source_wins);
+    RUN_TEST(test_never_back_to_relayer);
+    RUN_TEST(test_forget_falls_back_to_flooding);
+    RUN_TEST(test_fallback_flood_is_not_a_duplicate);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,251 @@
+#include "modules/esp32/StoreForwardDiskHistory.h"
+
+#include <Arduino.h>
+#include <unity.h>
+#include <vector>
+
+#define TEST_DIR "/sftest"
+
+// The benchmark fills the log with this many messages, build with a larger count (1000000 is the figure we quote) to measure
+#ifndef SF_BENCH_MESSAGES
+#define SF_BENCH_MESSAGES 10000
+#endif
+#define SF_BENCH_NODES 50
+
+static StoreForwardDiskHistory *history;
+
+// Writes only half of one record, like a disk that filled up
+class ShortWriteHistory : public StoreForwardDiskHistory
+{
+  public:
+    bool failNext = false;
+
+  protected:
+    virtual size_t writeRecord(const uint8_t *data, size_t len) override
+    {
+        if (failNext) {
+            failNext = false;
+            return StoreForwardDiskHistory::writeRecord(data, len / 2);
+        }
+        return StoreForwardDiskHistory::writeRecord(data, len);
+    }
+};
+static uint8_t payload[meshtastic_Constants_DATA_PAYLOAD_LEN];
+
+static void clearDir()
+{
+    delete history;
+    history = nullptr;
+    rmDir(TEST_DIR);
+}
+
+// Mostly broadcasts with some direct messages in between, all payloads different
+static uint32_t addMessage(uint32_t i, uint16_t len)
+{
+    for (uint16_t b = 0; b < len; b++)
+        payload[b] = i + b;
+    uint32_t to = (i % 5 == 0) ? (i / 5) % SF_BENCH_NODES : NODENUM_BROADCAST;
+    uint32_t from = 1000 + i % SF_BENCH_NODES;
+    return history->add(1 + i / 10, to, from, 0, payload, len);
+}
+
+void setUp(void)
+{
+    clearDir();
+    history = new StoreForwardDiskHistory();
+}
+
+void tearDown(void)
+{
+    clearDir();
+}
+
+void test_replay_order(void)
+{
+    TEST_ASSERT_TRUE(history->init(TEST_DIR, 1000, 1024 * 1024));
+    for (uint32_t i = 0; i < 200; i++)
+        TEST_ASSERT_EQUAL_UINT32(i, addMessage(i, i % 64));
+
+    // Node 3 gets every broadcast plus the direct messages to it, in order
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < 200; i++) {
+        if ((i % 5 != 0 || (i / 5) % SF_BENCH_NODES == 3) && 1000 + i % SF_BENCH_NODES != 3)
+            expected++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(expected, history->countAvailable(3, 0, 0));
+
+    uint32_t cursor = 0, count = 0;
+    while (const StoreForwardRecord *r = history->findNext(3, cursor, 0)) {
+        TEST_ASSERT_TRUE(r->to == NODENUM_BROADCAST || r->to == 3);
+        TEST_ASSERT_EQUAL_UINT16(r->seq % 64, r->payload_size);
+        if (r->payload_size)
+            TEST_ASSERT_EQUAL_UINT8((uint8_t)r->seq, r->payload()[0]);
+        TEST_ASSERT_TRUE(r->seq >= cursor);
+        cursor = r->seq + 1;
+        count++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(expected, count);
+}
+
+void test_skips_damaged_record(void)
+{
+    // Small segments, so the damaged one is no longer being written to
+    uint32_t len = StoreForwardDiskHistory::recordSize(30);
+    TEST_ASSERT_TRUE(history->init(TEST_DIR, 1000, 40 * len));
+    for (uint32_t i = 0; i < 20; i++)
+        addMessage(i, 30);
+
+    // Flip a payload byte of record 3 in the first segment
+    File f = FSCom.open(TEST_DIR "/00000000.sfl", FILE_O_READ);
+    TEST_ASSERT_TRUE(f);
+    std::vector<uint8_t> bytes(f.size());
+    TEST_ASSERT_EQUAL_INT(bytes.size(), f.read(bytes.data(), bytes.size()));
+    f.close();
+    bytes[3 * len + sizeof(StoreForwardRecord)] ^= 0xff;
+    FSCom.remove(TEST_DIR "/00000000.sfl");
+    f = FSCom.open(TEST_DIR "/00000000.sfl", FILE_O_WRITE);
+    TEST_ASSERT_TRUE(f);
+    f.write(bytes.data(), bytes.size());
+    f.close();
+
+    // Node 3 gets the broadcasts and message 15, all but the damaged record still come through
+    uint32_t cursor = 0, count = 0;
+    while (const StoreForwardRecord *r = history->findNext(3, cursor, 0)) {
+        TEST_ASSERT_NOT_EQUAL(3, r->seq);
+        cursor = r->seq + 1;
+        count++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(16, count);
+    TEST_ASSERT_EQUAL_UINT32(20, cursor);
+}
+
+void test_retention(void)
+{
+    TEST_ASSERT_TRUE(history->init(TEST_DIR, 100, 1024 * 1024));
+    for (uint32_t i = 0; i < 1000; i++) {
+        addMessage(i, 20);
+        TEST_ASSERT_TRUE(history->size() <= 100);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1000, history->totalAdded());
+
+    // A cursor from before the oldest record starts at the oldest one, the first broadcast is at most 1 further
+    uint32_t oldest = history->totalAdded() - history->size();
+    const StoreForwardRecord *r = history->findNext(2000, 0, 0);
+    TEST_ASSERT_NOT_NULL(r);
+    TEST_ASSERT_TRUE(r->seq >= oldest && r->seq <= oldest + 1);
+    TEST_ASSERT_EQUAL_UINT32(history->countAvailable(2000, oldest, 0), history->countAvailable(2000, 0, 0));
+}
+
+void test_recovery(void)
+{
+    TEST_ASSERT_TRUE(history->init(TEST_DIR, 1000, 1024 * 1024));
+    for (uint32_t i = 0; i < 50; i++)
+        addMessage(i, 30);
+
+    // Simulate a write cut short by a crash: half a record at the end of the log
+    File f = FSCom.open(TEST_DIR "/00000000.sfl", FILE_O_APPEND);
+    TEST_ASSERT_TRUE(f);
+    f.write(payload, 17);
+    f.close();
+
+    delete history;
+    history = new StoreForwardDiskHistory();
+    TEST_ASSERT_TRUE(history->init(TEST_DIR, 1000, 1024 * 1024));
+    TEST_ASSERT_EQUAL_UINT32(50, history->size());
+
+    // And we carry on where we left off
+    TEST_ASSERT_EQUAL_UINT32(50, addMessage(50, 30));
+    delete history;
+    history = new StoreForwardDiskHistory();
+    TEST_ASSERT_TRUE(history->init(TEST_DIR, 1000, 1024 * 1024));
+    TEST_ASSERT_EQUAL_UINT32(51, history->size());
+}
+
+void test_short_write(void)
+{
+    delete history;
+    ShortWriteHistory *failing = new ShortWriteHistory();
+    history = failing;
+    TEST_ASSERT_TRUE(history->init(TEST_DIR, 1000, 1024 * 1024));
+    for (uint32_t i = 0; i < 10; i++)
+        addMessage(i, 30);
+
+    failing->failNext = true;
+    TEST_ASSERT_EQUAL_UINT32(StoreForwardStorage::NONE, addMessage(10, 30));
+
+    // The half record is gone, so the ones after it are where the index says and read back intact
+    for (uint32_t i = 10; i < 20; i++)
+        TEST_ASSERT_EQUAL_UINT32(i, addMessage(i, 30));
+    TEST_ASSERT_EQUAL_UINT32(20 * StoreForwardDiskHistory::recordSize(30), history->bytesUsed());
+    uint32_t cursor = 0, count = 0;
+    while (const StoreForwardRecord *r = history->findNext(2000, cursor, 0)) {
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)r->seq, r->payload()[0]);
+        cursor = r->seq + 1;
+        count++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(16, count);
+    TEST_ASSERT_EQUAL_UINT32(20, cursor);
+
+    // And nothing is cut off when the log is loaded again
+    delete history;
+    history = new StoreForwardDiskHistory();
+    TEST_ASSERT_TRUE(history->init(TEST_DIR, 1000, 1024 * 1024));
+    TEST_ASSERT_EQUAL_UINT32(20, history->size());
+}
+
+void test_benchmark(void)
+{
+    TEST_ASSERT_TRUE(history->init(TEST_DIR, SF_BENCH_MESSAGES, 0xFFFFFFFF));
+
+    uint32_t start = millis();
+    for (uint32_t i = 0; i < SF_BENCH_MESSAGES; i++)
+        addMessage(i, 16 + i % 48);
+    uint32_t insertMs = millis() - start;
+
+    // Replay the last hour a client would ask for, and the full history of one node
+    uint32_t lastTime = 1 + (SF_BENCH_MESSAGES - SF_BENCH_MESSAGES / 10) / 10;
+    start = millis();
+    uint32_t cursor = 0, replayed = 0;
+    while (const StoreForwardRecord *r = history->findNext(7, cursor, lastTime)) {
+        cursor = r->seq + 1;
+        replayed++;
+    }
+    uint32_t replayMs = millis() - start;
+
+    start = millis();
+    uint32_t counted = history->countAvailable(7, 0, 0);
+    uint32_t countMs = millis() - start;
+
+    delete history;
+    history = new StoreForwardDiskHistory();
+    start = millis();
+    TEST_ASSERT_TRUE(history->init(TEST_DIR, SF_BENCH_MESSAGES, 0xFFFFFFFF));
+    uint32_t loadMs = millis() - start;
+    TEST_ASSERT_EQUAL_UINT32(SF_BENCH_MESSAGES, history->size());
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%lu messages: insert %lums, replay %lu in %lums, count %lu in %lums, reload %lums",
+             (unsigned long)SF_BENCH_MESSAGES, (unsigned long)insertMs, (unsigned long)replayed, (unsigned long)replayMs,
+             (unsigned long)counted, (unsigned long)countMs, (unsigned long)loadMs);
+    TEST_MESSAGE(msg);
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_replay_order);
+    RUN_TEST(test_skips_damaged_record);
+    RUN_TEST(test_retention);
+    RUN_TEST(test_recovery);
+    RUN_TEST(test_short_write);
+    RUN_TEST(test_benchmark);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,123 @@
+#include "modules/esp32/StoreForwardHistory.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#define RING_RECORDS 8
+#define RING_PAYLOAD 24
+
+static StoreForwardHistory history;
+static uint32_t ringIndex[64];
+static uint32_t ringBuffer[RING_RECORDS * ((sizeof(StoreForwardRecord) + RING_PAYLOAD + 3) / 4)];
+static uint8_t payload[meshtastic_Constants_DATA_PAYLOAD_LEN];
+
+// Every third message goes directly to node 7, the rest are broadcasts
+static uint32_t addMessage(uint32_t i, uint16_t len)
+{
+    for (uint16_t b = 0; b < len; b++)
+        payload[b] = i + b;
+    uint32_t to = (i % 3 == 0) ? 7 : NODENUM_BROADCAST;
+    return history.add(100 + i, to, 1000 + i % 4, 0, payload, len);
+}
+
+/// Replays everything dest would get from cursor on, checking each record is intact and comes after the one before
+static uint32_t replay(NodeNum dest, uint32_t cursor, uint32_t *first = nullptr)
+{
+    uint32_t count = 0;
+    while (const StoreForwardRecord *r = history.findNext(dest, cursor, 0)) {
+        TEST_ASSERT_TRUE(r->seq >= cursor);
+        TEST_ASSERT_EQUAL_UINT32(100 + r->seq, r->time);
+        if (r->payload_size)
+            TEST_ASSERT_EQUAL_UINT8((uint8_t)r->seq, r->payload()[0]);
+        if (!count && first)
+            *first = r->seq;
+        cursor = r->seq + 1;
+        count++;
+    }
+    return count;
+}
+
+void setUp(void)
+{
+    history.init((uint8_t *)ringBuffer, sizeof(ringBuffer), ringIndex, sizeof(ringIndex) / sizeof(ringIndex[0]));
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_wraps_oldest_first(void)
+{
+    // The buffer fills up long before the index does, so records are dropped for room
+    for (uint32_t i = 0; i < 5 * RING_RECORDS; i++) {
+        TEST_ASSERT_EQUAL_UINT32(i, addMessage(i, RING_PAYLOAD));
+        TEST_ASSERT_TRUE(history.bytesUsed() <= sizeof(ringBuffer));
+    }
+    TEST_ASSERT_EQUAL_UINT32(RING_RECORDS, history.size());
+    TEST_ASSERT_EQUAL_UINT32(5 * RING_RECORDS, history.totalAdded());
+
+    // A node that sent none of them gets every one that is left, oldest first and without gaps
+    uint32_t oldest = history.totalAdded() - history.size(), first = 0;
+    TEST_ASSERT_EQUAL_UINT32(RING_RECORDS, replay(7, 0, &first));
+    TEST_ASSERT_EQUAL_UINT32(oldest, first);
+}
+
+void test_mixed_sizes_wrap(void)
+{
+    // Records of different sizes don't line up with the end of the buffer, so some wraps skip its tail
+    for (uint32_t i = 0; i < 200; i++)
+        TEST_ASSERT_EQUAL_UINT32(i, addMessage(i, (i * 7) % (RING_PAYLOAD + 1)));
+
+    uint32_t oldest = history.totalAdded() - history.size(), first = 0;
+    TEST_ASSERT_TRUE(history.size() >= RING_RECORDS);
+    TEST_ASSERT_EQUAL_UINT32(history.size(), replay(7, 0, &first));
+    TEST_ASSERT_EQUAL_UINT32(oldest, first);
+}
+
+void test_cursors_across_wrap(void)
+{
+    for (uint32_t i = 0; i < RING_RECORDS; i++)
+        addMessage(i, RING_PAYLOAD);
+
+    // One client read everything so far, one only the first two records
+    uint32_t caughtUp = history.totalAdded(), behind = 2;
+    for (uint32_t i = RING_RECORDS; i < RING_RECORDS + 5; i++)
+        addMessage(i, RING_PAYLOAD);
+
+    // The client that caught up gets exactly the new records
+    uint32_t first = 0;
+    TEST_ASSERT_EQUAL_UINT32(5, replay(7, caughtUp, &first));
+    TEST_ASSERT_EQUAL_UINT32(caughtUp, first);
+
+    // The records after the other cursor were dropped, it carries on at the oldest one left
+    uint32_t oldest = history.totalAdded() - history.size();
+    TEST_ASSERT_TRUE(oldest > behind);
+    TEST_ASSERT_EQUAL_UINT32(RING_RECORDS, replay(7, behind, &first));
+    TEST_ASSERT_EQUAL_UINT32(oldest, first);
+    TEST_ASSERT_EQUAL_UINT32(history.countAvailable(7, behind, 0), history.countAvailable(7, oldest, 0));
+
+    // Another node only gets the broadcasts, the direct messages to 7 that wrapped out are gone from its chain too
+    uint32_t broadcasts = 0;
+    for (uint32_t seq = oldest; seq < history.totalAdded(); seq++)
+        broadcasts += (seq % 3 != 0);
+    TEST_ASSERT_EQUAL_UINT32(broadcasts, replay(8, behind));
+    TEST_ASSERT_EQUAL_UINT32(broadcasts, history.countAvailable(8, behind, 0));
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_wraps_oldest_first);
+    RUN_TEST(test_mixed_sizes_wrap);
+    RUN_TEST(test_cursors_across_wrap);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,139 @@
+#include "../TestNode.h"
+#include "ReliableRouter.h"
+#include "mesh/udp/UdpMulticastInterface.h"
+#include "platform/portduino/SimRadio.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#if HAS_UDP_MULTICAST
+#define TEST_PORT 14404
+
+// Our node has a LoRa radio and the LAN, peer is another node in the same multicast group
+static SimRadio *lora;
+static UdpMulticastInterface *lan, *peer;
+static uint32_t nextId = 1;
+
+// A broadcast from someone else, one hop away
+static meshtastic_MeshPacket *allocReceived()
+{
+    meshtastic_MeshPacket *p = packetPool.allocZeroed();
+    p->from = 0x1000 + nextId % 50;
+    p->to = NODENUM_BROADCAST;
+    p->id = nextId++;
+    p->hop_start = 3;
+    p->hop_limit = 2;
+    p->which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p->decoded.portnum = meshtastic_PortNum_PRIVATE_APP;
+    p->decoded.payload.size = 10;
+    memset(p->decoded.payload.bytes, 0xA5, p->decoded.payload.size);
+    return p;
+}
+
+// The same, as the peer has it: still encrypted, with a key we don't know
+static meshtastic_MeshPacket *allocEncrypted(PacketId id)
+{
+    meshtastic_MeshPacket *p = allocReceived();
+    p->id = id;
+    p->which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+    p->encrypted.size = 20;
+    memset(p->encrypted.bytes, 0x5A, p->encrypted.size);
+    return p;
+}
+
+// Let the main loop run, until done() or we give up
+template <typename F> static bool runUntil(F done, uint32_t timeoutMs = 5000)
+{
+    uint32_t start = millis();
+    while (!done()) {
+        if (millis() - start > timeoutMs)
+            return false;
+        concurrency::mainController.run();
+        delay(1);
+    }
+    return true;
+}
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_relays_lora_packets_to_lan(void)
+{
+    uint32_t txBefore = lan->txGood, dupeBefore = peer->rxDupe;
+    meshtastic_MeshPacket *p = allocReceived();
+    lora->startReceive(p);
+    packetPool.release(p);
+
+    TEST_ASSERT_TRUE(runUntil([txBefore] { return lan->txGood > txBefore; }));
+    // The peer hands it to the same router here, which already has it
+    TEST_ASSERT_TRUE(runUntil([dupeBefore] { return peer->rxDupe > dupeBefore; }));
+}
+
+void test_ignores_own_datagrams(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(0, lan->rxGood + lan->rxDupe + lan->rxBad);
+}
+
+void test_drops_lan_duplicates(void)
+{
+    uint32_t goodBefore = lan->rxGood, dupeBefore = lan->rxDupe, txBefore = lan->txGood;
+    PacketId id = nextId++;
+    peer->send(allocEncrypted(id));
+    TEST_ASSERT_TRUE(runUntil([goodBefore] { return lan->rxGood > goodBefore; }));
+
+    peer->send(allocEncrypted(id));
+    TEST_ASSERT_TRUE(runUntil([dupeBefore] { return lan->rxDupe > dupeBefore; }));
+    TEST_ASSERT_EQUAL_UINT32(goodBefore + 1, lan->rxGood);
+    // Everyone in the group has it already
+    TEST_ASSERT_EQUAL_UINT32(txBefore, lan->txGood);
+}
+
+void test_takes_no_airtime(void)
+{
+    meshtastic_MeshPacket *p = allocEncrypted(nextId++);
+    TEST_ASSERT_EQUAL_UINT32(0, lan->getPacketTime(p));
+    TEST_ASSERT_GREATER_THAN_UINT32(0, lora->getPacketTime(p));
+    packetPool.release(p);
+    TEST_ASSERT_EQUAL_FLOAT(0, lan->getAirTime()->utilizationTXPercent());
+}
+#endif
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+#if HAS_UDP_MULTICAST
+    initTestNode();
+    lora = new SimRadio();
+    lora->reconfigure();
+    lan = new UdpMulticastInterface(UDP_MULTICAST_DEFAULT_GROUP, TEST_PORT, "127.0.0.1");
+    peer = new UdpMulticastInterface(UDP_MULTICAST_DEFAULT_GROUP, TEST_PORT, "127.0.0.1");
+    startTestRouter(new ReliableRouter());
+    router->addInterface(lora);
+    if (lan->init())
+        router->addInterface(lan);
+    peer->init();
+#endif
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+#if HAS_UDP_MULTICAST
+    RUN_TEST(test_relays_lora_packets_to_lan);
+    RUN_TEST(test_ignores_own_datagrams);
+    RUN_TEST(test_drops_lan_duplicates);
+    RUN_TEST(test_takes_no_airtime);
+#endif
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}